@@ -0,0 +1,382 @@
+/*
+ * 多路编码吞吐基准
+ *
+ * 在一个 MediaManager 中创建 N 路 VI → VPSS → VENC 流水线，同时运行一段时间，
+ * 统计每路及总计的编码帧率与码率。主机上链接软件 MPI（make bench）运行，
+ * 也可以交叉编译后在板端运行。
+ *
+ *   ./build_native/bench_multi_stream -n 6 -t 10 -w 3840 -h 2160 -f 30
+ *
+ * -m 指定目录时每路同时录制 fMP4（Mp4Muxer，订阅者线程写盘），额外统计录像丢帧、
+ * 分片写出（含 fdatasync）耗时和总写入带宽，用于评估存储设备能承受的录像路数：
+ *
+ *   ./build_native/bench_multi_stream -n 16 -t 30 -b 16000000 -m /mnt/emmc/rec
+ *
+ * -d 指定目录时每路的裸码流（以及 -y 时的 YUV）经 DiskWriterSvc 转储，统计丢帧与写盘耗时分位数，
+ * 例如 4K30 NV12 全帧率转储（约 370MB/s）：
+ *
+ *   ./build_native/bench_multi_stream -n 1 -t 30 -y -z 3840x2160 -d /mnt/nvme/dump
+ *
+ * 关键帧数超过 GOP 允许的数量时返回失败，可配合 RK_SIM_VENC_ISLICE_INTERVAL 检查非 IDR 的 I 帧
+ * 不被当作关键帧：
+ *
+ *   RK_SIM_VENC_ISLICE_INTERVAL=5 ./build_native/bench_multi_stream -n 2 -t 3 -w 1920 -h 1080
+ *
+ * -g 指定 GOP（默认等于帧率），短 GOP（2-4 帧）下 IDR 之外几乎没有码率预算：
+ *
+ *   ./build_native/bench_multi_stream -n 1 -t 2 -w 640 -h 360 -f 3 -g 2
+ */
+#include "MediaManager.h"
+#include "PipelineConfig.h"
+#include "Mp4Muxer.h"
+#include "DiskWriterSvc.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct StreamStats {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> keyFrames{0};
+    std::atomic<uint64_t> yuvFrames{0};
+};
+
+volatile sig_atomic_t g_running = 1;
+
+void onSignal(int) {
+    g_running = 0;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  -n <streams>   number of pipelines (default 6)\n"
+              << "  -t <seconds>   run time (default 10)\n"
+              << "  -w <width>     VI width (default 3840)\n"
+              << "  -h <height>    VI height (default 2160)\n"
+              << "  -f <fps>       VI / VENC frame rate (default 30)\n"
+              << "  -b <bitrate>   VENC bitrate in bps (default 8000000)\n"
+              << "  -g <gop>       VENC GOP in frames (default: fps)\n"
+              << "  -c <codec>     h264 | h265 (default h265)\n"
+              << "  -y             also fetch a YUV channel per pipeline\n"
+              << "  -z <WxH>       YUV channel size (default 640x360)\n"
+              << "  -d <dir>       dump raw stream (and YUV) to <dir> through DiskWriterSvc\n"
+              << "  -m <dir>       record each stream to <dir>/stream_<n>.mp4\n"
+              << "  -C <file>      base pipeline config (applied before the options above)\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int streams = 6;
+    int seconds = 10;
+    uint32_t width = 3840;
+    uint32_t height = 2160;
+    int fps = 30;
+    int gop = 0;
+    uint32_t bitrate = 8000000;
+    bool h265 = true;
+    bool withYuv = false;
+    std::string recordDir;
+    std::string dumpDir;
+    uint32_t yuvWidth = 640;
+    uint32_t yuvHeight = 360;
+    PipelineConfig base;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:w:h:f:g:b:c:yz:m:d:C:")) != -1) {
+        switch (opt) {
+        case 'n': streams = atoi(optarg); break;
+        case 't': seconds = atoi(optarg); break;
+        case 'w': width = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'h': height = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'f': fps = atoi(optarg); break;
+        case 'g': gop = atoi(optarg); break;
+        case 'b': bitrate = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'c': h265 = (strcmp(optarg, "h264") != 0); break;
+        case 'y': withYuv = true; break;
+        case 'z':
+            if (sscanf(optarg, "%ux%u", &yuvWidth, &yuvHeight) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'm': recordDir = optarg; break;
+        case 'd': dumpDir = optarg; break;
+        case 'C':
+            if (!loadPipelineConfig(optarg, base)) {
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (streams <= 0 || seconds <= 0 || fps <= 0 || gop < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (gop == 0) {
+        gop = fps;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    MediaManager manager;
+    std::vector<std::unique_ptr<StreamStats>> stats;
+    std::vector<std::shared_ptr<MediaPipeline>> pipelines;
+    std::vector<std::shared_ptr<Mp4Muxer>> muxers;
+    std::vector<int> muxerSubscribers;
+
+    // 转储：所有路共用一个写盘服务，缓冲约 1 秒的数据量
+    std::unique_ptr<DiskWriterSvc> writer;
+    std::vector<int> dumpSubscribers;
+    std::vector<SubscriberStats> dumpQueues;
+    if (!dumpDir.empty()) {
+        DiskWriterConfig writerConfig;
+        size_t perSecond = static_cast<size_t>(bitrate / 8) +
+                           (withYuv ? static_cast<size_t>(yuvWidth) * yuvHeight * 3 / 2 * fps : 0);
+        writerConfig.bufferBytes = std::max<size_t>(perSecond * streams, 64 * 1024 * 1024);
+        writer.reset(new DiskWriterSvc(writerConfig));
+        writer->start();
+    }
+
+    for (int i = 0; i < streams; i++) {
+        PipelineConfig config = base;
+        config.vi.devId = i;
+        config.vi.pipeId = i;
+        config.vi.chnId = 0;
+        config.vi.width = width;
+        config.vi.height = height;
+        config.vi.fps = fps;
+        config.vpss[kVpssChnDisplay].enabled = false;
+        config.vpss[kVpssChnYuv].enabled = withYuv;
+        config.vpss[kVpssChnYuv].width = yuvWidth;
+        config.vpss[kVpssChnYuv].height = yuvHeight;
+        config.venc.useH265 = h265;
+        config.venc.bitrate = bitrate;
+        config.venc.fps = static_cast<uint32_t>(fps);
+        config.venc.gop = static_cast<uint32_t>(gop);
+
+        int index = manager.addPipeline(config);
+        if (index < 0) {
+            std::cerr << "[Bench] Failed to add pipeline " << i << std::endl;
+            return 1;
+        }
+        pipelines.push_back(manager.getPipeline(index));
+        stats.push_back(std::unique_ptr<StreamStats>(new StreamStats()));
+
+        StreamStats* s = stats.back().get();
+        pipelines.back()->getEncoderService()->setEncodeCallback([s](const EncodedFrame& frame) {
+            s->frames.fetch_add(1, std::memory_order_relaxed);
+            s->bytes.fetch_add(frame.size, std::memory_order_relaxed);
+            if (frame.isKeyFrame) {
+                s->keyFrames.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        if (withYuv) {
+            pipelines.back()->getYUVService()->setYUVCallback([s](const VideoFrameRef&) {
+                s->yuvFrames.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        if (!recordDir.empty()) {
+            Mp4MuxerConfig mp4Config;
+            mp4Config.path = recordDir + "/stream_" + std::to_string(i) + ".mp4";
+            std::shared_ptr<Mp4Muxer> muxer = std::make_shared<Mp4Muxer>(mp4Config);
+            if (!muxer->open()) {
+                return 1;
+            }
+            muxers.push_back(muxer);
+            // 队列约 2 个 GOP：一次分片写出 + fdatasync 期间不丢帧
+            muxerSubscribers.push_back(pipelines.back()->getEncoderService()->addSubscriber(
+                "mp4", [muxer](const EncodedFrame& frame) { muxer->writeFrame(frame); },
+                static_cast<size_t>(fps) * 2, OverflowPolicy::DropNewest));
+        }
+        if (writer) {
+            // 回调只拷进写盘缓冲；缓冲不足时 write() 丢弃整帧并计数
+            DiskWriterSvc* w = writer.get();
+            int streamFile = w->openFile(dumpDir + "/stream_" + std::to_string(i) + (h265 ? ".h265" : ".h264"));
+            if (streamFile < 0) {
+                return 1;
+            }
+            dumpSubscribers.push_back(pipelines.back()->getEncoderService()->addSubscriber(
+                "dump", [w, streamFile](const EncodedFrame& frame) { w->write(streamFile, frame); },
+                static_cast<size_t>(fps), OverflowPolicy::DropNewest));
+            if (withYuv) {
+                int yuvFile = w->openFile(dumpDir + "/yuv_" + std::to_string(i) + ".nv12");
+                if (yuvFile < 0) {
+                    return 1;
+                }
+                dumpSubscribers.push_back(pipelines.back()->getYUVService()->addSubscriber(
+                    "dump", [w, yuvFile](const VideoFrameRef& frame) { w->write(yuvFile, frame); },
+                    2, OverflowPolicy::DropOldest));
+            }
+        }
+    }
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pipelines.size(); i++) {
+        pipelines[i]->startEncoderService();
+        if (withYuv) {
+            pipelines[i]->startYUVService();
+        }
+    }
+    std::chrono::steady_clock::time_point runTime = std::chrono::steady_clock::now();
+
+    // 以所有服务启动完成为计时起点，启动期间的帧不计入
+    for (size_t i = 0; i < stats.size(); i++) {
+        stats[i]->frames = 0;
+        stats[i]->bytes = 0;
+        stats[i]->keyFrames = 0;
+        stats[i]->yuvFrames = 0;
+    }
+
+    for (int sec = 0; sec < seconds * 10 && g_running; sec++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+    std::vector<uint64_t> frames(stats.size());
+    std::vector<uint64_t> bytes(stats.size());
+    std::vector<uint64_t> keyFrames(stats.size());
+    std::vector<uint64_t> yuvFrames(stats.size());
+    for (size_t i = 0; i < stats.size(); i++) {
+        frames[i] = stats[i]->frames;
+        bytes[i] = stats[i]->bytes;
+        keyFrames[i] = stats[i]->keyFrames;
+        yuvFrames[i] = stats[i]->yuvFrames;
+    }
+
+    // 录像：订阅者队列丢帧在停止前取，分片统计在写出最后一个分片后取
+    std::vector<SubscriberStats> recordQueues(muxers.size());
+    std::vector<Mp4Muxer::Stats> recordStats(muxers.size());
+    for (size_t i = 0; i < muxers.size(); i++) {
+        pipelines[i]->getEncoderService()->getSubscriberStats(muxerSubscribers[i], recordQueues[i]);
+    }
+    for (size_t i = 0; i < muxers.size(); i++) {
+        pipelines[i]->getEncoderService()->removeSubscriber(muxerSubscribers[i]);
+        muxers[i]->close();
+        recordStats[i] = muxers[i]->stats();
+    }
+
+    // 转储：统计在所有文件写完之后取（包含收尾写盘的耗时）
+    DiskWriterSvc::Stats dumpStats;
+    memset(&dumpStats, 0, sizeof(dumpStats));
+    uint64_t dumpQueueDrops = 0;
+    if (writer) {
+        size_t perPipeline = dumpSubscribers.size() / pipelines.size();
+        for (size_t i = 0; i < dumpSubscribers.size(); i++) {
+            std::shared_ptr<MediaPipeline> pipeline = pipelines[i / perPipeline];
+            SubscriberStats queue;
+            bool yuv = (i % perPipeline) == 1;
+            bool found = yuv ? pipeline->getYUVService()->getSubscriberStats(dumpSubscribers[i], queue)
+                             : pipeline->getEncoderService()->getSubscriberStats(dumpSubscribers[i], queue);
+            if (found) {
+                dumpQueueDrops += queue.dropped;
+            }
+            if (yuv) {
+                pipeline->getYUVService()->removeSubscriber(dumpSubscribers[i]);
+            } else {
+                pipeline->getEncoderService()->removeSubscriber(dumpSubscribers[i]);
+            }
+        }
+        writer->stop();
+        writer->join();
+        dumpStats = writer->stats();
+        writer.reset();  // 关闭所有文件
+    }
+
+    pipelines.clear();
+    manager.deinit();
+
+    double elapsed = std::chrono::duration<double>(endTime - runTime).count();
+    double startupMs = std::chrono::duration<double, std::milli>(runTime - startTime).count();
+    uint64_t totalFrames = 0;
+    uint64_t totalBytes = 0;
+
+    printf("\n%d x %ux%u@%d %s, %.1f s (startup %.1f ms)\n", streams, width, height, fps,
+           h265 ? "H265" : "H264", elapsed, startupMs);
+    printf("%-8s %10s %10s %10s %10s", "stream", "frames", "fps", "Mbps", "idr");
+    if (withYuv) {
+        printf(" %10s", "yuv fps");
+    }
+    printf("\n");
+    for (size_t i = 0; i < frames.size(); i++) {
+        printf("%-8zu %10llu %10.2f %10.2f %10llu", i, static_cast<unsigned long long>(frames[i]),
+               frames[i] / elapsed, bytes[i] * 8.0 / elapsed / 1e6,
+               static_cast<unsigned long long>(keyFrames[i]));
+        if (withYuv) {
+            printf(" %10.2f", yuvFrames[i] / elapsed);
+        }
+        printf("\n");
+        totalFrames += frames[i];
+        totalBytes += bytes[i];
+    }
+    printf("%-8s %10llu %10.2f %10.2f\n", "total", static_cast<unsigned long long>(totalFrames),
+           totalFrames / elapsed, totalBytes * 8.0 / elapsed / 1e6);
+    printf("expected %.2f fps aggregate, achieved %.1f%%\n", static_cast<double>(streams) * fps,
+           100.0 * totalFrames / elapsed / (static_cast<double>(streams) * fps));
+
+    // 关键帧只能出现在 GOP 边界（丢帧只会让关键帧更少）；多出来的是被误判为关键帧的
+    // 非 IDR I 帧（RK_SIM_VENC_ISLICE_INTERVAL 模拟）
+    bool keyFrameError = false;
+    for (size_t i = 0; i < frames.size(); i++) {
+        uint64_t maxKeyFrames = frames[i] / static_cast<uint64_t>(gop) + 1;
+        if (keyFrames[i] > maxKeyFrames) {
+            fprintf(stderr, "stream %zu: %llu key frames in %llu frames, at most %llu expected with GOP %d\n", i,
+                    static_cast<unsigned long long>(keyFrames[i]), static_cast<unsigned long long>(frames[i]),
+                    static_cast<unsigned long long>(maxKeyFrames), gop);
+            keyFrameError = true;
+        }
+    }
+
+    if (!muxers.empty()) {
+        uint64_t recordBytes = 0;
+        uint64_t recordDropped = 0;
+        uint64_t maxFragmentUs = 0;
+        printf("\nrecording to %s\n", recordDir.c_str());
+        printf("%-8s %10s %10s %10s %10s %12s\n", "stream", "frames", "fragments", "dropped", "MB",
+               "max frag ms");
+        for (size_t i = 0; i < muxers.size(); i++) {
+            const Mp4Muxer::Stats& r = recordStats[i];
+            uint64_t dropped = recordQueues[i].dropped + r.droppedFrames;
+            printf("%-8zu %10llu %10llu %10llu %10.1f %12.2f\n", i,
+                   static_cast<unsigned long long>(r.frames), static_cast<unsigned long long>(r.fragments),
+                   static_cast<unsigned long long>(dropped), r.bytes / 1e6, r.maxFragmentUs / 1000.0);
+            recordBytes += r.bytes;
+            recordDropped += dropped;
+            if (r.maxFragmentUs > maxFragmentUs) {
+                maxFragmentUs = r.maxFragmentUs;
+            }
+        }
+        printf("total write %.2f MB/s, %llu frames dropped, max fragment write %.2f ms\n",
+               recordBytes / elapsed / 1e6, static_cast<unsigned long long>(recordDropped),
+               maxFragmentUs / 1000.0);
+    }
+
+    if (!dumpDir.empty()) {
+        printf("\ndump to %s\n", dumpDir.c_str());
+        printf("accepted %.1f MB (%.1f MB/s), written %.1f MB in %llu writes\n", dumpStats.bytesAccepted / 1e6,
+               dumpStats.bytesAccepted / elapsed / 1e6, dumpStats.bytesWritten / 1e6,
+               static_cast<unsigned long long>(dumpStats.writeCalls));
+        printf("dropped %llu writes (buffer full), %llu frames (subscriber queue), peak buffer %.1f MB\n",
+               static_cast<unsigned long long>(dumpStats.droppedWrites),
+               static_cast<unsigned long long>(dumpQueueDrops), dumpStats.peakBufferedBytes / 1e6);
+        printf("write latency p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n", dumpStats.latencyP50Us / 1000.0,
+               dumpStats.latencyP95Us / 1000.0, dumpStats.latencyP99Us / 1000.0, dumpStats.latencyMaxUs / 1000.0);
+    }
+    return keyFrameError ? 1 : 0;
+}
@@ -0,0 +1,494 @@
+/*
+ * RTSP 扇出基准
+ *
+ * 一路 VI → VPSS → VENC 流水线通过 RtspServer 发布，本进程内建立 N 个回环 RTSP 客户端
+ * （OPTIONS/DESCRIBE/SETUP/PLAY，RTP over UDP），接收线程用 recvmmsg 收包并还原每一帧，
+ * 与编码输出逐帧比对（NAL 内容哈希），统计丢包、错帧、接收码率和服务端扇出开销：
+ *
+ *   ./build_native/bench_rtsp -n 32 -t 10 -w 3840 -h 2160 -c h265
+ *
+ * 服务端每帧只打包一次，"packets" 为打包数，"datagrams" 为发给所有观看者的 UDP 包数，
+ * 所有观看者加入后两者之比等于观看者数（观看者从各自 PLAY 之后的第一个关键帧开始接收）；
+ * "per call" 为平均每次 sendmmsg 发出的包数。
+ */
+#include "AnnexB.h"
+#include "MediaManager.h"
+#include "PipelineConfig.h"
+#include "RtspServer.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const uint64_t kFnvOffset = 1469598103934665603ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t fnv1a(uint64_t hash, const uint8_t* p, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+/**
+ * @brief 帧内容哈希：按顺序连接所有 NAL（不含起始码和 AUD），与 RTP 还原结果对应
+ */
+uint64_t hashFrame(const EncodedFrame& frame) {
+    uint64_t hash = kFnvOffset;
+    forEachNal(frame, [&](const uint8_t* nal, size_t size) {
+        if (nalUnitType(nal, frame.isH265) != (frame.isH265 ? 35 : 9)) {
+            hash = fnv1a(hash, nal, size);
+        }
+    });
+    return hash;
+}
+
+/**
+ * @brief 一个回环观看者：RTSP 控制连接 + RTP 接收 socket + 解包状态
+ */
+struct Viewer {
+    int control = -1;
+    int rtp = -1;
+    uint16_t rtpPort = 0;
+    std::string session;
+    int cseq = 0;
+
+    // 接收线程独占
+    bool started = false;
+    uint16_t expectedSeq = 0;
+    bool damaged = false;            // 当前帧有丢包，到 Marker 为止丢弃
+    uint64_t hash = kFnvOffset;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t lost = 0;
+    uint64_t damagedFrames = 0;
+    std::vector<uint64_t> frames;    // 完整还原的帧的哈希
+    std::chrono::steady_clock::time_point firstFrameTime;
+
+    std::chrono::steady_clock::time_point playTime;
+};
+
+volatile sig_atomic_t g_running = 1;
+
+void onSignal(int) {
+    g_running = 0;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  -n <viewers>   number of loopback RTSP clients (default 32)\n"
+              << "  -t <seconds>   run time (default 10)\n"
+              << "  -w <width>     VI width (default 1920)\n"
+              << "  -h <height>    VI height (default 1080)\n"
+              << "  -f <fps>       VI / VENC frame rate (default 30)\n"
+              << "  -b <bitrate>   VENC bitrate in bps (default 8000000)\n"
+              << "  -c <codec>     h264 | h265 (default h265)\n"
+              << "  -p <port>      RTSP port (default 0 = any free port)\n"
+              << "  -C <file>      base pipeline config (applied before the options above)\n";
+}
+
+/**
+ * @brief 发送一个 RTSP 请求并读取回复（阻塞，回复完整读完为止）
+ */
+bool rtspRequest(Viewer& v, const std::string& method, const std::string& url,
+                 const std::string& headers, std::string& reply) {
+    std::string req = method + " " + url + " RTSP/1.0\r\nCSeq: " + std::to_string(++v.cseq) + "\r\n";
+    if (!v.session.empty()) {
+        req += "Session: " + v.session + "\r\n";
+    }
+    req += headers + "\r\n";
+    if (send(v.control, req.data(), req.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(req.size())) {
+        return false;
+    }
+
+    reply.clear();
+    char buf[2048];
+    while (true) {
+        size_t end = reply.find("\r\n\r\n");
+        if (end != std::string::npos) {
+            size_t total = end + 4;
+            size_t cl = reply.find("Content-Length:");
+            if (cl != std::string::npos && cl < end) {
+                total += strtoul(reply.c_str() + cl + 15, nullptr, 10);
+            }
+            if (reply.size() >= total) {
+                return reply.compare(0, 12, "RTSP/1.0 200") == 0;
+            }
+        }
+        ssize_t n = recv(v.control, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        reply.append(buf, static_cast<size_t>(n));
+    }
+}
+
+bool openRtpSocket(Viewer& v) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    v.rtp = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(v.rtp, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    socklen_t len = sizeof(addr);
+    if (v.rtp < 0 || bind(v.rtp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        getsockname(v.rtp, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        return false;
+    }
+    v.rtpPort = ntohs(addr.sin_port);
+    return true;
+}
+
+/**
+ * @brief RTSP 握手：OPTIONS、DESCRIBE、SETUP、PLAY
+ */
+bool startViewer(Viewer& v, uint16_t port, const std::string& url) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    v.control = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(v.control, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        return false;
+    }
+
+    std::string reply;
+    if (!rtspRequest(v, "OPTIONS", url, "", reply) ||
+        !rtspRequest(v, "DESCRIBE", url, "Accept: application/sdp\r\n", reply) ||
+        reply.find("a=rtpmap:96") == std::string::npos) {
+        std::cerr << "[Bench] DESCRIBE failed:\n" << reply << std::endl;
+        return false;
+    }
+    std::string transport = "Transport: RTP/AVP;unicast;client_port=" + std::to_string(v.rtpPort) + "-" +
+                            std::to_string(v.rtpPort + 1) + "\r\n";
+    if (!rtspRequest(v, "SETUP", url + "/trackID=0", transport, reply)) {
+        std::cerr << "[Bench] SETUP failed:\n" << reply << std::endl;
+        return false;
+    }
+    size_t s = reply.find("Session: ");
+    if (s == std::string::npos) {
+        return false;
+    }
+    v.session = reply.substr(s + 9, reply.find_first_of(";\r", s + 9) - s - 9);
+    v.playTime = std::chrono::steady_clock::now();
+    return rtspRequest(v, "PLAY", url, "Range: npt=0.000-\r\n", reply);
+}
+
+/**
+ * @brief 解一个 RTP 包（单 NAL / FU-A / H265 FU），Marker 时结束一帧
+ */
+void depacketize(Viewer& v, const uint8_t* p, size_t size, bool h265) {
+    if (size < 13 || (p[0] & 0xC0) != 0x80) {
+        return;
+    }
+    v.packets++;
+    v.bytes += size;
+
+    uint16_t seq = static_cast<uint16_t>((p[2] << 8) | p[3]);
+    bool marker = (p[1] & 0x80) != 0;
+    if (v.started && seq != v.expectedSeq) {
+        v.lost += static_cast<uint16_t>(seq - v.expectedSeq);
+        v.damaged = true;
+    }
+    v.started = true;
+    v.expectedSeq = static_cast<uint16_t>(seq + 1);
+
+    const uint8_t* payload = p + 12;
+    size_t len = size - 12;
+    if (h265) {
+        int type = (payload[0] >> 1) & 0x3F;
+        if (type == 49 && len > 3) {
+            uint8_t fu = payload[2];
+            if (fu & 0x80) {
+                uint8_t header[2] = { static_cast<uint8_t>((payload[0] & 0x81) | ((fu & 0x3F) << 1)), payload[1] };
+                v.hash = fnv1a(v.hash, header, 2);
+            }
+            v.hash = fnv1a(v.hash, payload + 3, len - 3);
+        } else {
+            v.hash = fnv1a(v.hash, payload, len);
+        }
+    } else {
+        int type = payload[0] & 0x1F;
+        if (type == 28 && len > 2) {
+            if (payload[1] & 0x80) {
+                uint8_t header = static_cast<uint8_t>((payload[0] & 0xE0) | (payload[1] & 0x1F));
+                v.hash = fnv1a(v.hash, &header, 1);
+            }
+            v.hash = fnv1a(v.hash, payload + 2, len - 2);
+        } else {
+            v.hash = fnv1a(v.hash, payload, len);
+        }
+    }
+
+    if (marker) {
+        if (v.damaged) {
+            v.damagedFrames++;
+        } else {
+            if (v.frames.empty()) {
+                v.firstFrameTime = std::chrono::steady_clock::now();
+            }
+            v.frames.push_back(v.hash);
+        }
+        v.hash = kFnvOffset;
+        v.damaged = false;
+    }
+}
+
+void receiveLoop(std::vector<std::unique_ptr<Viewer>>& viewers, bool h265, std::atomic<bool>& running) {
+    int ep = epoll_create1(0);
+    for (size_t i = 0; i < viewers.size(); i++) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = viewers[i].get();
+        epoll_ctl(ep, EPOLL_CTL_ADD, viewers[i]->rtp, &ev);
+    }
+
+    const unsigned kBatch = 64;
+    std::vector<uint8_t> buffers(kBatch * 2048);
+    mmsghdr msgs[kBatch];
+    iovec iovs[kBatch];
+    struct epoll_event events[64];
+    while (running.load()) {
+        int n = epoll_wait(ep, events, 64, 100);
+        for (int e = 0; e < n; e++) {
+            Viewer& v = *static_cast<Viewer*>(events[e].data.ptr);
+            while (true) {
+                for (unsigned i = 0; i < kBatch; i++) {
+                    iovs[i].iov_base = &buffers[i * 2048];
+                    iovs[i].iov_len = 2048;
+                    memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+                    msgs[i].msg_hdr.msg_iov = &iovs[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                }
+                int got = recvmmsg(v.rtp, msgs, kBatch, MSG_DONTWAIT, nullptr);
+                if (got <= 0) {
+                    break;
+                }
+                for (int i = 0; i < got; i++) {
+                    depacketize(v, &buffers[i * 2048], msgs[i].msg_len, h265);
+                }
+            }
+        }
+    }
+    close(ep);
+}
+
+double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int viewerCount = 32;
+    int seconds = 10;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    int fps = 30;
+    uint32_t bitrate = 8000000;
+    bool h265 = true;
+    uint16_t port = 0;
+    PipelineConfig config;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:w:h:f:b:c:p:C:")) != -1) {
+        switch (opt) {
+        case 'n': viewerCount = atoi(optarg); break;
+        case 't': seconds = atoi(optarg); break;
+        case 'w': width = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'h': height = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'f': fps = atoi(optarg); break;
+        case 'b': bitrate = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)); break;
+        case 'c': h265 = (strcmp(optarg, "h264") != 0); break;
+        case 'p': port = static_cast<uint16_t>(atoi(optarg)); break;
+        case 'C':
+            if (!loadPipelineConfig(optarg, config)) {
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (viewerCount <= 0 || seconds <= 0 || fps <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    config.vi.width = width;
+    config.vi.height = height;
+    config.vi.fps = fps;
+    config.vpss[kVpssChnDisplay].enabled = false;
+    config.vpss[kVpssChnYuv].enabled = false;
+    config.venc.useH265 = h265;
+    config.venc.bitrate = bitrate;
+    config.venc.fps = static_cast<uint32_t>(fps);
+    config.venc.gop = static_cast<uint32_t>(fps);
+
+    MediaManager manager;
+    if (!manager.init(config)) {
+        std::cerr << "[Bench] Failed to initialize MediaManager" << std::endl;
+        return 1;
+    }
+    std::shared_ptr<VideoEncoderSvc> encoder = manager.getEncoderService();
+
+    RtspServerConfig serverConfig;
+    serverConfig.port = port;
+    serverConfig.maxViewers = static_cast<uint32_t>(viewerCount);
+    RtspServer server(serverConfig);
+    int stream = server.addStream("live", h265);
+    if (stream < 0 || !server.open()) {
+        return 1;
+    }
+    server.start();
+
+    // 编码输出的帧哈希（比对基准）
+    std::mutex publishedMutex;
+    std::set<uint64_t> published;
+    uint64_t publishedFrames = 0;
+    encoder->setEncodeCallback([&](const EncodedFrame& frame) {
+        uint64_t hash = hashFrame(frame);
+        std::lock_guard<std::mutex> lock(publishedMutex);
+        published.insert(hash);
+        publishedFrames++;
+    });
+    int subscriber = encoder->addSubscriber("rtsp", [&server, stream](const EncodedFrame& frame) {
+        server.pushFrame(stream, frame);
+    }, static_cast<size_t>(fps), OverflowPolicy::DropOldest);
+
+    manager.startEncoderService();
+
+    std::string url = "rtsp://127.0.0.1:" + std::to_string(server.port()) + "/live";
+    std::vector<std::unique_ptr<Viewer>> viewers;
+    for (int i = 0; i < viewerCount; i++) {
+        viewers.push_back(std::unique_ptr<Viewer>(new Viewer()));
+    }
+
+    for (size_t i = 0; i < viewers.size(); i++) {
+        if (!openRtpSocket(*viewers[i])) {
+            std::cerr << "[Bench] Failed to open RTP socket: " << strerror(errno) << std::endl;
+            return 1;
+        }
+    }
+
+    // 接收线程先于 PLAY 启动，PLAY 之后的第一个关键帧就开始收
+    std::atomic<bool> receiving{true};
+    std::thread receiver(receiveLoop, std::ref(viewers), h265, std::ref(receiving));
+    bool started = true;
+    for (size_t i = 0; i < viewers.size() && started; i++) {
+        started = startViewer(*viewers[i], server.port(), url);
+        if (!started) {
+            std::cerr << "[Bench] Viewer " << i << " failed to start" << std::endl;
+        }
+    }
+    if (!started) {
+        g_running = 0;
+    }
+
+    double cpuStart = cpuSeconds();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < seconds * 10 && g_running; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = cpuSeconds() - cpuStart;
+
+    RtspServer::Stats stats = server.stats();
+    for (size_t i = 0; i < viewers.size(); i++) {
+        std::string reply;
+        if (!viewers[i]->session.empty()) {
+            rtspRequest(*viewers[i], "TEARDOWN", url, "", reply);
+        }
+    }
+    encoder->removeSubscriber(subscriber);
+    manager.stopEncoderService();
+    // 留出时间收完在途的包
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    receiving = false;
+    receiver.join();
+    server.stop();
+    server.join();
+    manager.deinit();
+
+    uint64_t totalFrames = 0;
+    uint64_t totalBytes = 0;
+    uint64_t totalLost = 0;
+    uint64_t totalDamaged = 0;
+    uint64_t mismatched = 0;
+    uint64_t minFrames = UINT64_MAX;
+    double maxFirstFrameMs = 0;
+    for (size_t i = 0; i < viewers.size(); i++) {
+        Viewer& v = *viewers[i];
+        for (size_t f = 0; f < v.frames.size(); f++) {
+            if (published.find(v.frames[f]) == published.end()) {
+                mismatched++;
+            }
+        }
+        totalFrames += v.frames.size();
+        totalBytes += v.bytes;
+        totalLost += v.lost;
+        totalDamaged += v.damagedFrames;
+        if (v.frames.size() < minFrames) {
+            minFrames = v.frames.size();
+        }
+        if (!v.frames.empty()) {
+            double firstFrameMs = std::chrono::duration<double, std::milli>(v.firstFrameTime - v.playTime).count();
+            if (firstFrameMs > maxFirstFrameMs) {
+                maxFirstFrameMs = firstFrameMs;
+            }
+        }
+        close(v.control);
+        close(v.rtp);
+    }
+
+    printf("\n1 x %ux%u@%d %s -> %d viewers, %.1f s, %llu frames encoded\n", width, height, fps,
+           h265 ? "H265" : "H264", viewerCount, elapsed, static_cast<unsigned long long>(publishedFrames));
+    printf("%-22s %12llu (min %llu per viewer)\n", "frames received", static_cast<unsigned long long>(totalFrames),
+           static_cast<unsigned long long>(minFrames));
+    printf("%-22s %12llu\n", "frames mismatched", static_cast<unsigned long long>(mismatched));
+    printf("%-22s %12llu packets, %llu damaged frames\n", "lost", static_cast<unsigned long long>(totalLost),
+           static_cast<unsigned long long>(totalDamaged));
+    printf("%-22s %12.2f Mbps total\n", "received", totalBytes * 8.0 / elapsed / 1e6);
+    printf("%-22s %12.1f ms (worst viewer)\n", "first frame after PLAY", maxFirstFrameMs);
+    printf("\nserver\n");
+    printf("%-22s %12llu\n", "packets", static_cast<unsigned long long>(stats.packets));
+    printf("%-22s %12llu (%.1f per packet)\n", "datagrams", static_cast<unsigned long long>(stats.datagrams),
+           stats.packets ? static_cast<double>(stats.datagrams) / stats.packets : 0.0);
+    printf("%-22s %12llu (%.1f datagrams per call)\n", "sendmmsg calls",
+           static_cast<unsigned long long>(stats.sendCalls),
+           stats.sendCalls ? static_cast<double>(stats.datagrams) / stats.sendCalls : 0.0);
+    printf("%-22s %12llu\n", "send errors", static_cast<unsigned long long>(stats.sendErrors));
+    printf("%-22s %12.2f ms\n", "max frame fan-out", stats.maxFanoutUs / 1000.0);
+    printf("%-22s %12.1f%% of one core (encoder + server + clients)\n", "process CPU", 100.0 * cpu / elapsed);
+    return (started && mismatched == 0 && totalLost == 0) ? 0 : 2;
+}
@@ -0,0 +1,551 @@
+/*
+ * 服务框架热点路径基准
+ *
+ * 分别测量：
+ * - post：N 个生产者线程全速向同一服务投递小任务的吞吐、投递调用耗时和投递到执行的时延（含排队）
+ * - postSync：N 个线程同步投递空任务的往返时延
+ * - dispatch：YUVOutputSvc::processFrame 的分发开销（同步回调 + 耗时统计 + 发布给 K 个异步订阅者），
+ *   processFrame 是私有函数，这里用相同的类型（FrameDispatcher<VideoFrameRef>、MetricHistogram）按同样的步骤复现
+ * - copy：getEncodedStream 零拷贝退化时的 copyEncodedFrame（缓冲池）与直接 new + memcpy 对比，
+ *   以及 EncodedFrame 句柄本身的拷贝
+ * - pipeline：完整流水线（VI → VPSS → VENC + YUV）不限速时的帧率和每帧 CPU 时间（软件 MPI 下
+ *   RK_SIM_VI_FPS 默认置 0；板端受摄像头帧率限制）
+ *
+ * 结果可以用 -J 写成 JSON（每个结果一行，按名称对齐），不同版本的结果可以直接 diff：
+ *
+ *   ./build_native/bench_service -J /tmp/bench_v1.json
+ *   ./build_native/bench_service -s post,copy -p 1,4,8 -J /tmp/bench_v2.json
+ */
+#include "FrameDispatcher.h"
+#include "LatencyTracer.h"
+#include "MediaManager.h"
+#include "MetricsRegistry.h"
+#include "PacketBufferPool.h"
+#include "PipelineConfig.h"
+#include "ServiceBase.h"
+#include "VideoEncoderSvc.h"
+#include "VideoFrame.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * @brief 一项结果：名称 + 有序的数值字段
+ */
+struct Result {
+    std::string name;
+    std::vector<std::pair<std::string, double>> fields;
+
+    Result(const std::string& n) : name(n) {}
+    Result& add(const char* key, double value) {
+        fields.push_back(std::make_pair(std::string(key), value));
+        return *this;
+    }
+};
+
+void printResult(const Result& r) {
+    printf("  %-28s", r.name.c_str());
+    for (size_t i = 0; i < r.fields.size(); i++) {
+        printf(" %s=%.6g", r.fields[i].first.c_str(), r.fields[i].second);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief 空闲时只等待任务的最小服务
+ */
+class BenchService : public ServiceBase {
+public:
+    BenchService() : ServiceBase("BenchService") {}
+    ~BenchService() override {
+        stop();
+        join();
+    }
+
+protected:
+    void run() override {
+        while (m_running.load()) {
+            if (waitEvents(100) & WAIT_TASK) {
+                processTasks();
+            }
+        }
+    }
+};
+
+/**
+ * @brief 所有生产者线程就绪后同时开始
+ */
+template<typename F>
+uint64_t runProducers(int producers, F body) {
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            ready.fetch_add(1);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            body(p);
+        });
+    }
+    while (ready.load() < producers) {
+        std::this_thread::yield();
+    }
+    uint64_t start = nowNs();
+    go.store(true);
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    return start;
+}
+
+Result benchPost(int producers, int ops) {
+    BenchService svc;
+    svc.start();
+
+    std::atomic<uint64_t> executed(0);
+    std::unique_ptr<LatencyHistogram> latency(new LatencyHistogram());  // 投递 → 执行（纳秒）
+    std::atomic<uint64_t> enqueueNs(0);
+    LatencyHistogram* hist = latency.get();
+
+    uint64_t start = runProducers(producers, [&](int) {
+        uint64_t begin = nowNs();
+        for (int i = 0; i < ops; i++) {
+            uint64_t posted = nowNs();
+            svc.post([&executed, hist, posted]() {
+                hist->record(nowNs() - posted);
+                executed.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        enqueueNs.fetch_add(nowNs() - begin);
+    });
+
+    uint64_t total = static_cast<uint64_t>(producers) * ops;
+    while (executed.load() < total) {
+        std::this_thread::yield();
+    }
+    double seconds = (nowNs() - start) / 1e9;
+
+    Result r("post/producers=" + std::to_string(producers));
+    r.add("ops_per_sec", total / seconds)
+     .add("enqueue_ns", static_cast<double>(enqueueNs.load()) / total)
+     .add("latency_p50_ns", static_cast<double>(hist->percentile(0.50)))
+     .add("latency_p99_ns", static_cast<double>(hist->percentile(0.99)))
+     .add("latency_max_ns", static_cast<double>(hist->max()));
+    return r;
+}
+
+Result benchPostSync(int producers, int ops) {
+    BenchService svc;
+    svc.start();
+
+    std::unique_ptr<LatencyHistogram> latency(new LatencyHistogram());  // 往返（纳秒）
+    std::atomic<uint64_t> failed(0);
+    LatencyHistogram* hist = latency.get();
+
+    uint64_t start = runProducers(producers, [&](int) {
+        for (int i = 0; i < ops; i++) {
+            uint64_t begin = nowNs();
+            if (!svc.postSync([]() { return true; })) {
+                failed.fetch_add(1);
+            }
+            hist->record(nowNs() - begin);
+        }
+    });
+    double seconds = (nowNs() - start) / 1e9;
+    uint64_t total = static_cast<uint64_t>(producers) * ops;
+
+    Result r("postSync/producers=" + std::to_string(producers));
+    r.add("ops_per_sec", total / seconds)
+     .add("latency_p50_ns", static_cast<double>(hist->percentile(0.50)))
+     .add("latency_p99_ns", static_cast<double>(hist->percentile(0.99)))
+     .add("latency_max_ns", static_cast<double>(hist->max()))
+     .add("failed", static_cast<double>(failed.load()));
+    return r;
+}
+
+Result benchDispatch(int subscribers, int frames) {
+    // 与 YUVOutputSvc 相同的成员：回调锁、同步回调、耗时直方图、分发器
+    std::mutex callbackMutex;
+    std::atomic<uint64_t> syncCalls(0);
+    std::function<void(const VideoFrameRef&)> callback = [&syncCalls](const VideoFrameRef&) {
+        syncCalls.fetch_add(1, std::memory_order_relaxed);
+    };
+    MetricHistogram callbackMetric;
+    FrameDispatcher<VideoFrameRef> dispatcher;
+
+    std::atomic<uint64_t> consumed(0);
+    for (int i = 0; i < subscribers; i++) {
+        dispatcher.addSubscriber("bench-" + std::to_string(i), [&consumed](const VideoFrameRef&) {
+            consumed.fetch_add(1, std::memory_order_relaxed);
+        }, 4, OverflowPolicy::DropOldest);
+    }
+
+    static uint8_t pixels[64];
+    VideoFrame meta(640, 360, 0);
+    meta.data = pixels;
+    meta.size = sizeof(pixels);
+    std::shared_ptr<void> holder(pixels, [](void*) {});
+
+    uint64_t start = nowNs();
+    for (int i = 0; i < frames; i++) {
+        VideoFrameRef frame(meta, nullptr, holder);
+        frame.timestamp = static_cast<uint64_t>(i);
+        {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            if (callback) {
+                uint64_t begin = LatencyTracer::nowUs();
+                callback(frame);
+                callbackMetric.observe(LatencyTracer::nowUs() - begin);
+            }
+        }
+        dispatcher.publish(frame);
+    }
+    double ns = static_cast<double>(nowNs() - start) / frames;
+    dispatcher.removeAll();
+
+    Result r("dispatch/subscribers=" + std::to_string(subscribers));
+    r.add("ns_per_frame", ns)
+     .add("delivered_ratio", subscribers > 0 ? static_cast<double>(consumed.load()) /
+                                                   (static_cast<double>(frames) * subscribers) : 1.0);
+    return r;
+}
+
+/**
+ * @brief 按真实码流的片段结构构造一帧（参数集 + SEI + slice）
+ */
+EncodedFrame makeFrame(std::vector<uint8_t>& storage, size_t size) {
+    storage.assign(size, 0x5a);
+    EncodedFrame frame;
+    frame.size = size;
+    frame.timestamp = 0;
+    frame.isKeyFrame = true;
+    frame.width = 1920;
+    frame.height = 1080;
+    size_t head[] = { 32, 16, 64 };
+    size_t offset = 0;
+    for (int i = 0; i < 3 && offset + head[i] < size; i++) {
+        frame.segments[i].data = storage.data() + offset;
+        frame.segments[i].size = head[i];
+        frame.segmentCount++;
+        offset += head[i];
+    }
+    frame.segments[frame.segmentCount].data = storage.data() + offset;
+    frame.segments[frame.segmentCount].size = size - offset;
+    frame.segmentCount++;
+    frame.contiguous = false;
+    return frame;
+}
+
+std::vector<Result> benchCopy(int iterations) {
+    std::vector<Result> results;
+    std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::create();
+    const size_t sizes[] = { 16 * 1024, 256 * 1024, 1024 * 1024 };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        std::vector<uint8_t> storage;
+        EncodedFrame source = makeFrame(storage, sizes[s]);
+        std::string suffix = "/" + std::to_string(sizes[s] / 1024) + "KB";
+
+        // 缓冲池 + 逐片段拼接拷贝（零拷贝退化路径）
+        uint64_t start = nowNs();
+        uint64_t failures = 0;
+        for (int i = 0; i < iterations; i++) {
+            EncodedFrame copy = copyEncodedFrame(source, *pool);
+            if (!copy.data) {
+                failures++;
+            }
+        }
+        double poolNs = static_cast<double>(nowNs() - start) / iterations;
+
+        // 对照：每帧堆分配（读回末字节，避免分配与拷贝被优化掉）
+        volatile uint8_t sink = 0;
+        start = nowNs();
+        for (int i = 0; i < iterations; i++) {
+            std::shared_ptr<uint8_t> data(new uint8_t[source.size], std::default_delete<uint8_t[]>());
+            uint8_t* dst = data.get();
+            for (int k = 0; k < source.segmentCount; k++) {
+                memcpy(dst, source.segments[k].data, source.segments[k].size);
+                dst += source.segments[k].size;
+            }
+            sink = *(dst - 1);
+        }
+        (void)sink;
+        double heapNs = static_cast<double>(nowNs() - start) / iterations;
+
+        Result r("copy" + suffix);
+        r.add("pool_ns", poolNs)
+         .add("pool_gb_per_sec", sizes[s] / poolNs)
+         .add("heap_ns", heapNs)
+         .add("heap_gb_per_sec", sizes[s] / heapNs)
+         .add("failures", static_cast<double>(failures));
+        results.push_back(r);
+    }
+
+    // 句柄拷贝（订阅者队列入队时发生）
+    std::vector<uint8_t> storage;
+    EncodedFrame source = makeFrame(storage, 64 * 1024);
+    source.data = std::shared_ptr<uint8_t>(storage.data(), [](uint8_t*) {});
+    std::vector<EncodedFrame> sink(16);
+    uint64_t start = nowNs();
+    for (int i = 0; i < iterations * 16; i++) {
+        sink[i & 15] = source;
+    }
+    Result r("copy/handle");
+    r.add("ns", static_cast<double>(nowNs() - start) / (iterations * 16.0))
+     .add("bytes", static_cast<double>(sizeof(EncodedFrame)));
+    results.push_back(r);
+    return results;
+}
+
+Result benchPipeline(int streams, uint32_t width, uint32_t height, int seconds) {
+    // 软件 MPI 默认按配置帧率出帧，这里不限速（已设置 RK_SIM_VI_FPS 时以环境变量为准）
+    setenv("RK_SIM_VI_FPS", "0", 0);
+
+    struct Counters {
+        std::atomic<uint64_t> encoded{0};
+        std::atomic<uint64_t> yuv{0};
+    } counters;
+
+    MediaManager manager;
+    for (int i = 0; i < streams; i++) {
+        PipelineConfig config;
+        config.vi.devId = i;
+        config.vi.pipeId = i;
+        config.vi.chnId = 0;
+        config.vi.width = width;
+        config.vi.height = height;
+        config.vpss[kVpssChnDisplay].enabled = false;
+        config.vpss[kVpssChnYuv].enabled = true;
+        config.vpss[kVpssChnYuv].width = 640;
+        config.vpss[kVpssChnYuv].height = 360;
+
+        int index = manager.addPipeline(config);
+        if (index < 0) {
+            std::cerr << "[Bench] Failed to add pipeline " << i << std::endl;
+            return Result("pipeline/failed");
+        }
+        std::shared_ptr<MediaPipeline> pipeline = manager.getPipeline(index);
+        pipeline->getEncoderService()->setEncodeCallback([&counters](const EncodedFrame&) {
+            counters.encoded.fetch_add(1, std::memory_order_relaxed);
+        });
+        pipeline->getYUVService()->setYUVCallback([&counters](const VideoFrameRef&) {
+            counters.yuv.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    if (!manager.start(MediaPipeline::kServiceEncoder | MediaPipeline::kServiceYuv)) {
+        std::cerr << "[Bench] Failed to start pipelines" << std::endl;
+        manager.deinit();
+        return Result("pipeline/failed");
+    }
+
+    // 预热 1 秒后开始计数
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    uint64_t encoded0 = counters.encoded.load();
+    uint64_t yuv0 = counters.yuv.load();
+    double cpu0 = cpuSeconds();
+    uint64_t start = nowNs();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    double elapsed = (nowNs() - start) / 1e9;
+    uint64_t encoded = counters.encoded.load() - encoded0;
+    uint64_t yuv = counters.yuv.load() - yuv0;
+    double cpu = cpuSeconds() - cpu0;
+    manager.deinit();
+
+    char name[64];
+    snprintf(name, sizeof(name), "pipeline/%dx%ux%u", streams, width, height);
+    Result r(name);
+    r.add("venc_fps", encoded / elapsed)
+     .add("yuv_fps", yuv / elapsed)
+     .add("cpu_ms_per_frame", encoded ? cpu * 1000.0 / encoded : 0.0);
+    return r;
+}
+
+bool writeJson(const std::string& path, const std::vector<Result>& results) {
+    struct utsname host;
+    uname(&host);
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    std::string json = "{\n";
+    json += "  \"benchmark\": \"bench_service\",\n";
+    json += std::string("  \"timestamp\": \"") + stamp + "\",\n";
+    json += std::string("  \"host\": {\"machine\": \"") + host.machine + "\", \"release\": \"" +
+            host.release + "\", \"cpus\": " + std::to_string(sysconf(_SC_NPROCESSORS_ONLN)) +
+            ", \"compiler\": \"" + __VERSION__ + "\"},\n";
+    json += "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        json += "    {\"name\": \"" + results[i].name + "\"";
+        for (size_t k = 0; k < results[i].fields.size(); k++) {
+            char value[64];
+            snprintf(value, sizeof(value), "%.6g", results[i].fields[k].second);
+            json += ", \"" + results[i].fields[k].first + "\": " + value;
+        }
+        json += (i + 1 < results.size()) ? "},\n" : "}\n";
+    }
+    json += "  ]\n}\n";
+
+    FILE* fp = fopen(path.c_str(), "w");
+    if (!fp) {
+        std::cerr << "[Bench] Cannot write " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    bool ok = fwrite(json.data(), 1, json.size(), fp) == json.size();
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
+
+/**
+ * @brief 解析逗号分隔的整数列表，格式错误返回空
+ */
+std::vector<int> parseList(const char* text, int minValue) {
+    std::vector<int> values;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        long v = strtol(p, &end, 10);
+        if (end == p || v < minValue) {
+            return std::vector<int>();
+        }
+        values.push_back(static_cast<int>(v));
+        p = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return std::vector<int>();
+        }
+    }
+    return values;
+}
+
+bool selected(const std::string& suites, const char* name) {
+    std::string list = "," + suites + ",";
+    return suites == "all" || list.find("," + std::string(name) + ",") != std::string::npos;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  -s <suites>    comma list of post,postSync,dispatch,copy,pipeline (default all)\n"
+              << "  -p <list>      producer thread counts (default 1,2,4)\n"
+              << "  -n <ops>       tasks per producer for post (default 200000, postSync uses 1/10)\n"
+              << "  -k <list>      async subscriber counts for dispatch (default 0,1,4)\n"
+              << "  -i <iters>     iterations for dispatch / copy (default 20000)\n"
+              << "  -m <streams>   pipelines for the pipeline suite (default 1)\n"
+              << "  -w <width>     pipeline VI width (default 1920)\n"
+              << "  -h <height>    pipeline VI height (default 1080)\n"
+              << "  -t <seconds>   pipeline run time (default 5)\n"
+              << "  -J <file>      also write results as JSON\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string suites = "all";
+    std::vector<int> producers = parseList("1,2,4", 1);
+    std::vector<int> subscriberCounts = parseList("0,1,4", 0);  // 0：只有同步回调
+    int ops = 200000;
+    int iterations = 20000;
+    int streams = 1;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    int seconds = 5;
+    std::string jsonPath;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:n:k:i:m:w:h:t:J:")) != -1) {
+        switch (opt) {
+        case 's': suites = optarg; break;
+        case 'p': producers = parseList(optarg, 1); break;
+        case 'n': ops = atoi(optarg); break;
+        case 'k': subscriberCounts = parseList(optarg, 0); break;
+        case 'i': iterations = atoi(optarg); break;
+        case 'm': streams = atoi(optarg); break;
+        case 'w': width = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'h': height = static_cast<uint32_t>(atoi(optarg)); break;
+        case 't': seconds = atoi(optarg); break;
+        case 'J': jsonPath = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (producers.empty() || subscriberCounts.empty() || ops <= 0 || iterations <= 0 ||
+        streams <= 0 || seconds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Result> results;
+    std::function<void(const Result&)> report = [&](const Result& r) {
+        results.push_back(r);
+        printResult(r);
+    };
+
+    if (selected(suites, "post")) {
+        printf("post (%d tasks per producer):\n", ops);
+        for (size_t i = 0; i < producers.size(); i++) {
+            report(benchPost(producers[i], ops));
+        }
+    }
+    if (selected(suites, "postSync")) {
+        printf("postSync (%d calls per producer):\n", ops / 10);
+        for (size_t i = 0; i < producers.size(); i++) {
+            report(benchPostSync(producers[i], std::max(ops / 10, 1)));
+        }
+    }
+    if (selected(suites, "dispatch")) {
+        printf("dispatch (%d frames):\n", iterations);
+        for (size_t i = 0; i < subscriberCounts.size(); i++) {
+            report(benchDispatch(subscriberCounts[i], iterations));
+        }
+    }
+    if (selected(suites, "copy")) {
+        printf("copy (%d iterations):\n", iterations);
+        std::vector<Result> copies = benchCopy(iterations);
+        for (size_t i = 0; i < copies.size(); i++) {
+            report(copies[i]);
+        }
+    }
+    if (selected(suites, "pipeline")) {
+        printf("pipeline (%d x %ux%u, %ds):\n", streams, width, height, seconds);
+        report(benchPipeline(streams, width, height, seconds));
+    }
+
+    if (!jsonPath.empty()) {
+        if (!writeJson(jsonPath, results)) {
+            return 1;
+        }
+        printf("results written to %s\n", jsonPath.c_str());
+    }
+    return 0;
+}
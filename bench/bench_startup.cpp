@@ -0,0 +1,240 @@
+/*
+ * 冷启动基准
+ *
+ * 在一个 MediaManager 中创建 N 路流水线，分别以串行（1 个线程）和并行方式调用
+ * MediaManager::start()，统计从 start() 开始到每路第一帧编码数据、第一帧 YUV 到达的时间，
+ * 并打印并行启动时各阶段的耗时。
+ *
+ * 软件 MPI 下各模块初始化几乎不耗时，可以用 RK_SIM_SETUP_US 模拟板端阻塞调用的耗时：
+ *
+ *   RK_SIM_SETUP_US=30000 ./build_native/bench_startup -n 4
+ */
+#include "MediaManager.h"
+#include "PipelineConfig.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 第一帧到达时间（绝对时间，0 表示还没到）
+struct FirstFrame {
+    std::atomic<int64_t> encodedUs{0};
+    std::atomic<int64_t> yuvUs{0};
+};
+
+void markFirst(std::atomic<int64_t>& slot) {
+    int64_t expected = 0;
+    if (slot.load(std::memory_order_relaxed) == 0) {
+        slot.compare_exchange_strong(expected, nowUs());
+    }
+}
+
+struct RunResult {
+    double startMs = 0;                    // start() 返回耗时
+    std::vector<double> firstEncodedMs;    // 相对 start() 调用时刻，< 0 表示超时
+    std::vector<double> firstYuvMs;
+    std::vector<StartupStageTiming> stages;
+    bool ok = false;
+};
+
+struct Options {
+    int streams = 4;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    int fps = 30;
+    bool withVo = false;
+    int timeoutMs = 5000;
+    PipelineConfig base;
+};
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  -n <streams>   number of pipelines (default 4)\n"
+              << "  -w <width>     VI width (default 1920)\n"
+              << "  -h <height>    VI height (default 1080)\n"
+              << "  -f <fps>       VI / VENC frame rate (default 30)\n"
+              << "  -j <threads>   parallel startup threads (default: CPU count)\n"
+              << "  -o             also start the VO output service\n"
+              << "  -T <ms>        first frame timeout (default 5000)\n"
+              << "  -C <file>      base pipeline config (applied before the options above)\n";
+}
+
+RunResult runOnce(const Options& opts, int threads) {
+    RunResult result;
+    MediaManager manager;
+    manager.setStartupThreads(threads);
+
+    std::vector<std::unique_ptr<FirstFrame>> firsts;
+    for (int i = 0; i < opts.streams; i++) {
+        PipelineConfig config = opts.base;
+        config.vi.devId = i;
+        config.vi.pipeId = i;
+        config.vi.chnId = 0;
+        config.vi.width = opts.width;
+        config.vi.height = opts.height;
+        config.vi.fps = opts.fps;
+        config.vpss[kVpssChnDisplay].enabled = opts.withVo;
+        config.vpss[kVpssChnYuv].enabled = true;
+        config.vpss[kVpssChnYuv].width = 640;
+        config.vpss[kVpssChnYuv].height = 360;
+        config.venc.fps = static_cast<uint32_t>(opts.fps);
+        config.venc.gop = static_cast<uint32_t>(opts.fps);
+
+        int index = manager.addPipeline(config);
+        if (index < 0) {
+            std::cerr << "[Bench] Failed to add pipeline " << i << std::endl;
+            return result;
+        }
+        std::shared_ptr<MediaPipeline> pipeline = manager.getPipeline(index);
+        firsts.push_back(std::unique_ptr<FirstFrame>(new FirstFrame()));
+
+        FirstFrame* first = firsts.back().get();
+        pipeline->getEncoderService()->setEncodeCallback([first](const EncodedFrame&) {
+            markFirst(first->encodedUs);
+        });
+        pipeline->getYUVService()->setYUVCallback([first](const VideoFrameRef&) {
+            markFirst(first->yuvUs);
+        });
+    }
+
+    unsigned services = MediaPipeline::kServiceEncoder | MediaPipeline::kServiceYuv;
+    if (opts.withVo) {
+        services |= MediaPipeline::kServiceOutput;
+    }
+
+    int64_t begin = nowUs();
+    result.ok = manager.start(services);
+    result.startMs = (nowUs() - begin) / 1000.0;
+    result.stages = manager.getStartupTimings();
+
+    // 等所有消费者拿到第一帧
+    int64_t deadline = begin + static_cast<int64_t>(opts.timeoutMs) * 1000;
+    while (nowUs() < deadline) {
+        bool all = true;
+        for (size_t i = 0; i < firsts.size(); i++) {
+            if (firsts[i]->encodedUs == 0 || firsts[i]->yuvUs == 0) {
+                all = false;
+                break;
+            }
+        }
+        if (all) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (size_t i = 0; i < firsts.size(); i++) {
+        int64_t enc = firsts[i]->encodedUs;
+        int64_t yuv = firsts[i]->yuvUs;
+        result.firstEncodedMs.push_back(enc > 0 ? (enc - begin) / 1000.0 : -1.0);
+        result.firstYuvMs.push_back(yuv > 0 ? (yuv - begin) / 1000.0 : -1.0);
+    }
+
+    manager.deinit();
+    return result;
+}
+
+double maxOf(const std::vector<double>& values) {
+    double m = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (values[i] < 0) {
+            return -1.0;
+        }
+        if (values[i] > m) {
+            m = values[i];
+        }
+    }
+    return m;
+}
+
+void printMs(double ms) {
+    if (ms < 0) {
+        printf(" %12s", "timeout");
+    } else {
+        printf(" %12.2f", ms);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    int threads = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:h:f:j:oT:C:")) != -1) {
+        switch (opt) {
+        case 'n': opts.streams = atoi(optarg); break;
+        case 'w': opts.width = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'h': opts.height = static_cast<uint32_t>(atoi(optarg)); break;
+        case 'f': opts.fps = atoi(optarg); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'o': opts.withVo = true; break;
+        case 'T': opts.timeoutMs = atoi(optarg); break;
+        case 'C':
+            if (!loadPipelineConfig(optarg, opts.base)) {
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.streams <= 0 || opts.fps <= 0 || opts.timeoutMs <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RunResult serial = runOnce(opts, 1);
+    RunResult parallel = runOnce(opts, threads);
+    if (!serial.ok || !parallel.ok) {
+        std::cerr << "[Bench] Startup failed" << std::endl;
+        return 1;
+    }
+
+    printf("\n%d x %ux%u@%d, consumers: venc yuv%s\n", opts.streams, opts.width, opts.height,
+           opts.fps, opts.withVo ? " vo" : "");
+    printf("\nparallel startup stages:\n");
+    for (size_t i = 0; i < parallel.stages.size(); i++) {
+        const StartupStageTiming& t = parallel.stages[i];
+        printf("  %-28s %8.2f ms +%8.2f ms\n", t.name.c_str(), t.startUs / 1000.0,
+               t.durationUs / 1000.0);
+    }
+
+    printf("\ntime to first frame (ms since start()):\n");
+    printf("%-8s %12s %12s %12s %12s\n", "stream", "serial venc", "serial yuv", "par venc",
+           "par yuv");
+    for (int i = 0; i < opts.streams; i++) {
+        printf("%-8d", i);
+        printMs(serial.firstEncodedMs[i]);
+        printMs(serial.firstYuvMs[i]);
+        printMs(parallel.firstEncodedMs[i]);
+        printMs(parallel.firstYuvMs[i]);
+        printf("\n");
+    }
+    printf("%-8s", "max");
+    printMs(maxOf(serial.firstEncodedMs));
+    printMs(maxOf(serial.firstYuvMs));
+    printMs(maxOf(parallel.firstEncodedMs));
+    printMs(maxOf(parallel.firstYuvMs));
+    printf("\n");
+
+    printf("\nstart(): serial %.2f ms, parallel %.2f ms (%.2fx)\n", serial.startMs, parallel.startMs,
+           parallel.startMs > 0 ? serial.startMs / parallel.startMs : 0.0);
+    return 0;
+}
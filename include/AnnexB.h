@@ -0,0 +1,74 @@
+#ifndef ANNEX_B_H
+#define ANNEX_B_H
+
+#include "VideoEncoderSvc.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Annex-B 码流工具（封装、打包模块共用）
+ */
+
+/**
+ * @brief 查找起始码（00 00 01 或 00 00 00 01）
+ *
+ * @param scLen 输出起始码长度（3 或 4）
+ * @return 起始码位置，没有时返回 size
+ */
+inline size_t findStartCode(const uint8_t* p, size_t size, size_t from, size_t& scLen) {
+    for (size_t i = from; i + 3 <= size; i++) {
+        if (p[i] != 0 || p[i + 1] != 0) {
+            continue;
+        }
+        if (p[i + 2] == 1) {
+            scLen = 3;
+            return i;
+        }
+        if (p[i + 2] == 0 && i + 3 < size && p[i + 3] == 1) {
+            scLen = 4;
+            return i;
+        }
+    }
+    scLen = 0;
+    return size;
+}
+
+/**
+ * @brief NAL 类型（nal 指向 NAL 头，不含起始码）
+ */
+inline int nalUnitType(const uint8_t* nal, bool h265) {
+    return h265 ? (nal[0] >> 1) & 0x3F : nal[0] & 0x1F;
+}
+
+/**
+ * @brief 按顺序遍历帧中的 NAL（不含起始码）
+ *
+ * 每个片段按起始码切分；片段开头没有起始码时整个片段作为一个 NAL。
+ *
+ * @param func 回调 func(const uint8_t* nal, size_t size)，size 不为 0
+ */
+template<typename F>
+void forEachNal(const EncodedFrame& frame, F&& func) {
+    for (int i = 0; i < frame.segmentCount; i++) {
+        const uint8_t* p = frame.segments[i].data;
+        size_t size = frame.segments[i].size;
+
+        size_t scLen = 0;
+        size_t pos = findStartCode(p, size, 0, scLen);
+        if (pos == size) {
+            pos = 0;
+        }
+        while (pos < size) {
+            size_t begin = pos + scLen;
+            size_t nextLen = 0;
+            size_t next = findStartCode(p, size, begin, nextLen);
+            if (next > begin) {
+                func(p + begin, next - begin);
+            }
+            pos = next;
+            scLen = nextLen;
+        }
+    }
+}
+
+#endif // ANNEX_B_H
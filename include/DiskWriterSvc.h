@@ -0,0 +1,203 @@
+#ifndef DISK_WRITER_SVC_H
+#define DISK_WRITER_SVC_H
+
+#include "ServiceBase.h"
+#include "VideoEncoderSvc.h"
+#include "VideoFrame.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+/**
+ * @brief 写盘服务参数
+ */
+struct DiskWriterConfig {
+    size_t bufferBytes = 64 * 1024 * 1024;   // 缓冲总预算（所有文件共用，用完即背压）
+    size_t chunkBytes = 4 * 1024 * 1024;     // 缓冲块大小，写盘的基本单位（alignment 的整数倍）
+    uint32_t maxBatchChunks = 8;             // 一次 pwritev 最多合并的连续缓冲块数
+    uint32_t flushIntervalMs = 1000;         // 未写满的缓冲块最长滞留时间
+    uint32_t blockMs = 0;                    // 缓冲不足时写入方最多等待的时间，0 表示立即丢弃
+    bool directIo = true;                    // O_DIRECT 写盘（文件系统不支持时退回普通写）
+    size_t alignment = 4096;                 // O_DIRECT 的地址/长度/偏移对齐
+};
+
+/**
+ * @brief 异步批量写盘服务
+ *
+ * 写入方（编码/YUV 订阅者回调等）调用 write() 只把数据拷贝进对齐的缓冲块，立即返回，
+ * 不持有 VENC/VPSS 缓冲区，也不等待磁盘；服务线程把写满的缓冲块按文件偏移合并，
+ * 一次 pwritev 写出多块，O_DIRECT 下绕过页缓存，大流量转储不会挤占内存、
+ * 也不会因脏页回写造成周期性的长时间阻塞。
+ *
+ * 背压：缓冲块总数由 bufferBytes 决定，写满后 write() 最多等待 blockMs，
+ * 仍没有空闲缓冲块时整帧丢弃并计数（不会写入半帧）。
+ *
+ * 未写满的缓冲块最多滞留 flushIntervalMs 后写出一次（O_DIRECT 下补齐到对齐长度，
+ * 之后随新数据覆盖重写），closeFile() 时截断到实际长度并 fdatasync。
+ *
+ * 线程安全：所有公开接口可在任意线程调用，同一文件的写入按调用顺序落盘。
+ */
+class DiskWriterSvc : public ServiceBase {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        uint64_t bytesAccepted;     // 写入方提交成功的字节数
+        uint64_t bytesWritten;      // 写到文件的字节数（含 O_DIRECT 补齐与重写）
+        uint64_t writeCalls;        // 写盘系统调用次数
+        uint64_t droppedWrites;     // 缓冲不足丢弃的写入次数
+        uint64_t droppedBytes;      // 丢弃的字节数
+        uint64_t writeErrors;       // 写盘失败次数
+        size_t bufferedBytes;       // 当前占用的缓冲（按块计）
+        size_t peakBufferedBytes;   // 占用缓冲高水位
+        uint64_t latencyP50Us;      // 写盘调用耗时分位数（最近 kLatencyWindow 次）
+        uint64_t latencyP95Us;
+        uint64_t latencyP99Us;
+        uint64_t latencyMaxUs;
+    };
+
+    static const size_t kLatencyWindow = 4096;
+
+    explicit DiskWriterSvc(const DiskWriterConfig& config = DiskWriterConfig());
+    ~DiskWriterSvc() override;
+
+    /**
+     * @brief 打开（截断）文件
+     *
+     * @param maxBytes 文件大小上限，写入会超出时截断文件从头写，0 表示不限
+     * @return 文件编号，失败返回 -1
+     */
+    int openFile(const std::string& path, uint64_t maxBytes = 0);
+
+    /**
+     * @brief 写出剩余数据、截断到实际长度、fdatasync 并关闭
+     */
+    bool closeFile(int file);
+
+    /**
+     * @brief 追加数据（多段按顺序拼接为一次写入，要么全部接受要么全部丢弃）
+     */
+    bool write(int file, const iovec* iov, int count);
+    bool write(int file, const void* data, size_t size);
+
+    /**
+     * @brief 追加一帧码流（所有片段）
+     */
+    bool write(int file, const EncodedFrame& frame);
+
+    /**
+     * @brief 追加一帧 YUV（frame.data 起的 frame.size 字节）
+     */
+    bool write(int file, const VideoFrame& frame);
+
+    /**
+     * @brief 当前写入的字节数（截断从头写后重新计数）
+     */
+    uint64_t fileSize(int file) const;
+
+    Stats stats() const;
+
+protected:
+    void run() override;
+
+private:
+    struct Chunk {
+        uint8_t* data;
+        size_t fill = 0;               // 已拷入的字节数
+        size_t flushed = 0;            // 已写到文件的字节数（部分写出后）
+        uint64_t fileOffset = 0;       // 在文件中的偏移
+        bool restart = false;          // 写之前先截断文件（文件达到上限后从头写）
+        std::chrono::steady_clock::time_point dirtySince;  // 最早未写出数据的时间
+    };
+
+    struct File {
+        int id;
+        std::string path;
+        int fd = -1;
+        bool direct = false;
+        uint64_t maxBytes = 0;
+        bool errorLogged = false;      // 写盘失败只打印一次（服务线程）
+
+        // 写入方（mutex 保护）
+        std::mutex mutex;
+        Chunk* current = nullptr;      // 正在填充的缓冲块
+        uint64_t size = 0;             // 逻辑长度
+        uint64_t nextChunkOffset = 0;
+        bool restartNext = false;
+        bool closing = false;
+    };
+
+    /**
+     * @brief 追加到当前缓冲块（持有 file.mutex）
+     */
+    bool append(const std::shared_ptr<File>& file, const iovec* iov, int count, size_t total);
+
+    /**
+     * @brief 申请 count 个空闲缓冲块，不足时按 blockMs 等待
+     */
+    bool reserveChunks(size_t count, std::vector<Chunk*>& out);
+
+    /**
+     * @brief 把缓冲块交给服务线程写盘（持有 file.mutex）
+     */
+    void sealChunk(const std::shared_ptr<File>& file, Chunk* chunk);
+
+    /**
+     * @brief 是否还有该文件的缓冲块等待写盘
+     */
+    bool hasPending(const File* file) const;
+
+    // 写盘（持有 m_ioMutex：一般在服务线程，closeFile() 时在调用方线程）
+    void writePending();
+    void flushPartial(bool force);
+    void writeChunks(File& file, Chunk* const* chunks, size_t count);
+    void recycle(Chunk* chunk);
+    bool pwriteAll(File& file, const iovec* iov, int count, uint64_t offset);
+    void recordLatency(uint64_t us);
+
+    std::shared_ptr<File> findFile(int file) const;
+
+    const DiskWriterConfig m_config;
+
+    const size_t m_chunkBytes;           // 按 alignment 对齐后的缓冲块大小
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_chunkFreed;
+    uint8_t* m_arena = nullptr;          // 所有缓冲块（一次对齐分配）
+    std::vector<Chunk> m_chunks;
+    std::vector<Chunk*> m_freeChunks;
+    std::deque<std::pair<std::shared_ptr<File>, Chunk*>> m_pending;  // 写满待写盘
+    std::map<int, std::shared_ptr<File>> m_files;
+    int m_nextFileId = 0;
+
+    // 写盘串行（m_ioMutex 保护）
+    std::mutex m_ioMutex;
+    std::vector<std::pair<std::shared_ptr<File>, Chunk*>> m_batch;
+    std::vector<Chunk*> m_group;
+    std::vector<iovec> m_iov;
+    uint8_t* m_tailBlock = nullptr;      // 部分写出时未写满的最后一个对齐块的副本（alignment 字节）
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+    std::vector<uint32_t> m_latencies;   // 环形窗口
+    size_t m_latencyNext = 0;
+
+    /**
+     * @brief 采集时把 Stats 换算成指标
+     */
+    void collectMetrics(MetricsWriter& writer);
+
+    std::shared_ptr<MetricHistogram> m_writeMetric;
+    MetricsCollectorHandle m_metricsCollector;  // 最后一个成员：最先析构，先移除 collector
+};
+
+#endif // DISK_WRITER_SVC_H
@@ -0,0 +1,111 @@
+#ifndef ENCODED_FRAME_RING_H
+#define ENCODED_FRAME_RING_H
+
+#include "VideoEncoderSvc.h"
+#include "PacketBufferPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 编码帧预录环形缓冲（事件录像的 pre-roll）
+ *
+ * 按字节预算保存最近的编码帧，并维护关键帧索引：
+ * - 超出预算时从最旧的帧开始淘汰（每帧 O(1)），淘汰关键帧后同一 GOP 剩余的帧
+ *   已无法解码，一并淘汰，缓冲总是从关键帧开始
+ * - extract() 从指定时间之前最近的关键帧开始取出一段帧，取出的帧与缓冲共享数据，不拷贝
+ *
+ * 零拷贝模式的帧（EncodedFrame::zeroCopy）借用 VENC 输出缓冲，放入缓冲时拷贝到
+ * PacketBufferPool，避免长时间占用 VENC 缓冲；其他帧直接共享引用。
+ *
+ * 时间戳为 EncodedFrame::timestamp（VENC PTS，微秒），要求单调递增。
+ */
+class EncodedFrameRing {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        size_t frames;             // 当前帧数
+        size_t keyFrames;          // 当前关键帧数
+        size_t bytes;              // 当前数据字节数（按 EncodedFrame::size 计）
+        size_t byteBudget;         // 字节预算
+        uint64_t oldestTimestamp;  // 最旧帧时间戳（为空时 0）
+        uint64_t newestTimestamp;  // 最新帧时间戳（为空时 0）
+        uint64_t pushed;           // 放入的帧数
+        uint64_t evicted;          // 被淘汰的帧数
+        uint64_t dropped;          // 未放入的帧数（单帧超出预算、等待关键帧、拷贝失败）
+    };
+
+    /**
+     * @param byteBudget 字节预算（建议至少为 预录时长 + 一个 GOP 的码流大小）
+     * @param pool       零拷贝帧转存用的缓冲池
+     */
+    explicit EncodedFrameRing(size_t byteBudget,
+                              std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::shared());
+
+    EncodedFrameRing(const EncodedFrameRing&) = delete;
+    EncodedFrameRing& operator=(const EncodedFrameRing&) = delete;
+
+    /**
+     * @brief 放入一帧（取流线程调用）
+     */
+    void push(const EncodedFrame& frame);
+
+    /**
+     * @brief 取出一段帧
+     *
+     * 从时间戳 <= fromTimestamp 的最近关键帧开始（fromTimestamp 早于缓冲中所有关键帧时
+     * 从最旧的关键帧开始），到时间戳 <= toTimestamp 的最后一帧为止。
+     *
+     * @param out 追加输出，帧数据与缓冲共享
+     * @return 取出的帧数，没有关键帧时为 0
+     */
+    size_t extract(uint64_t fromTimestamp, uint64_t toTimestamp, std::vector<EncodedFrame>& out) const;
+
+    /**
+     * @brief 取出最近 durationUs 微秒（从其之前最近的关键帧开始）到最新的帧
+     */
+    size_t extractLast(uint64_t durationUs, std::vector<EncodedFrame>& out) const;
+
+    /**
+     * @brief 清空缓冲（下一帧关键帧开始重新缓存）
+     */
+    void clear();
+
+    /**
+     * @brief 获取统计信息
+     */
+    Stats stats() const;
+
+private:
+    /**
+     * @brief 淘汰最旧的一帧（调用方持有 m_mutex）
+     */
+    void evictFront();
+
+    /**
+     * @brief 在关键帧索引中找时间戳 <= timestamp 的最近关键帧（调用方持有 m_mutex）
+     * @return 帧序号
+     */
+    uint64_t findKeyFrame(uint64_t timestamp) const;
+
+    const size_t m_byteBudget;
+    std::shared_ptr<PacketBufferPool> m_pool;
+
+    mutable std::mutex m_mutex;
+    std::deque<EncodedFrame> m_frames;
+    std::deque<uint64_t> m_keyFrames;  // 关键帧的帧序号（递增）
+    uint64_t m_headSeq = 0;            // m_frames.front() 的帧序号
+    size_t m_bytes = 0;
+    bool m_waitKeyFrame = true;        // 丢帧后等到下一个关键帧再缓存
+
+    uint64_t m_pushed = 0;
+    uint64_t m_evicted = 0;
+    uint64_t m_dropped = 0;
+};
+
+#endif // ENCODED_FRAME_RING_H
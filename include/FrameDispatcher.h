@@ -0,0 +1,332 @@
+#ifndef FRAME_DISPATCHER_H
+#define FRAME_DISPATCHER_H
+
+#include "LockFreeRing.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief 订阅者队列满时的处理策略
+ */
+enum class OverflowPolicy {
+    DropOldest,  // 丢弃队列中最旧的一项，保证最新数据入队
+    DropNewest,  // 丢弃新到的数据
+    Block,       // 阻塞发布线程直到有空位（只适合不允许丢帧且消费足够快的场景）
+};
+
+/**
+ * @brief 订阅者统计
+ */
+struct SubscriberStats {
+    uint64_t delivered;  // 已回调次数
+    uint64_t dropped;    // 因队列满丢弃的次数
+    size_t   queued;     // 当前排队数（近似值）
+};
+
+/**
+ * @brief 异步多订阅者分发器
+ *
+ * 每个订阅者拥有独立的有界无锁队列和工作线程，慢速订阅者只会影响自己的队列，
+ * 不会阻塞发布线程（Block 策略除外）。
+ *
+ * 订阅者存放在固定大小的槽位中，发布路径只读取原子指针，不加锁；
+ * 移除订阅者时先清空槽位，再等待正在进行的 publish() 结束后才回收。
+ *
+ * 注意：不能在订阅者自己的回调中移除该订阅者。
+ */
+template<typename T>
+class FrameDispatcher {
+public:
+    using Callback = std::function<void(const T&)>;
+
+    static const int kMaxSubscribers = 8;
+
+    FrameDispatcher() {
+        for (int i = 0; i < kMaxSubscribers; i++) {
+            m_slots[i].store(nullptr);
+        }
+    }
+
+    ~FrameDispatcher() { removeAll(); }
+
+    // 禁止拷贝
+    FrameDispatcher(const FrameDispatcher&) = delete;
+    FrameDispatcher& operator=(const FrameDispatcher&) = delete;
+
+    /**
+     * @brief 添加订阅者（启动工作线程）
+     *
+     * @param name     订阅者名称（日志用）
+     * @param callback 回调，在订阅者自己的工作线程中执行
+     * @param capacity 队列容量（向上取整为 2 的幂）
+     * @param policy   队列满时的处理策略
+     * @return 订阅者ID，槽位已满返回 -1
+     */
+    int addSubscriber(const std::string& name, Callback callback, size_t capacity,
+                      OverflowPolicy policy) {
+        std::lock_guard<std::mutex> lock(m_manageMutex);
+        for (int i = 0; i < kMaxSubscribers; i++) {
+            if (m_slots[i].load() == nullptr) {
+                Subscriber* sub = new Subscriber(name, std::move(callback), capacity, policy);
+                sub->start();
+                m_slots[i].store(sub, std::memory_order_release);
+                m_count.fetch_add(1);
+                return i;
+            }
+        }
+        std::cerr << "[FrameDispatcher] No free subscriber slot for " << name << std::endl;
+        return -1;
+    }
+
+    /**
+     * @brief 移除订阅者（停止工作线程，丢弃未处理的数据）
+     */
+    bool removeSubscriber(int id) {
+        if (id < 0 || id >= kMaxSubscribers) {
+            return false;
+        }
+
+        Subscriber* sub;
+        {
+            std::lock_guard<std::mutex> lock(m_manageMutex);
+            sub = m_slots[id].load();
+            if (!sub) {
+                return false;
+            }
+            if (sub->isWorkerThread()) {
+                std::cerr << "[FrameDispatcher] Subscriber " << sub->name
+                          << " cannot remove itself from its callback" << std::endl;
+                return false;
+            }
+            m_slots[id].store(nullptr);
+            m_count.fetch_sub(1);
+        }
+
+        // 先请求停止，唤醒可能因 Block 策略阻塞在该订阅者上的 publish()
+        sub->requestStop();
+
+        // 等待可能仍在使用该订阅者的 publish() 结束
+        while (m_publishing.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        sub->join();
+        delete sub;
+        return true;
+    }
+
+    /**
+     * @brief 移除所有订阅者
+     */
+    void removeAll() {
+        for (int i = 0; i < kMaxSubscribers; i++) {
+            removeSubscriber(i);
+        }
+    }
+
+    /**
+     * @brief 发布一项数据给所有订阅者（无锁）
+     */
+    void publish(const T& item) {
+        if (m_count.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+
+        m_publishing.fetch_add(1);
+        for (int i = 0; i < kMaxSubscribers; i++) {
+            // 必须是 seq_cst（见 m_publishing 的说明），acquire 不足以保证移除方看到本次 publish
+            Subscriber* sub = m_slots[i].load();
+            if (sub) {
+                sub->push(item);
+            }
+        }
+        m_publishing.fetch_sub(1);
+    }
+
+    /**
+     * @brief 是否有订阅者
+     */
+    bool hasSubscribers() const { return m_count.load() > 0; }
+
+    /**
+     * @brief 获取订阅者统计
+     */
+    bool getStats(int id, SubscriberStats& stats) const {
+        std::lock_guard<std::mutex> lock(m_manageMutex);
+        if (id < 0 || id >= kMaxSubscribers) {
+            return false;
+        }
+        Subscriber* sub = m_slots[id].load();
+        if (!sub) {
+            return false;
+        }
+        stats.delivered = sub->delivered.load();
+        stats.dropped = sub->dropped.load();
+        stats.queued = sub->ring.sizeApprox();
+        return true;
+    }
+
+    /**
+     * @brief 遍历所有订阅者的统计（采集指标用）
+     *
+     * @param func 以 (const std::string& name, const SubscriberStats& stats) 调用
+     */
+    template<typename F>
+    void forEachStats(F func) const {
+        std::lock_guard<std::mutex> lock(m_manageMutex);
+        for (int i = 0; i < kMaxSubscribers; i++) {
+            Subscriber* sub = m_slots[i].load();
+            if (!sub) {
+                continue;
+            }
+            SubscriberStats stats;
+            stats.delivered = sub->delivered.load();
+            stats.dropped = sub->dropped.load();
+            stats.queued = sub->ring.sizeApprox();
+            func(sub->name, stats);
+        }
+    }
+
+private:
+    struct Subscriber {
+        std::string name;
+        Callback callback;
+        OverflowPolicy policy;
+        LockFreeRing<T> ring;
+        std::thread worker;
+        std::atomic<bool> running{false};
+
+        // 空闲等待：只有对端声明正在等待时才加锁通知
+        std::mutex waitMutex;
+        std::condition_variable dataCv;
+        std::condition_variable spaceCv;
+        std::atomic<bool> consumerWaiting{false};
+        std::atomic<bool> producerWaiting{false};
+
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+
+        Subscriber(const std::string& n, Callback cb, size_t capacity, OverflowPolicy p)
+            : name(n), callback(std::move(cb)), policy(p), ring(capacity) {}
+
+        void start() {
+            running.store(true);
+            worker = std::thread([this]() { workerLoop(); });
+        }
+
+        void requestStop() {
+            running.store(false);
+            std::lock_guard<std::mutex> lock(waitMutex);
+            dataCv.notify_all();
+            spaceCv.notify_all();
+        }
+
+        void join() {
+            if (worker.joinable()) {
+                worker.join();
+            }
+            T item;
+            while (ring.tryPop(item)) {
+            }
+        }
+
+        bool isWorkerThread() const { return std::this_thread::get_id() == worker.get_id(); }
+
+        void push(const T& item) {
+            T value(item);
+            if (!ring.tryPush(std::move(value))) {
+                switch (policy) {
+                case OverflowPolicy::DropNewest:
+                    dropped.fetch_add(1);
+                    return;
+                case OverflowPolicy::DropOldest: {
+                    T oldest;
+                    while (!ring.tryPush(std::move(value))) {
+                        if (ring.tryPop(oldest)) {
+                            oldest = T();  // 立即释放被丢弃数据的引用
+                            dropped.fetch_add(1);
+                        }
+                    }
+                    break;
+                }
+                case OverflowPolicy::Block:
+                    while (!ring.tryPush(std::move(value))) {
+                        if (!running.load()) {
+                            dropped.fetch_add(1);
+                            return;
+                        }
+                        std::unique_lock<std::mutex> lock(waitMutex);
+                        producerWaiting.store(true);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        if (ring.sizeApprox() >= ring.capacity()) {
+                            spaceCv.wait_for(lock, std::chrono::milliseconds(10));
+                        }
+                        producerWaiting.store(false);
+                    }
+                    break;
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (consumerWaiting.load()) {
+                std::lock_guard<std::mutex> lock(waitMutex);
+                dataCv.notify_one();
+            }
+        }
+
+        void workerLoop() {
+            T item;
+            while (running.load()) {
+                if (ring.tryPop(item)) {
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (producerWaiting.load()) {
+                        std::lock_guard<std::mutex> lock(waitMutex);
+                        spaceCv.notify_one();
+                    }
+
+                    try {
+                        callback(item);
+                    } catch (const std::exception& e) {
+                        std::cerr << "[FrameDispatcher] Subscriber " << name
+                                  << " callback exception: " << e.what() << std::endl;
+                    }
+                    item = T();  // 尽快释放数据引用（例如 VPSS/VENC 缓冲区）
+                    delivered.fetch_add(1);
+                    continue;
+                }
+
+                // 队列空：声明等待后再检查一次，避免错过发布方的通知
+                std::unique_lock<std::mutex> lock(waitMutex);
+                consumerWaiting.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (ring.emptyApprox() && running.load()) {
+                    dataCv.wait_for(lock, std::chrono::milliseconds(100));
+                }
+                consumerWaiting.store(false);
+            }
+        }
+    };
+
+    std::atomic<Subscriber*> m_slots[kMaxSubscribers];
+    std::atomic<int> m_count{0};
+    /**
+     * @brief 正在执行的 publish() 个数
+     *
+     * 与 m_slots 构成 Dekker 式握手，双方的四个操作都必须是 seq_cst：
+     * - publish()：m_publishing 加一，然后读 m_slots[i]
+     * - removeSubscriber()：m_slots[id] 置空，然后读 m_publishing，直到为 0 才删除订阅者
+     * 这样要么 publish() 读到 nullptr，要么移除方读到非 0 并等待其结束，不会删除仍在使用的订阅者。
+     * 任一侧放宽为 acquire/release 时，两边可能同时读到旧值（store-buffer 重排）。
+     */
+    std::atomic<int> m_publishing{0};
+    mutable std::mutex m_manageMutex;  // 只保护订阅者的添加/移除
+};
+
+#endif // FRAME_DISPATCHER_H
@@ -0,0 +1,150 @@
+#ifndef FRAME_SEQUENCE_TRACKER_H
+#define FRAME_SEQUENCE_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief 丢帧告警
+ */
+struct FrameDropAlert {
+    std::string stage;       // 阶段名（"venc"、"yuv"）
+    bool active;             // true：丢帧率超过阈值；false：已恢复
+    double dropRate;         // 窗口内丢帧率（丢帧数 / 应到帧数）
+    uint64_t windowFrames;   // 窗口内收到的帧数
+    uint64_t windowDropped;  // 窗口内丢失的帧数
+};
+
+/**
+ * @brief 帧连续性检查参数
+ */
+struct FrameSequenceConfig {
+    double fps = 0;                    // 期望帧率，<= 0 表示从帧间隔学习
+    uint32_t seqStep = 1;              // 相邻帧的序号差（VI 的 u32TimeRef 按场计数时为 2）
+    double lateIntervals = 3.0;        // 迟到阈值（帧间隔倍数）
+    uint32_t windowMs = 1000;          // 丢帧率统计窗口
+    double dropRateThreshold = 0.05;   // 告警阈值
+};
+
+/**
+ * @brief 逐帧序号 / PTS 连续性检查
+ *
+ * MPI 在下游取帧不及时时会直接丢帧（VPSS 输出队列满、VENC 码流缓冲满），取帧一侧只会看到
+ * 超时或 BUF_EMPTY，本身察觉不到。这里对每个阶段取到的帧检查：
+ * - 丢帧：PTS 间隔按期望帧间隔折算缺了几帧；有序号时同时按序号差计算，取两者较大值
+ * - 重复：PTS 不大于上一帧（或序号相同），这类帧不更新基准
+ * - 迟到：取到帧时距采集超过 lateIntervals 个帧间隔
+ *
+ * 期望帧间隔取配置的帧率；帧率未知（<= 0）时用前 kLearnFrames 个间隔中的最小值。
+ * 每 windowMs 统计一次丢帧率，超过 dropRateThreshold 时调用告警回调，降到阈值一半以下时
+ * 再调用一次（active=false）。上游完全停止出帧时窗口由 noteTimeout() / checkStall() 关闭，
+ * 上一帧之后应到而未到的帧先按丢帧计入，之后的帧按 PTS 间隔核对（帧只是迟到时扣回）。
+ *
+ * observe()、noteTimeout()、checkStall()、stallCheckMs() 只应在一个线程（服务线程）中调用；
+ * stats() 可在任意线程调用。告警回调在服务线程中执行，不要在回调中做耗时操作。
+ */
+class FrameSequenceTracker {
+public:
+    using AlertCallback = std::function<void(const FrameDropAlert&)>;
+
+    struct Stats {
+        uint64_t frames;          // 收到的帧数
+        uint64_t dropped;         // 推算丢失的帧数
+        uint64_t duplicated;      // 重复或乱序的帧数
+        uint64_t late;            // 迟到的帧数
+        uint64_t timeouts;        // 取帧超时次数
+        uint64_t alerts;          // 告警次数
+        uint64_t maxGapUs;        // 最大 PTS 间隔
+        uint64_t intervalUs;      // 当前使用的期望帧间隔（0 表示尚未确定）
+        double windowDropRate;    // 最近一个完整窗口的丢帧率
+    };
+
+    static const int kLearnFrames = 16;
+
+    explicit FrameSequenceTracker(const std::string& stage, const FrameSequenceConfig& config = FrameSequenceConfig());
+
+    FrameSequenceTracker(const FrameSequenceTracker&) = delete;
+    FrameSequenceTracker& operator=(const FrameSequenceTracker&) = delete;
+
+    /**
+     * @brief 修改配置（清空连续性基准，统计保留）
+     */
+    void setConfig(const FrameSequenceConfig& config);
+    FrameSequenceConfig config() const;
+
+    void setAlertCallback(AlertCallback callback);
+
+    /**
+     * @brief 记录取到的一帧
+     *
+     * @param pts    帧 PTS（微秒，CLOCK_MONOTONIC）
+     * @param nowUs  取到帧的时间
+     * @param seq    帧序号（hasSeq 为 false 时忽略）
+     */
+    void observe(uint64_t pts, uint64_t nowUs, uint32_t seq = 0, bool hasSeq = false);
+
+    /**
+     * @brief 记录一次取帧超时（队列空），并检查停顿
+     */
+    void noteTimeout(uint64_t nowUs);
+
+    /**
+     * @brief 到 nowUs 为止没有取到帧：窗口到期时把停顿期间应到的帧计为丢帧并关闭窗口
+     */
+    void checkStall(uint64_t nowUs);
+
+    /**
+     * @brief 距当前窗口到期的毫秒数（不超过 maxMs），服务线程空闲等待时用作超时，
+     *        保证上游停顿时告警在一个窗口内发出
+     */
+    int stallCheckMs(uint64_t nowUs, int maxMs) const;
+
+    /**
+     * @brief 重新开始连续性检查（通道重建、暂停恢复后调用，避免把停顿算成丢帧）
+     */
+    void resetSequence();
+
+    Stats stats() const;
+    const std::string& stage() const { return m_stage; }
+
+private:
+    void closeWindow(uint64_t nowUs);
+
+    const std::string m_stage;
+
+    mutable std::mutex m_configMutex;  // 保护配置与回调
+    FrameSequenceConfig m_config;
+    AlertCallback m_callback;
+    std::atomic<bool> m_resetPending{true};  // 配置变化或请求重置，下一帧时生效
+
+    // 服务线程独占
+    FrameSequenceConfig m_active;
+    uint64_t m_intervalUs = 0;
+    uint64_t m_learnedUs = 0;
+    int m_learnCount = 0;
+    bool m_havePrev = false;
+    uint64_t m_prevPts = 0;
+    uint64_t m_prevArrivalUs = 0;
+    uint64_t m_stallDropped = 0;  // 上一帧之后按停顿计入的丢帧数，下一帧到达时按 PTS 间隔核对
+    uint32_t m_prevSeq = 0;
+    bool m_prevHasSeq = false;
+    uint64_t m_windowStart = 0;
+    uint64_t m_windowFrames = 0;
+    uint64_t m_windowDropped = 0;
+    bool m_alerting = false;
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_duplicated{0};
+    std::atomic<uint64_t> m_late{0};
+    std::atomic<uint64_t> m_timeouts{0};
+    std::atomic<uint64_t> m_alerts{0};
+    std::atomic<uint64_t> m_maxGapUs{0};
+    std::atomic<uint64_t> m_currentIntervalUs{0};
+    std::atomic<uint32_t> m_windowRatePpm{0};
+};
+
+#endif // FRAME_SEQUENCE_TRACKER_H
@@ -0,0 +1,209 @@
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 对数分桶的时延直方图（HDR 风格，微秒）
+ *
+ * 小于 128us 的值精确计数；更大的值每个 2 的幂区间分 64 个桶，相对误差约 1.6%，
+ * 覆盖到约 19 小时（更大的值计入最后一个桶）。记录只做几次原子加，可在任意线程并发调用。
+ */
+class LatencyHistogram {
+public:
+    static const int kSubBucketBits = 7;
+    static const uint64_t kSubBuckets = 1u << kSubBucketBits;      // 128
+    static const uint64_t kHalfSubBuckets = kSubBuckets / 2;        // 64
+    static const int kMaxShift = 29;
+    static const size_t kBucketCount = kSubBuckets + kMaxShift * kHalfSubBuckets;
+
+    LatencyHistogram();
+
+    void record(uint64_t us);
+    void reset();
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t min() const;
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    /**
+     * @brief 分位数（q 取 0~1），没有样本时返回 0
+     */
+    uint64_t percentile(double q) const;
+
+private:
+    static size_t bucketIndex(uint64_t us);
+    static uint64_t bucketValue(size_t index);  // 桶的代表值（区间中点）
+
+    std::atomic<uint64_t> m_buckets[kBucketCount];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+};
+
+/**
+ * @brief 端到端逐帧时延追踪
+ *
+ * 以 VI 采集时间戳（VIDEO_FRAME_S::u64PTS，VPSS/VENC 输出沿用同一值）为起点，
+ * 在各阶段记录帧的"年龄"（当前时间 - 采集时间）：
+ * - vpss-output：YUV 通道 RK_MPI_VPSS_GetChnFrame 取到帧
+ * - yuv-delivery：YUV 帧交给回调/订阅者之前
+ * - venc-output：RK_MPI_VENC_GetStream 取到码流
+ * - venc-delivery：码流交给回调/订阅者之前（零拷贝退化时含拷贝耗时）
+ * - 每个回调/订阅者返回时（按名称分别统计，同时统计回调耗时）
+ *
+ * MPI 的 PTS 与 nowUs() 都是 CLOCK_MONOTONIC 微秒，可以直接相减；PTS 为 0 或晚于当前时间
+ * 超过 1 秒的帧视为时间戳无效，只计数不记录。
+ *
+ * 各阶段直方图可在运行中随时查询；最近 traceEvents 个事件保存在环形缓冲中，
+ * exportChromeTrace() 导出为 Chrome/Perfetto 可打开的 JSON（chrome://tracing 或 ui.perfetto.dev）：
+ * 每帧从采集到各阶段是一组异步区间，回调按订阅者各占一行。
+ *
+ * 由 MediaPipeline::enableLatencyTracing() 创建并交给该路的编码与 YUV 服务。
+ */
+class LatencyTracer {
+public:
+    enum Stage {
+        kStageVpssOutput,
+        kStageYuvDelivery,
+        kStageVencOutput,
+        kStageVencDelivery,
+        kStageCount,
+    };
+
+    /**
+     * @brief 回调所属的数据通路
+     */
+    enum Path {
+        kPathYuv,
+        kPathVenc,
+    };
+
+    /**
+     * @brief 一个阶段（或回调）的统计
+     */
+    struct Summary {
+        std::string name;   // 阶段名，回调为 "yuv/<订阅者>"、"venc/<订阅者>"
+        uint64_t count;
+        uint64_t minUs;     // 采集到该阶段的时延
+        uint64_t p50Us;
+        uint64_t p90Us;
+        uint64_t p99Us;
+        uint64_t maxUs;
+        double meanUs;
+        uint64_t callbackP99Us;  // 回调耗时 p99（阶段为 0）
+        uint64_t callbackMaxUs;
+    };
+
+    static const size_t kDefaultTraceEvents = 65536;
+    static const int kMaxConsumers = 32;
+
+    /**
+     * @param name        名称（导出时作为进程名）
+     * @param traceEvents 环形缓冲保存的事件数，0 表示只统计直方图
+     */
+    explicit LatencyTracer(const std::string& name = "pipeline",
+                           size_t traceEvents = kDefaultTraceEvents);
+
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    /**
+     * @brief 当前时间（CLOCK_MONOTONIC，微秒，与 MPI PTS 同一时钟）
+     */
+    static uint64_t nowUs();
+
+    /**
+     * @brief 记录帧到达某阶段
+     */
+    void recordStage(Stage stage, uint64_t pts, uint64_t now);
+
+    /**
+     * @brief 记录一次回调（startUs 回调开始，endUs 回调返回）
+     */
+    void recordCallback(Path path, const std::string& consumer, uint64_t pts,
+                        uint64_t startUs, uint64_t endUs);
+
+    /**
+     * @brief 某阶段的统计
+     */
+    Summary summary(Stage stage) const;
+
+    /**
+     * @brief 所有阶段及回调的统计（阶段在前，回调按首次出现顺序）
+     */
+    std::vector<Summary> summaries() const;
+
+    /**
+     * @brief 时间戳无效而未记录的次数
+     */
+    uint64_t invalidTimestamps() const { return m_invalid.load(); }
+
+    /**
+     * @brief 清空直方图与事件
+     */
+    void reset();
+
+    const std::string& name() const { return m_name; }
+
+    static const char* stageName(Stage stage);
+
+    /**
+     * @brief 导出 Chrome trace JSON
+     */
+    bool exportChromeTrace(const std::string& path) const;
+
+    /**
+     * @brief 多路导出到同一文件（每个追踪器一个进程）
+     */
+    static bool exportChromeTrace(const std::string& path,
+                                  const std::vector<const LatencyTracer*>& tracers);
+
+private:
+    struct Consumer {
+        Path path;
+        std::string name;
+        std::string label;           // "yuv/<name>"
+        LatencyHistogram age;        // 回调返回时的帧年龄
+        LatencyHistogram duration;   // 回调耗时
+    };
+
+    struct TraceEvent {
+        uint64_t pts;
+        uint64_t ts;        // 阶段事件为到达时间，回调为开始时间
+        uint32_t dur;       // 回调耗时（阶段为 0）
+        int32_t track;      // < kStageCount 为阶段，否则为 kStageCount + 回调下标
+    };
+
+    bool validAge(uint64_t pts, uint64_t now, uint64_t& age);
+    void pushEvent(const TraceEvent& event);
+    void pushEventLocked(const TraceEvent& event);
+
+    /**
+     * @brief 查找回调统计，首次出现时添加（持有 m_mutex），超出上限返回 -1
+     */
+    int findConsumer(Path path, const std::string& name);
+    void appendEvents(std::string& json, int pid) const;
+
+    static Summary makeSummary(const std::string& name, const LatencyHistogram& age);
+
+    const std::string m_name;
+    LatencyHistogram m_stages[kStageCount];
+    std::atomic<uint64_t> m_invalid{0};
+
+    mutable std::mutex m_mutex;                        // 保护回调列表与事件缓冲
+    std::vector<std::unique_ptr<Consumer>> m_consumers;
+    std::vector<TraceEvent> m_events;                  // 环形缓冲
+    size_t m_eventNext = 0;
+    size_t m_eventCount = 0;
+};
+
+#endif // LATENCY_TRACER_H
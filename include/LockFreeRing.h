@@ -0,0 +1,131 @@
+#ifndef LOCK_FREE_RING_H
+#define LOCK_FREE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief 有界无锁环形队列
+ *
+ * 基于 Dmitry Vyukov 的有界 MPMC 队列算法：每个槽位带序号，
+ * 生产者/消费者各自通过 CAS 推进位置，不需要互斥锁。
+ * 多生产者/多消费者均安全（ServiceBase 中按 MPSC 使用）。
+ *
+ * 要求 T 可默认构造、可移动赋值。容量向上取整为 2 的幂。
+ */
+template<typename T>
+class LockFreeRing {
+public:
+    explicit LockFreeRing(size_t capacity)
+        : m_mask(roundUpPow2(capacity < 2 ? 2 : capacity) - 1),
+          m_cells(new Cell[m_mask + 1]),
+          m_enqueuePos(0),
+          m_dequeuePos(0) {
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 禁止拷贝
+    LockFreeRing(const LockFreeRing&) = delete;
+    LockFreeRing& operator=(const LockFreeRing&) = delete;
+
+    /**
+     * @brief 入队（队列满时返回 false，value 保持不变）
+     */
+    bool tryPush(T&& value) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 满
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::move(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队（队列空时返回 false）
+     */
+    bool tryPop(T& value) {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 空
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->data);
+        cell->data = T();  // 及时释放槽位中残留的资源
+        cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 容量
+     */
+    size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief 当前元素个数（并发下为近似值）
+     */
+    size_t sizeApprox() const {
+        size_t enq = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t deq = m_dequeuePos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    static size_t roundUpPow2(size_t v) {
+        size_t n = 1;
+        while (n < v) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    // 缓存行填充，避免生产者/消费者位置的伪共享
+    static const size_t kCacheLine = 64;
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    char m_pad0[kCacheLine];
+    std::atomic<size_t> m_enqueuePos;
+    char m_pad1[kCacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_dequeuePos;
+    char m_pad2[kCacheLine - sizeof(std::atomic<size_t>)];
+};
+
+#endif // LOCK_FREE_RING_H
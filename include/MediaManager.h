@@ -1,22 +1,25 @@
 #ifndef MEDIA_MANAGER_H
 #define MEDIA_MANAGER_H
 
-#include "VideoEncoderSvc.h"
-#include "VideoOutputSvc.h"
-#include "YUVOutputSvc.h"
+#include "MediaPipeline.h"
+#include "PipelineConfig.h"
+#include "StartupScheduler.h"
+#include <map>
 #include <memory>
 #include <functional>
-#include <atomic>
 #include <mutex>
+#include <vector>
 
 /**
  * @brief 媒体管理器
- * 
+ *
  * 职责：
- * - 创建和管理所有服务
- * - 执行 MPP 绑定操作（VI → VPSS → VENC/VO）
- * - 协调数据流转
+ * - 管理多路媒体流水线（每路一个摄像头：VI → VPSS → VENC/VO/YUV）
+ * - 分配各路的 VPSS 组、VENC 通道、VO 通道号，检查 VI 冲突
+ * - 共享的系统初始化（RK_MPI_SYS_Init/Exit）与 VO 设备/图层
  * - 生命周期管理
+ *
+ * 单路使用时保持原有接口：init() 创建第 0 路，startEncoderService() 等接口作用于第 0 路。
  */
 class MediaManager {
 public:
@@ -25,7 +28,7 @@ public:
 
     /**
      * @brief 初始化（创建所有服务，执行绑定操作）
-     * 
+     *
      * @param viDevId VI 设备ID
      * @param viPipeId VI 管道ID
      * @param viChnId VI 通道ID
@@ -34,159 +37,143 @@ public:
     bool init(int viDevId, int viPipeId, int viChnId, const std::string& entityName);
 
     /**
-     * @brief 反初始化（解绑，清理所有服务）
+     * @brief 按拓扑描述初始化（VI 尺寸、各 VPSS 通道输出、VENC 码控、VO 区域）
+     *
+     * 等价于在空的管理器上 addPipeline(config)。
+     * config.venc 作为编码服务的初始参数，启动编码服务前仍可通过
+     * getEncoderService()->setEncodeParams() 修改。
      */
-    void deinit();
+    bool init(const PipelineConfig& config);
 
     /**
-     * @brief 启动所有服务
+     * @brief 添加一路流水线
+     *
+     * config 中为 -1 的 VPSS 组、VENC 通道、VO 通道号自动分配为最小的空闲值；
+     * 显式指定的 ID 以及 VI 设备/通道不能与已有流水线冲突，共用同一 VO 图层的流水线
+     * 必须使用相同的 VO 设备、接口、时序和图层区域。
+     *
+     * @return 流水线序号（>= 0），失败返回 -1
      */
-    void start();
+    int addPipeline(const PipelineConfig& config);
 
     /**
-     * @brief 停止所有服务
+     * @brief 停止并移除一路流水线，其他流水线不受影响，序号不会被复用
      */
-    void stop();
+    bool removePipeline(int index);
 
     /**
-     * @brief 启动单个服务（支持独立控制）
+     * @brief 获取流水线（已移除或序号无效时返回空）
      */
-    void startEncoderService();
-    void startOutputService();
-    void startYUVService();
+    std::shared_ptr<MediaPipeline> getPipeline(int index);
 
     /**
-     * @brief 停止单个服务（支持独立控制）
+     * @brief 流水线数量（包含已移除的空位，即最大序号 + 1）
      */
-    void stopEncoderService();
-    void stopOutputService();
-    void stopYUVService();
+    int getPipelineCount();
 
     /**
-     * @brief 获取服务实例
+     * @brief 获取第 0 路的拓扑描述
      */
-    std::shared_ptr<VideoEncoderSvc> getEncoderService() { return m_encoderSvc; }
-    std::shared_ptr<VideoOutputSvc> getOutputService() { return m_outputSvc; }
-    std::shared_ptr<YUVOutputSvc> getYUVService() { return m_yuvSvc; }
+    const PipelineConfig& getConfig();
 
-private:
     /**
-     * @brief 初始化 VI 模块
+     * @brief 反初始化（停止并移除所有流水线，退出 MPI 系统）
      */
-    bool initializeVI();
+    void deinit();
 
     /**
-     * @brief 清理 VI 模块
+     * @brief 启动所有流水线的服务
+     *
+     * 所有流水线的启动阶段放进同一个 StartupScheduler：各路之间、同一路内没有依赖的
+     * 模块（VI 使能、VENC 建通道、VO 配置等）并行初始化。
+     *
+     * @param services MediaPipeline::ServiceMask 组合
+     * @return 所有请求的服务都启动成功返回 true
      */
-    void cleanupVI();
+    bool start(unsigned services = MediaPipeline::kServiceAll);
 
     /**
-     * @brief 初始化 VPSS 模块
+     * @brief 启动并行度（1 为串行，默认 CPU 核数，至少 4）
      */
-    bool initializeVPSS();
+    void setStartupThreads(int threads) { m_startupThreads = threads; }
 
     /**
-     * @brief 清理 VPSS 模块
+     * @brief 最近一次 start() 的各阶段耗时
      */
-    void cleanupVPSS();
+    std::vector<StartupStageTiming> getStartupTimings();
 
     /**
-     * @brief 初始化 VENC 模块
+     * @brief 停止所有流水线的所有服务
      */
-    bool initializeVENC();
+    void stop();
 
     /**
-     * @brief 清理 VENC 模块
+     * @brief 启动第 0 路的单个服务（支持独立控制）
      */
-    void cleanupVENC();
+    void startEncoderService();
+    void startOutputService();
+    void startYUVService();
 
     /**
-     * @brief 初始化 VO 模块
+     * @brief 停止第 0 路的单个服务（支持独立控制）
      */
-    bool initializeVO();
+    void stopEncoderService();
+    void stopOutputService();
+    void stopYUVService();
 
     /**
-     * @brief 清理 VO 模块
+     * @brief 获取第 0 路的服务实例
      */
-    void cleanupVO();
+    std::shared_ptr<VideoEncoderSvc> getEncoderService();
+    std::shared_ptr<VideoOutputSvc> getOutputService();
+    std::shared_ptr<YUVOutputSvc> getYUVService();
 
-    /**
-     * @brief 执行 MPP 绑定操作（根据服务状态动态绑定）
-     * 
-     * 绑定拓扑：
-     * VI → VPSS → ┬→ VENC (编码)
-     *              ├→ VO (显示)
-     *              └→ VPSS_CHN (YUV输出)
-     */
-    bool setupBindings();
+private:
+    friend class MediaPipeline;
 
     /**
-     * @brief 解绑所有连接
+     * @brief 引用 VO 图层（第一次引用时打开 VO 设备并配置图层）
+     * @param layerWidth/layerHeight 输出图层显示区域的宽高
      */
-    void teardownBindings();
+    bool acquireVoLayer(const VoConfig& vo, uint32_t& layerWidth, uint32_t& layerHeight);
 
     /**
-     * @brief 增加服务引用计数（服务启动时调用）
+     * @brief 释放 VO 图层引用（最后一个引用释放时关闭图层和设备）
      */
-    void incrementServiceRef();
+    void releaseVoLayer(const VoConfig& vo);
 
     /**
-     * @brief 减少服务引用计数（服务停止时调用）
-     * @return 返回当前引用计数
+     * @brief 分配 ID 并检查与已有流水线的冲突（调用方持有 m_pipelinesMutex）
      */
-    int decrementServiceRef();
+    bool assignIds(PipelineConfig& config);
 
     /**
-     * @brief 根据服务状态动态绑定/解绑
+     * @brief 引用/释放 MPI 系统（进程内计数，所有管理器共享）
      */
-    void updateBindings();
-
-    // VI 参数
-    int m_viDevId;
-    int m_viPipeId;
-    int m_viChnId;
-    std::string m_entityName;
+    static bool acquireSystem();
+    static void releaseSystem();
 
-    // VPSS 参数
-    int m_vpssGrpId;
-    int m_vpssChnEnc;   // 编码用的 VPSS 通道
-    int m_vpssChnVo;    // 显示用的 VPSS 通道
-    int m_vpssChnYuv;   // YUV输出用的 VPSS 通道
+    // 各路流水线（下标即序号，移除后置空）
+    std::vector<std::shared_ptr<MediaPipeline>> m_pipelines;
+    std::mutex m_pipelinesMutex;
 
-    // 实际图像宽高（从 VI 通道获取，用于配置 VPSS/VENC 等）
-    int m_imgWidth  = 0;
-    int m_imgHeight = 0;
+    // 是否持有 MPI 系统引用
+    bool m_systemAcquired = false;
 
-    // VENC 参数
-    int m_vencChnId;
+    // 启动并行度（0 表示调度器默认值）与最近一次启动的记录
+    int m_startupThreads = 0;
+    std::vector<StartupStageTiming> m_startupTimings;
+    std::mutex m_startupMutex;
 
-    // VO 参数
-    int m_voDevId;
-    int m_voLayerId;
-    int m_voChnId;
-
-    // 服务实例
-    std::shared_ptr<VideoEncoderSvc> m_encoderSvc;
-    std::shared_ptr<VideoOutputSvc> m_outputSvc;
-    std::shared_ptr<YUVOutputSvc> m_yuvSvc;
-
-    // 状态
-    bool m_initialized = false;
-    bool m_bindingsSetup = false;
-
-    // VI/VPSS 初始化状态
-    bool m_viInitialized = false;
-    bool m_vpssInitialized = false;
-
-    // 服务引用计数（用于管理VI生命周期）
-    std::atomic<int> m_serviceRefCount{0};
-    std::mutex m_refCountMutex;
-
-    // 服务运行状态
-    bool m_encoderRunning = false;
-    bool m_outputRunning = false;
-    bool m_yuvRunning = false;
+    // VO 图层共享状态（按 layerId）
+    struct VoLayerState {
+        VoConfig config;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int refCount = 0;
+    };
+    std::map<int, VoLayerState> m_voLayers;
+    std::mutex m_voMutex;
 };
 
 #endif // MEDIA_MANAGER_H
-
@@ -0,0 +1,303 @@
+#ifndef MEDIA_PIPELINE_H
+#define MEDIA_PIPELINE_H
+
+#include "VideoEncoderSvc.h"
+#include "VideoOutputSvc.h"
+#include "YUVOutputSvc.h"
+#include "PipelineConfig.h"
+#include "LatencyTracer.h"
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+class MediaManager;
+class StartupScheduler;
+
+/**
+ * @brief 单路媒体流水线（一个摄像头）
+ *
+ * VI → VPSS → ┬→ VENC (编码)
+ *              ├→ VO (显示)
+ *              └→ VPSS_CHN (YUV输出)
+ *
+ * 由 MediaManager::addPipeline() 创建，VPSS 组、VENC 通道、VO 通道号在创建前已分配。
+ * 各路流水线的服务独立启停；VO 设备/图层可被多路共享，由 MediaManager 统一管理。
+ */
+class MediaPipeline {
+public:
+    /**
+     * @brief 服务掩码（startServices / addStartupStages 用）
+     */
+    enum ServiceMask : unsigned {
+        kServiceEncoder = 1u << 0,
+        kServiceOutput  = 1u << 1,
+        kServiceYuv     = 1u << 2,
+        kServiceAll     = kServiceEncoder | kServiceOutput | kServiceYuv,
+    };
+
+    MediaPipeline(MediaManager& owner, int index, const PipelineConfig& config);
+    ~MediaPipeline();
+
+    MediaPipeline(const MediaPipeline&) = delete;
+    MediaPipeline& operator=(const MediaPipeline&) = delete;
+
+    /**
+     * @brief 创建服务（不初始化 VI，等第一个服务启动时再初始化）
+     */
+    bool init();
+
+    /**
+     * @brief 停止所有服务并释放 MPI 资源
+     */
+    void deinit();
+
+    /**
+     * @brief 启动/停止所有服务
+     */
+    void start();
+    void stop();
+
+    /**
+     * @brief 启动单个服务（支持独立控制）
+     */
+    void startEncoderService();
+    void startOutputService();
+    void startYUVService();
+
+    /**
+     * @brief 启动一组服务
+     *
+     * VI 设备/通道、VPSS 建组、VENC 建通道、VO 通道配置等按依赖关系并行执行，
+     * 各阶段耗时打印到日志。
+     * @return 所有请求的服务都启动成功返回 true
+     */
+    bool startServices(unsigned services);
+
+    /**
+     * @brief 把启动各阶段加入调度器（多路流水线共用一个调度器并行启动）
+     *
+     * scheduler.run() 之后必须调用 finishStartup()，按各阶段结果启动服务线程或回滚。
+     */
+    void addStartupStages(StartupScheduler& scheduler, unsigned services);
+    bool finishStartup(const StartupScheduler& scheduler);
+
+    /**
+     * @brief 停止单个服务（支持独立控制）
+     */
+    void stopEncoderService();
+    void stopOutputService();
+    void stopYUVService();
+
+    /**
+     * @brief 获取服务实例
+     */
+    std::shared_ptr<VideoEncoderSvc> getEncoderService() { return m_encoderSvc; }
+    std::shared_ptr<VideoOutputSvc> getOutputService() { return m_outputSvc; }
+    std::shared_ptr<YUVOutputSvc> getYUVService() { return m_yuvSvc; }
+
+    /**
+     * @brief 开启端到端时延追踪（编码与 YUV 服务共用一个追踪器）
+     *
+     * 已开启时替换为新的追踪器（统计重新开始）。须在 init() 之后调用，运行中可随时开启/关闭。
+     *
+     * @param traceEvents 保存用于导出 Chrome trace 的最近事件数，0 表示只统计直方图
+     * @return 追踪器，用于查询各阶段时延与导出
+     */
+    std::shared_ptr<LatencyTracer> enableLatencyTracing(
+        size_t traceEvents = LatencyTracer::kDefaultTraceEvents);
+
+    /**
+     * @brief 关闭时延追踪
+     */
+    void disableLatencyTracing();
+
+    /**
+     * @brief 获取时延追踪器（未开启时为空）
+     */
+    std::shared_ptr<LatencyTracer> getLatencyTracer();
+
+    /**
+     * @brief 设置丢帧告警回调（编码与 YUV 两个阶段，为空表示取消）
+     *
+     * 告警中的阶段名为 "pipe<序号>.venc" / "pipe<序号>.yuv"，回调在对应服务线程中执行。
+     * 阈值等参数通过各服务的 getSequenceTracker() 调整。须在 init() 之后调用。
+     */
+    void setFrameDropCallback(FrameSequenceTracker::AlertCallback callback);
+
+    /**
+     * @brief 流水线序号（MediaManager 中的下标）
+     */
+    int getIndex() const { return m_index; }
+
+    /**
+     * @brief 获取拓扑描述（ID 已分配）
+     */
+    const PipelineConfig& getConfig() const { return m_config; }
+
+private:
+    /**
+     * @brief 初始化 VI 模块
+     */
+    bool initializeVI();
+
+    /**
+     * @brief 清理 VI 模块
+     */
+    void cleanupVI();
+
+    /**
+     * @brief 初始化 VPSS 模块
+     */
+    bool initializeVPSS();
+
+    /**
+     * @brief 清理 VPSS 模块
+     */
+    void cleanupVPSS();
+
+    /**
+     * @brief 计算 VPSS 通道输出尺寸（禁用的通道为 0）
+     */
+    void resolveVpssChnSize(int chn, uint32_t inWidth, uint32_t inHeight,
+                            uint32_t& width, uint32_t& height);
+
+    /**
+     * @brief VPSS 初始化前按配置规划各通道尺寸（VENC 据此与 VPSS 并行创建）
+     */
+    void planVpssChannels();
+
+    /**
+     * @brief 初始化 VENC 模块（输入尺寸即 VPSS 编码通道输出尺寸）
+     */
+    bool initializeVENC(uint32_t width, uint32_t height);
+
+    /**
+     * @brief 清理 VENC 模块
+     */
+    void cleanupVENC();
+
+    /**
+     * @brief 按新编码参数重建 VENC 通道（编码服务线程中调用，VI/VPSS 保持运行）
+     *
+     * 编码尺寸变化时同时修改 VPSS 编码通道的输出尺寸。
+     */
+    bool rebuildEncoderChannel();
+
+    /**
+     * @brief 运行中修改 VPSS 通道输出尺寸（其他通道不受影响）
+     */
+    bool resizeVpssChn(int chn, uint32_t width, uint32_t height);
+
+    /**
+     * @brief 初始化 VO 通道（VO 设备/图层由 MediaManager 共享）
+     */
+    bool initializeVO();
+
+    /**
+     * @brief 清理 VO 通道
+     */
+    void cleanupVO();
+
+    /**
+     * @brief 绑定/解绑各模块
+     *
+     * 绑定拓扑：
+     * VI → VPSS → ┬→ VENC (编码)
+     *              ├→ VO (显示)
+     *              └→ VPSS_CHN (YUV输出)
+     */
+    bool bindViToVpss();
+    bool bindVpssToVenc();
+    void unbindVpssFromVenc();
+    bool bindVpssToVo();
+    void unbindVpssFromVo();
+
+    /**
+     * @brief 解绑 VI → VPSS（最后一个服务停止时）
+     */
+    void teardownBindings();
+
+    /**
+     * @brief 减少服务引用计数（服务停止时调用）
+     * @return 返回当前引用计数
+     */
+    int decrementServiceRef();
+
+    /**
+     * @brief 一次启动中各服务对应的最后阶段（-1 表示未请求）
+     */
+    struct StartupStages {
+        unsigned services = 0;
+        int encoder = -1;  // bind.vpss-venc
+        int output = -1;   // bind.vpss-vo
+    };
+
+    MediaManager& m_owner;
+    int m_index;
+    std::string m_tag;  // 日志前缀
+
+    // 拓扑描述
+    PipelineConfig m_config;
+
+    // VI 参数
+    int m_viDevId;
+    int m_viPipeId;
+    int m_viChnId;
+    std::string m_entityName;
+
+    // VPSS 参数
+    int m_vpssGrpId;
+    int m_vpssChnEnc;   // 编码用的 VPSS 通道
+    int m_vpssChnVo;    // 显示用的 VPSS 通道
+    int m_vpssChnYuv;   // YUV输出用的 VPSS 通道
+
+    // 实际图像宽高（从 VI 通道获取，用于配置 VPSS/VENC 等）
+    int m_imgWidth  = 0;
+    int m_imgHeight = 0;
+
+    // 各 VPSS 通道实际输出宽高（initializeVPSS 时确定）
+    uint32_t m_vpssChnWidth[kVpssChnCount] = {};
+    uint32_t m_vpssChnHeight[kVpssChnCount] = {};
+
+    // VENC 参数
+    int m_vencChnId;
+    uint32_t m_vencWidth = 0;   // VENC 通道实际创建的输入尺寸
+    uint32_t m_vencHeight = 0;
+
+    // VO 参数
+    int m_voDevId;
+    int m_voLayerId;
+    int m_voChnId;
+
+    // 服务实例
+    std::shared_ptr<VideoEncoderSvc> m_encoderSvc;
+    std::shared_ptr<VideoOutputSvc> m_outputSvc;
+    std::shared_ptr<YUVOutputSvc> m_yuvSvc;
+
+    // 状态
+    bool m_initialized = false;
+    bool m_bindingsSetup = false;
+
+    // VI/VPSS/VO 初始化状态
+    bool m_viInitialized = false;
+    bool m_vpssInitialized = false;
+    bool m_voInitialized = false;
+    bool m_vencCreated = false;
+    bool m_vencBound = false;
+    bool m_voBound = false;
+
+    // 进行中的启动（addStartupStages → finishStartup）
+    StartupStages m_startup;
+
+    // 服务引用计数（用于管理VI生命周期）
+    std::atomic<int> m_serviceRefCount{0};
+    std::mutex m_refCountMutex;
+
+    // 服务运行状态
+    bool m_encoderRunning = false;
+    bool m_outputRunning = false;
+    bool m_yuvRunning = false;
+};
+
+#endif // MEDIA_PIPELINE_H
@@ -0,0 +1,255 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 指标标签（按给定顺序输出）
+ */
+typedef std::vector<std::pair<std::string, std::string>> MetricLabels;
+
+/**
+ * @brief 指标基类
+ */
+class Metric {
+public:
+    virtual ~Metric() {}
+
+    /**
+     * @brief 按 Prometheus 文本格式输出样本行（labels 为已格式化的 k="v",... 或空）
+     */
+    virtual void render(std::string& out, const std::string& name, const std::string& labels) const = 0;
+
+protected:
+    /**
+     * @brief 当前线程的分片下标（线程首次使用时轮流分配）
+     */
+    static unsigned shardIndex();
+
+    static const unsigned kShards = 16;
+};
+
+/**
+ * @brief 计数器（单调递增）
+ *
+ * 每个线程写自己的分片（各占一个缓存行），inc() 只有一次 relaxed 原子加，
+ * 多个线程并发计数不会互相争用；读取时把各分片相加。
+ */
+class MetricCounter : public Metric {
+public:
+    MetricCounter();
+
+    void inc(uint64_t n = 1) { m_shards[shardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+    void render(std::string& out, const std::string& name, const std::string& labels) const override;
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> value;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    Shard m_shards[kShards];
+};
+
+/**
+ * @brief 仪表（可增可减的当前值）
+ */
+class MetricGauge : public Metric {
+public:
+    MetricGauge() : m_value(0) {}
+
+    void set(int64_t v) { m_value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+    void render(std::string& out, const std::string& name, const std::string& labels) const override;
+
+private:
+    std::atomic<int64_t> m_value;
+};
+
+/**
+ * @brief 直方图（微秒记录，按 Prometheus 惯例以秒输出）
+ *
+ * 桶上界在创建时固定；每个线程写自己的分片，observe() 为两到三次 relaxed 原子加。
+ */
+class MetricHistogram : public Metric {
+public:
+    static const size_t kMaxBuckets = 16;
+
+    /**
+     * @param boundsUs 桶上界（微秒，递增），超过 kMaxBuckets 的部分忽略；空表示默认桶
+     */
+    explicit MetricHistogram(const std::vector<uint64_t>& boundsUs = std::vector<uint64_t>());
+
+    void observe(uint64_t us);
+
+    uint64_t count() const;
+    uint64_t sumUs() const;
+
+    void render(std::string& out, const std::string& name, const std::string& labels) const override;
+
+    /**
+     * @brief 默认桶：50us ~ 1s（回调、写盘等耗时）
+     */
+    static const std::vector<uint64_t>& defaultBounds();
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> buckets[kMaxBuckets + 1];  // 最后一个为 +Inf
+        std::atomic<uint64_t> sum;
+        char pad[64 - (((kMaxBuckets + 2) * sizeof(std::atomic<uint64_t>)) % 64)];
+    };
+
+    uint64_t m_bounds[kMaxBuckets];
+    size_t m_boundCount;
+    Shard m_shards[kShards];
+};
+
+/**
+ * @brief 采集时计算的样本（由 collector 输出，不占用帧路径）
+ */
+class MetricsWriter {
+public:
+    void counter(const std::string& name, const std::string& help, const MetricLabels& labels,
+                 uint64_t value);
+    void gauge(const std::string& name, const std::string& help, const MetricLabels& labels,
+               double value);
+
+private:
+    friend class MetricsRegistry;
+
+    struct Sample {
+        std::string name;
+        std::string help;
+        bool isCounter;
+        std::string labels;
+        double value;
+    };
+    std::vector<Sample> m_samples;
+};
+
+/**
+ * @brief 进程级指标注册表
+ *
+ * 两类指标来源：
+ * - 注册的指标对象：counter()/gauge()/histogram() 返回 shared_ptr，由使用方持有，
+ *   帧路径直接操作对象（无锁、无查找）；注册表只保存弱引用，使用方释放后自动消失
+ * - collector：采集时调用的函数，把已有的统计（队列深度、写盘/RTSP Stats 等）换算成样本，
+ *   适合本来就有的统计和只在采集时才需要的值
+ *
+ * 同名同标签重复注册返回同一个对象（例如按错误码计数）。
+ * render() 输出 Prometheus 文本格式（同名指标合并为一组），由 MetricsServer 提供给采集方。
+ */
+class MetricsRegistry {
+public:
+    typedef std::function<void(MetricsWriter&)> Collector;
+
+    static MetricsRegistry& instance();
+
+    std::shared_ptr<MetricCounter> counter(const std::string& name, const std::string& help,
+                                           const MetricLabels& labels = MetricLabels());
+    std::shared_ptr<MetricGauge> gauge(const std::string& name, const std::string& help,
+                                       const MetricLabels& labels = MetricLabels());
+    std::shared_ptr<MetricHistogram> histogram(const std::string& name, const std::string& help,
+                                               const MetricLabels& labels = MetricLabels(),
+                                               const std::vector<uint64_t>& boundsUs =
+                                                   std::vector<uint64_t>());
+
+    /**
+     * @brief 添加 collector
+     * @return 编号（removeCollector 用）
+     */
+    int addCollector(Collector collector);
+
+    /**
+     * @brief 移除 collector（返回后不会再被调用）
+     */
+    void removeCollector(int id);
+
+    /**
+     * @brief 分配同名服务的实例序号（取最小的未用序号）
+     */
+    int acquireInstance(const std::string& service);
+    void releaseInstance(const std::string& service, int instance);
+
+    /**
+     * @brief 输出所有指标（Prometheus 文本格式 0.0.4）
+     */
+    std::string render();
+
+    /**
+     * @brief 格式化标签（转义引号、反斜杠、换行）
+     */
+    static std::string formatLabels(const MetricLabels& labels);
+
+private:
+    MetricsRegistry() {}
+
+    enum Type { kCounter, kGauge, kHistogram };
+
+    struct Series {
+        std::string labels;
+        std::weak_ptr<Metric> metric;
+    };
+
+    struct Family {
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    /**
+     * @brief 查找同名同标签的存活对象（持有 m_mutex），顺带清理已释放的
+     */
+    std::shared_ptr<Metric> findSeries(Family& family, const std::string& labels);
+    Family* family(const std::string& name, const std::string& help, Type type);
+
+    std::mutex m_mutex;
+    std::map<std::string, Family> m_families;
+    std::map<int, Collector> m_collectors;
+    int m_nextCollectorId = 0;
+    std::map<std::string, std::vector<bool>> m_instances;
+};
+
+/**
+ * @brief collector 的 RAII 句柄：析构时移除
+ *
+ * collector 通常捕获所属对象的成员，句柄应声明为该对象的最后一个成员，
+ * 保证先于其他成员析构。
+ */
+class MetricsCollectorHandle {
+public:
+    MetricsCollectorHandle() : m_id(-1) {}
+    explicit MetricsCollectorHandle(MetricsRegistry::Collector collector)
+        : m_id(MetricsRegistry::instance().addCollector(std::move(collector))) {}
+    ~MetricsCollectorHandle() { reset(); }
+
+    MetricsCollectorHandle(const MetricsCollectorHandle&) = delete;
+    MetricsCollectorHandle& operator=(const MetricsCollectorHandle&) = delete;
+
+    void reset(MetricsRegistry::Collector collector = MetricsRegistry::Collector()) {
+        if (m_id >= 0) {
+            MetricsRegistry::instance().removeCollector(m_id);
+            m_id = -1;
+        }
+        if (collector) {
+            m_id = MetricsRegistry::instance().addCollector(std::move(collector));
+        }
+    }
+
+private:
+    int m_id;
+};
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,114 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "ServiceBase.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief 指标采集服务参数
+ */
+struct MetricsServerConfig {
+    std::string unixPath = "/tmp/media_metrics.sock";  // Unix socket 路径，空表示不监听
+    uint16_t tcpPort = 0;                              // HTTP 端口，0 表示不监听 TCP
+    std::string bindAddress = "127.0.0.1";             // TCP 监听地址（默认只允许本机访问）
+    uint32_t maxConnections = 16;                      // 同时处理的连接数上限
+    uint32_t requestTimeoutMs = 5000;                  // 连接从建立到响应发完的时限
+};
+
+/**
+ * @brief 本地指标采集端点（HTTP/1.0，Prometheus 文本格式）
+ *
+ * GET /metrics（或 /）返回 MetricsRegistry::instance().render() 的内容，其余路径返回 404。
+ * 每个连接只处理一个请求，响应发完后关闭。可同时监听 Unix socket 与本机 TCP 端口：
+ *   curl --unix-socket /tmp/media_metrics.sock http://localhost/metrics
+ *   curl http://127.0.0.1:<port>/metrics
+ *
+ * 监听与连接 socket 放在自己的 epoll 集合中，集合的 fd 作为通道 fd 交给 ServiceBase 等待；
+ * 指标在服务线程中按请求生成，不占用帧路径。
+ */
+class MetricsServer : public ServiceBase {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        uint64_t scrapes;          // 成功返回指标的次数
+        uint64_t notFound;         // 404/405 响应次数
+        uint64_t badRequests;      // 请求格式错误或过大
+        uint64_t timeouts;         // 超时关闭的连接
+        uint64_t rejected;         // 超过连接上限被拒绝的连接
+        uint64_t lastRenderUs;     // 最近一次生成指标的耗时
+        uint64_t lastResponseBytes;
+    };
+
+    explicit MetricsServer(const MetricsServerConfig& config = MetricsServerConfig());
+    ~MetricsServer() override;
+
+    /**
+     * @brief 创建监听 socket（须在 start() 之前调用；未调用时 start() 后自动调用）
+     *
+     * Unix socket 路径上的残留文件会先删除。
+     */
+    bool open();
+
+    /**
+     * @brief 实际监听的 TCP 端口（未监听时为 0）
+     */
+    uint16_t port() const { return m_port; }
+
+    const std::string& unixPath() const { return m_config.unixPath; }
+
+    Stats stats() const;
+
+protected:
+    void run() override;
+
+private:
+    struct Connection {
+        int fd;
+        std::string input;
+        std::string output;
+        size_t sent;
+        std::chrono::steady_clock::time_point accepted;
+    };
+
+    void handleSocketEvents();
+    void acceptConnections(int listenFd);
+    void readConnection(Connection& conn);
+    void writeConnection(Connection& conn);
+    void closeConnection(int fd);
+    void expireConnections();
+    void closeAll();
+    void closeSockets();
+
+    /**
+     * @brief 根据请求头块生成响应，返回 false 表示请求格式错误
+     */
+    bool handleRequest(Connection& conn, const std::string& head);
+    void respond(Connection& conn, int code, const char* reason, const std::string& body,
+                 bool headOnly);
+
+    const MetricsServerConfig m_config;
+
+    int m_tcpFd = -1;
+    int m_unixFd = -1;
+    int m_pollFd = -1;                   // 监听与连接 socket 的 epoll 集合
+    uint16_t m_port = 0;
+
+    // 服务线程独占
+    std::map<int, Connection> m_connections;
+    std::chrono::steady_clock::time_point m_lastExpireCheck;
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+
+    std::shared_ptr<MetricCounter> m_scrapeMetric;
+    std::shared_ptr<MetricHistogram> m_renderMetric;
+};
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,188 @@
+#ifndef MP4_MUXER_H
+#define MP4_MUXER_H
+
+#include "VideoEncoderSvc.h"
+#include "PacketBufferPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+/**
+ * @brief fMP4 封装参数
+ */
+struct Mp4MuxerConfig {
+    std::string path;                              // 输出文件路径
+    uint32_t minFragmentMs = 0;                    // 分片最短时长，到达后的下一个关键帧开始新分片（0 表示每个关键帧）
+    size_t maxFragmentBytes = 8 * 1024 * 1024;     // 分片缓冲上限，超出时不等关键帧立即写出
+    uint32_t maxFragmentFrames = 300;              // 分片缓冲帧数上限
+    bool syncFragments = true;                     // 每个分片写出后 fdatasync（掉电最多丢一个分片）
+    size_t preallocateBytes = 32 * 1024 * 1024;    // 预分配步长（fallocate KEEP_SIZE），0 表示不预分配
+    bool dropCache = true;                         // 分片落盘后丢弃对应的页缓存
+};
+
+/**
+ * @brief 流式 fMP4 封装（H264/H265）
+ *
+ * 输入 VideoEncoderSvc 输出的 EncodedFrame（Annex-B），输出分片 MP4：
+ * - 第一个关键帧到达时写 ftyp + moov（参数集放在 avcC/hvcC，样本中去掉 SPS/PPS/VPS/AUD），
+ *   之前的帧丢弃
+ * - 之后每个关键帧（或到达 minFragmentMs 后的下一个关键帧）把缓冲的帧写成一个 moof + mdat，
+ *   缓冲超过 maxFragmentBytes/maxFragmentFrames 时提前写出
+ * - 每个分片一次 writev：box 头和长度前缀在一块缓冲中，帧数据直接引用 EncodedFrame，不拼接
+ * - 参数集变化（编码格式/分辨率重建）时结束当前文件，新文件名追加 _1、_2 …
+ *
+ * 文件中不需要回写 moov，写出的每个分片立即可播放；开启 syncFragments 时掉电最多丢失
+ * 正在缓冲/写出的一个分片，文件其余部分完整。
+ *
+ * 时间戳为 EncodedFrame::timestamp（微秒），不支持 B 帧（DTS = PTS）。
+ * 缓冲中的零拷贝帧会拷贝到缓冲池，不占用 VENC 输出缓冲。
+ *
+ * 线程安全：writeFrame() 一般在订阅者线程中调用，close()/stats() 可在其他线程调用。
+ */
+class Mp4Muxer {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        uint64_t files;               // 创建的文件数
+        uint64_t fragments;           // 写出的分片数
+        uint64_t frames;              // 写出的帧数
+        uint64_t bytes;               // 写入文件的字节数
+        uint64_t droppedFrames;       // 丢弃的帧数（第一个关键帧之前、写入失败）
+        uint64_t writeErrors;         // 写入失败次数
+        uint64_t lastFragmentUs;      // 最近一个分片写出（含 fdatasync）耗时
+        uint64_t maxFragmentUs;       // 分片写出耗时最大值
+    };
+
+    explicit Mp4Muxer(const Mp4MuxerConfig& config,
+                      std::shared_ptr<PacketBufferPool> pool = PacketBufferPool::shared());
+    ~Mp4Muxer();
+
+    Mp4Muxer(const Mp4Muxer&) = delete;
+    Mp4Muxer& operator=(const Mp4Muxer&) = delete;
+
+    /**
+     * @brief 创建输出文件
+     */
+    bool open();
+
+    /**
+     * @brief 写入一帧（可直接作为 VideoEncoderSvc 订阅者回调）
+     *
+     * @return 文件未打开或写入失败时返回 false
+     */
+    bool writeFrame(const EncodedFrame& frame);
+
+    /**
+     * @brief 写出缓冲中的帧并关闭文件
+     */
+    bool close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief 当前输出文件路径
+     */
+    std::string currentPath() const;
+
+    Stats stats() const;
+
+private:
+    struct Nal {
+        const uint8_t* data;
+        uint32_t size;
+    };
+
+    struct Sample {
+        EncodedFrame frame;  // 持有帧数据
+        uint64_t dts;        // 90kHz
+        uint32_t firstNal;   // m_nals 中的下标
+        uint32_t nalCount;
+        uint32_t size;       // 样本大小（NAL 长度前缀 + NAL）
+    };
+
+    /**
+     * @brief 解析 Annex-B 帧：样本 NAL 放入 m_frameNals，参数集放入 m_frameVps/Sps/Pps
+     */
+    void parseFrame(const EncodedFrame& frame);
+
+    /**
+     * @brief 当前帧的参数集是否与文件的不同（需要新文件）
+     */
+    bool parameterSetsChanged(const EncodedFrame& frame) const;
+
+    bool openFile();
+    void closeFile();
+    std::string pathForIndex(uint64_t index) const;
+
+    /**
+     * @brief 写 ftyp + moov
+     */
+    bool writeInit(const EncodedFrame& frame);
+
+    /**
+     * @brief 把缓冲的样本写成一个分片
+     *
+     * @param nextTimestamp 下一帧时间戳（用于最后一个样本的时长），0 表示沿用上一个样本时长
+     */
+    bool flushFragment(uint64_t nextTimestamp);
+
+    /**
+     * @brief 写出一组 iovec（分批 writev，处理部分写入），失败时截断回写入前的长度
+     */
+    bool writeBuffers(iovec* iov, size_t count, size_t total);
+
+    void preallocate(size_t bytes);
+
+    uint64_t toDts(uint64_t timestamp) const;
+
+    const Mp4MuxerConfig m_config;
+    std::shared_ptr<PacketBufferPool> m_pool;
+
+    mutable std::mutex m_mutex;
+    int m_fd = -1;
+    std::string m_path;
+    uint64_t m_fileIndex = 0;
+    uint64_t m_offset = 0;        // 已写入的文件长度
+    uint64_t m_allocated = 0;     // 已预分配到的位置
+    uint64_t m_cachedFrom = 0;    // 尚未丢弃页缓存的起始位置
+    bool m_preallocate = true;
+
+    // 当前文件的码流参数（写入 moov 的参数集）
+    bool m_initWritten = false;
+    bool m_isH265 = false;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    std::vector<uint8_t> m_vps;
+    std::vector<uint8_t> m_sps;
+    std::vector<uint8_t> m_pps;
+    uint64_t m_startTimestamp = 0;
+    uint32_t m_sequence = 0;
+    uint64_t m_lastDts = 0;
+    uint32_t m_lastDuration = 3000;  // 90kHz 下 30fps
+
+    // 当前帧的解析结果（复用，避免每帧分配）
+    std::vector<Nal> m_frameNals;
+    std::vector<uint8_t> m_frameVps;
+    std::vector<uint8_t> m_frameSps;
+    std::vector<uint8_t> m_framePps;
+
+    // 当前分片缓冲
+    std::vector<Sample> m_samples;
+    std::vector<Nal> m_nals;
+    size_t m_pendingBytes = 0;
+
+    // 写出用的缓冲（复用）
+    std::vector<uint8_t> m_header;
+    std::vector<uint8_t> m_prefixes;
+    std::vector<iovec> m_iov;
+
+    Stats m_stats;
+};
+
+#endif // MP4_MUXER_H
@@ -0,0 +1,133 @@
+#ifndef PACKET_BUFFER_POOL_H
+#define PACKET_BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+/**
+ * @brief 编码包缓冲池（按大小分级复用）
+ *
+ * 缓冲区按 2 的幂分级（4KB ~ 8MB），释放后回到对应级别的空闲链表供下次复用，
+ * 避免每帧 new[]/delete[] 导致的内存碎片和 RSS 持续增长。
+ *
+ * acquire() 返回的 shared_ptr 控制块也放在缓冲区头部的预留空间中，
+ * 命中时整个过程没有堆分配。超过最大级别的请求直接从堆上分配，不进入缓存。
+ *
+ * 多个编码服务可以共享同一个池（例如 16 路录像共用 PacketBufferPool::shared()）。
+ */
+class PacketBufferPool : public std::enable_shared_from_this<PacketBufferPool> {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        uint64_t hits;                 // 从空闲链表复用的次数
+        uint64_t misses;               // 新分配的次数（分级内）
+        uint64_t oversize;             // 超过最大级别、直接堆分配的次数
+        uint64_t outstandingBlocks;    // 当前借出的缓冲区个数
+        uint64_t outstandingBytes;     // 当前借出的字节数（按容量计）
+        uint64_t peakOutstandingBytes; // 借出字节数高水位
+        uint64_t cachedBytes;          // 空闲链表中缓存的字节数
+        uint64_t peakCachedBytes;      // 缓存字节数高水位
+    };
+
+    static const size_t kMinClassSize = 4 * 1024;          // 最小级别 4KB
+    static const int    kNumClasses = 12;                  // 4KB ~ 8MB
+    static const size_t kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+
+    /**
+     * @brief 创建缓冲池
+     *
+     * @param maxCachedBytes 空闲链表最多缓存的字节数，超出时释放的缓冲区直接归还系统
+     */
+    static std::shared_ptr<PacketBufferPool> create(size_t maxCachedBytes = kDefaultMaxCachedBytes);
+
+    /**
+     * @brief 进程级默认缓冲池
+     */
+    static std::shared_ptr<PacketBufferPool> shared();
+
+    ~PacketBufferPool();
+
+    // 禁止拷贝
+    PacketBufferPool(const PacketBufferPool&) = delete;
+    PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+    /**
+     * @brief 申请缓冲区
+     *
+     * @param size     需要的字节数
+     * @param capacity 输出实际容量（可为 nullptr）
+     * @return 缓冲区，最后一个引用释放时自动归还；分配失败返回空
+     */
+    std::shared_ptr<uint8_t> acquire(size_t size, size_t* capacity = nullptr);
+
+    /**
+     * @brief 释放所有缓存的空闲缓冲区
+     */
+    void trim();
+
+    /**
+     * @brief 获取统计信息
+     */
+    Stats stats() const;
+
+private:
+    // 控制块预留空间（libstdc++ 带删除器和分配器的控制块约 40 字节）
+    static const size_t kCtrlSpace = 64;
+
+    struct Block {
+        std::shared_ptr<PacketBufferPool> owner;  // 借出期间持有，保证池晚于缓冲区析构
+        size_t capacity;                          // 数据区容量
+        int sizeClass;                            // 级别，-1 表示超大块
+        bool ctrlInline;                          // 控制块是否放在 ctrl 中
+        Block* next;                              // 空闲链表链接
+        std::aligned_storage<kCtrlSpace, alignof(std::max_align_t)>::type ctrl;
+
+        uint8_t* payload();
+    };
+
+    struct ClassList {
+        std::mutex mutex;
+        Block* head = nullptr;
+        size_t count = 0;
+    };
+
+    template<typename T> struct CtrlAllocator;
+    struct Deleter;
+
+    explicit PacketBufferPool(size_t maxCachedBytes);
+
+    static int classFor(size_t size);
+    static size_t classSize(int sizeClass);
+    static size_t dataOffset();
+
+    Block* allocBlock(size_t capacity, int sizeClass);
+    static void freeBlock(Block* block);
+
+    /**
+     * @brief 缓冲区最后一个引用释放后调用，归还空闲链表或释放
+     */
+    static void releaseBlock(Block* block);
+    void recycle(Block* block);
+
+    static void updatePeak(std::atomic<uint64_t>& peak, uint64_t value);
+
+    const size_t m_maxCachedBytes;
+    ClassList m_classes[kNumClasses];
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_oversize{0};
+    std::atomic<uint64_t> m_outstandingBlocks{0};
+    std::atomic<uint64_t> m_outstandingBytes{0};
+    std::atomic<uint64_t> m_peakOutstandingBytes{0};
+    std::atomic<uint64_t> m_cachedBytes{0};
+    std::atomic<uint64_t> m_peakCachedBytes{0};
+};
+
+#endif // PACKET_BUFFER_POOL_H
@@ -0,0 +1,139 @@
+#ifndef PIPELINE_CONFIG_H
+#define PIPELINE_CONFIG_H
+
+#include "VideoEncoderSvc.h"
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <linux/videodev2.h>
+
+/**
+ * @brief VPSS 输出通道用途（数组下标即 VPSS 通道号）
+ */
+enum PipelineVpssChn {
+    kVpssChnEncoder = 0,  // 编码
+    kVpssChnDisplay = 1,  // 显示
+    kVpssChnYuv     = 2,  // YUV 输出（算法）
+    kVpssChnCount   = 3,
+};
+
+/**
+ * @brief VI 配置
+ */
+struct ViConfig {
+    int devId = 0;
+    int pipeId = 0;
+    int chnId = 0;
+    std::string entityName;      // 设备节点或 entity 名称
+    uint32_t width = 3840;
+    uint32_t height = 2160;
+    int fps = -1;                // 输出帧率，-1 表示跟随 sensor
+    uint32_t bufCount = 6;       // V4L2 缓冲区个数
+    uint32_t depth = 0;          // 用户取帧深度（绑定模式为 0）
+};
+
+/**
+ * @brief VPSS 输出通道配置
+ */
+struct VpssChnConfig {
+    bool enabled = true;
+    uint32_t width = 0;                       // 0 表示与 VI 相同
+    uint32_t height = 0;
+    uint32_t pixelFormat = V4L2_PIX_FMT_NV12; // V4L2 格式：NV12 / NV21 / NV16
+    int fps = -1;                             // 输出帧率（由 vi.fps 抽帧），-1 表示不抽帧
+    uint32_t depth = 0;                       // 用户取帧深度，0 表示按用途取默认值
+    uint32_t bufCount = 0;                    // 输出缓冲区个数，0 表示驱动默认
+};
+
+/** VPSS 缩放能力：单通道输出最大边长，以及相对输入的最大缩小/放大倍数 */
+static const uint32_t kVpssMaxOutputSize = 8192;
+static const uint32_t kVpssMaxScaleDown = 16;
+static const uint32_t kVpssMaxScaleUp = 16;
+
+/** H264/H265 QP 上限 */
+static const uint32_t kVencMaxQp = 51;
+
+/**
+ * @brief VO 配置
+ */
+struct VoConfig {
+    int devId = 0;
+    int layerId = 0;
+    int chnId = -1;                // -1 表示由 MediaManager 在图层内自动分配
+    std::string intf = "hdmi";     // hdmi / edp / dp / mipi / lcd
+    std::string sync = "1080P60";  // 输出时序，如 1080P60、720P60、4K30、4K60
+    int rectX = 0;                 // 视频层显示区域，宽高为 0 表示与输出分辨率相同
+    int rectY = 0;
+    uint32_t rectWidth = 0;
+    uint32_t rectHeight = 0;
+    int chnRectX = 0;              // 本路通道在视频层内的区域，宽高为 0 表示铺满视频层
+    int chnRectY = 0;
+    uint32_t chnRectWidth = 0;
+    uint32_t chnRectHeight = 0;
+};
+
+/**
+ * @brief 流水线拓扑描述
+ *
+ * VI → VPSS → ┬→ CHN0 → VENC
+ *              ├→ CHN1 → VO
+ *              └→ CHN2 → YUV 输出
+ *
+ * 每个 VPSS 通道独立指定尺寸、格式和帧率，由硬件缩放/抽帧，
+ * 例如算法只需要 640x360@10 时，YUV 通道不必输出整幅 4K@30。
+ *
+ * 可以直接填写结构体，也可以用 loadPipelineConfig() 从文本文件加载，
+ * 同一个程序即可适配 1080p60、4K15 等不同摄像头。多路摄像头时每路一份配置，
+ * VPSS 组、VENC 通道、VO 通道号留空（-1）即可由 MediaManager 分配。
+ */
+struct PipelineConfig {
+    ViConfig vi;
+    int vpssGrpId = -1;            // -1 表示由 MediaManager 自动分配
+    VpssChnConfig vpss[kVpssChnCount];
+    int vencChnId = -1;            // -1 表示由 MediaManager 自动分配
+    EncodeParams venc;             // 宽高为 0 时跟随 VPSS 编码通道
+    VoConfig vo;
+};
+
+/**
+ * @brief 从文本解析流水线配置
+ *
+ * 格式为每行一个 key = value，# 开头为注释，未出现的键保持 config 中的原值。例如：
+ *
+ *   vi.width = 1920
+ *   vi.height = 1080
+ *   vi.fps = 60
+ *   vpss.yuv.width = 640
+ *   vpss.yuv.height = 360
+ *   vpss.yuv.fps = 10
+ *   venc.codec = h265
+ *   venc.rc = vbr
+ *   venc.bitrate = 4M
+ *   vo.rect = 0,0,1280,720
+ *
+ * @param in     输入流
+ * @param config 输入为默认值，输出为解析结果
+ * @param source 来源名称（错误信息用）
+ * @return 成功返回 true；遇到未知键或非法值时打印行号并返回 false
+ */
+bool parsePipelineConfig(std::istream& in, PipelineConfig& config,
+                         const std::string& source = "<config>");
+
+/**
+ * @brief 从文件加载流水线配置
+ */
+bool loadPipelineConfig(const std::string& path, PipelineConfig& config);
+
+/**
+ * @brief 检查配置取值（尺寸非零且为偶数、VPSS 缩放倍数与抽帧、码率/帧率/GOP 为正数等）
+ */
+bool validatePipelineConfig(const PipelineConfig& config);
+
+/**
+ * @brief 检查编码参数（宽高成对且为偶数、码率/帧率/GOP 为正数、码率上限与 QP 范围）
+ *
+ * validatePipelineConfig() 与运行中的 VideoEncoderSvc::reconfigure() 共用。
+ */
+bool validateEncodeParams(const EncodeParams& params);
+
+#endif // PIPELINE_CONFIG_H
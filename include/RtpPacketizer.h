@@ -0,0 +1,97 @@
+#ifndef RTP_PACKETIZER_H
+#define RTP_PACKETIZER_H
+
+#include "VideoEncoderSvc.h"
+#include <cstddef>
+#include <cstdint>
+#include <sys/uio.h>
+#include <vector>
+
+/**
+ * @brief H264/H265 RTP 打包（RFC 6184 / RFC 7798）
+ *
+ * NAL 不超过 MTU 时单 NAL 包发送，超过时切分为 FU-A（H264）/ FU（H265）分片；
+ * AUD 丢弃，VPS/SPS/PPS 随关键帧带内发送，每帧最后一个包置 Marker 位。
+ *
+ * 打包不拷贝码流：每个包由两个 iovec 组成，第一个指向内部的头部区
+ * （RTP 头 + 分片头），第二个直接指向 EncodedFrame 中的 NAL 数据。
+ * 同一组 iovec 可以被多个发送目标共用（sendmmsg 中每个 mmsghdr 指向同一组 iovec）。
+ *
+ * 线程安全：非线程安全，由调用方保证同一时刻只有一个线程打包。
+ */
+class RtpPacketizer {
+public:
+    static const size_t kRtpHeaderSize = 12;
+    static const size_t kMaxHeaderSize = 16;  // RTP 头 + H265 FU 载荷头（3 字节），按 4 字节对齐
+
+    /**
+     * @param payloadType 动态载荷类型（96~127）
+     * @param mtu RTP 包最大长度（RTP 头 + 载荷，不含 IP/UDP 头）
+     */
+    RtpPacketizer(uint8_t payloadType, size_t mtu);
+
+    /**
+     * @brief 打包一帧
+     *
+     * 生成的包引用 frame 的数据，在下一次 packetize() 之前、frame 数据释放之前有效。
+     *
+     * @return 包数
+     */
+    size_t packetize(const EncodedFrame& frame);
+
+    size_t packetCount() const { return m_packetCount; }
+
+    /**
+     * @brief 第 index 个包的 iovec（两个：头部、NAL 数据）
+     */
+    iovec* packetIov(size_t index) { return &m_iov[index * 2]; }
+
+    /**
+     * @brief 第 index 个包的长度（字节）
+     */
+    size_t packetSize(size_t index) const {
+        return m_iov[index * 2].iov_len + m_iov[index * 2 + 1].iov_len;
+    }
+
+    uint32_t ssrc() const { return m_ssrc; }
+
+    /**
+     * @brief 下一个包的序列号
+     */
+    uint16_t nextSequence() const { return m_sequence; }
+
+    /**
+     * @brief 时间戳（微秒）对应的 RTP 时间戳（90kHz，带随机起点）
+     */
+    uint32_t rtpTimestamp(uint64_t timestampUs) const {
+        return static_cast<uint32_t>(timestampUs * 9 / 100) + m_timestampOffset;
+    }
+
+private:
+    struct Nal {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    /**
+     * @brief 写一个包的头部与 iovec
+     *
+     * @param payloadHeader 载荷头（单 NAL 包为空，FU 为指示字节 + 分片头）
+     */
+    void addPacket(size_t index, uint32_t timestamp, bool marker, const uint8_t* payloadHeader,
+                   size_t payloadHeaderSize, const uint8_t* data, size_t size);
+
+    const uint8_t m_payloadType;
+    const size_t m_maxPayload;      // mtu - RTP 头
+
+    uint32_t m_ssrc;
+    uint16_t m_sequence;
+    uint32_t m_timestampOffset;
+
+    std::vector<Nal> m_nals;        // 当前帧的 NAL（已去掉 AUD）
+    std::vector<uint8_t> m_headers; // 每包 kMaxHeaderSize 字节
+    std::vector<iovec> m_iov;       // 每包 2 个
+    size_t m_packetCount = 0;
+};
+
+#endif // RTP_PACKETIZER_H
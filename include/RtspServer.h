@@ -0,0 +1,235 @@
+#ifndef RTSP_SERVER_H
+#define RTSP_SERVER_H
+
+#include "ServiceBase.h"
+#include "RtpPacketizer.h"
+#include "VideoEncoderSvc.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+/**
+ * @brief RTSP 服务参数
+ */
+struct RtspServerConfig {
+    uint16_t port = 8554;                    // RTSP 监听端口，0 表示由系统分配
+    uint16_t rtpPort = 5004;                 // 服务端 RTP 端口（RTCP 为 +1），被占用时向后查找
+    size_t mtu = 1400;                       // RTP 包最大长度（不含 IP/UDP 头）
+    uint32_t maxViewers = 64;                // 每路流的观看会话上限
+    uint32_t sessionTimeoutSec = 60;         // 会话超时：期间没有 RTSP 请求也没有 RTCP 报告
+    int sendBufferBytes = 4 * 1024 * 1024;   // RTP socket 发送缓冲
+};
+
+/**
+ * @brief RTSP 直播服务（RTP over UDP 单播）
+ *
+ * 每路流对应一个 VideoEncoderSvc 的输出，pushFrame() 一般作为订阅者回调：
+ *   int id = server.addStream("live", params.useH265);
+ *   encoderSvc->addSubscriber("rtsp", [&](const EncodedFrame& f) { server.pushFrame(id, f); }, ...);
+ * 客户端地址：rtsp://<ip>:<port>/live
+ *
+ * 扇出不按观看者复制：同一路流的所有观看者共用一个 RTP 流（同一 SSRC 和序列号空间），
+ * 每帧只打包一次，所有观看者的 mmsghdr 指向同一组 iovec（RTP 头 + EncodedFrame 中的 NAL 数据），
+ * 一次 sendmmsg 发给多个观看者。新观看者从下一个关键帧开始接收，参数集在 SDP 与码流中都有。
+ *
+ * 线程模型：
+ * - 服务线程处理 RTSP 连接（OPTIONS/DESCRIBE/SETUP/PLAY/PAUSE/GET_PARAMETER/TEARDOWN）、
+ *   RTCP 报告和会话超时；监听、RTCP 与各连接的 socket 放在自己的 epoll 集合中，
+ *   集合的 fd 作为通道 fd 交给 ServiceBase 等待
+ * - pushFrame() 在调用方线程中打包并发送；观看者列表写时复制，发送时不持有列表锁
+ *
+ * 会话在 TEARDOWN、RTSP 连接断开或超时后结束。只支持 UDP 单播传输（不支持 RTP over TCP）。
+ */
+class RtspServer : public ServiceBase {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        uint32_t connections;      // 当前 RTSP 连接数
+        uint32_t viewers;          // 当前播放中的会话数
+        uint64_t frames;           // 发送的帧数（有观看者时）
+        uint64_t packets;          // 打包的 RTP 包数（每帧一次，不按观看者计）
+        uint64_t datagrams;        // 发出的 UDP 包数（包数 × 观看者数）
+        uint64_t bytes;            // 发出的字节数
+        uint64_t sendCalls;        // sendmmsg 调用次数
+        uint64_t sendErrors;       // 发送失败的包数
+        uint64_t maxFanoutUs;      // 单帧打包 + 发送最大耗时
+    };
+
+    explicit RtspServer(const RtspServerConfig& config = RtspServerConfig());
+    ~RtspServer() override;
+
+    /**
+     * @brief 添加一路流（须在 start() 之前调用）
+     *
+     * @param name 流名称（URL 路径）
+     * @param isH265 编码格式（SDP 使用，收到帧后以帧为准）
+     * @return 流编号，失败返回 -1
+     */
+    int addStream(const std::string& name, bool isH265);
+
+    /**
+     * @brief 创建监听与 RTP/RTCP socket（须在 start() 之前调用）
+     */
+    bool open();
+
+    /**
+     * @brief 发送一帧给该流的所有观看者（可直接作为 VideoEncoderSvc 订阅者回调）
+     *
+     * 同一路流的 pushFrame() 串行执行，不同流可以在不同线程中并发调用。
+     */
+    void pushFrame(int stream, const EncodedFrame& frame);
+
+    /**
+     * @brief 实际监听的 RTSP 端口
+     */
+    uint16_t port() const { return m_port; }
+
+    /**
+     * @brief 实际使用的 RTP 端口
+     */
+    uint16_t rtpPort() const { return m_rtpPort; }
+
+    /**
+     * @brief 该流当前播放中的会话数
+     */
+    uint32_t viewerCount(int stream) const;
+
+    Stats stats() const;
+
+protected:
+    void run() override;
+
+private:
+    /**
+     * @brief 播放中的会话（发送线程只读）
+     */
+    struct Viewer {
+        sockaddr_in rtpAddr;
+        std::atomic<bool> waitKeyFrame{true};   // 还未收到关键帧（发送线程置位后开始发送）
+    };
+
+    typedef std::vector<std::shared_ptr<Viewer>> ViewerList;
+
+    struct Stream {
+        std::string name;
+        std::atomic<bool> isH265{false};
+
+        // 发送（pushFrame 串行）
+        std::mutex sendMutex;
+        std::unique_ptr<RtpPacketizer> packetizer;
+        std::vector<mmsghdr> messages;
+        std::vector<Viewer*> targets;
+
+        // 最近一次关键帧的参数集（SDP 用）
+        std::mutex paramMutex;
+        std::vector<uint8_t> vps;
+        std::vector<uint8_t> sps;
+        std::vector<uint8_t> pps;
+
+        // 观看者列表（写时复制，发送线程取快照）
+        mutable std::mutex viewersMutex;
+        std::shared_ptr<const ViewerList> viewers;
+    };
+
+    struct Session {
+        std::string id;
+        int stream;
+        int connection;                 // 建立会话的 RTSP 连接
+        sockaddr_in rtpAddr;
+        sockaddr_in rtcpAddr;
+        std::shared_ptr<Viewer> viewer; // 播放中时非空
+        std::chrono::steady_clock::time_point lastActive;
+    };
+
+    struct Connection {
+        int fd;
+        sockaddr_in peer;
+        std::string input;
+    };
+
+    struct Request {
+        std::string method;
+        std::string url;
+        std::string cseq;
+        std::map<std::string, std::string> headers;  // 名称小写
+    };
+
+    // 服务线程
+    void handleSocketEvents();
+    void acceptConnections();
+    void readConnection(int fd);
+    void closeConnection(int fd);
+    void readRtcp();
+    void expireSessions();
+    void closeAll();
+    void closeSockets();
+
+    /**
+     * @brief 解析请求头块（请求行 + 头部，不含结尾空行）
+     */
+    static bool parseRequest(const std::string& text, Request& req);
+
+    /**
+     * @brief 处理一个请求
+     */
+    void handleRequest(Connection& conn, const Request& req);
+    void handleDescribe(Connection& conn, const Request& req);
+    void handleSetup(Connection& conn, const Request& req);
+    void handlePlay(Connection& conn, const Request& req, Session& session);
+    void sendResponse(Connection& conn, const Request& req, int code, const char* reason,
+                      const std::string& headers = std::string(),
+                      const std::string& body = std::string());
+
+    /**
+     * @brief 从 URL 路径查找流，找不到返回 -1
+     */
+    int findStream(const std::string& url) const;
+    std::string buildSdp(int stream, const Connection& conn);
+    Session* findSession(const Request& req);
+    void removeSession(const std::string& id);
+
+    // 观看者列表（写时复制）
+    void addViewer(Stream& stream, const std::shared_ptr<Viewer>& viewer);
+    void removeViewer(Stream& stream, const std::shared_ptr<Viewer>& viewer);
+
+    /**
+     * @brief 关键帧：更新 SDP 使用的参数集
+     */
+    void updateParameterSets(Stream& stream, const EncodedFrame& frame);
+
+    const RtspServerConfig m_config;
+
+    std::vector<std::unique_ptr<Stream>> m_streams;
+
+    int m_listenFd = -1;
+    int m_rtpFd = -1;
+    int m_rtcpFd = -1;
+    int m_pollFd = -1;                   // 监听、RTCP 与连接 socket 的 epoll 集合
+    uint16_t m_port = 0;
+    uint16_t m_rtpPort = 0;
+
+    // 服务线程独占
+    std::map<int, Connection> m_connections;
+    std::map<std::string, Session> m_sessions;
+    std::chrono::steady_clock::time_point m_lastExpireCheck;
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+
+    /**
+     * @brief 采集时把 Stats 换算成指标
+     */
+    void collectMetrics(MetricsWriter& writer);
+
+    MetricsCollectorHandle m_metricsCollector;  // 最后一个成员：最先析构，先移除 collector
+};
+
+#endif // RTSP_SERVER_H
@@ -3,11 +3,17 @@
 
 #include <thread>
 #include <atomic>
+#include <pthread.h>
 #include <mutex>
 #include <functional>
 #include <queue>
-#include <condition_variable>
 #include <string>
+#include <type_traits>
+#include "LockFreeRing.h"
+#include "MetricsRegistry.h"
+#include "Task.h"
+#include "TaskFuture.h"
+#include "ThreadAttr.h"
 
 /**
  * @brief 服务基类
@@ -16,6 +22,10 @@
  * - 线程生命周期管理
  * - 任务投递机制
  * - 线程安全的状态管理
+ * - 统一的事件等待（任务 / 停止请求 / MPI 通道 fd 可读，基于 epoll）
+ * - 线程属性（CPU 亲和性、调度策略/优先级、nice、线程名、栈大小，见 setThreadAttr()）
+ * - 运行指标（MetricsRegistry，标签 service=<名称>、instance=<同名服务序号>）：
+ *   任务数、各类唤醒次数、运行状态，子类可以通过 enableFrameMetrics() 等添加帧路径指标
  */
 class ServiceBase {
 public:
@@ -26,6 +36,15 @@ public:
     ServiceBase(const ServiceBase&) = delete;
     ServiceBase& operator=(const ServiceBase&) = delete;
 
+    /**
+     * @brief 设置服务线程属性（在 start() 之前调用，运行中修改在下次启动时生效）
+     *
+     * 子类构造时设置默认值：编码取流服务放在大核并使用 SCHED_FIFO，YUV 服务放在大核
+     * 但使用普通调度（同步回调运行应用代码），其余服务放在小核。线程名为空时使用服务名（同名服务附加序号）。
+     */
+    void setThreadAttr(const ThreadAttr& attr);
+    ThreadAttr threadAttr() const;
+
     /**
      * @brief 启动服务线程
      */
@@ -41,6 +60,14 @@ public:
      */
     void join();
 
+    /**
+     * @brief 带超时地等待线程退出
+     *
+     * @param timeoutMs 超时（毫秒），-1 表示一直等待
+     * @return 线程已退出（或未启动）返回 true；超时返回 false，线程保持可 join
+     */
+    bool join(int timeoutMs);
+
     /**
      * @brief 检查服务是否运行中
      */
@@ -56,57 +83,156 @@ public:
     /**
      * @brief 投递任务到服务线程
      * 
+     * 任务写入无锁环形队列，小函数对象不产生堆分配；
+     * 环形队列满时退化到带锁的溢出队列，保证任务不丢失且保持投递顺序。
+     *
      * @param f 要执行的任务（函数对象）
      */
     template<typename F>
     void post(F&& f) {
-        {
-            std::lock_guard<std::mutex> lock(m_taskMutex);
-            m_taskQueue.push(std::forward<F>(f));
+        enqueueTask(Task(std::forward<F>(f)));
+    }
+
+    /**
+     * @brief 异步投递任务，返回可等待的 future
+     *
+     * 任务返回 bool 时以返回值表示成功与否，抛出异常视为失败。
+     * 服务未运行时不投递，直接返回已取消的 future；服务停止时未执行的任务被标记为取消。
+     * 注意：等待超时后任务仍可能被执行，函数对象不要按引用捕获调用方的局部变量
+     * （需要超时后放弃任务时先调用 TaskFuture::cancel()）。
+     *
+     * @param f 要执行的任务
+     */
+    template<typename F>
+    TaskFuture postAsync(F&& f) {
+        TaskPromise promise;
+        TaskFuture future = promise.getFuture();
+        // 先登记再检查运行标志：服务线程退出时等登记清零后才丢弃剩余任务，
+        // 检查通过后入队的任务要么被执行，要么被取消，不会滞留在队列中
+        PostingGuard guard(m_posting);
+        if (!m_running.load()) {
+            return future;  // promise 析构时标记为 Cancelled
         }
-        m_taskCv.notify_one();
+        enqueueTask(Task(AsyncTask<typename std::decay<F>::type>(std::forward<F>(f),
+                                                                  std::move(promise))));
+        return future;
     }
 
     /**
      * @brief 同步投递任务（投递并等待完成）
      * 
+     * 在服务线程中调用时直接执行，避免自身死锁。
+     * 超时后会尝试取消任务；任务已开始执行时继续等待其结束，
+     * 因此按引用捕获局部变量是安全的。
+     *
      * @param f 要执行的任务
+     * @param timeoutMs 超时（毫秒），-1 表示一直等待
+     * @return 任务执行成功返回 true；服务未运行、超时取消或执行失败返回 false
      */
     template<typename F>
-    void postSync(F&& f) {
-        std::mutex syncMutex;
-        std::condition_variable syncCv;
-        bool done = false;
-
-        post([&]() {
-            f();
-            {
-                std::lock_guard<std::mutex> lock(syncMutex);
-                done = true;
-            }
-            syncCv.notify_one();
-        });
-
-        std::unique_lock<std::mutex> lock(syncMutex);
-        syncCv.wait(lock, [&] { return done; });
+    bool postSync(F&& f, int timeoutMs = -1) {
+        if (isInServiceThread()) {
+            TaskPromise promise;
+            TaskFuture future = promise.getFuture();
+            Task task(AsyncTask<typename std::decay<F>::type>(std::forward<F>(f),
+                                                               std::move(promise)));
+            runTask(task);
+            return future.status() == TaskStatus::Done;
+        }
+
+        TaskFuture future = postAsync(std::forward<F>(f));
+        if (!future.wait(timeoutMs) && !future.cancel()) {
+            // 任务已在执行，必须等它结束（函数对象可能引用调用方栈上的数据）
+            future.wait(-1);
+        }
+        return future.status() == TaskStatus::Done;
     }
 
 protected:
+    /**
+     * @brief waitEvents() 返回的事件位
+     */
+    enum WaitEvent {
+        WAIT_TIMEOUT = 0,        // 超时，无事件
+        WAIT_TASK    = 1 << 0,   // 有新任务投递或收到停止请求
+        WAIT_CHANNEL = 1 << 1,   // MPI 通道 fd 可读（有帧/码流可取）
+    };
+
     /**
      * @brief 服务线程主循环（子类实现）
      */
     virtual void run() = 0;
 
     /**
-     * @brief 处理任务队列
+     * @brief 处理任务队列（非阻塞，执行当前所有待处理任务后立即返回）
      */
     void processTasks();
 
+    /**
+     * @brief 等待事件：新任务、停止请求或 MPI 通道 fd 可读
+     *
+     * 服务线程在此阻塞，代替固定间隔的 usleep 轮询。
+     *
+     * @param timeoutMs 超时时间（毫秒），-1 表示一直等待
+     * @return WaitEvent 位组合，超时返回 WAIT_TIMEOUT
+     */
+    int waitEvents(int timeoutMs);
+
+    /**
+     * @brief 设置参与等待的 MPI 通道 fd（如 RK_MPI_VENC_GetFd 的返回值）
+     *
+     * 只能在服务线程中调用。传入 -1 表示移除当前 fd。
+     *
+     * @return fd 已加入等待集合返回 true
+     */
+    bool setChannelFd(int fd);
+
+    /**
+     * @brief 是否已有 MPI 通道 fd 参与等待
+     */
+    bool hasChannelFd() const { return m_channelFd >= 0; }
+
+    /**
+     * @brief 帧路径通用指标（enableFrameMetrics() 之后非空）
+     */
+    struct FrameMetrics {
+        std::shared_ptr<MetricCounter> framesIn;       // 从 MPI 取到的帧
+        std::shared_ptr<MetricCounter> framesOut;      // 交给回调/订阅者的帧
+        std::shared_ptr<MetricCounter> framesDropped;  // 取到但未交付的帧
+        std::shared_ptr<MetricCounter> bytes;          // 交付的字节数
+        std::shared_ptr<MetricCounter> timeouts;       // 取帧时没有数据（超时或空唤醒）
+    };
+
+    /**
+     * @brief 创建帧路径通用指标（子类构造时调用）
+     */
+    void enableFrameMetrics();
+
+    /**
+     * @brief 本服务的指标标签（service、instance 以及 extra）
+     */
+    MetricLabels metricLabels(const MetricLabels& extra = MetricLabels()) const;
+
+    /**
+     * @brief 按 MPI 接口和错误码计数（错误路径，首次出现时注册）
+     */
+    void countMpiError(const char* call, int code);
+
+    /**
+     * @brief 回调耗时直方图（按订阅者名称，同名共用）
+     */
+    std::shared_ptr<MetricHistogram> callbackHistogram(const std::string& subscriber);
+
     /**
      * @brief 服务名称（用于日志）
      */
     std::string m_name;
 
+    /**
+     * @brief 帧路径通用指标
+     */
+    FrameMetrics m_frameMetrics;
+
     /**
      * @brief 运行标志
      */
@@ -114,9 +240,73 @@ protected:
 
 private:
     /**
-     * @brief 线程对象
+     * @brief postAsync() 进行中的登记（构造时加一，析构时减一）
+     */
+    class PostingGuard {
+    public:
+        explicit PostingGuard(std::atomic<int>& count) : m_count(count) { m_count.fetch_add(1); }
+        ~PostingGuard() { m_count.fetch_sub(1); }
+        PostingGuard(const PostingGuard&) = delete;
+        PostingGuard& operator=(const PostingGuard&) = delete;
+
+    private:
+        std::atomic<int>& m_count;
+    };
+
+    /**
+     * @brief 任务入队并唤醒服务线程
+     */
+    void enqueueTask(Task&& task);
+
+    /**
+     * @brief 执行单个任务（捕获异常）
+     */
+    void runTask(Task& task);
+
+    /**
+     * @brief 丢弃所有未执行的任务（异步任务被标记为取消）
      */
-    std::thread m_thread;
+    void discardTasks();
+
+    /**
+     * @brief 唤醒 waitEvents()（已有未消费的唤醒时不重复写 eventfd）
+     */
+    void wakeup();
+
+    /**
+     * @brief 写 eventfd
+     */
+    void signalEventFd();
+
+    /**
+     * @brief 线程入口（pthread_create 的参数为 std::function<void()>*，由入口释放）
+     */
+    static void* threadEntry(void* arg);
+
+    /**
+     * @brief 默认线程名（服务名，同名服务附加序号，截断到 15 字符）
+     */
+    std::string defaultThreadName() const;
+
+    /**
+     * @brief 线程对象（直接用 pthread 创建以便指定栈大小）
+     */
+    pthread_t m_thread{};
+
+    /**
+     * @brief 线程已创建且尚未 join
+     */
+    bool m_threadJoinable = false;
+
+    /**
+     * @brief 线程属性
+     */
+    ThreadAttr m_threadAttr;
+
+    /**
+     * @brief 保护 m_threadAttr
+     */
+    mutable std::mutex m_threadAttrMutex;
 
     /**
      * @brief 线程ID
@@ -124,19 +314,76 @@ private:
     std::thread::id m_threadId;
 
     /**
-     * @brief 任务队列
+     * @brief 线程退出通知（用于带超时的 join）
+     */
+    TaskFuture m_exitFuture;
+
+    /**
+     * @brief 环形任务队列容量
+     */
+    static const size_t kTaskRingCapacity = 256;
+
+    /**
+     * @brief 任务队列（无锁，多生产者/单消费者）
+     */
+    LockFreeRing<Task> m_taskRing{kTaskRingCapacity};
+
+    /**
+     * @brief 溢出任务队列（环形队列满时使用）
+     */
+    std::queue<Task> m_overflowQueue;
+
+    /**
+     * @brief 溢出队列互斥锁
+     */
+    std::mutex m_overflowMutex;
+
+    /**
+     * @brief 溢出队列非空标志（置位期间新任务全部进入溢出队列，保证顺序）
+     */
+    std::atomic<bool> m_overflowActive{false};
+
+    /**
+     * @brief 正在 postAsync() 中（已检查运行标志、尚未完成入队）的调用数
+     *
+     * 与 m_running 构成 Dekker 式握手（均为 seq_cst）：投递方先加一再读 m_running，
+     * 服务线程退出时先清 m_running 再等待本计数归零，之后 discardTasks() 能看到所有已入队的任务。
+     */
+    std::atomic<int> m_posting{0};
+
+    /**
+     * @brief 是否已有未消费的唤醒（合并连续投递的 eventfd 写入）
+     */
+    std::atomic<bool> m_wakePending{false};
+
+    /**
+     * @brief epoll 句柄（等待集合：m_eventFd + m_channelFd）
+     */
+    int m_epollFd = -1;
+
+    /**
+     * @brief 任务/停止通知用的 eventfd
+     */
+    int m_eventFd = -1;
+
+    /**
+     * @brief 当前参与等待的 MPI 通道 fd
      */
-    std::queue<std::function<void()>> m_taskQueue;
+    int m_channelFd = -1;
 
     /**
-     * @brief 任务队列互斥锁
+     * @brief 同名服务中的序号（指标 instance 标签）
      */
-    std::mutex m_taskMutex;
+    int m_metricInstance;
 
     /**
-     * @brief 任务队列条件变量
+     * @brief 服务线程指标
      */
-    std::condition_variable m_taskCv;
+    std::shared_ptr<MetricCounter> m_tasksMetric;
+    std::shared_ptr<MetricCounter> m_wakeTaskMetric;
+    std::shared_ptr<MetricCounter> m_wakeChannelMetric;
+    std::shared_ptr<MetricCounter> m_wakeTimeoutMetric;
+    std::shared_ptr<MetricGauge> m_runningMetric;
 };
 
 #endif // SERVICE_BASE_H
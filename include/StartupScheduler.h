@@ -0,0 +1,107 @@
+#ifndef STARTUP_SCHEDULER_H
+#define STARTUP_SCHEDULER_H
+
+#include "TaskFuture.h"
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 单个启动阶段的执行记录
+ */
+struct StartupStageTiming {
+    std::string name;
+    TaskStatus status = TaskStatus::Pending;  // Done / Failed / Cancelled（依赖失败未执行）
+    int64_t startUs = 0;                      // 相对 run() 开始的时间（微秒）
+    int64_t durationUs = 0;
+};
+
+/**
+ * @brief 按依赖关系并行执行的启动调度器
+ *
+ * 各模块初始化（VI 设备使能、VPSS 建组、VENC 建通道、VO 图层配置等）都是阻塞的 MPI 调用，
+ * 彼此没有依赖的阶段在不同线程上同时执行，依赖满足后才开始下一阶段；
+ * 某个阶段失败时，依赖它的阶段不再执行（状态为 Cancelled）。
+ *
+ * 用法：
+ *   StartupScheduler s;
+ *   int vi   = s.addStage("vi", initVi);
+ *   int vpss = s.addStage("vpss", initVpss, { vi });
+ *   int venc = s.addStage("venc", initVenc);
+ *   s.addStage("bind", bind, { vpss, venc });
+ *   s.run();
+ */
+class StartupScheduler {
+public:
+    using StageFunc = std::function<bool()>;
+
+    StartupScheduler();
+
+    /**
+     * @brief 最大并行线程数，1 表示按添加顺序串行执行（默认为 CPU 核数，至少 4）
+     */
+    void setMaxThreads(int maxThreads);
+
+    /**
+     * @brief 添加阶段
+     *
+     * @param name 阶段名称（计时输出用）
+     * @param func 阶段函数，返回 false 表示失败
+     * @param deps 依赖的阶段（必须是已添加的阶段）
+     * @return 阶段 ID
+     */
+    int addStage(const std::string& name, StageFunc func, std::initializer_list<int> deps = {});
+    int addStage(const std::string& name, StageFunc func, const std::vector<int>& deps);
+
+    /**
+     * @brief 执行所有阶段，全部结束后返回
+     *
+     * @return 所有阶段都成功返回 true
+     */
+    bool run();
+
+    /**
+     * @brief 阶段结束状态（run() 之后有效）
+     */
+    TaskStatus getStatus(int stage) const;
+
+    /**
+     * @brief 各阶段执行记录（按添加顺序）
+     */
+    std::vector<StartupStageTiming> getTimings() const;
+
+    /**
+     * @brief 已添加的阶段数
+     */
+    int getStageCount() const { return static_cast<int>(m_stages.size()); }
+
+    /**
+     * @brief run() 总耗时（微秒）
+     */
+    int64_t getTotalUs() const { return m_totalUs; }
+
+    /**
+     * @brief 打印各阶段耗时
+     */
+    void printTimings(std::ostream& out) const;
+
+private:
+    struct Stage {
+        StageFunc func;
+        std::vector<int> deps;
+        std::vector<int> dependents;
+        int pendingDeps = 0;
+        StartupStageTiming timing;
+    };
+
+    static const int kMinDefaultThreads = 4;
+
+    std::vector<Stage> m_stages;
+    int m_maxThreads;
+    int64_t m_totalUs = 0;
+};
+
+#endif // STARTUP_SCHEDULER_H
@@ -0,0 +1,128 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief 可投递任务（只可移动的 void() 函数对象包装）
+ *
+ * 与 std::function 不同，较小的函数对象（lambda 捕获不超过 kInlineSize 字节）
+ * 直接存放在对象内部，投递时不产生堆分配；超出时才退化为堆上存储。
+ */
+class Task {
+public:
+    static const size_t kInlineSize = 48;
+
+    Task() : m_ops(nullptr) {}
+
+    template<typename F,
+             typename = typename std::enable_if<
+                 !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F&& f) : m_ops(nullptr) {
+        typedef typename std::decay<F>::type Fn;
+        init<Fn>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Fn>()>());
+    }
+
+    Task(Task&& other) noexcept : m_ops(other.m_ops) {
+        if (m_ops) {
+            m_ops->relocate(&other.m_storage, &m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_ops = other.m_ops;
+            if (m_ops) {
+                m_ops->relocate(&other.m_storage, &m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    /**
+     * @brief 执行任务
+     */
+    void operator()() { m_ops->invoke(&m_storage); }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    /**
+     * @brief 释放持有的函数对象
+     */
+    void reset() {
+        if (m_ops) {
+            m_ops->destroy(&m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* from, void* to);  // 移动到新位置并析构旧对象
+        void (*destroy)(void* storage);
+    };
+
+    typedef typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type Storage;
+
+    template<typename Fn>
+    static constexpr bool fitsInline() {
+        return sizeof(Fn) <= kInlineSize &&
+               alignof(std::max_align_t) % alignof(Fn) == 0 &&
+               std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    // 内联存储：函数对象直接构造在 m_storage 中
+    template<typename Fn>
+    struct InlineOps {
+        static void invoke(void* s) { (*static_cast<Fn*>(s))(); }
+        static void relocate(void* from, void* to) {
+            Fn* src = static_cast<Fn*>(from);
+            new (to) Fn(std::move(*src));
+            src->~Fn();
+        }
+        static void destroy(void* s) { static_cast<Fn*>(s)->~Fn(); }
+    };
+
+    // 堆存储：m_storage 中只保存指针
+    template<typename Fn>
+    struct HeapOps {
+        static void invoke(void* s) { (**static_cast<Fn**>(s))(); }
+        static void relocate(void* from, void* to) {
+            *static_cast<Fn**>(to) = *static_cast<Fn**>(from);
+        }
+        static void destroy(void* s) { delete *static_cast<Fn**>(s); }
+    };
+
+    template<typename Fn, typename F>
+    void init(F&& f, std::true_type /* inline */) {
+        static const Ops ops = { &InlineOps<Fn>::invoke, &InlineOps<Fn>::relocate,
+                                 &InlineOps<Fn>::destroy };
+        new (&m_storage) Fn(std::forward<F>(f));
+        m_ops = &ops;
+    }
+
+    template<typename Fn, typename F>
+    void init(F&& f, std::false_type /* heap */) {
+        static const Ops ops = { &HeapOps<Fn>::invoke, &HeapOps<Fn>::relocate,
+                                 &HeapOps<Fn>::destroy };
+        *reinterpret_cast<Fn**>(&m_storage) = new Fn(std::forward<F>(f));
+        m_ops = &ops;
+    }
+
+    Storage m_storage;
+    const Ops* m_ops;
+};
+
+#endif // TASK_H
@@ -0,0 +1,205 @@
+#ifndef TASK_FUTURE_H
+#define TASK_FUTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 异步任务状态
+ */
+enum class TaskStatus {
+    Pending,    // 等待执行
+    Running,    // 正在执行
+    Done,       // 执行成功
+    Failed,     // 执行失败（抛出异常或返回 false）
+    Cancelled,  // 未执行（服务已停止、任务被丢弃或调用方取消）
+};
+
+/**
+ * @brief 完成槽（TaskFuture/TaskPromise 共享的状态）
+ *
+ * 状态字同时作为 futex 等待字，等待方不需要 mutex/condition_variable。
+ * 槽位来自进程级的无锁对象池，池耗尽时才在堆上分配。
+ */
+struct CompletionSlot {
+    std::atomic<uint32_t> state;  // 低位为 TaskStatus，kWaiterBit 表示有等待者
+    std::atomic<uint32_t> refs;   // 引用计数（future + promise）
+    std::atomic<uint32_t> next;   // 空闲链表链接（池内下标 + 1）
+    uint32_t index;               // 池内下标，kHeapIndex 表示堆分配
+
+    static const uint32_t kWaiterBit = 0x80000000u;
+    static const uint32_t kStatusMask = 0x7fffffffu;
+    static const uint32_t kHeapIndex = 0xffffffffu;
+
+    static CompletionSlot* acquire();
+    void addRef() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+
+    TaskStatus status() const {
+        return static_cast<TaskStatus>(state.load(std::memory_order_acquire) & kStatusMask);
+    }
+
+    /**
+     * @brief 状态迁移：仅当当前状态为 from 时迁移到 to（保留等待位）
+     */
+    bool transition(TaskStatus from, TaskStatus to);
+
+    /**
+     * @brief 等待进入终止状态（Done/Failed/Cancelled）
+     *
+     * @param timeoutMs 超时（毫秒），-1 表示一直等待
+     * @return 已进入终止状态返回 true，超时返回 false
+     */
+    bool wait(int timeoutMs);
+};
+
+/**
+ * @brief 轻量 future：查询/等待 postAsync() 投递的任务
+ *
+ * 可拷贝，拷贝之间共享同一个完成槽。
+ */
+class TaskFuture {
+public:
+    TaskFuture() : m_slot(nullptr) {}
+    explicit TaskFuture(CompletionSlot* slot) : m_slot(slot) {
+        if (m_slot) {
+            m_slot->addRef();
+        }
+    }
+    TaskFuture(const TaskFuture& other) : TaskFuture(other.m_slot) {}
+    TaskFuture(TaskFuture&& other) noexcept : m_slot(other.m_slot) { other.m_slot = nullptr; }
+    TaskFuture& operator=(TaskFuture other) {
+        std::swap(m_slot, other.m_slot);
+        return *this;
+    }
+    ~TaskFuture() {
+        if (m_slot) {
+            m_slot->release();
+        }
+    }
+
+    bool valid() const { return m_slot != nullptr; }
+
+    TaskStatus status() const { return m_slot ? m_slot->status() : TaskStatus::Cancelled; }
+
+    /**
+     * @brief 是否已结束（成功、失败或取消）
+     */
+    bool ready() const {
+        TaskStatus s = status();
+        return s == TaskStatus::Done || s == TaskStatus::Failed || s == TaskStatus::Cancelled;
+    }
+
+    /**
+     * @brief 等待任务结束
+     *
+     * @param timeoutMs 超时（毫秒），-1 表示一直等待
+     * @return 任务已结束返回 true，超时返回 false
+     */
+    bool wait(int timeoutMs = -1) const { return m_slot ? m_slot->wait(timeoutMs) : true; }
+
+    /**
+     * @brief 尝试取消尚未开始执行的任务
+     *
+     * @return 取消成功返回 true；任务已在执行或已结束返回 false
+     */
+    bool cancel() {
+        return m_slot && m_slot->transition(TaskStatus::Pending, TaskStatus::Cancelled);
+    }
+
+    /**
+     * @brief 等待一组任务全部结束（共享同一个截止时间）
+     *
+     * @return 全部结束返回 true，超时返回 false
+     */
+    static bool waitAll(const std::vector<TaskFuture>& futures, int timeoutMs = -1);
+
+private:
+    CompletionSlot* m_slot;
+};
+
+/**
+ * @brief promise：任务执行端持有，负责设置结束状态
+ *
+ * 未设置结束状态就被销毁（例如服务停止时丢弃任务）时自动标记为 Cancelled。
+ */
+class TaskPromise {
+public:
+    TaskPromise() : m_slot(CompletionSlot::acquire()) {}
+    TaskPromise(TaskPromise&& other) noexcept : m_slot(other.m_slot) { other.m_slot = nullptr; }
+    TaskPromise& operator=(TaskPromise&& other) noexcept {
+        std::swap(m_slot, other.m_slot);
+        return *this;
+    }
+    TaskPromise(const TaskPromise&) = delete;
+    TaskPromise& operator=(const TaskPromise&) = delete;
+    ~TaskPromise() {
+        if (m_slot) {
+            finish(TaskStatus::Cancelled);
+            m_slot->release();
+        }
+    }
+
+    TaskFuture getFuture() const { return TaskFuture(m_slot); }
+
+    /**
+     * @brief 开始执行（调用方已取消时返回 false，任务不应再执行）
+     */
+    bool begin() { return m_slot->transition(TaskStatus::Pending, TaskStatus::Running); }
+
+    /**
+     * @brief 设置结束状态（只有第一次设置生效）
+     */
+    void finish(TaskStatus status) {
+        if (!m_slot->transition(TaskStatus::Running, status)) {
+            m_slot->transition(TaskStatus::Pending, status);
+        }
+    }
+
+private:
+    CompletionSlot* m_slot;
+};
+
+/**
+ * @brief postAsync() 投递的任务包装：执行函数对象并通过 promise 报告结果
+ *
+ * 返回 bool 的函数对象以返回值作为成功与否；其它返回类型以是否抛出异常判断。
+ */
+template<typename Fn>
+class AsyncTask {
+public:
+    template<typename F>
+    AsyncTask(F&& f, TaskPromise&& promise)
+        : m_fn(std::forward<F>(f)), m_promise(std::move(promise)) {}
+
+    AsyncTask(AsyncTask&& other) noexcept(std::is_nothrow_move_constructible<Fn>::value)
+        : m_fn(std::move(other.m_fn)), m_promise(std::move(other.m_promise)) {}
+
+    void operator()() {
+        if (!m_promise.begin()) {
+            return;  // 调用方已取消
+        }
+        try {
+            bool ok = invoke(std::is_same<typename std::result_of<Fn&()>::type, bool>());
+            m_promise.finish(ok ? TaskStatus::Done : TaskStatus::Failed);
+        } catch (...) {
+            m_promise.finish(TaskStatus::Failed);
+            throw;
+        }
+    }
+
+private:
+    bool invoke(std::true_type /* returns bool */) { return m_fn(); }
+    bool invoke(std::false_type) {
+        m_fn();
+        return true;
+    }
+
+    Fn m_fn;
+    TaskPromise m_promise;
+};
+
+#endif // TASK_FUTURE_H
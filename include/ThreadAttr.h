@@ -0,0 +1,76 @@
+#ifndef THREAD_ATTR_H
+#define THREAD_ATTR_H
+
+#include <cstddef>
+#include <sched.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 服务线程属性
+ *
+ * 在 ServiceBase::start() 之前通过 setThreadAttr() 设置。栈大小在创建线程时生效，
+ * 其余属性由新线程在进入 run() 之前对自身设置；设置失败（如无 CAP_SYS_NICE 时的实时调度、
+ * 不存在的 CPU）只打印警告，线程按默认属性继续运行。
+ */
+struct ThreadAttr {
+    std::vector<int> cpus;        // 允许运行的 CPU，空表示不限制；本机不存在的 CPU 被忽略
+    int policy = SCHED_OTHER;     // SCHED_OTHER / SCHED_FIFO / SCHED_RR
+    int priority = 0;             // 实时优先级（1-99，仅 SCHED_FIFO / SCHED_RR）
+    int nice = 0;                 // nice 值（仅 SCHED_OTHER），0 表示不修改
+    std::string name;             // 线程名（最长 15 字符），空表示使用服务名
+    size_t stackSize = 0;         // 栈大小（字节），0 表示系统默认
+
+    /**
+     * @brief 取帧线程默认属性：RK3588 大核（A76，CPU 4-7），SCHED_FIFO
+     *
+     * VENC/VPSS 输出缓冲很浅，取帧线程被抢占时硬件直接丢帧，
+     * 放在大核并以实时优先级运行，不与分析等普通线程争抢。
+     */
+    static ThreadAttr captureDrain();
+
+    /**
+     * @brief 帧回调线程默认属性：RK3588 大核，普通调度
+     *
+     * 同步回调中运行的是应用代码（如分析算法），不能以实时优先级运行，
+     * 否则会抢占同在大核上的编码取流线程。
+     */
+    static ThreadAttr frameCallback();
+
+    /**
+     * @brief 后台服务默认属性：RK3588 小核（A55，CPU 0-3），普通调度
+     */
+    static ThreadAttr background();
+
+    /**
+     * @brief 取帧线程默认实时优先级
+     */
+    static const int kCaptureDrainPriority = 10;
+};
+
+/**
+ * @brief RK3588 大核 / 小核编号
+ */
+std::vector<int> rk3588BigCores();
+std::vector<int> rk3588LittleCores();
+
+/**
+ * @brief 对调用线程应用 attr（不含栈大小）
+ *
+ * @param attr    线程属性
+ * @param logName 日志前缀
+ * @return 全部属性设置成功返回 true
+ */
+bool applyThreadAttr(const ThreadAttr& attr, const std::string& logName);
+
+/**
+ * @brief 读取调用线程当前实际生效的属性（CPU 集合为全部 CPU 时返回空）
+ */
+ThreadAttr currentThreadAttr();
+
+/**
+ * @brief 属性的可读描述（用于日志），如 "cpus 4-7, SCHED_FIFO 10"
+ */
+std::string describeThreadAttr(const ThreadAttr& attr);
+
+#endif // THREAD_ATTR_H
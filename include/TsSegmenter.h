@@ -0,0 +1,165 @@
+#ifndef TS_SEGMENTER_H
+#define TS_SEGMENTER_H
+
+#include "VideoEncoderSvc.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief TS 分段录像参数
+ */
+struct TsSegmenterConfig {
+    std::string dir;                            // 输出目录（需已存在）
+    std::string prefix = "seg";                 // 分段文件名前缀：<prefix><序号>.ts
+    std::string playlist = "index.m3u8";        // 播放列表文件名（空表示不写）
+    uint32_t segmentMs = 6000;                  // 分段时长：到达后的下一个关键帧开始新分段
+    uint32_t playlistSize = 10;                 // 播放列表窗口（最近的分段数）
+    uint32_t maxSegments = 0;                   // 保留的分段数上限，0 表示不限
+    uint64_t maxBytes = 0;                      // 保留的分段总字节数上限，0 表示不限
+    size_t writeBufferBytes = 256 * 1024;       // 写缓冲（攒满后一次 pwrite）
+    size_t preallocateBytes = 16 * 1024 * 1024; // 第一个分段的预分配大小，之后按上一分段大小估算，0 表示不预分配
+};
+
+/**
+ * @brief MPEG-TS 打包与分段录像（H264/H265）
+ *
+ * 输入 VideoEncoderSvc 输出的 EncodedFrame（Annex-B），每帧一个 PES（PTS，首包带 PCR），
+ * 每个分段开头和每个关键帧前插入 PAT/PMT，分段从关键帧开始，可以单独播放。
+ *
+ * 长时间录像的写盘：
+ * - TS 包直接生成到写缓冲中，攒满 writeBufferBytes 才 pwrite 一次，不逐帧写
+ * - 新分段按上一分段的大小 fallocate（KEEP_SIZE）预分配，关闭时截断到实际长度，
+ *   文件在盘上连续，写入过程中不产生块分配
+ * - 关闭分段时 fdatasync 并丢弃页缓存，之后才更新播放列表
+ *
+ * 滚动保留：分段数或总字节数超出上限时删除最旧的分段。open() 时扫描目录中同前缀的旧分段，
+ * 序号接着往后编，旧分段计入保留预算（不进入播放列表）。
+ * 播放列表写临时文件后 rename，读取方不会看到写了一半的列表。
+ *
+ * 线程安全：writeFrame() 一般在订阅者线程中调用，close()/stats() 可在其他线程调用。
+ */
+class TsSegmenter {
+public:
+    /**
+     * @brief 统计信息
+     */
+    struct Stats {
+        uint64_t segments;         // 完成的分段数
+        uint64_t deletedSegments;  // 因保留上限删除的分段数
+        uint64_t frames;           // 写入的帧数
+        uint64_t bytes;            // 写入的字节数
+        uint64_t droppedFrames;    // 丢弃的帧数（第一个关键帧之前、写入失败）
+        uint64_t writeErrors;      // 写入失败次数
+        uint64_t maxWriteUs;       // 单次写出（pwrite 或分段收尾）最大耗时
+    };
+
+    explicit TsSegmenter(const TsSegmenterConfig& config);
+    ~TsSegmenter();
+
+    TsSegmenter(const TsSegmenter&) = delete;
+    TsSegmenter& operator=(const TsSegmenter&) = delete;
+
+    /**
+     * @brief 开始录像（扫描目录中已有的分段）
+     */
+    bool open();
+
+    /**
+     * @brief 写入一帧（可直接作为 VideoEncoderSvc 订阅者回调）
+     *
+     * @return 未打开或写入失败时返回 false
+     */
+    bool writeFrame(const EncodedFrame& frame);
+
+    /**
+     * @brief 结束当前分段，播放列表追加 EXT-X-ENDLIST
+     */
+    bool close();
+
+    Stats stats() const;
+
+private:
+    struct Segment {
+        uint64_t sequence;
+        std::string name;
+        uint64_t bytes;
+        double duration;      // 秒，open() 时扫描到的旧分段为 0（不进入播放列表）
+        bool discontinuity;   // 与上一分段之间码流不连续（编码格式变化、重新开始录像）
+    };
+
+    bool openSegment(const EncodedFrame& frame);
+    bool closeSegment(uint64_t endTimestamp);
+
+    /**
+     * @brief 按保留上限删除最旧的分段
+     */
+    void applyRetention();
+
+    void writePlaylist(bool endList);
+    void scanExistingSegments();
+
+    /**
+     * @brief 写 PAT + PMT
+     */
+    void writeTables();
+
+    /**
+     * @brief 把一帧打包为 PES 并切分为 TS 包
+     */
+    void writePes(const EncodedFrame& frame);
+
+    /**
+     * @brief 在写缓冲中分配一个 TS 包，缓冲满时先写出
+     */
+    uint8_t* nextPacket();
+
+    bool flushBuffer();
+
+    /**
+     * @brief 保证当前分段已预分配到 end
+     */
+    void preallocate(uint64_t end);
+
+    std::string segmentPath(const std::string& name) const;
+
+    const TsSegmenterConfig m_config;
+
+    mutable std::mutex m_mutex;
+    bool m_opened = false;
+    bool m_writeFailed = false;      // 当前分段写入失败，等下一个关键帧开新分段
+
+    // 当前分段
+    int m_fd = -1;
+    Segment m_current;
+    uint64_t m_segmentStart = 0;     // 分段第一帧时间戳（微秒）
+    uint64_t m_lastTimestamp = 0;
+    uint64_t m_lastFrameInterval = 0;
+    bool m_isH265 = false;
+    uint64_t m_offset = 0;
+    uint64_t m_allocated = 0;
+    bool m_preallocate = true;
+    uint64_t m_nextPrealloc = 0;
+    bool m_nextDiscontinuity = true;
+
+    // TS 连续计数器
+    uint8_t m_ccPat = 0;
+    uint8_t m_ccPmt = 0;
+    uint8_t m_ccVideo = 0;
+
+    // 写缓冲（按 TS 包对齐）
+    std::vector<uint8_t> m_buffer;
+    size_t m_bufferUsed = 0;
+
+    // 已完成的分段（最旧的在前）与序号
+    std::deque<Segment> m_segments;
+    uint64_t m_retainedBytes = 0;
+    uint64_t m_nextSequence = 0;
+
+    Stats m_stats;
+};
+
+#endif // TS_SEGMENTER_H
@@ -3,33 +3,89 @@
 
 #include "ServiceBase.h"
 #include "VideoFrame.h"
+#include "PacketBufferPool.h"
+#include "FrameDispatcher.h"
+#include "FrameSequenceTracker.h"
 #include <functional>
 #include <memory>
+#include <atomic>
+
+class EncodedFrameRing;
+class LatencyTracer;
+
+/**
+ * @brief 编码数据片段（对应 VENC_STREAM_S 中的一个 pack）
+ */
+struct EncodedSegment {
+    const uint8_t* data;
+    size_t size;
+};
 
 /**
  * @brief 编码后的帧数据
+ *
+ * 一帧可能由多个 pack 组成（SPS/PPS/SEI 与多 slice 分开输出），segments 按顺序覆盖整帧。
+ * contiguous 为 true 时也可以直接按 data/size 连续读取；零拷贝模式下各 pack 位于
+ * 不同缓冲区时 contiguous 为 false，此时必须按 segments 读取（例如 writev）。
  */
 struct EncodedFrame {
-    std::shared_ptr<uint8_t> data;  // 编码后的数据
-    size_t size;                     // 数据大小
+    static const int kMaxSegments = 16;
+
+    std::shared_ptr<uint8_t> data;  // 编码后的数据（零拷贝模式下直接指向 VENC 缓冲区）
+    size_t size;                     // 数据大小（所有片段之和）
     uint64_t timestamp;              // 时间戳
-    bool isKeyFrame;                 // 是否为关键帧
+    bool isKeyFrame;                 // 是否为关键帧（IDR/IRAP）
     uint32_t width;                  // 原始宽度
     uint32_t height;                 // 原始高度
+    bool zeroCopy = false;           // data 是否借用 VENC 缓冲区（持有期间占用 VENC 输出缓冲）
+    bool isH265 = false;             // 码流格式：false=H264, true=H265
+    bool contiguous = true;          // 片段在内存中是否连续
+    int segmentCount = 0;            // 片段个数
+    EncodedSegment segments[kMaxSegments];  // 片段列表（生命周期与 data 相同）
+};
+
+/**
+ * @brief 把帧的所有片段拼接拷贝到缓冲池中的一块连续缓冲
+ *
+ * 需要长时间持有零拷贝帧（预录、封装缓冲）时使用，避免占用 VENC 输出缓冲。
+ *
+ * @return 拷贝后的帧，申请失败时 size 和 segmentCount 为 0
+ */
+EncodedFrame copyEncodedFrame(const EncodedFrame& frame, PacketBufferPool& pool);
+
+/**
+ * @brief 码率控制模式
+ */
+enum class RateControlMode {
+    CBR,   // 恒定码率
+    VBR,   // 可变码率（bitrate 为目标，maxBitrate 为上限）
+    AVBR,  // 自适应可变码率（静止画面自动降码率）
 };
 
 /**
  * @brief 编码参数
  */
 struct EncodeParams {
-    uint32_t width = 1920;
-    uint32_t height = 1080;
+    uint32_t width = 0;              // 0 表示跟随输入（VPSS 编码通道）
+    uint32_t height = 0;
     uint32_t bitrate = 2000000;      // 2Mbps
     uint32_t fps = 30;
     uint32_t gop = 30;               // GOP大小
     bool useH265 = false;            // false=H264, true=H265
+    RateControlMode rcMode = RateControlMode::CBR;
+    uint32_t maxBitrate = 0;         // VBR/AVBR 码率上限，0 表示 bitrate 的 1.5 倍
+    uint32_t minBitrate = 0;         // VBR/AVBR 码率下限
+    uint32_t profile = 0;            // 0 表示默认（H264 High / H265 Main）
+    uint32_t streamBufCnt = 0;       // VENC 输出缓冲个数，0 表示驱动默认
+    uint32_t minQp = 0;              // P 帧 QP 范围，0 表示驱动默认
+    uint32_t maxQp = 0;
+    uint32_t minIQp = 0;             // I 帧 QP 范围，0 表示驱动默认
+    uint32_t maxIQp = 0;
 };
 
+struct rkVENC_PACK_S;
+struct rkVENC_CHN_ATTR_S;
+
 /**
  * @brief 视频编码服务
  * 
@@ -41,20 +97,129 @@ struct EncodeParams {
 class VideoEncoderSvc : public ServiceBase {
 public:
     using EncodeCallback = std::function<void(const EncodedFrame&)>;
+    using ChannelRebuilder = std::function<bool()>;
 
     VideoEncoderSvc();
     virtual ~VideoEncoderSvc();
 
     /**
-     * @brief 设置编码参数
+     * @brief 设置编码参数（等价于 reconfigure()，不等待结果）
      */
     void setEncodeParams(const EncodeParams& params);
 
+    /**
+     * @brief 修改编码参数
+     *
+     * 服务未运行时只保存参数，下次创建 VENC 通道时生效。
+     * 运行中在服务线程上应用，VI/VPSS 不停流：
+     * - 码率、码控模式、GOP、帧率：RK_MPI_VENC_SetChnAttr，不重建通道、不丢帧
+     * - QP 范围：RK_MPI_VENC_SetRcParam
+     * - 编码格式、分辨率、profile、输出缓冲数：通过 setChannelRebuilder() 设置的回调
+     *   只重建 VENC 通道（以及 VPSS 编码通道的输出尺寸），新码流从 IDR 开始
+     * 应用失败时恢复原参数。
+     *
+     * @return 参数非法时为 Failed；否则完成后为 Done/Failed，服务在应用前停止时为 Cancelled
+     */
+    TaskFuture reconfigure(const EncodeParams& params);
+
+    /**
+     * @brief 设置 VENC 通道重建回调（由 MediaPipeline 设置，在服务线程中调用）
+     *
+     * 回调按 getEncodeParams() 的新参数解绑、销毁并重新创建、绑定 VENC 通道。
+     */
+    void setChannelRebuilder(ChannelRebuilder rebuilder);
+
+    /**
+     * @brief 设置 VENC 输入帧率（VPSS 编码通道输出帧率）
+     *
+     * 码控源帧率取该值，EncodeParams::fps 更低时由 VENC 丢帧，运行中降帧率不需要改 VPSS。
+     * 0 表示与 EncodeParams::fps 相同。
+     */
+    void setInputFrameRate(uint32_t fps) { m_inputFps.store(fps); }
+
+    /**
+     * @brief 获取编码参数
+     */
+    EncodeParams getEncodeParams();
+
+    /**
+     * @brief 按编码参数填写 VENC 通道属性（创建通道前调用）
+     *
+     * @param attr   输出的通道属性
+     * @param width  输入图像宽度（参数中宽高为 0 时使用）
+     * @param height 输入图像高度
+     */
+    void fillChnAttr(rkVENC_CHN_ATTR_S& attr, uint32_t width, uint32_t height);
+
     /**
      * @brief 设置编码数据回调
      */
     void setEncodeCallback(EncodeCallback callback);
 
+    /**
+     * @brief 添加异步订阅者
+     *
+     * 订阅者在自己的工作线程中回调，拥有独立的有界队列，慢速订阅者不会阻塞取流。
+     * 可在运行期间随时添加/移除。
+     *
+     * @param name     订阅者名称（日志用）
+     * @param callback 回调函数
+     * @param capacity 队列容量
+     * @param policy   队列满时的处理策略
+     * @return 订阅者ID，失败返回 -1
+     */
+    int addSubscriber(const std::string& name, EncodeCallback callback, size_t capacity = 64,
+                      OverflowPolicy policy = OverflowPolicy::DropNewest);
+
+    /**
+     * @brief 移除异步订阅者（不能在该订阅者自己的回调中调用）
+     */
+    bool removeSubscriber(int id);
+
+    /**
+     * @brief 获取订阅者统计
+     */
+    bool getSubscriberStats(int id, SubscriberStats& stats) const;
+
+    /**
+     * @brief 开启预录缓冲：取流线程把每帧放入按字节预算淘汰的环形缓冲
+     *
+     * 已开启时替换为新的缓冲（原缓冲中的帧丢弃）。
+     *
+     * @param byteBudget 字节预算
+     * @return 预录缓冲，用于 extract() 取出事件前的帧
+     */
+    std::shared_ptr<EncodedFrameRing> enableFrameRing(size_t byteBudget);
+
+    /**
+     * @brief 关闭预录缓冲
+     */
+    void disableFrameRing();
+
+    /**
+     * @brief 获取预录缓冲（未开启时为空）
+     */
+    std::shared_ptr<EncodedFrameRing> getFrameRing();
+
+    /**
+     * @brief 设置时延追踪器（为空表示关闭），可在运行中随时切换
+     *
+     * 取到码流、交给回调之前以及每个回调/订阅者返回时打点，见 LatencyTracer。
+     */
+    void setLatencyTracer(const std::shared_ptr<LatencyTracer>& tracer);
+
+    /**
+     * @brief 获取时延追踪器（未开启时为空）
+     */
+    std::shared_ptr<LatencyTracer> getLatencyTracer();
+
+    /**
+     * @brief 码流连续性检查（按 u32Seq 与 PTS 统计 VENC 丢帧、重复与迟到）
+     *
+     * 期望帧率跟随编码参数；可以通过 setAlertCallback() 设置丢帧告警。
+     */
+    FrameSequenceTracker& getSequenceTracker() { return m_sequence; }
+
     /**
      * @brief 设置 MPP 参数（绑定模式下使用）
      * 
@@ -62,24 +227,91 @@ public:
      */
     void setMPPParams(int vencChnId);
 
+    /**
+     * @brief 设置编码包缓冲池（默认使用进程级共享池，需在 start() 前调用）
+     */
+    void setPacketPool(const std::shared_ptr<PacketBufferPool>& pool);
+
+    /**
+     * @brief 获取编码包缓冲池（用于查询命中率/高水位统计）
+     */
+    std::shared_ptr<PacketBufferPool> getPacketPool() const { return m_packetPool; }
+
+    /**
+     * @brief 设置零拷贝模式
+     *
+     * 开启后回调收到的 EncodedFrame::data 直接借用 VENC 码流缓冲区，
+     * 最后一个引用释放时才调用 RK_MPI_VENC_ReleaseStream。同时借出的码流
+     * 超过 maxOutstanding 时退化为拷贝到缓冲池，避免 VENC 输出缓冲耗尽。
+     *
+     * 注意：借出的码流必须在 VENC 通道销毁前全部释放。
+     *
+     * @param enable         是否开启
+     * @param maxOutstanding 最多同时借出的码流个数
+     */
+    void setZeroCopy(bool enable, int maxOutstanding = 4);
+
+    /**
+     * @brief 当前借出未释放的码流个数
+     */
+    int outstandingStreams() const { return m_outstandingStreams->load(); }
+
+    /**
+     * @brief 零拷贝预算耗尽而退化为拷贝的次数
+     */
+    uint64_t zeroCopyFallbacks() const { return m_zeroCopyFallbacks.load(); }
+
 protected:
     void run() override;
 
 private:
     /**
      * @brief 从 VENC 获取编码流（绑定模式下）
+     *
+     * @param timeoutMs GetStream 超时（毫秒），0 表示不等待
+     */
+    bool getEncodedStream(int timeoutMs);
+
+    /**
+     * @brief 查询通道码流格式和分辨率（run() 开始时调用）
+     */
+    void queryChannelInfo();
+
+    /**
+     * @brief 打开/关闭 VENC 通道 fd（参与 waitEvents 等待）
      */
-    bool getEncodedStream();
+    void openChannelFd();
+    void closeChannelFd();
 
     /**
-     * @brief 初始化编码器
+     * @brief 在服务线程中应用新参数（reconfigure 投递）
      */
-    bool initEncoder();
+    bool applyParams(const EncodeParams& params);
 
     /**
-     * @brief 清理编码器
+     * @brief 连续性检查的期望帧率跟随编码帧率
      */
-    void cleanupEncoder();
+    void setSequenceFps(uint32_t fps);
+
+    /**
+     * @brief 只更新码控属性（通道不重建）
+     */
+    bool updateRcAttr();
+
+    /**
+     * @brief 重建 VENC 通道（编码格式/分辨率变化）
+     */
+    bool rebuildChannel();
+
+    /**
+     * @brief 按编码参数设置 QP 范围（全部为 0 时不设置）
+     */
+    bool applyRcParam();
+
+    /**
+     * @brief 采集时输出订阅者队列、零拷贝借出等指标
+     */
+    void collectMetrics(MetricsWriter& writer);
 
     // 编码参数
     EncodeParams m_params;
@@ -89,12 +321,53 @@ private:
     EncodeCallback m_callback;
     std::mutex m_callbackMutex;
 
-    // 编码器状态
-    bool m_encoderInitialized = false;
-    
+    // 异步订阅者
+    FrameDispatcher<EncodedFrame> m_dispatcher;
+
+    // 预录缓冲
+    std::shared_ptr<EncodedFrameRing> m_frameRing;
+    std::mutex m_frameRingMutex;
+
+    // 时延追踪
+    std::shared_ptr<LatencyTracer> m_tracer;
+    std::mutex m_tracerMutex;
+
+    // 通道重建回调与 VENC 输入帧率
+    ChannelRebuilder m_rebuilder;
+    std::mutex m_rebuilderMutex;
+    std::atomic<uint32_t> m_inputFps{0};
+
     // MPP 参数（绑定模式）
     int m_vencChnId = -1;
     bool m_useBindingMode = false;  // 是否使用绑定模式
+    bool m_useFd = false;           // VENC 通道 fd 是否参与等待
+
+    // 预分配的 pack 数组（kMaxSegments 个，每次 GetStream 按容量提供）
+    std::unique_ptr<rkVENC_PACK_S[]> m_packs;
+    std::atomic<uint64_t> m_packOverflows{0};  // pack 数超过 kMaxSegments 的帧数
+
+    // 通道信息（run() 开始时从 VENC 通道属性获取）
+    bool m_isH265 = false;
+    uint32_t m_picWidth = 0;
+    uint32_t m_picHeight = 0;
+
+    // 编码包缓冲池（替代每帧 new[]）
+    std::shared_ptr<PacketBufferPool> m_packetPool;
+
+    // 零拷贝模式（计数器由码流持有者共享，服务先于码流析构也安全）
+    std::atomic<bool> m_zeroCopy{false};
+    std::atomic<int> m_maxOutstandingStreams{4};
+    std::shared_ptr<std::atomic<int>> m_outstandingStreams{std::make_shared<std::atomic<int>>(0)};
+    std::atomic<uint64_t> m_zeroCopyFallbacks{0};
+
+    // 同步回调耗时
+    std::shared_ptr<MetricHistogram> m_callbackMetric;
+
+    // 码流连续性
+    FrameSequenceTracker m_sequence{"venc"};
+
+    // 指标采集（最后一个成员，先于其他成员析构）
+    MetricsCollectorHandle m_metricsCollector;
 };
 
 #endif // VIDEO_ENCODER_SVC_H
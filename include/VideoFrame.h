@@ -2,8 +2,22 @@
 #define VIDEO_FRAME_H
 
 #include <cstdint>
+#include <memory>
+#include <utility>
 #include <linux/videodev2.h>
 
+/**
+ * @brief 图像平面描述
+ */
+struct VideoPlane {
+    uint8_t* data;    // 平面起始地址（= 帧 data + offset）
+    uint32_t stride;  // 行跨度（字节），包含 VPSS 的对齐填充
+    size_t   offset;  // 相对帧 data 的偏移（字节）
+    uint32_t height;  // 平面行数（包含对齐填充）
+
+    VideoPlane() : data(nullptr), stride(0), offset(0), height(0) {}
+};
+
 /**
  * @brief 视频帧数据结构
  * 
@@ -11,6 +25,8 @@
  */
 class VideoFrame {
 public:
+    static const int kMaxPlanes = 3;
+
     uint8_t* data;        // 帧数据指针（mmap 映射的地址或 MPP buffer 地址）
     size_t   size;        // 数据大小
     int width;            // 宽度
@@ -18,13 +34,84 @@ public:
     uint64_t timestamp;   // 时间戳（微秒）
     uint32_t pixelFormat; // 像素格式（V4L2 格式或 MPP 格式）
 
+    // 内存布局（numPlanes 为 0 表示未知格式，只能按 width/height 紧密排列处理）
+    int virWidth;         // 虚宽（对齐后的宽度，像素）
+    int virHeight;        // 虚高（对齐后的高度，像素）
+    int numPlanes;        // 平面个数
+    VideoPlane planes[kMaxPlanes];
+
     VideoFrame()
-        : data(nullptr), size(0), width(0), height(0), timestamp(0), pixelFormat(0) {}
+        : data(nullptr), size(0), width(0), height(0), timestamp(0), pixelFormat(0),
+          virWidth(0), virHeight(0), numPlanes(0) {}
 
     VideoFrame(int w, int h, uint32_t fmt)
-        : data(nullptr), size(0), width(w), height(h), timestamp(0), pixelFormat(fmt) {}
+        : data(nullptr), size(0), width(w), height(h), timestamp(0), pixelFormat(fmt),
+          virWidth(w), virHeight(h), numPlanes(0) {}
 
     inline void setTimestamp(uint64_t ts) { timestamp = ts; }
+
+    /**
+     * @brief 设置平面（data 必须已设置）
+     */
+    inline void setPlane(int index, size_t offset, uint32_t stride, uint32_t rows) {
+        if (index < 0 || index >= kMaxPlanes) {
+            return;
+        }
+        planes[index].data = data ? data + offset : nullptr;
+        planes[index].stride = stride;
+        planes[index].offset = offset;
+        planes[index].height = rows;
+        if (numPlanes < index + 1) {
+            numPlanes = index + 1;
+        }
+    }
+};
+
+/**
+ * @brief 引用计数的视频帧句柄
+ *
+ * 在 VideoFrame 的基础上持有底层缓冲区（如 VPSS 输出帧的 MB_BLK），
+ * 最后一个引用释放时才把缓冲区归还给 MPI。消费者拷贝句柄即可跨线程保留帧，
+ * 不需要拷贝帧数据。
+ *
+ * 注意：句柄必须在对应的 MPI 模块（如 VPSS 组）销毁前全部释放。
+ */
+class VideoFrameRef : public VideoFrame {
+public:
+    void* mbBlk;  // 底层 MB_BLK（可用 RK_MPI_MB_Handle2Fd 取 dma-buf fd 给 RGA/NPU）
+
+    VideoFrameRef() : mbBlk(nullptr) {}
+
+    /**
+     * @param frame  帧元数据
+     * @param blk    底层 MB_BLK
+     * @param holder 缓冲区持有者，析构时归还缓冲区
+     */
+    VideoFrameRef(const VideoFrame& frame, void* blk, std::shared_ptr<void> holder)
+        : VideoFrame(frame), mbBlk(blk), m_holder(std::move(holder)) {}
+
+    /**
+     * @brief 是否仍持有底层缓冲区
+     */
+    bool isHeld() const { return m_holder != nullptr; }
+
+    /**
+     * @brief 当前引用数（调试用）
+     */
+    long useCount() const { return m_holder.use_count(); }
+
+    /**
+     * @brief 提前释放引用（之后 data 不再可用）
+     */
+    void reset() {
+        m_holder.reset();
+        data = nullptr;
+        size = 0;
+        mbBlk = nullptr;
+    }
+
+private:
+    std::shared_ptr<void> m_holder;
 };
 
 #endif // VIDEO_FRAME_H
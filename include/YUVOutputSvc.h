@@ -3,7 +3,13 @@
 
 #include "ServiceBase.h"
 #include "VideoFrame.h"
+#include "FrameDispatcher.h"
+#include "FrameSequenceTracker.h"
 #include <functional>
+#include <atomic>
+#include <memory>
+
+class LatencyTracer;
 
 /**
  * @brief YUV 数据输出服务
@@ -11,19 +17,72 @@
  * 职责：
  * - 接收 YUV 数据
  * - 回调给应用层（算法处理）
+ *
+ * 回调收到的是引用计数帧句柄：回调返回后帧即归还 VPSS；
+ * 需要在其它线程继续使用时拷贝 VideoFrameRef 保留引用即可，无需拷贝数据。
  */
 class YUVOutputSvc : public ServiceBase {
 public:
-    using YUVCallback = std::function<void(const VideoFrame&)>;
+    // 参数为 const VideoFrame& 的旧回调仍可直接赋值
+    using YUVCallback = std::function<void(const VideoFrameRef&)>;
 
     YUVOutputSvc();
     virtual ~YUVOutputSvc();
 
     /**
      * @brief 设置 YUV 回调函数
+     *
+     * 回调在服务（取帧）线程中同步执行，耗时会直接推迟下一次取帧。分析等耗时处理应使用
+     * addSubscriber()，在订阅者自己的线程中运行。服务线程默认为普通调度；改为实时调度
+     * （setThreadAttr()）时回调也随之以实时优先级运行。
      */
     void setYUVCallback(YUVCallback callback);
 
+    /**
+     * @brief 添加异步订阅者
+     *
+     * 订阅者在自己的工作线程中回调，拥有独立的有界队列，慢速订阅者不会阻塞取帧。
+     * 可在运行期间随时添加/移除。
+     *
+     * @param name     订阅者名称（日志用）
+     * @param callback 回调函数
+     * @param capacity 队列容量（排队的帧占用 VPSS 缓冲区，计入保留帧上限）
+     * @param policy   队列满时的处理策略
+     * @return 订阅者ID，失败返回 -1
+     */
+    int addSubscriber(const std::string& name, YUVCallback callback, size_t capacity = 2,
+                      OverflowPolicy policy = OverflowPolicy::DropOldest);
+
+    /**
+     * @brief 移除异步订阅者（不能在该订阅者自己的回调中调用）
+     */
+    bool removeSubscriber(int id);
+
+    /**
+     * @brief 获取订阅者统计
+     */
+    bool getSubscriberStats(int id, SubscriberStats& stats) const;
+
+    /**
+     * @brief 设置时延追踪器（为空表示关闭），可在运行中随时切换
+     *
+     * 取到 VPSS 帧、交给回调之前以及每个回调/订阅者返回时打点，见 LatencyTracer。
+     */
+    void setLatencyTracer(const std::shared_ptr<LatencyTracer>& tracer);
+
+    /**
+     * @brief 获取时延追踪器（未开启时为空）
+     */
+    std::shared_ptr<LatencyTracer> getLatencyTracer();
+
+    /**
+     * @brief 帧连续性检查（按 PTS 统计 VPSS 丢帧、重复与迟到）
+     *
+     * u32TimeRef 是 VI 的帧计数，VPSS 抽帧时本来就不连续，因此只看 PTS；
+     * 期望帧率由 MediaPipeline 按配置设置（未设置时从帧间隔学习）。
+     */
+    FrameSequenceTracker& getSequenceTracker() { return m_sequence; }
+
     /**
      * @brief 设置 MPP 参数（绑定模式下使用）
      * 
@@ -32,28 +91,74 @@ public:
      */
     void setMPPParams(int vpssGrpId, int vpssChnId);
 
+    /**
+     * @brief 设置应用层最多同时保留的帧数
+     *
+     * 保留帧占用 VPSS 通道缓冲区，达到上限时新帧直接归还 VPSS 并计入丢弃，
+     * 避免 VPSS 因缓冲区耗尽而停顿。应小于 VPSS 通道的缓冲区个数。
+     */
+    void setMaxHeldFrames(int maxFrames) { m_maxHeldFrames.store(maxFrames); }
+
+    /**
+     * @brief 当前仍被应用层保留的帧数
+     */
+    int heldFrameCount() const { return m_heldFrames->load(); }
+
+    /**
+     * @brief 因保留帧达到上限而丢弃的帧数
+     */
+    uint64_t heldLimitDrops() const { return m_heldLimitDrops.load(); }
+
 protected:
     void run() override;
 
 private:
     /**
      * @brief 从 VPSS 获取 YUV 帧（绑定模式下）
+     *
+     * @param timeoutMs GetChnFrame 超时（毫秒），0 表示不等待
      */
-    bool getYUVFrame();
+    bool getYUVFrame(int timeoutMs);
 
     /**
      * @brief 处理一帧数据
      */
-    void processFrame(const VideoFrame& frame);
+    void processFrame(const VideoFrameRef& frame);
+
+    /**
+     * @brief 采集时输出订阅者队列、保留帧等指标
+     */
+    void collectMetrics(MetricsWriter& writer);
 
     // 回调函数
     YUVCallback m_callback;
     std::mutex m_callbackMutex;
 
+    // 异步订阅者
+    FrameDispatcher<VideoFrameRef> m_dispatcher;
+
+    // 时延追踪
+    std::shared_ptr<LatencyTracer> m_tracer;
+    std::mutex m_tracerMutex;
+
     // MPP 参数（绑定模式）
     int m_vpssGrpId = -1;
     int m_vpssChnId = -1;
     bool m_useBindingMode = false;  // 是否使用绑定模式
+
+    // 保留帧统计（计数器由帧句柄共享，服务先于帧析构也安全）
+    std::shared_ptr<std::atomic<int>> m_heldFrames{std::make_shared<std::atomic<int>>(0)};
+    std::atomic<int> m_maxHeldFrames{4};
+    std::atomic<uint64_t> m_heldLimitDrops{0};
+
+    // 同步回调耗时
+    std::shared_ptr<MetricHistogram> m_callbackMetric;
+
+    // 帧连续性
+    FrameSequenceTracker m_sequence{"yuv"};
+
+    // 指标采集（最后一个成员，先于其他成员析构）
+    MetricsCollectorHandle m_metricsCollector;
 };
 
 #endif // YUV_OUTPUT_SVC_H
@@ -0,0 +1,23 @@
+/*
+ * rockit MPI 软件替身：内存块（MB）公共定义
+ */
+#ifndef SIM_RK_COMM_MB_H
+#define SIM_RK_COMM_MB_H
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *MB_BLK;
+typedef RK_U32 MB_POOL;
+
+#define MB_INVALID_POOLID  (-1U)
+#define MB_INVALID_HANDLE  NULL
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_MB_H
@@ -0,0 +1,108 @@
+/*
+ * rockit MPI 软件替身：VENC 码率控制结构
+ */
+#ifndef SIM_RK_COMM_RC_H
+#define SIM_RK_COMM_RC_H
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum rkVENC_RC_MODE_E {
+    VENC_RC_MODE_H264CBR = 1,
+    VENC_RC_MODE_H264VBR,
+    VENC_RC_MODE_H264AVBR,
+    VENC_RC_MODE_MJPEGCBR,
+    VENC_RC_MODE_MJPEGVBR,
+    VENC_RC_MODE_H265CBR,
+    VENC_RC_MODE_H265VBR,
+    VENC_RC_MODE_H265AVBR,
+    VENC_RC_MODE_BUTT,
+} VENC_RC_MODE_E;
+
+typedef struct rkVENC_H264_CBR_S {
+    RK_U32 u32Gop;
+    RK_U32 u32SrcFrameRateNum;
+    RK_U32 u32SrcFrameRateDen;
+    RK_U32 fr32DstFrameRateNum;
+    RK_U32 fr32DstFrameRateDen;
+    RK_U32 u32BitRate;          /* kbps */
+    RK_U32 u32StatTime;
+} VENC_H264_CBR_S;
+
+typedef struct rkVENC_H264_VBR_S {
+    RK_U32 u32Gop;
+    RK_U32 u32SrcFrameRateNum;
+    RK_U32 u32SrcFrameRateDen;
+    RK_U32 fr32DstFrameRateNum;
+    RK_U32 fr32DstFrameRateDen;
+    RK_U32 u32BitRate;          /* kbps */
+    RK_U32 u32MaxBitRate;
+    RK_U32 u32MinBitRate;
+    RK_U32 u32StatTime;
+} VENC_H264_VBR_S;
+
+typedef VENC_H264_VBR_S VENC_H264_AVBR_S;
+typedef VENC_H264_CBR_S VENC_H265_CBR_S;
+typedef VENC_H264_VBR_S VENC_H265_VBR_S;
+typedef VENC_H264_AVBR_S VENC_H265_AVBR_S;
+
+typedef struct rkVENC_MJPEG_CBR_S {
+    RK_U32 u32SrcFrameRateNum;
+    RK_U32 u32SrcFrameRateDen;
+    RK_U32 fr32DstFrameRateNum;
+    RK_U32 fr32DstFrameRateDen;
+    RK_U32 u32BitRate;
+    RK_U32 u32StatTime;
+} VENC_MJPEG_CBR_S;
+
+typedef struct rkVENC_RC_ATTR_S {
+    VENC_RC_MODE_E enRcMode;
+    union {
+        VENC_H264_CBR_S  stH264Cbr;
+        VENC_H264_VBR_S  stH264Vbr;
+        VENC_H264_AVBR_S stH264Avbr;
+        VENC_MJPEG_CBR_S stMjpegCbr;
+        VENC_H265_CBR_S  stH265Cbr;
+        VENC_H265_VBR_S  stH265Vbr;
+        VENC_H265_AVBR_S stH265Avbr;
+    };
+} VENC_RC_ATTR_S;
+
+typedef struct rkVENC_PARAM_H264_S {
+    RK_U32 u32StepQp;
+    RK_U32 u32MaxQp;
+    RK_U32 u32MinQp;
+    RK_U32 u32MaxIQp;
+    RK_U32 u32MinIQp;
+    RK_S32 s32DeltIpQp;
+    RK_S32 s32MaxReEncodeTimes;
+    RK_U32 u32FrmMaxQp;
+    RK_U32 u32FrmMinQp;
+    RK_U32 u32FrmMaxIQp;
+    RK_U32 u32FrmMinIQp;
+} VENC_PARAM_H264_S;
+
+typedef VENC_PARAM_H264_S VENC_PARAM_H265_S;
+
+typedef struct rkVENC_PARAM_MJPEG_S {
+    RK_U32 u32MaxQfactor;
+    RK_U32 u32MinQfactor;
+} VENC_PARAM_MJPEG_S;
+
+typedef struct rkVENC_RC_PARAM_S {
+    RK_S32 s32FirstFrameStartQp;
+    union {
+        VENC_PARAM_H264_S  stParamH264;
+        VENC_PARAM_H265_S  stParamH265;
+        VENC_PARAM_MJPEG_S stParamMjpeg;
+    };
+} VENC_RC_PARAM_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_RC_H
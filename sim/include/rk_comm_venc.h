@@ -0,0 +1,199 @@
+/*
+ * rockit MPI 软件替身：VENC 公共结构
+ */
+#ifndef SIM_RK_COMM_VENC_H
+#define SIM_RK_COMM_VENC_H
+
+#include "rk_common.h"
+#include "rk_comm_video.h"
+#include "rk_comm_rc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VENC_MAX_CHN_NUM        64
+#define VENC_MAX_PACK_INFO_NUM  8
+
+#define RK_ERR_VENC_INVALID_CHNID   RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_INVALID_CHNID)
+#define RK_ERR_VENC_ILLEGAL_PARAM   RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_ILLEGAL_PARAM)
+#define RK_ERR_VENC_EXIST           RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_EXIST)
+#define RK_ERR_VENC_UNEXIST         RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_UNEXIST)
+#define RK_ERR_VENC_NULL_PTR        RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR)
+#define RK_ERR_VENC_NOT_CONFIG      RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_CONFIG)
+#define RK_ERR_VENC_NOT_SUPPORT     RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_SUPPORT)
+#define RK_ERR_VENC_NOT_PERM        RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_PERM)
+#define RK_ERR_VENC_NOMEM           RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_NOMEM)
+#define RK_ERR_VENC_NOBUF           RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_NOBUF)
+#define RK_ERR_VENC_BUF_EMPTY       RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_BUF_EMPTY)
+#define RK_ERR_VENC_BUF_FULL        RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_BUF_FULL)
+#define RK_ERR_VENC_BUSY            RK_DEF_ERR(RK_ID_VENC, RK_ERR_LEVEL_ERROR, RK_ERR_BUSY)
+
+typedef enum rkCODEC_ID_E {
+    RK_VIDEO_ID_Unused = 0,
+    RK_VIDEO_ID_AutoDetect,
+    RK_VIDEO_ID_MPEG1VIDEO,
+    RK_VIDEO_ID_MPEG2VIDEO,
+    RK_VIDEO_ID_H263,
+    RK_VIDEO_ID_MPEG4,
+    RK_VIDEO_ID_WMV,
+    RK_VIDEO_ID_RV,
+    RK_VIDEO_ID_AVC,
+    RK_VIDEO_ID_MJPEG,
+    RK_VIDEO_ID_VP8,
+    RK_VIDEO_ID_VP9,
+    RK_VIDEO_ID_HEVC = 0x1000004,
+    RK_VIDEO_ID_JPEG = 0x1000008,
+} RK_CODEC_ID_E;
+
+#define H264E_PROFILE_BASELINE  66
+#define H264E_PROFILE_MAIN      77
+#define H264E_PROFILE_HIGH      100
+#define H265E_PROFILE_MAIN      0
+#define H265E_PROFILE_MAIN10    1
+
+typedef enum rkH264E_NALU_TYPE_E {
+    H264E_NALU_BSLICE   = 0,
+    H264E_NALU_PSLICE   = 1,
+    H264E_NALU_ISLICE   = 2,
+    H264E_NALU_IDRSLICE = 5,
+    H264E_NALU_SEI      = 6,
+    H264E_NALU_SPS      = 7,
+    H264E_NALU_PPS      = 8,
+    H264E_NALU_BUTT
+} H264E_NALU_TYPE_E;
+
+typedef enum rkH265E_NALU_TYPE_E {
+    H265E_NALU_BSLICE   = 0,
+    H265E_NALU_PSLICE   = 1,
+    H265E_NALU_ISLICE   = 2,
+    H265E_NALU_IDRSLICE = 19,
+    H265E_NALU_VPS      = 32,
+    H265E_NALU_SPS      = 33,
+    H265E_NALU_PPS      = 34,
+    H265E_NALU_SEI      = 39,
+    H265E_NALU_BUTT
+} H265E_NALU_TYPE_E;
+
+typedef enum rkJPEGE_PACK_TYPE_E {
+    JPEGE_PACK_ECS  = 5,
+    JPEGE_PACK_APP  = 6,
+    JPEGE_PACK_VDO  = 7,
+    JPEGE_PACK_PIC  = 8,
+    JPEGE_PACK_BUTT
+} JPEGE_PACK_TYPE_E;
+
+typedef union rkVENC_DATA_TYPE_U {
+    H264E_NALU_TYPE_E enH264EType;
+    JPEGE_PACK_TYPE_E enJPEGEType;
+    H265E_NALU_TYPE_E enH265EType;
+} VENC_DATA_TYPE_U;
+
+typedef struct rkVENC_PACK_INFO_S {
+    VENC_DATA_TYPE_U u32PackType;
+    RK_U32 u32PackOffset;
+    RK_U32 u32PackLength;
+} VENC_PACK_INFO_S;
+
+typedef struct rkVENC_PACK_S {
+    MB_BLK              pMbBlk;
+    RK_U32              u32Len;
+    RK_U64              u64PTS;
+    RK_BOOL             bFrameEnd;
+    RK_BOOL             bStreamEnd;
+    VENC_DATA_TYPE_U    DataType;
+    RK_U32              u32Offset;
+    RK_U32              u32DataNum;
+    VENC_PACK_INFO_S    stPackInfo[VENC_MAX_PACK_INFO_NUM];
+} VENC_PACK_S;
+
+typedef struct rkVENC_STREAM_INFO_H264_S {
+    RK_U32 u32PicBytesNum;
+    RK_U32 u32Inter16x16MbNum;
+    RK_U32 u32Intra16MbNum;
+    RK_U32 u32Intra4MbNum;
+    RK_U32 enRefType;
+    RK_U32 u32UpdateAttrCnt;
+    RK_U32 u32StartQp;
+} VENC_STREAM_INFO_H264_S;
+
+typedef VENC_STREAM_INFO_H264_S VENC_STREAM_INFO_H265_S;
+
+typedef struct rkVENC_STREAM_S {
+    VENC_PACK_S *pstPack;
+    RK_U32       u32PackCount;
+    RK_U32       u32Seq;
+    union {
+        VENC_STREAM_INFO_H264_S stH264Info;
+        VENC_STREAM_INFO_H265_S stH265Info;
+    };
+} VENC_STREAM_S;
+
+typedef struct rkVENC_ATTR_H264_S {
+    RK_U32 u32Level;
+} VENC_ATTR_H264_S;
+
+typedef struct rkVENC_ATTR_H265_S {
+    RK_U32 u32Level;
+} VENC_ATTR_H265_S;
+
+typedef struct rkVENC_ATTR_S {
+    RK_CODEC_ID_E   enType;
+    PIXEL_FORMAT_E  enPixelFormat;
+    RK_U32          u32Profile;
+    RK_U32          u32PicWidth;
+    RK_U32          u32PicHeight;
+    RK_U32          u32VirWidth;
+    RK_U32          u32VirHeight;
+    RK_U32          u32StreamBufCnt;
+    RK_U32          u32BufSize;
+    RK_BOOL         bByFrame;
+    MIRROR_E        enMirror;
+    union {
+        VENC_ATTR_H264_S stAttrH264e;
+        VENC_ATTR_H265_S stAttrH265e;
+    };
+} VENC_ATTR_S;
+
+typedef enum rkVENC_GOP_MODE_E {
+    VENC_GOPMODE_INIT = 0,
+    VENC_GOPMODE_NORMALP,
+    VENC_GOPMODE_TSVC2,
+    VENC_GOPMODE_TSVC3,
+    VENC_GOPMODE_TSVC4,
+    VENC_GOPMODE_SMARTP,
+    VENC_GOPMODE_BUTT,
+} VENC_GOP_MODE_E;
+
+typedef struct rkVENC_GOP_ATTR_S {
+    VENC_GOP_MODE_E enGopMode;
+    RK_S32          s32VirIdrLen;
+    RK_U32          u32MaxLtrCount;
+    RK_U32          u32TsvcPreload;
+} VENC_GOP_ATTR_S;
+
+typedef struct rkVENC_CHN_ATTR_S {
+    VENC_ATTR_S     stVencAttr;
+    VENC_RC_ATTR_S  stRcAttr;
+    VENC_GOP_ATTR_S stGopAttr;
+} VENC_CHN_ATTR_S;
+
+typedef struct rkVENC_RECV_PIC_PARAM_S {
+    RK_S32 s32RecvPicNum;
+} VENC_RECV_PIC_PARAM_S;
+
+typedef struct rkVENC_CHN_STATUS_S {
+    RK_U32 u32LeftPics;
+    RK_U32 u32LeftStreamBytes;
+    RK_U32 u32LeftStreamFrames;
+    RK_U32 u32CurPacks;
+    RK_U32 u32LeftRecvPics;
+    RK_U32 u32LeftEncPics;
+    RK_BOOL bJpegSnapEnd;
+} VENC_CHN_STATUS_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_VENC_H
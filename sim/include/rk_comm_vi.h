@@ -0,0 +1,105 @@
+/*
+ * rockit MPI 软件替身：VI 公共结构
+ */
+#ifndef SIM_RK_COMM_VI_H
+#define SIM_RK_COMM_VI_H
+
+#include "rk_common.h"
+#include "rk_comm_video.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VI_MAX_PIPE_NUM          16
+#define MAX_VI_ENTITY_NAME_LEN   32
+
+#define RK_ERR_VI_INVALID_PARA      RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_ILLEGAL_PARAM)
+#define RK_ERR_VI_INVALID_DEVID     RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_INVALID_DEVID)
+#define RK_ERR_VI_INVALID_CHNID     RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_INVALID_CHNID)
+#define RK_ERR_VI_INVALID_NULL_PTR  RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR)
+#define RK_ERR_VI_NOT_CONFIG        RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_CONFIG)
+#define RK_ERR_VI_NOT_SUPPORT       RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_SUPPORT)
+#define RK_ERR_VI_NOT_PERM          RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_PERM)
+#define RK_ERR_VI_NOMEM             RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_NOMEM)
+#define RK_ERR_VI_BUF_EMPTY         RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_BUF_EMPTY)
+#define RK_ERR_VI_BUF_FULL          RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_BUF_FULL)
+#define RK_ERR_VI_BUSY              RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_BUSY)
+#define RK_ERR_VI_EXIST             RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_EXIST)
+#define RK_ERR_VI_UNEXIST           RK_DEF_ERR(RK_ID_VI, RK_ERR_LEVEL_ERROR, RK_ERR_UNEXIST)
+
+typedef enum rkVI_V4L2_CAPTURE_TYPE {
+    VI_V4L2_CAPTURE_TYPE_VIDEO_CAPTURE        = 1,
+    VI_V4L2_CAPTURE_TYPE_VIDEO_OUTPUT         = 2,
+    VI_V4L2_CAPTURE_TYPE_VIDEO_CAPTURE_MPLANE = 9,
+    VI_V4L2_CAPTURE_TYPE_BUTT
+} VI_V4L2_CAPTURE_TYPE;
+
+typedef enum rkVI_V4L2_MEMORY_TYPE {
+    VI_V4L2_MEMORY_TYPE_MMAP    = 1,
+    VI_V4L2_MEMORY_TYPE_USERPTR = 2,
+    VI_V4L2_MEMORY_TYPE_OVERLAY = 3,
+    VI_V4L2_MEMORY_TYPE_DMABUF  = 4,
+    VI_V4L2_MEMORY_TYPE_BUTT
+} VI_V4L2_MEMORY_TYPE;
+
+typedef enum rkVI_ALLOC_BUF_TYPE_E {
+    VI_ALLOC_BUF_TYPE_INTERNAL = 0,
+    VI_ALLOC_BUF_TYPE_EXTERNAL,
+    VI_ALLOC_BUF_TYPE_BUTT
+} VI_ALLOC_BUF_TYPE_E;
+
+typedef struct rkVI_DEV_ATTR_S {
+    RK_U32          enIntfMode;
+    RK_U32          enWorkMode;
+    RK_U32          enScanMode;
+    SIZE_S          stMaxSize;
+    DYNAMIC_RANGE_E enDynamicRange;
+} VI_DEV_ATTR_S;
+
+typedef struct rkVI_DEV_BIND_PIPE_S {
+    RK_U32  u32Num;
+    VI_PIPE PipeId[VI_MAX_PIPE_NUM];
+    RK_BOOL bDataOffline;
+    RK_BOOL bUserStartPipe[VI_MAX_PIPE_NUM];
+} VI_DEV_BIND_PIPE_S;
+
+typedef struct rkVI_ISP_OPT_S {
+    RK_U32               u32BufCount;
+    RK_U32               u32BufSize;
+    VI_V4L2_CAPTURE_TYPE enCaptureType;
+    VI_V4L2_MEMORY_TYPE  enMemoryType;
+    RK_CHAR              aEntityName[MAX_VI_ENTITY_NAME_LEN];
+    RK_BOOL              bNoUseLibV4L2;
+    SIZE_S               stMaxSize;
+} VI_ISP_OPT_S;
+
+typedef struct rkVI_CHN_ATTR_S {
+    SIZE_S              stSize;
+    PIXEL_FORMAT_E      enPixelFormat;
+    DYNAMIC_RANGE_E     enDynamicRange;
+    VIDEO_FORMAT_E      enVideoFormat;
+    COMPRESS_MODE_E     enCompressMode;
+    RK_BOOL             bMirror;
+    RK_BOOL             bFlip;
+    RK_U32              u32Depth;
+    FRAME_RATE_CTRL_S   stFrameRate;
+    VI_ALLOC_BUF_TYPE_E enAllocBufType;
+    VI_ISP_OPT_S        stIspOpt;
+} VI_CHN_ATTR_S;
+
+typedef struct rkVI_CHN_STATUS_S {
+    RK_BOOL bEnable;
+    RK_U32  u32FrameRate;
+    RK_U32  u32CurFrameID;
+    RK_U32  u32InputLostFrame;
+    RK_U32  u32OutputLostFrame;
+    RK_U32  u32VbFail;
+    SIZE_S  stSize;
+} VI_CHN_STATUS_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_VI_H
@@ -0,0 +1,167 @@
+/*
+ * rockit MPI 软件替身：视频公共结构
+ */
+#ifndef SIM_RK_COMM_VIDEO_H
+#define SIM_RK_COMM_VIDEO_H
+
+#include "rk_type.h"
+#include "rk_comm_mb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum rkPIXEL_FORMAT_E {
+    RK_FMT_YUV_BEGIN = 0x0,
+    RK_FMT_YUV420SP  = RK_FMT_YUV_BEGIN,   /* YYYY... UV...            */
+    RK_FMT_YUV420SP_10BIT,
+    RK_FMT_YUV422SP,                       /* YYYY... UVUV...          */
+    RK_FMT_YUV422SP_10BIT,
+    RK_FMT_YUV420P,                        /* YYYY... U...V...         */
+    RK_FMT_YUV420P_VU,
+    RK_FMT_YUV420SP_VU,                    /* YYYY... VU...            */
+    RK_FMT_YUV422P,
+    RK_FMT_YUV422SP_VU,
+    RK_FMT_YUV422_YUYV,
+    RK_FMT_YUV422_UYVY,
+    RK_FMT_YUV400SP,
+    RK_FMT_YUV440SP,
+    RK_FMT_YUV411SP,
+    RK_FMT_YUV444,
+    RK_FMT_YUV444SP,
+    RK_FMT_YUV444P,
+    RK_FMT_YUV_BUTT,
+
+    RK_FMT_RGB_BEGIN = 0x10000,
+    RK_FMT_RGB565    = RK_FMT_RGB_BEGIN,
+    RK_FMT_BGR565,
+    RK_FMT_RGB555,
+    RK_FMT_BGR555,
+    RK_FMT_RGB444,
+    RK_FMT_BGR444,
+    RK_FMT_RGB888,
+    RK_FMT_BGR888,
+    RK_FMT_RGB101010,
+    RK_FMT_BGR101010,
+    RK_FMT_ARGB1555,
+    RK_FMT_ABGR1555,
+    RK_FMT_ARGB4444,
+    RK_FMT_ABGR4444,
+    RK_FMT_ARGB8565,
+    RK_FMT_ABGR8565,
+    RK_FMT_ARGB8888,
+    RK_FMT_ABGR8888,
+    RK_FMT_BGRA8888,
+    RK_FMT_RGBA8888,
+    RK_FMT_RGB_BUTT,
+
+    RK_FMT_BUTT = RK_FMT_RGB_BUTT,
+} PIXEL_FORMAT_E;
+
+typedef enum rkVIDEO_FIELD_E {
+    VIDEO_FIELD_TOP         = 0x1,
+    VIDEO_FIELD_BOTTOM      = 0x2,
+    VIDEO_FIELD_INTERLACED  = 0x3,
+    VIDEO_FIELD_FRAME       = 0x4,
+    VIDEO_FIELD_BUTT
+} VIDEO_FIELD_E;
+
+typedef enum rkVIDEO_FORMAT_E {
+    VIDEO_FORMAT_LINEAR = 0,
+    VIDEO_FORMAT_TILE_64x16,
+    VIDEO_FORMAT_TILE_16x8,
+    VIDEO_FORMAT_LINEAR_DISCRETE,
+    VIDEO_FORMAT_BUTT
+} VIDEO_FORMAT_E;
+
+typedef enum rkCOMPRESS_MODE_E {
+    COMPRESS_MODE_NONE = 0,
+    COMPRESS_AFBC_16x16,
+    COMPRESS_MODE_BUTT
+} COMPRESS_MODE_E;
+
+typedef enum rkDYNAMIC_RANGE_E {
+    DYNAMIC_RANGE_SDR8 = 0,
+    DYNAMIC_RANGE_SDR10,
+    DYNAMIC_RANGE_HDR10,
+    DYNAMIC_RANGE_HLG,
+    DYNAMIC_RANGE_SLF,
+    DYNAMIC_RANGE_XDR,
+    DYNAMIC_RANGE_BUTT
+} DYNAMIC_RANGE_E;
+
+typedef enum rkCOLOR_GAMUT_E {
+    COLOR_GAMUT_BT601 = 0,
+    COLOR_GAMUT_BT709,
+    COLOR_GAMUT_BT2020,
+    COLOR_GAMUT_USER,
+    COLOR_GAMUT_BUTT
+} COLOR_GAMUT_E;
+
+typedef enum rkMIRROR_E {
+    MIRROR_NONE = 0,
+    MIRROR_HORIZONTAL,
+    MIRROR_VERTICAL,
+    MIRROR_BOTH,
+    MIRROR_BUTT
+} MIRROR_E;
+
+typedef struct rkPOINT_S {
+    RK_S32 s32X;
+    RK_S32 s32Y;
+} POINT_S;
+
+typedef struct rkSIZE_S {
+    RK_U32 u32Width;
+    RK_U32 u32Height;
+} SIZE_S;
+
+typedef struct rkRECT_S {
+    RK_S32 s32X;
+    RK_S32 s32Y;
+    RK_U32 u32Width;
+    RK_U32 u32Height;
+} RECT_S;
+
+typedef struct rkFRAME_RATE_CTRL_S {
+    RK_S32 s32SrcFrameRate;
+    RK_S32 s32DstFrameRate;
+} FRAME_RATE_CTRL_S;
+
+typedef struct rkASPECT_RATIO_S {
+    RK_U32 enMode;
+    RK_U32 u32BgColor;
+    RECT_S stVideoRect;
+} ASPECT_RATIO_S;
+
+typedef struct rkVIDEO_FRAME_S {
+    MB_BLK              pMbBlk;
+    RK_U32              u32Width;
+    RK_U32              u32Height;
+    RK_U32              u32VirWidth;
+    RK_U32              u32VirHeight;
+    VIDEO_FIELD_E       enField;
+    PIXEL_FORMAT_E      enPixelFormat;
+    VIDEO_FORMAT_E      enVideoFormat;
+    COMPRESS_MODE_E     enCompressMode;
+    DYNAMIC_RANGE_E     enDynamicRange;
+    COLOR_GAMUT_E       enColorGamut;
+
+    RK_VOID            *pVirAddr[3];
+
+    RK_U32              u32TimeRef;
+    RK_U64              u64PTS;
+
+    RK_U64              u64PrivateData;
+    RK_U32              u32FrameFlag;
+} VIDEO_FRAME_S;
+
+typedef struct rkVIDEO_FRAME_INFO_S {
+    VIDEO_FRAME_S stVFrame;
+} VIDEO_FRAME_INFO_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_VIDEO_H
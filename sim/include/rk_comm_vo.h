@@ -0,0 +1,87 @@
+/*
+ * rockit MPI 软件替身：VO 公共结构
+ */
+#ifndef SIM_RK_COMM_VO_H
+#define SIM_RK_COMM_VO_H
+
+#include "rk_common.h"
+#include "rk_comm_video.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VO_MAX_CHN_NUM   128
+
+typedef RK_U32 VO_INTF_TYPE_E;
+
+#define VO_INTF_CVBS     (0x01L << 0)
+#define VO_INTF_YPBPR    (0x01L << 1)
+#define VO_INTF_VGA      (0x01L << 2)
+#define VO_INTF_BT656    (0x01L << 3)
+#define VO_INTF_BT1120   (0x01L << 4)
+#define VO_INTF_LCD      (0x01L << 5)
+#define VO_INTF_LVDS     (0x01L << 6)
+#define VO_INTF_MIPI     (0x01L << 7)
+#define VO_INTF_HDMI     (0x01L << 10)
+#define VO_INTF_EDP      (0x01L << 11)
+#define VO_INTF_DP       (0x01L << 12)
+
+typedef enum rkVO_INTF_SYNC_E {
+    VO_OUTPUT_PAL = 0,
+    VO_OUTPUT_NTSC,
+    VO_OUTPUT_1080P24,
+    VO_OUTPUT_1080P25,
+    VO_OUTPUT_1080P30,
+    VO_OUTPUT_720P50,
+    VO_OUTPUT_720P60,
+    VO_OUTPUT_1080I50,
+    VO_OUTPUT_1080I60,
+    VO_OUTPUT_1080P50,
+    VO_OUTPUT_1080P60,
+    VO_OUTPUT_3840x2160_24,
+    VO_OUTPUT_3840x2160_25,
+    VO_OUTPUT_3840x2160_30,
+    VO_OUTPUT_3840x2160_50,
+    VO_OUTPUT_3840x2160_60,
+    VO_OUTPUT_USER,
+    VO_OUTPUT_DEFAULT,
+    VO_OUTPUT_BUTT
+} VO_INTF_SYNC_E;
+
+typedef enum rkVO_LAYER_MODE_E {
+    VO_LAYER_MODE_CURSOR = 0,
+    VO_LAYER_MODE_GRAPHIC,
+    VO_LAYER_MODE_VIDEO,
+    VO_LAYER_MODE_BUTT
+} VO_LAYER_MODE_E;
+
+typedef struct rkVO_PUB_ATTR_S {
+    RK_U32          u32BgColor;
+    VO_INTF_TYPE_E  enIntfType;
+    VO_INTF_SYNC_E  enIntfSync;
+} VO_PUB_ATTR_S;
+
+typedef struct rkVO_VIDEO_LAYER_ATTR_S {
+    RECT_S          stDispRect;
+    SIZE_S          stImageSize;
+    RK_U32          u32DispFrmRt;
+    PIXEL_FORMAT_E  enPixFormat;
+    RK_BOOL         bDoubleFrame;
+    COMPRESS_MODE_E enCompressMode;
+} VO_VIDEO_LAYER_ATTR_S;
+
+typedef struct rkVO_CHN_ATTR_S {
+    RK_U32  u32Priority;
+    RECT_S  stRect;
+    RK_BOOL bDeflicker;
+    RK_U32  u32FgAlpha;
+    RK_U32  u32BgAlpha;
+    MIRROR_E enMirror;
+} VO_CHN_ATTR_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_VO_H
@@ -0,0 +1,72 @@
+/*
+ * rockit MPI 软件替身：VPSS 公共结构
+ */
+#ifndef SIM_RK_COMM_VPSS_H
+#define SIM_RK_COMM_VPSS_H
+
+#include "rk_common.h"
+#include "rk_comm_video.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VPSS_MAX_GRP_NUM    256
+#define VPSS_MAX_CHN_NUM    4
+
+#define VPSS_CHN0           0
+#define VPSS_CHN1           1
+#define VPSS_CHN2           2
+#define VPSS_CHN3           3
+#define VPSS_INVALID_CHN    -1
+
+#define RK_ERR_VPSS_INVALID_DEVID   RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_INVALID_DEVID)
+#define RK_ERR_VPSS_INVALID_CHNID   RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_INVALID_CHNID)
+#define RK_ERR_VPSS_ILLEGAL_PARAM   RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_ILLEGAL_PARAM)
+#define RK_ERR_VPSS_EXIST           RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_EXIST)
+#define RK_ERR_VPSS_UNEXIST         RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_UNEXIST)
+#define RK_ERR_VPSS_NULL_PTR        RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR)
+#define RK_ERR_VPSS_NOT_SUPPORT     RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_SUPPORT)
+#define RK_ERR_VPSS_NOT_PERM        RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_NOT_PERM)
+#define RK_ERR_VPSS_NOMEM           RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_NOMEM)
+#define RK_ERR_VPSS_NOBUF           RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_NOBUF)
+#define RK_ERR_VPSS_BUF_EMPTY       RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_BUF_EMPTY)
+#define RK_ERR_VPSS_BUSY            RK_DEF_ERR(RK_ID_VPSS, RK_ERR_LEVEL_ERROR, RK_ERR_BUSY)
+
+typedef enum rkVPSS_CHN_MODE_E {
+    VPSS_CHN_MODE_USER = 0,
+    VPSS_CHN_MODE_AUTO,
+    VPSS_CHN_MODE_PASSTHROUGH,
+    VPSS_CHN_MODE_BUTT
+} VPSS_CHN_MODE_E;
+
+typedef struct rkVPSS_GRP_ATTR_S {
+    RK_U32              u32MaxW;
+    RK_U32              u32MaxH;
+    PIXEL_FORMAT_E      enPixelFormat;
+    DYNAMIC_RANGE_E     enDynamicRange;
+    FRAME_RATE_CTRL_S   stFrameRate;
+    COMPRESS_MODE_E     enCompressMode;
+} VPSS_GRP_ATTR_S;
+
+typedef struct rkVPSS_CHN_ATTR_S {
+    VPSS_CHN_MODE_E     enChnMode;
+    RK_U32              u32Width;
+    RK_U32              u32Height;
+    VIDEO_FORMAT_E      enVideoFormat;
+    PIXEL_FORMAT_E      enPixelFormat;
+    DYNAMIC_RANGE_E     enDynamicRange;
+    COMPRESS_MODE_E     enCompressMode;
+    FRAME_RATE_CTRL_S   stFrameRate;
+    RK_BOOL             bMirror;
+    RK_BOOL             bFlip;
+    RK_U32              u32Depth;
+    ASPECT_RATIO_S      stAspectRatio;
+    RK_U32              u32FrameBufCnt;
+} VPSS_CHN_ATTR_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMM_VPSS_H
@@ -0,0 +1,62 @@
+/*
+ * rockit MPI 软件替身：公共定义（模块ID、绑定通道等）
+ */
+#ifndef SIM_RK_COMMON_H
+#define SIM_RK_COMMON_H
+
+#include "rk_type.h"
+#include "rk_errno.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef RK_S32 AI_CHN;
+typedef RK_S32 VI_DEV;
+typedef RK_S32 VI_PIPE;
+typedef RK_S32 VI_CHN;
+typedef RK_S32 VO_DEV;
+typedef RK_S32 VO_LAYER;
+typedef RK_S32 VO_CHN;
+typedef RK_S32 VENC_CHN;
+typedef RK_S32 VPSS_GRP;
+typedef RK_S32 VPSS_CHN;
+
+typedef enum rkMOD_ID_E {
+    RK_ID_CMPI    = 0,
+    RK_ID_MB      = 1,
+    RK_ID_SYS     = 2,
+    RK_ID_RGN     = 3,
+    RK_ID_VENC    = 4,
+    RK_ID_VDEC    = 5,
+    RK_ID_VPSS    = 6,
+    RK_ID_VGS     = 7,
+    RK_ID_VI      = 8,
+    RK_ID_VO      = 9,
+    RK_ID_AI      = 10,
+    RK_ID_AO      = 11,
+    RK_ID_AENC    = 12,
+    RK_ID_ADEC    = 13,
+    RK_ID_TDE     = 14,
+    RK_ID_ISP     = 15,
+    RK_ID_WBC     = 16,
+    RK_ID_AVS     = 17,
+    RK_ID_RGA     = 18,
+    RK_ID_AF      = 19,
+    RK_ID_IVS     = 20,
+    RK_ID_GPU     = 21,
+    RK_ID_NN      = 22,
+    RK_ID_BUTT,
+} MOD_ID_E;
+
+typedef struct rkMPP_CHN_S {
+    MOD_ID_E    enModId;
+    RK_S32      s32DevId;
+    RK_S32      s32ChnId;
+} MPP_CHN_S;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_COMMON_H
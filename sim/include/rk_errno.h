@@ -0,0 +1,47 @@
+/*
+ * rockit MPI 软件替身：错误码（编码方式与 rockit SDK 的 RK_DEF_ERR 一致）
+ */
+#ifndef SIM_RK_ERRNO_H
+#define SIM_RK_ERRNO_H
+
+#include "rk_type.h"
+
+#define RK_ERR_APPID  (0x80000000L + 0x20000000L)
+
+typedef enum rkERR_LEVEL_E {
+    RK_ERR_LEVEL_DEBUG = 0,
+    RK_ERR_LEVEL_INFO,
+    RK_ERR_LEVEL_NOTICE,
+    RK_ERR_LEVEL_WARNING,
+    RK_ERR_LEVEL_ERROR,
+    RK_ERR_LEVEL_CRIT,
+    RK_ERR_LEVEL_ALERT,
+    RK_ERR_LEVEL_FATAL,
+    RK_ERR_LEVEL_BUTT
+} ERR_LEVEL_E;
+
+#define RK_DEF_ERR(module, level, errid) \
+    ((RK_S32)((RK_ERR_APPID) | ((module) << 16) | ((level) << 13) | (errid)))
+
+typedef enum rkEN_ERR_CODE_E {
+    RK_ERR_INVALID_DEVID = 1,
+    RK_ERR_INVALID_CHNID = 2,
+    RK_ERR_ILLEGAL_PARAM = 3,
+    RK_ERR_EXIST         = 4,
+    RK_ERR_UNEXIST       = 5,
+    RK_ERR_NULL_PTR      = 6,
+    RK_ERR_NOT_CONFIG    = 7,
+    RK_ERR_NOT_SUPPORT   = 8,
+    RK_ERR_NOT_PERM      = 9,
+    RK_ERR_NOMEM         = 12,
+    RK_ERR_NOBUF         = 13,
+    RK_ERR_BUF_EMPTY     = 14,
+    RK_ERR_BUF_FULL      = 15,
+    RK_ERR_SYS_NOTREADY  = 16,
+    RK_ERR_BADADDR       = 17,
+    RK_ERR_BUSY          = 18,
+    RK_ERR_SIZE_NOT_ENOUGH = 19,
+    RK_ERR_BUTT          = 63,
+} RK_ERR_CODE_E;
+
+#endif  // SIM_RK_ERRNO_H
@@ -0,0 +1,23 @@
+/*
+ * rockit MPI 软件替身：内存块（MB）接口
+ */
+#ifndef SIM_RK_MPI_MB_H
+#define SIM_RK_MPI_MB_H
+
+#include "rk_common.h"
+#include "rk_comm_mb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_VOID *RK_MPI_MB_Handle2VirAddr(MB_BLK mb);
+RK_U64   RK_MPI_MB_Handle2PhysAddr(MB_BLK mb);
+RK_S32   RK_MPI_MB_Handle2Fd(MB_BLK mb);
+RK_U64   RK_MPI_MB_GetSize(MB_BLK mb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_MPI_MB_H
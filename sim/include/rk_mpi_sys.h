@@ -0,0 +1,23 @@
+/*
+ * rockit MPI 软件替身：系统接口（初始化、绑定、时间戳）
+ */
+#ifndef SIM_RK_MPI_SYS_H
+#define SIM_RK_MPI_SYS_H
+
+#include "rk_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_S32 RK_MPI_SYS_Init(RK_VOID);
+RK_S32 RK_MPI_SYS_Exit(RK_VOID);
+RK_S32 RK_MPI_SYS_Bind(const MPP_CHN_S *pstSrcChn, const MPP_CHN_S *pstDestChn);
+RK_S32 RK_MPI_SYS_UnBind(const MPP_CHN_S *pstSrcChn, const MPP_CHN_S *pstDestChn);
+RK_S32 RK_MPI_SYS_GetCurPTS(RK_U64 *pu64CurPTS);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_MPI_SYS_H
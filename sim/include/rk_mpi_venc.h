@@ -0,0 +1,33 @@
+/*
+ * rockit MPI 软件替身：VENC 接口
+ */
+#ifndef SIM_RK_MPI_VENC_H
+#define SIM_RK_MPI_VENC_H
+
+#include "rk_comm_venc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_S32 RK_MPI_VENC_CreateChn(VENC_CHN VeChn, const VENC_CHN_ATTR_S *pstAttr);
+RK_S32 RK_MPI_VENC_DestroyChn(VENC_CHN VeChn);
+RK_S32 RK_MPI_VENC_ResetChn(VENC_CHN VeChn);
+RK_S32 RK_MPI_VENC_StartRecvFrame(VENC_CHN VeChn, const VENC_RECV_PIC_PARAM_S *pstRecvParam);
+RK_S32 RK_MPI_VENC_StopRecvFrame(VENC_CHN VeChn);
+RK_S32 RK_MPI_VENC_QueryStatus(VENC_CHN VeChn, VENC_CHN_STATUS_S *pstStatus);
+RK_S32 RK_MPI_VENC_SetChnAttr(VENC_CHN VeChn, const VENC_CHN_ATTR_S *pstChnAttr);
+RK_S32 RK_MPI_VENC_GetChnAttr(VENC_CHN VeChn, VENC_CHN_ATTR_S *pstChnAttr);
+RK_S32 RK_MPI_VENC_SetRcParam(VENC_CHN VeChn, const VENC_RC_PARAM_S *pstRcParam);
+RK_S32 RK_MPI_VENC_GetRcParam(VENC_CHN VeChn, VENC_RC_PARAM_S *pstRcParam);
+RK_S32 RK_MPI_VENC_RequestIDR(VENC_CHN VeChn, RK_BOOL bInstant);
+RK_S32 RK_MPI_VENC_GetStream(VENC_CHN VeChn, VENC_STREAM_S *pstStream, RK_S32 s32MilliSec);
+RK_S32 RK_MPI_VENC_ReleaseStream(VENC_CHN VeChn, VENC_STREAM_S *pstStream);
+RK_S32 RK_MPI_VENC_GetFd(VENC_CHN VeChn);
+RK_S32 RK_MPI_VENC_CloseFd(VENC_CHN VeChn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_MPI_VENC_H
@@ -0,0 +1,34 @@
+/*
+ * rockit MPI 软件替身：VO 接口
+ */
+#ifndef SIM_RK_MPI_VO_H
+#define SIM_RK_MPI_VO_H
+
+#include "rk_comm_vo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_S32 RK_MPI_VO_SetPubAttr(VO_DEV VoDev, const VO_PUB_ATTR_S *pstPubAttr);
+RK_S32 RK_MPI_VO_GetPubAttr(VO_DEV VoDev, VO_PUB_ATTR_S *pstPubAttr);
+RK_S32 RK_MPI_VO_Enable(VO_DEV VoDev);
+RK_S32 RK_MPI_VO_Disable(VO_DEV VoDev);
+RK_S32 RK_MPI_VO_BindLayer(VO_LAYER VoLayer, VO_DEV VoDev, VO_LAYER_MODE_E enLayerMode);
+RK_S32 RK_MPI_VO_UnBindLayer(VO_LAYER VoLayer, VO_DEV VoDev);
+RK_S32 RK_MPI_VO_SetLayerAttr(VO_LAYER VoLayer, const VO_VIDEO_LAYER_ATTR_S *pstLayerAttr);
+RK_S32 RK_MPI_VO_GetLayerAttr(VO_LAYER VoLayer, VO_VIDEO_LAYER_ATTR_S *pstLayerAttr);
+RK_S32 RK_MPI_VO_EnableLayer(VO_LAYER VoLayer);
+RK_S32 RK_MPI_VO_DisableLayer(VO_LAYER VoLayer);
+RK_S32 RK_MPI_VO_SetChnAttr(VO_LAYER VoLayer, VO_CHN VoChn, const VO_CHN_ATTR_S *pstChnAttr);
+RK_S32 RK_MPI_VO_GetChnAttr(VO_LAYER VoLayer, VO_CHN VoChn, VO_CHN_ATTR_S *pstChnAttr);
+RK_S32 RK_MPI_VO_EnableChn(VO_LAYER VoLayer, VO_CHN VoChn);
+RK_S32 RK_MPI_VO_DisableChn(VO_LAYER VoLayer, VO_CHN VoChn);
+RK_S32 RK_MPI_VO_ShowChn(VO_LAYER VoLayer, VO_CHN VoChn);
+RK_S32 RK_MPI_VO_HideChn(VO_LAYER VoLayer, VO_CHN VoChn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIM_RK_MPI_VO_H
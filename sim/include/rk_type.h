@@ -0,0 +1,38 @@
+/*
+ * rockit MPI 软件替身：基础类型（与 rockit SDK rk_type.h 保持一致的子集）
+ */
+#ifndef SIM_RK_TYPE_H
+#define SIM_RK_TYPE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef unsigned char      RK_U8;
+typedef unsigned short     RK_U16;
+typedef unsigned int       RK_U32;
+typedef signed char        RK_S8;
+typedef short              RK_S16;
+typedef int                RK_S32;
+typedef uint64_t           RK_U64;
+typedef int64_t            RK_S64;
+typedef char               RK_CHAR;
+typedef float              RK_FLOAT;
+typedef double             RK_DOUBLE;
+typedef unsigned long      RK_UL;
+typedef long               RK_SL;
+#define RK_VOID            void
+
+typedef enum {
+    RK_FALSE = 0,
+    RK_TRUE  = 1,
+} RK_BOOL;
+
+#ifndef NULL
+#define NULL 0L
+#endif
+
+#define RK_NULL     0L
+#define RK_SUCCESS  0
+#define RK_FAILURE  (-1)
+
+#endif  // SIM_RK_TYPE_H
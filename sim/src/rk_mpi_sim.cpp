@@ -0,0 +1,1593 @@
+/*
+ * rockit MPI 软件替身
+ *
+ * 在普通 Linux 主机上实现 MediaManager 及各服务用到的 RK_MPI_* 接口子集，
+ * 用于脱离开发板运行流水线、做吞吐/延迟回归：
+ * - VI：按帧率生成确定性的 NV12 测试图（或循环读取 NV12 原始文件）
+ * - VPSS：尺寸相同时直通共享缓冲区，否则最近邻缩放
+ * - VENC：生成结构正确的伪码流（IDR 帧含 SPS/PPS[/VPS] 分包，Annex-B 起始码）
+ * - SYS：绑定关系，帧在源模块的采集线程中沿绑定链同步下发
+ * - 通道 fd 为 eventfd，队列非空时可读，可直接放进 epoll
+ *
+ * 环境变量：
+ * - RK_SIM_VI_FPS   VI 帧率（覆盖通道属性），0 表示不限速
+ * - RK_SIM_VI_FILE  NV12 原始文件（按通道分辨率逐帧读取，到结尾后循环）
+ * - RK_SIM_VENC_US  每帧模拟编码耗时（微秒）
+ * - RK_SIM_VENC_ISLICE_INTERVAL  GOP 内每隔 N 帧输出一个非 IDR 的 I 帧（帧内刷新/周期 I 帧，
+ *                   NALU 类型为 *_NALU_ISLICE，不是随机访问点），0 表示不输出
+ * - RK_SIM_SETUP_US 模块建立类调用（VI/VO 使能、VPSS 建组、VENC 建通道等）的模拟阻塞耗时（微秒），
+ *                   用于评估启动流程；在全局锁外等待，并行调用时可以重叠
+ */
+#include "rk_mpi_sys.h"
+#include "rk_mpi_mb.h"
+#include "rk_mpi_vi.h"
+#include "rk_mpi_vpss.h"
+#include "rk_mpi_venc.h"
+#include "rk_mpi_vo.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace {
+
+const RK_U32 kMbMagic = 0x53494d42;  // "SIMB"
+const int kDefaultFps = 30;
+const RK_U32 kDefaultUserDepth = 4;      // 未绑定的输出通道默认可缓存的帧数
+const RK_U32 kDefaultStreamBufCnt = 8;   // VENC 默认可缓存的码流帧数
+
+RK_U64 nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<RK_U64>(ts.tv_sec) * 1000000ULL + static_cast<RK_U64>(ts.tv_nsec) / 1000ULL;
+}
+
+int envInt(const char* name, int def) {
+    const char* v = getenv(name);
+    return (v && *v) ? atoi(v) : def;
+}
+
+/** 模拟板端建立类 MPI 调用的阻塞耗时（驱动/固件配置），调用方不能持有全局锁 */
+void setupDelay() {
+    static const int kSetupUs = envInt("RK_SIM_SETUP_US", 0);
+    if (kSetupUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(kSetupUs));
+    }
+}
+
+// ==================== 内存块（MB） ====================
+
+struct BufferPool;
+
+struct SimMb {
+    RK_U32 magic;
+    std::atomic<int> refs;
+    uint8_t* data;
+    size_t size;
+    std::shared_ptr<BufferPool> pool;  // 引用归零后归还的池（空表示直接释放）
+};
+
+/**
+ * 按固定大小复用缓冲区，避免每帧分配 4K 帧大小的内存
+ */
+struct BufferPool : std::enable_shared_from_this<BufferPool> {
+    size_t blockSize;
+    std::mutex mutex;
+    std::vector<SimMb*> freeList;
+
+    explicit BufferPool(size_t size) : blockSize(size) {}
+
+    ~BufferPool() {
+        for (size_t i = 0; i < freeList.size(); i++) {
+            delete[] freeList[i]->data;
+            delete freeList[i];
+        }
+    }
+
+    SimMb* get() {
+        SimMb* mb = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeList.empty()) {
+                mb = freeList.back();
+                freeList.pop_back();
+            }
+        }
+        if (!mb) {
+            mb = new SimMb();
+            mb->magic = kMbMagic;
+            mb->data = new uint8_t[blockSize];
+            mb->size = blockSize;
+        }
+        mb->refs.store(1);
+        mb->pool = shared_from_this();
+        return mb;
+    }
+};
+
+SimMb* mbFromHandle(MB_BLK blk) {
+    SimMb* mb = static_cast<SimMb*>(blk);
+    return (mb && mb->magic == kMbMagic) ? mb : nullptr;
+}
+
+SimMb* mbAlloc(size_t size) {
+    SimMb* mb = new SimMb();
+    mb->magic = kMbMagic;
+    mb->refs.store(1);
+    mb->data = new uint8_t[size];
+    mb->size = size;
+    return mb;
+}
+
+void mbAddRef(SimMb* mb) {
+    mb->refs.fetch_add(1);
+}
+
+void mbRelease(SimMb* mb) {
+    if (!mb || mb->refs.fetch_sub(1) != 1) {
+        return;
+    }
+    std::shared_ptr<BufferPool> pool = std::move(mb->pool);
+    if (pool) {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->freeList.push_back(mb);
+    } else {
+        delete[] mb->data;
+        delete mb;
+    }
+}
+
+// ==================== 输出队列（带 eventfd） ====================
+
+/**
+ * 有界输出队列：满时丢弃最旧的一项；eventfd 在队列非空时可读
+ */
+template<typename Item>
+struct OutputQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Item> items;
+    RK_U32 depth;
+    int eventFd;
+    RK_U64 dropped;
+    void (*releaseFn)(Item&);
+
+    OutputQueue(RK_U32 d, void (*fn)(Item&))
+        : depth(d), eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), dropped(0), releaseFn(fn) {}
+
+    ~OutputQueue() {
+        clear();
+        if (eventFd >= 0) {
+            close(eventFd);
+        }
+    }
+
+    void signal() {
+        uint64_t one = 1;
+        ssize_t n = write(eventFd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void drainSignal() {
+        uint64_t value;
+        ssize_t n = read(eventFd, &value, sizeof(value));
+        (void)n;
+    }
+
+    /** 入队（转移 item 的引用），maxDepth 为 0 时直接释放 */
+    void push(Item& item, RK_U32 maxDepth, bool dropNewestWhenFull) {
+        std::lock_guard<std::mutex> lock(mutex);
+        depth = maxDepth;
+        if (depth == 0) {
+            releaseFn(item);
+            return;
+        }
+        if (items.size() >= depth) {
+            dropped++;
+            if (dropNewestWhenFull) {
+                releaseFn(item);
+                return;
+            }
+            releaseFn(items.front());
+            items.pop_front();
+        }
+        bool wasEmpty = items.empty();
+        items.push_back(item);
+        if (wasEmpty) {
+            signal();
+        }
+        cv.notify_one();
+    }
+
+    /** 出队（引用转移给调用方） */
+    bool pop(Item& out, RK_S32 timeoutMs) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.empty() && timeoutMs != 0) {
+            if (timeoutMs < 0) {
+                cv.wait(lock, [this]() { return !items.empty(); });
+            } else {
+                cv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                            [this]() { return !items.empty(); });
+            }
+        }
+        if (items.empty()) {
+            return false;
+        }
+        out = items.front();
+        items.pop_front();
+        if (items.empty()) {
+            drainSignal();
+        }
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!items.empty()) {
+            releaseFn(items.front());
+            items.pop_front();
+        }
+        drainSignal();
+    }
+};
+
+void releaseFrameItem(VIDEO_FRAME_INFO_S& frame) {
+    mbRelease(mbFromHandle(frame.stVFrame.pMbBlk));
+    frame.stVFrame.pMbBlk = nullptr;
+}
+
+typedef std::vector<VENC_PACK_S> SimStream;
+
+void releaseStreamItem(SimStream& stream) {
+    for (size_t i = 0; i < stream.size(); i++) {
+        mbRelease(mbFromHandle(stream[i].pMbBlk));
+    }
+    stream.clear();
+}
+
+typedef OutputQueue<VIDEO_FRAME_INFO_S> FrameQueue;
+typedef OutputQueue<SimStream> StreamQueue;
+
+// ==================== 模块状态 ====================
+
+struct SimViChn {
+    VI_CHN_ATTR_S attr;
+    bool configured = false;
+    bool enabled = false;
+    std::shared_ptr<FrameQueue> queue;
+    std::shared_ptr<BufferPool> pool;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    RK_U32 frameId = 0;
+};
+
+struct SimVpssChn {
+    VPSS_CHN_ATTR_S attr;
+    bool configured = false;
+    bool enabled = false;
+    std::shared_ptr<FrameQueue> queue;
+    std::shared_ptr<BufferPool> pool;
+    RK_U64 inputCount = 0;
+};
+
+struct SimVpssGrp {
+    VPSS_GRP_ATTR_S attr;
+    bool started = false;
+    SimVpssChn chns[VPSS_MAX_CHN_NUM];
+};
+
+struct SimVencChn {
+    VENC_CHN_ATTR_S attr;
+    VENC_RC_PARAM_S rcParam;
+    bool recv = false;
+    bool forceIdr = true;
+    RK_U32 frameIndex = 0;  // GOP 内计数
+    RK_U64 inputCount = 0;  // 帧率控制用的输入帧计数
+    RK_U32 seq = 0;
+    RK_U32 streamBufCnt = kDefaultStreamBufCnt;
+    std::shared_ptr<StreamQueue> queue;
+};
+
+struct VoLayer {
+    bool enabled = false;
+    bool chnEnabled[16] = {};
+    RK_U64 shown = 0;
+};
+
+struct ChnKey {
+    MOD_ID_E mod;
+    RK_S32 dev;
+    RK_S32 chn;
+
+    bool operator<(const ChnKey& o) const {
+        if (mod != o.mod) return mod < o.mod;
+        if (dev != o.dev) return dev < o.dev;
+        return chn < o.chn;
+    }
+    bool operator==(const ChnKey& o) const { return mod == o.mod && dev == o.dev && chn == o.chn; }
+};
+
+/**
+ * 全局状态：所有配置接口和帧下发时的状态更新都在 mutex 下进行，VPSS 缩放、VENC 模拟编码在锁外，
+ * Get*Frame/GetStream 只持有队列自身的锁等待数据。
+ */
+struct SimState {
+    std::mutex mutex;
+    bool sysInited = false;
+    std::map<VI_DEV, bool> viDevEnabled;
+    std::map<VI_DEV, bool> viDevConfigured;
+    std::map<ChnKey, std::unique_ptr<SimViChn>> viChns;        // key: (VI, pipe, chn)
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>> vpssGrps;
+    std::map<VENC_CHN, std::unique_ptr<SimVencChn>> vencChns;
+    std::map<VO_DEV, bool> voDevEnabled;
+    std::map<VO_LAYER, VoLayer> voLayers;
+    std::multimap<ChnKey, ChnKey> binds;                    // 源 → 目的
+};
+
+SimState& sim() {
+    static SimState* state = new SimState();  // 进程退出时不析构，避免与采集线程竞争
+    return *state;
+}
+
+ChnKey srcKey(const MPP_CHN_S* c) {
+    ChnKey k = { c->enModId, c->s32DevId, c->s32ChnId };
+    return k;
+}
+
+/** 目的端只关心模块内实际区分的编号（VPSS 组输入不区分通道，VENC 不区分设备） */
+ChnKey dstKey(const MPP_CHN_S* c) {
+    ChnKey k = { c->enModId, c->s32DevId, c->s32ChnId };
+    if (c->enModId == RK_ID_VPSS) {
+        k.chn = 0;
+    } else if (c->enModId == RK_ID_VENC) {
+        k.dev = 0;
+    }
+    return k;
+}
+
+bool hasBind(const ChnKey& src) {
+    return sim().binds.find(src) != sim().binds.end();
+}
+
+size_t nv12Size(RK_U32 w, RK_U32 h) {
+    return static_cast<size_t>(w) * h * 3 / 2;
+}
+
+void fillFrameInfo(VIDEO_FRAME_INFO_S& info, SimMb* mb, RK_U32 w, RK_U32 h, RK_U64 pts,
+                   RK_U32 timeRef) {
+    memset(&info, 0, sizeof(info));
+    info.stVFrame.pMbBlk = mb;
+    info.stVFrame.u32Width = w;
+    info.stVFrame.u32Height = h;
+    info.stVFrame.u32VirWidth = w;
+    info.stVFrame.u32VirHeight = h;
+    info.stVFrame.enField = VIDEO_FIELD_FRAME;
+    info.stVFrame.enPixelFormat = RK_FMT_YUV420SP;
+    info.stVFrame.enVideoFormat = VIDEO_FORMAT_LINEAR;
+    info.stVFrame.pVirAddr[0] = mb->data;
+    info.stVFrame.pVirAddr[1] = mb->data + static_cast<size_t>(w) * h;
+    info.stVFrame.u32TimeRef = timeRef;
+    info.stVFrame.u64PTS = pts;
+}
+
+// ==================== VPSS 处理 ====================
+
+/** 最近邻缩放 NV12 */
+void scaleNv12(const uint8_t* src, RK_U32 sw, RK_U32 sh, uint8_t* dst, RK_U32 dw, RK_U32 dh) {
+    std::vector<RK_U32> xmap(dw);
+    for (RK_U32 x = 0; x < dw; x++) {
+        xmap[x] = static_cast<RK_U32>(static_cast<uint64_t>(x) * sw / dw);
+    }
+    for (RK_U32 y = 0; y < dh; y++) {
+        const uint8_t* srow = src + static_cast<size_t>(y * sh / dh) * sw;
+        uint8_t* drow = dst + static_cast<size_t>(y) * dw;
+        for (RK_U32 x = 0; x < dw; x++) {
+            drow[x] = srow[xmap[x]];
+        }
+    }
+    const uint8_t* suv = src + static_cast<size_t>(sw) * sh;
+    uint8_t* duv = dst + static_cast<size_t>(dw) * dh;
+    for (RK_U32 y = 0; y < dh / 2; y++) {
+        const uint8_t* srow = suv + static_cast<size_t>(y * (sh / 2) / (dh / 2)) * sw;
+        uint8_t* drow = duv + static_cast<size_t>(y) * dw;
+        for (RK_U32 x = 0; x + 1 < dw; x += 2) {
+            RK_U32 sx = xmap[x] & ~1u;
+            drow[x] = srow[sx];
+            drow[x + 1] = srow[sx + 1];
+        }
+    }
+}
+
+/** 帧率控制：src/dst 均为正数时按比例抽帧 */
+bool passFrameRate(const FRAME_RATE_CTRL_S& fr, RK_U64 index) {
+    if (fr.s32SrcFrameRate <= 0 || fr.s32DstFrameRate <= 0 ||
+        fr.s32DstFrameRate >= fr.s32SrcFrameRate) {
+        return true;
+    }
+    RK_U64 cur = index * fr.s32DstFrameRate / fr.s32SrcFrameRate;
+    RK_U64 next = (index + 1) * fr.s32DstFrameRate / fr.s32SrcFrameRate;
+    return next != cur;
+}
+
+/**
+ * VPSS 一个通道的一帧输出：帧率控制、缓冲分配在全局锁内，缩放和继续下发在锁外进行
+ */
+struct VpssOutput {
+    ChnKey src;
+    VIDEO_FRAME_INFO_S out;
+    bool scale;       // 需要从输入缩放到 out
+    bool bound;       // 有绑定的下游
+    RK_U32 depth;     // 用户取帧队列深度
+    std::shared_ptr<FrameQueue> queue;
+};
+
+void vpssPrepare(VPSS_GRP grpId, SimVpssGrp& grp, const VIDEO_FRAME_INFO_S& in,
+                 std::vector<VpssOutput>& outputs) {
+    const VIDEO_FRAME_S& vf = in.stVFrame;
+    SimMb* inMb = mbFromHandle(vf.pMbBlk);
+    if (!inMb) {
+        return;
+    }
+
+    for (int c = 0; c < VPSS_MAX_CHN_NUM; c++) {
+        SimVpssChn& chn = grp.chns[c];
+        if (!chn.enabled) {
+            continue;
+        }
+        if (!passFrameRate(chn.attr.stFrameRate, chn.inputCount++)) {
+            continue;
+        }
+
+        VpssOutput o;
+        RK_U32 w = chn.attr.u32Width ? chn.attr.u32Width : vf.u32Width;
+        RK_U32 h = chn.attr.u32Height ? chn.attr.u32Height : vf.u32Height;
+        o.scale = !(w == vf.u32Width && h == vf.u32Height);
+        if (!o.scale) {
+            // 直通：共享输入缓冲区
+            mbAddRef(inMb);
+            o.out = in;
+        } else {
+            size_t size = nv12Size(w, h);
+            if (!chn.pool || chn.pool->blockSize != size) {
+                chn.pool = std::make_shared<BufferPool>(size);
+            }
+            fillFrameInfo(o.out, chn.pool->get(), w, h, vf.u64PTS, vf.u32TimeRef);
+        }
+
+        ChnKey src = { RK_ID_VPSS, grpId, c };
+        o.src = src;
+        o.bound = hasBind(src);
+        // 未绑定或设置了深度的通道，用户可以通过 GetChnFrame 取帧
+        o.depth = chn.attr.u32Depth ? chn.attr.u32Depth : (o.bound ? 0 : kDefaultUserDepth);
+        o.queue = chn.queue;
+        outputs.push_back(o);
+    }
+}
+
+// ==================== VENC 伪编码 ====================
+
+/** 写入一个 NAL：起始码 + 头 + 不含 0x00 的确定性负载（避免伪起始码） */
+void writeNal(uint8_t* dst, size_t size, const uint8_t* header, size_t headerLen, RK_U32 seed) {
+    static const uint8_t kStartCode[4] = { 0, 0, 0, 1 };
+    memcpy(dst, kStartCode, 4);
+    memcpy(dst + 4, header, headerLen);
+    for (size_t i = 4 + headerLen; i < size; i++) {
+        dst[i] = static_cast<uint8_t>(0x80 | ((seed + i) & 0x7f));
+    }
+}
+
+void addPack(SimStream& stream, size_t size, const uint8_t* header, size_t headerLen,
+             RK_U32 seed, RK_U64 pts, bool h265, int naluType, bool frameEnd) {
+    if (size < 4 + headerLen) {
+        size = 4 + headerLen;
+    }
+    SimMb* mb = mbAlloc(size);
+    writeNal(mb->data, size, header, headerLen, seed);
+
+    VENC_PACK_S pack;
+    memset(&pack, 0, sizeof(pack));
+    pack.pMbBlk = mb;
+    pack.u32Len = static_cast<RK_U32>(size);
+    pack.u64PTS = pts;
+    pack.bFrameEnd = frameEnd ? RK_TRUE : RK_FALSE;
+    if (h265) {
+        pack.DataType.enH265EType = static_cast<H265E_NALU_TYPE_E>(naluType);
+    } else {
+        pack.DataType.enH264EType = static_cast<H264E_NALU_TYPE_E>(naluType);
+    }
+    stream.push_back(pack);
+}
+
+void rcTarget(const VENC_RC_ATTR_S& rc, RK_U32& bitrateKbps, RK_U32& gop, RK_U32& fps,
+              RK_U32& srcFps) {
+    switch (rc.enRcMode) {
+    case VENC_RC_MODE_H264VBR:
+    case VENC_RC_MODE_H264AVBR:
+    case VENC_RC_MODE_H265VBR:
+    case VENC_RC_MODE_H265AVBR:
+        bitrateKbps = rc.stH264Vbr.u32BitRate;
+        gop = rc.stH264Vbr.u32Gop;
+        fps = rc.stH264Vbr.fr32DstFrameRateNum / (rc.stH264Vbr.fr32DstFrameRateDen ? rc.stH264Vbr.fr32DstFrameRateDen : 1);
+        srcFps = rc.stH264Vbr.u32SrcFrameRateNum / (rc.stH264Vbr.u32SrcFrameRateDen ? rc.stH264Vbr.u32SrcFrameRateDen : 1);
+        break;
+    default:
+        bitrateKbps = rc.stH264Cbr.u32BitRate;
+        gop = rc.stH264Cbr.u32Gop;
+        fps = rc.stH264Cbr.fr32DstFrameRateNum / (rc.stH264Cbr.fr32DstFrameRateDen ? rc.stH264Cbr.fr32DstFrameRateDen : 1);
+        srcFps = rc.stH264Cbr.u32SrcFrameRateNum / (rc.stH264Cbr.u32SrcFrameRateDen ? rc.stH264Cbr.u32SrcFrameRateDen : 1);
+        break;
+    }
+    if (bitrateKbps == 0) bitrateKbps = 2000;
+    if (gop == 0) gop = 30;
+    if (fps == 0) fps = kDefaultFps;
+}
+
+/**
+ * 一帧的编码任务：码控/GOP 状态在全局锁内更新，模拟编码耗时和生成码流在锁外进行，
+ * 多路流水线的编码可以并行
+ */
+struct VencJob {
+    std::shared_ptr<StreamQueue> queue;
+    RK_U32 streamBufCnt;
+    bool h265;
+    bool idr;
+    bool islice;
+    size_t avg;
+    size_t pSize;
+    RK_U32 seed;
+    RK_U32 paramSeed;
+    RK_U64 pts;
+};
+
+/** 码控帧率控制与 GOP 计数（全局锁内），该帧需要编码时返回 true */
+bool vencPrepare(SimVencChn& chn, const VIDEO_FRAME_INFO_S& in, VencJob& job) {
+    if (!chn.recv) {
+        return false;
+    }
+
+    RK_U32 bitrateKbps, gop, fps, srcFps;
+    rcTarget(chn.attr.stRcAttr, bitrateKbps, gop, fps, srcFps);
+
+    // 码控帧率控制：目标帧率低于源帧率时按比例丢帧
+    FRAME_RATE_CTRL_S fr;
+    fr.s32SrcFrameRate = static_cast<RK_S32>(srcFps);
+    fr.s32DstFrameRate = static_cast<RK_S32>(fps);
+    if (!passFrameRate(fr, chn.inputCount++)) {
+        return false;
+    }
+
+    job.h265 = (chn.attr.stVencAttr.enType == RK_VIDEO_ID_HEVC);
+
+    job.idr = chn.forceIdr || (chn.frameIndex % gop) == 0;
+    if (job.idr) {
+        chn.forceIdr = false;
+        chn.frameIndex = 0;
+    }
+    static const int kISliceInterval = envInt("RK_SIM_VENC_ISLICE_INTERVAL", 0);
+    job.islice = !job.idr && kISliceInterval > 0 && (chn.frameIndex % kISliceInterval) == 0;
+    chn.frameIndex++;
+
+    // 码率分配：IDR 帧为平均帧的 4 倍，P 帧均摊剩余预算（GOP 不超过 4 帧时没有剩余，P 帧取平均帧大小）
+    job.avg = static_cast<size_t>(bitrateKbps) * 1000 / 8 / fps;
+    job.pSize = gop > 4 ? (job.avg * gop - job.avg * 4) / (gop - 1) : job.avg;
+    if (job.pSize < 64) job.pSize = 64;
+    job.seed = in.stVFrame.u32TimeRef;
+    job.pts = in.stVFrame.u64PTS;
+    // 参数集只随通道配置变化（与硬件一致：同一配置下每个 IDR 的 SPS/PPS 相同）
+    job.paramSeed = chn.attr.stVencAttr.u32PicWidth * 31 + chn.attr.stVencAttr.u32PicHeight;
+    job.queue = chn.queue;
+    job.streamBufCnt = chn.streamBufCnt;
+    return true;
+}
+
+/** 模拟编码耗时并生成码流（不持有全局锁） */
+void vencRun(const VencJob& job) {
+    static const int kEncodeUs = envInt("RK_SIM_VENC_US", 0);
+    if (kEncodeUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(kEncodeUs));
+    }
+
+    size_t avg = job.avg;
+    RK_U32 seed = job.seed;
+    RK_U32 paramSeed = job.paramSeed;
+    RK_U64 pts = job.pts;
+
+    SimStream stream;
+    if (job.h265) {
+        static const uint8_t vps[2] = { 32 << 1, 1 }, sps[2] = { 33 << 1, 1 },
+                             pps[2] = { 34 << 1, 1 }, idrHdr[2] = { 19 << 1, 1 },
+                             pHdr[2] = { 1 << 1, 1 };
+        if (job.idr) {
+            addPack(stream, 24, vps, 2, paramSeed, pts, true, H265E_NALU_VPS, false);
+            addPack(stream, 40, sps, 2, paramSeed, pts, true, H265E_NALU_SPS, false);
+            addPack(stream, 12, pps, 2, paramSeed, pts, true, H265E_NALU_PPS, false);
+            addPack(stream, avg * 4, idrHdr, 2, seed, pts, true, H265E_NALU_IDRSLICE, true);
+        } else if (job.islice) {
+            // TRAIL_R 的 I 片：不是 IRAP
+            addPack(stream, avg * 2, pHdr, 2, seed, pts, true, H265E_NALU_ISLICE, true);
+        } else {
+            addPack(stream, job.pSize, pHdr, 2, seed, pts, true, H265E_NALU_PSLICE, true);
+        }
+    } else {
+        static const uint8_t sps[4] = { 0x67, 0x64, 0x00, 0x33 }, pps[1] = { 0x68 },
+                             idrHdr[1] = { 0x65 }, pHdr[1] = { 0x41 };
+        if (job.idr) {
+            addPack(stream, 24, sps, 4, paramSeed, pts, false, H264E_NALU_SPS, false);
+            addPack(stream, 8, pps, 1, paramSeed, pts, false, H264E_NALU_PPS, false);
+            addPack(stream, avg * 4, idrHdr, 1, seed, pts, false, H264E_NALU_IDRSLICE, true);
+        } else if (job.islice) {
+            // NAL 类型 1 的 I 片：不是 IDR
+            addPack(stream, avg * 2, pHdr, 1, seed, pts, false, H264E_NALU_ISLICE, true);
+        } else {
+            addPack(stream, job.pSize, pHdr, 1, seed, pts, false, H264E_NALU_PSLICE, true);
+        }
+    }
+
+    // 码流缓冲满时丢弃新帧（与硬件编码器输出缓冲耗尽时的行为一致）
+    job.queue->push(stream, job.streamBufCnt, true);
+}
+
+// ==================== 绑定下发 ====================
+
+void deliver(const ChnKey& src, const VIDEO_FRAME_INFO_S& frame) {
+    std::vector<VpssOutput> vpssOutputs;
+    std::vector<VencJob> vencJobs;
+    {
+        // 锁内只查找绑定关系并更新各模块状态，缩放和编码在锁外进行，互不相关的流水线不会互相串行
+        SimState& s = sim();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        std::pair<std::multimap<ChnKey, ChnKey>::iterator, std::multimap<ChnKey, ChnKey>::iterator> range =
+            s.binds.equal_range(src);
+        for (std::multimap<ChnKey, ChnKey>::iterator it = range.first; it != range.second; ++it) {
+            const ChnKey& dst = it->second;
+            if (dst.mod == RK_ID_VPSS) {
+                std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator g = s.vpssGrps.find(dst.dev);
+                if (g != s.vpssGrps.end() && g->second->started) {
+                    vpssPrepare(dst.dev, *g->second, frame, vpssOutputs);
+                }
+            } else if (dst.mod == RK_ID_VENC) {
+                std::map<VENC_CHN, std::unique_ptr<SimVencChn>>::iterator v = s.vencChns.find(dst.chn);
+                VencJob job;
+                if (v != s.vencChns.end() && vencPrepare(*v->second, frame, job)) {
+                    vencJobs.push_back(job);
+                }
+            } else if (dst.mod == RK_ID_VO) {
+                std::map<VO_LAYER, VoLayer>::iterator l = s.voLayers.find(dst.dev);
+                if (l != s.voLayers.end() && l->second.enabled) {
+                    l->second.shown++;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < vencJobs.size(); i++) {
+        vencRun(vencJobs[i]);
+    }
+
+    // 输入帧在调用方返回前一直有效，缩放时不需要额外引用
+    const VIDEO_FRAME_S& vf = frame.stVFrame;
+    for (size_t i = 0; i < vpssOutputs.size(); i++) {
+        VpssOutput& o = vpssOutputs[i];
+        if (o.scale) {
+            scaleNv12(mbFromHandle(vf.pMbBlk)->data, vf.u32Width, vf.u32Height,
+                      mbFromHandle(o.out.stVFrame.pMbBlk)->data, o.out.stVFrame.u32Width,
+                      o.out.stVFrame.u32Height);
+        }
+        if (o.bound) {
+            deliver(o.src, o.out);
+        }
+        o.queue->push(o.out, o.depth, false);
+    }
+}
+
+// ==================== VI 采集线程 ====================
+
+void generatePattern(uint8_t* dst, RK_U32 w, RK_U32 h, RK_U32 frameId, std::vector<uint8_t>& row) {
+    // 斜向渐变条纹，每帧平移 4 像素；按行从预生成的图案中拷贝
+    if (row.size() != static_cast<size_t>(w) + 256) {
+        row.resize(static_cast<size_t>(w) + 256);
+        for (size_t i = 0; i < row.size(); i++) {
+            row[i] = static_cast<uint8_t>(i & 0xff);
+        }
+    }
+    for (RK_U32 y = 0; y < h; y++) {
+        memcpy(dst + static_cast<size_t>(y) * w, &row[(y + frameId * 4) & 0xff], w);
+    }
+    memset(dst + static_cast<size_t>(w) * h, 128, static_cast<size_t>(w) * h / 2);
+}
+
+void viThread(ChnKey key, SimViChn* chn) {
+    RK_U32 w = chn->attr.stSize.u32Width;
+    RK_U32 h = chn->attr.stSize.u32Height;
+    size_t frameSize = nv12Size(w, h);
+
+    int fps = chn->attr.stFrameRate.s32DstFrameRate > 0 ? chn->attr.stFrameRate.s32DstFrameRate
+                                                        : kDefaultFps;
+    fps = envInt("RK_SIM_VI_FPS", fps);
+
+    FILE* file = nullptr;
+    const char* path = getenv("RK_SIM_VI_FILE");
+    if (path && *path) {
+        file = fopen(path, "rb");
+        if (!file) {
+            std::cerr << "[rk_mpi_sim] Cannot open RK_SIM_VI_FILE " << path
+                      << ", using test pattern" << std::endl;
+        }
+    }
+
+    std::vector<uint8_t> row;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (chn->running.load()) {
+        SimMb* mb = chn->pool->get();
+        bool filled = false;
+        if (file) {
+            if (fread(mb->data, 1, frameSize, file) != frameSize) {
+                rewind(file);
+                filled = fread(mb->data, 1, frameSize, file) == frameSize;
+            } else {
+                filled = true;
+            }
+        }
+        if (!filled) {
+            generatePattern(mb->data, w, h, chn->frameId, row);
+        }
+
+        VIDEO_FRAME_INFO_S frame;
+        fillFrameInfo(frame, mb, w, h, nowUs(), chn->frameId++);
+
+        // 未绑定或设置了深度时用户可以取帧；否则释放采集线程持有的引用
+        deliver(key, frame);
+        RK_U32 depth;
+        {
+            std::lock_guard<std::mutex> lock(sim().mutex);
+            depth = chn->attr.u32Depth ? chn->attr.u32Depth
+                                       : (hasBind(key) ? 0 : kDefaultUserDepth);
+        }
+        chn->queue->push(frame, depth, false);
+
+        if (fps > 0) {
+            next.tv_nsec += 1000000000L / fps;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+    }
+
+    if (file) {
+        fclose(file);
+    }
+}
+
+SimViChn* findViChn(VI_PIPE pipe, VI_CHN chn) {
+    ChnKey key = { RK_ID_VI, pipe, chn };
+    std::map<ChnKey, std::unique_ptr<SimViChn>>::iterator it = sim().viChns.find(key);
+    return it == sim().viChns.end() ? nullptr : it->second.get();
+}
+
+SimVpssChn* findVpssChn(VPSS_GRP grp, VPSS_CHN chn) {
+    if (chn < 0 || chn >= VPSS_MAX_CHN_NUM) {
+        return nullptr;
+    }
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator it = sim().vpssGrps.find(grp);
+    return it == sim().vpssGrps.end() ? nullptr : &it->second->chns[chn];
+}
+
+SimVencChn* findVencChn(VENC_CHN chn) {
+    std::map<VENC_CHN, std::unique_ptr<SimVencChn>>::iterator it = sim().vencChns.find(chn);
+    return it == sim().vencChns.end() ? nullptr : it->second.get();
+}
+
+}  // namespace
+
+// ==================== SYS ====================
+
+RK_S32 RK_MPI_SYS_Init(RK_VOID) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().sysInited = true;
+    std::cout << "[rk_mpi_sim] Software MPI backend initialized" << std::endl;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_SYS_Exit(RK_VOID) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().sysInited = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_SYS_Bind(const MPP_CHN_S* pstSrcChn, const MPP_CHN_S* pstDestChn) {
+    if (!pstSrcChn || !pstDestChn) {
+        return RK_DEF_ERR(RK_ID_SYS, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    ChnKey src = srcKey(pstSrcChn);
+    ChnKey dst = dstKey(pstDestChn);
+    std::pair<std::multimap<ChnKey, ChnKey>::iterator, std::multimap<ChnKey, ChnKey>::iterator> range =
+        sim().binds.equal_range(src);
+    for (std::multimap<ChnKey, ChnKey>::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == dst) {
+            return RK_DEF_ERR(RK_ID_SYS, RK_ERR_LEVEL_ERROR, RK_ERR_EXIST);
+        }
+    }
+    sim().binds.insert(std::make_pair(src, dst));
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_SYS_UnBind(const MPP_CHN_S* pstSrcChn, const MPP_CHN_S* pstDestChn) {
+    if (!pstSrcChn || !pstDestChn) {
+        return RK_DEF_ERR(RK_ID_SYS, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    ChnKey src = srcKey(pstSrcChn);
+    ChnKey dst = dstKey(pstDestChn);
+    std::pair<std::multimap<ChnKey, ChnKey>::iterator, std::multimap<ChnKey, ChnKey>::iterator> range =
+        sim().binds.equal_range(src);
+    for (std::multimap<ChnKey, ChnKey>::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == dst) {
+            sim().binds.erase(it);
+            return RK_SUCCESS;
+        }
+    }
+    return RK_DEF_ERR(RK_ID_SYS, RK_ERR_LEVEL_ERROR, RK_ERR_UNEXIST);
+}
+
+RK_S32 RK_MPI_SYS_GetCurPTS(RK_U64* pu64CurPTS) {
+    if (!pu64CurPTS) {
+        return RK_DEF_ERR(RK_ID_SYS, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+    }
+    *pu64CurPTS = nowUs();
+    return RK_SUCCESS;
+}
+
+// ==================== MB ====================
+
+RK_VOID* RK_MPI_MB_Handle2VirAddr(MB_BLK mb) {
+    SimMb* m = mbFromHandle(mb);
+    return m ? m->data : nullptr;
+}
+
+RK_U64 RK_MPI_MB_Handle2PhysAddr(MB_BLK mb) {
+    (void)mb;
+    return 0;
+}
+
+RK_S32 RK_MPI_MB_Handle2Fd(MB_BLK mb) {
+    (void)mb;
+    return -1;  // 软件缓冲区没有 dma-buf
+}
+
+RK_U64 RK_MPI_MB_GetSize(MB_BLK mb) {
+    SimMb* m = mbFromHandle(mb);
+    return m ? m->size : 0;
+}
+
+// ==================== VI ====================
+
+RK_S32 RK_MPI_VI_SetDevAttr(VI_DEV ViDev, const VI_DEV_ATTR_S* pstDevAttr) {
+    if (!pstDevAttr) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().viDevConfigured[ViDev] = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_GetDevAttr(VI_DEV ViDev, VI_DEV_ATTR_S* pstDevAttr) {
+    if (!pstDevAttr) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    if (!sim().viDevConfigured[ViDev]) {
+        return RK_ERR_VI_NOT_CONFIG;
+    }
+    memset(pstDevAttr, 0, sizeof(VI_DEV_ATTR_S));
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_EnableDev(VI_DEV ViDev) {
+    setupDelay();
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().viDevEnabled[ViDev] = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_DisableDev(VI_DEV ViDev) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().viDevEnabled[ViDev] = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_GetDevIsEnable(VI_DEV ViDev) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    return sim().viDevEnabled[ViDev] ? RK_SUCCESS : RK_ERR_VI_NOT_CONFIG;
+}
+
+RK_S32 RK_MPI_VI_SetDevBindPipe(VI_DEV ViDev, const VI_DEV_BIND_PIPE_S* pstDevBindPipe) {
+    (void)ViDev;
+    return pstDevBindPipe ? RK_SUCCESS : RK_ERR_VI_INVALID_NULL_PTR;
+}
+
+RK_S32 RK_MPI_VI_GetDevBindPipe(VI_DEV ViDev, VI_DEV_BIND_PIPE_S* pstDevBindPipe) {
+    if (!pstDevBindPipe) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    memset(pstDevBindPipe, 0, sizeof(VI_DEV_BIND_PIPE_S));
+    pstDevBindPipe->u32Num = 1;
+    pstDevBindPipe->PipeId[0] = ViDev;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_SetChnAttr(VI_PIPE ViPipe, VI_CHN ViChn, const VI_CHN_ATTR_S* pstChnAttr) {
+    if (!pstChnAttr) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    if (pstChnAttr->stSize.u32Width == 0 || pstChnAttr->stSize.u32Height == 0 ||
+        (pstChnAttr->stSize.u32Width & 1) || (pstChnAttr->stSize.u32Height & 1)) {
+        return RK_ERR_VI_INVALID_PARA;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    ChnKey key = { RK_ID_VI, ViPipe, ViChn };
+    std::unique_ptr<SimViChn>& chn = sim().viChns[key];
+    if (!chn) {
+        chn.reset(new SimViChn());
+    }
+    if (chn->enabled) {
+        return RK_ERR_VI_BUSY;
+    }
+    chn->attr = *pstChnAttr;
+    chn->configured = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_GetChnAttr(VI_PIPE ViPipe, VI_CHN ViChn, VI_CHN_ATTR_S* pstChnAttr) {
+    if (!pstChnAttr) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimViChn* chn = findViChn(ViPipe, ViChn);
+    if (!chn || !chn->configured) {
+        return RK_ERR_VI_NOT_CONFIG;
+    }
+    *pstChnAttr = chn->attr;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_EnableChn(VI_PIPE ViPipe, VI_CHN ViChn) {
+    setupDelay();
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimViChn* chn = findViChn(ViPipe, ViChn);
+    if (!chn || !chn->configured) {
+        return RK_ERR_VI_NOT_CONFIG;
+    }
+    if (chn->enabled) {
+        return RK_SUCCESS;
+    }
+    chn->queue = std::make_shared<FrameQueue>(kDefaultUserDepth, &releaseFrameItem);
+    chn->pool = std::make_shared<BufferPool>(nv12Size(chn->attr.stSize.u32Width,
+                                                      chn->attr.stSize.u32Height));
+    chn->enabled = true;
+    chn->running.store(true);
+    ChnKey key = { RK_ID_VI, ViPipe, ViChn };
+    chn->thread = std::thread(viThread, key, chn);
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_DisableChn(VI_PIPE ViPipe, VI_CHN ViChn) {
+    SimViChn* chn;
+    {
+        std::lock_guard<std::mutex> lock(sim().mutex);
+        chn = findViChn(ViPipe, ViChn);
+        if (!chn || !chn->enabled) {
+            return RK_ERR_VI_NOT_CONFIG;
+        }
+        chn->running.store(false);
+    }
+    // 采集线程下发时需要全局锁，必须在锁外 join
+    if (chn->thread.joinable()) {
+        chn->thread.join();
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    chn->queue->clear();
+    chn->enabled = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_GetChnFrame(VI_PIPE ViPipe, VI_CHN ViChn, VIDEO_FRAME_INFO_S* pstFrameInfo,
+                             RK_S32 s32MilliSec) {
+    if (!pstFrameInfo) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    std::shared_ptr<FrameQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(sim().mutex);
+        SimViChn* chn = findViChn(ViPipe, ViChn);
+        if (!chn || !chn->enabled) {
+            return RK_ERR_VI_NOT_CONFIG;
+        }
+        queue = chn->queue;
+    }
+    return queue->pop(*pstFrameInfo, s32MilliSec) ? RK_SUCCESS : RK_ERR_VI_BUF_EMPTY;
+}
+
+RK_S32 RK_MPI_VI_ReleaseChnFrame(VI_PIPE ViPipe, VI_CHN ViChn, const VIDEO_FRAME_INFO_S* pstFrameInfo) {
+    (void)ViPipe;
+    (void)ViChn;
+    if (!pstFrameInfo) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    mbRelease(mbFromHandle(pstFrameInfo->stVFrame.pMbBlk));
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_QueryChnStatus(VI_PIPE ViPipe, VI_CHN ViChn, VI_CHN_STATUS_S* pstChnStatus) {
+    if (!pstChnStatus) {
+        return RK_ERR_VI_INVALID_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimViChn* chn = findViChn(ViPipe, ViChn);
+    if (!chn) {
+        return RK_ERR_VI_UNEXIST;
+    }
+    memset(pstChnStatus, 0, sizeof(VI_CHN_STATUS_S));
+    pstChnStatus->bEnable = chn->enabled ? RK_TRUE : RK_FALSE;
+    pstChnStatus->u32CurFrameID = chn->frameId;
+    pstChnStatus->stSize = chn->attr.stSize;
+    pstChnStatus->u32OutputLostFrame = chn->queue ? static_cast<RK_U32>(chn->queue->dropped) : 0;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VI_GetChnFd(VI_PIPE ViPipe, VI_CHN ViChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimViChn* chn = findViChn(ViPipe, ViChn);
+    return (chn && chn->queue) ? chn->queue->eventFd : -1;
+}
+
+// ==================== VPSS ====================
+
+RK_S32 RK_MPI_VPSS_CreateGrp(VPSS_GRP VpssGrp, const VPSS_GRP_ATTR_S* pstGrpAttr) {
+    if (!pstGrpAttr) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    setupDelay();
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::unique_ptr<SimVpssGrp>& grp = sim().vpssGrps[VpssGrp];
+    if (grp) {
+        return RK_ERR_VPSS_EXIST;
+    }
+    grp.reset(new SimVpssGrp());
+    grp->attr = *pstGrpAttr;
+    for (int i = 0; i < VPSS_MAX_CHN_NUM; i++) {
+        memset(&grp->chns[i].attr, 0, sizeof(VPSS_CHN_ATTR_S));
+        grp->chns[i].queue = std::make_shared<FrameQueue>(0, &releaseFrameItem);
+    }
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_DestroyGrp(VPSS_GRP VpssGrp) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator it = sim().vpssGrps.find(VpssGrp);
+    if (it == sim().vpssGrps.end()) {
+        return RK_ERR_VPSS_UNEXIST;
+    }
+    for (int i = 0; i < VPSS_MAX_CHN_NUM; i++) {
+        it->second->chns[i].queue->clear();
+    }
+    sim().vpssGrps.erase(it);
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_StartGrp(VPSS_GRP VpssGrp) {
+    setupDelay();
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator it = sim().vpssGrps.find(VpssGrp);
+    if (it == sim().vpssGrps.end()) {
+        return RK_ERR_VPSS_UNEXIST;
+    }
+    it->second->started = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_StopGrp(VPSS_GRP VpssGrp) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator it = sim().vpssGrps.find(VpssGrp);
+    if (it == sim().vpssGrps.end()) {
+        return RK_ERR_VPSS_UNEXIST;
+    }
+    it->second->started = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_GetGrpAttr(VPSS_GRP VpssGrp, VPSS_GRP_ATTR_S* pstGrpAttr) {
+    if (!pstGrpAttr) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator it = sim().vpssGrps.find(VpssGrp);
+    if (it == sim().vpssGrps.end()) {
+        return RK_ERR_VPSS_UNEXIST;
+    }
+    *pstGrpAttr = it->second->attr;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_SetGrpAttr(VPSS_GRP VpssGrp, const VPSS_GRP_ATTR_S* pstGrpAttr) {
+    if (!pstGrpAttr) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::map<VPSS_GRP, std::unique_ptr<SimVpssGrp>>::iterator it = sim().vpssGrps.find(VpssGrp);
+    if (it == sim().vpssGrps.end()) {
+        return RK_ERR_VPSS_UNEXIST;
+    }
+    it->second->attr = *pstGrpAttr;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_SetChnAttr(VPSS_GRP VpssGrp, VPSS_CHN VpssChn, const VPSS_CHN_ATTR_S* pstChnAttr) {
+    if (!pstChnAttr) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    if ((pstChnAttr->u32Width & 1) || (pstChnAttr->u32Height & 1)) {
+        return RK_ERR_VPSS_ILLEGAL_PARAM;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVpssChn* chn = findVpssChn(VpssGrp, VpssChn);
+    if (!chn) {
+        return RK_ERR_VPSS_INVALID_CHNID;
+    }
+    chn->attr = *pstChnAttr;
+    chn->configured = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_GetChnAttr(VPSS_GRP VpssGrp, VPSS_CHN VpssChn, VPSS_CHN_ATTR_S* pstChnAttr) {
+    if (!pstChnAttr) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVpssChn* chn = findVpssChn(VpssGrp, VpssChn);
+    if (!chn) {
+        return RK_ERR_VPSS_INVALID_CHNID;
+    }
+    *pstChnAttr = chn->attr;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_EnableChn(VPSS_GRP VpssGrp, VPSS_CHN VpssChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVpssChn* chn = findVpssChn(VpssGrp, VpssChn);
+    if (!chn) {
+        return RK_ERR_VPSS_INVALID_CHNID;
+    }
+    chn->enabled = true;
+    chn->inputCount = 0;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_DisableChn(VPSS_GRP VpssGrp, VPSS_CHN VpssChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVpssChn* chn = findVpssChn(VpssGrp, VpssChn);
+    if (!chn) {
+        return RK_ERR_VPSS_INVALID_CHNID;
+    }
+    chn->enabled = false;
+    chn->queue->clear();
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_GetChnFrame(VPSS_GRP VpssGrp, VPSS_CHN VpssChn, VIDEO_FRAME_INFO_S* pstVideoFrame,
+                               RK_S32 s32MilliSec) {
+    if (!pstVideoFrame) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    std::shared_ptr<FrameQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(sim().mutex);
+        SimVpssChn* chn = findVpssChn(VpssGrp, VpssChn);
+        if (!chn) {
+            return RK_ERR_VPSS_INVALID_CHNID;
+        }
+        if (!chn->enabled) {
+            return RK_ERR_VPSS_NOT_PERM;
+        }
+        queue = chn->queue;
+    }
+    return queue->pop(*pstVideoFrame, s32MilliSec) ? RK_SUCCESS : RK_ERR_VPSS_BUF_EMPTY;
+}
+
+RK_S32 RK_MPI_VPSS_ReleaseChnFrame(VPSS_GRP VpssGrp, VPSS_CHN VpssChn,
+                                   const VIDEO_FRAME_INFO_S* pstVideoFrame) {
+    (void)VpssGrp;
+    (void)VpssChn;
+    if (!pstVideoFrame) {
+        return RK_ERR_VPSS_NULL_PTR;
+    }
+    SimMb* mb = mbFromHandle(pstVideoFrame->stVFrame.pMbBlk);
+    if (!mb) {
+        return RK_ERR_VPSS_ILLEGAL_PARAM;
+    }
+    mbRelease(mb);
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VPSS_GetChnFd(VPSS_GRP VpssGrp, VPSS_CHN VpssChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVpssChn* chn = findVpssChn(VpssGrp, VpssChn);
+    return chn ? chn->queue->eventFd : -1;
+}
+
+// ==================== VENC ====================
+
+RK_S32 RK_MPI_VENC_CreateChn(VENC_CHN VeChn, const VENC_CHN_ATTR_S* pstAttr) {
+    if (!pstAttr) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    setupDelay();
+    if (pstAttr->stVencAttr.enType != RK_VIDEO_ID_AVC && pstAttr->stVencAttr.enType != RK_VIDEO_ID_HEVC) {
+        return RK_ERR_VENC_NOT_SUPPORT;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::unique_ptr<SimVencChn>& chn = sim().vencChns[VeChn];
+    if (chn) {
+        return RK_ERR_VENC_EXIST;
+    }
+    chn.reset(new SimVencChn());
+    chn->attr = *pstAttr;
+    memset(&chn->rcParam, 0, sizeof(VENC_RC_PARAM_S));
+    RK_U32 bufCnt = pstAttr->stVencAttr.u32StreamBufCnt ? pstAttr->stVencAttr.u32StreamBufCnt
+                                                        : kDefaultStreamBufCnt;
+    chn->streamBufCnt = bufCnt;
+    chn->queue = std::make_shared<StreamQueue>(bufCnt, &releaseStreamItem);
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_DestroyChn(VENC_CHN VeChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    std::map<VENC_CHN, std::unique_ptr<SimVencChn>>::iterator it = sim().vencChns.find(VeChn);
+    if (it == sim().vencChns.end()) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    it->second->queue->clear();
+    sim().vencChns.erase(it);
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_ResetChn(VENC_CHN VeChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    chn->queue->clear();
+    chn->forceIdr = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_StartRecvFrame(VENC_CHN VeChn, const VENC_RECV_PIC_PARAM_S* pstRecvParam) {
+    (void)pstRecvParam;
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    chn->recv = true;
+    chn->forceIdr = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_StopRecvFrame(VENC_CHN VeChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    chn->recv = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_QueryStatus(VENC_CHN VeChn, VENC_CHN_STATUS_S* pstStatus) {
+    if (!pstStatus) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    std::shared_ptr<StreamQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(sim().mutex);
+        SimVencChn* chn = findVencChn(VeChn);
+        if (!chn) {
+            return RK_ERR_VENC_UNEXIST;
+        }
+        queue = chn->queue;
+    }
+    memset(pstStatus, 0, sizeof(VENC_CHN_STATUS_S));
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    pstStatus->u32LeftStreamFrames = static_cast<RK_U32>(queue->items.size());
+    if (!queue->items.empty()) {
+        const SimStream& head = queue->items.front();
+        pstStatus->u32CurPacks = static_cast<RK_U32>(head.size());
+        for (size_t i = 0; i < head.size(); i++) {
+            pstStatus->u32LeftStreamBytes += head[i].u32Len;
+        }
+    }
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_SetChnAttr(VENC_CHN VeChn, const VENC_CHN_ATTR_S* pstChnAttr) {
+    if (!pstChnAttr) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    // 与硬件一致：编码格式和分辨率不能动态修改
+    if (pstChnAttr->stVencAttr.enType != chn->attr.stVencAttr.enType ||
+        pstChnAttr->stVencAttr.u32PicWidth != chn->attr.stVencAttr.u32PicWidth ||
+        pstChnAttr->stVencAttr.u32PicHeight != chn->attr.stVencAttr.u32PicHeight) {
+        return RK_ERR_VENC_NOT_PERM;
+    }
+    chn->attr = *pstChnAttr;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_GetChnAttr(VENC_CHN VeChn, VENC_CHN_ATTR_S* pstChnAttr) {
+    if (!pstChnAttr) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    *pstChnAttr = chn->attr;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_SetRcParam(VENC_CHN VeChn, const VENC_RC_PARAM_S* pstRcParam) {
+    if (!pstRcParam) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    chn->rcParam = *pstRcParam;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_GetRcParam(VENC_CHN VeChn, VENC_RC_PARAM_S* pstRcParam) {
+    if (!pstRcParam) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    *pstRcParam = chn->rcParam;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_RequestIDR(VENC_CHN VeChn, RK_BOOL bInstant) {
+    (void)bInstant;
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    if (!chn) {
+        return RK_ERR_VENC_UNEXIST;
+    }
+    chn->forceIdr = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_GetStream(VENC_CHN VeChn, VENC_STREAM_S* pstStream, RK_S32 s32MilliSec) {
+    if (!pstStream || !pstStream->pstPack || pstStream->u32PackCount == 0) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    std::shared_ptr<StreamQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(sim().mutex);
+        SimVencChn* chn = findVencChn(VeChn);
+        if (!chn) {
+            return RK_ERR_VENC_UNEXIST;
+        }
+        queue = chn->queue;
+    }
+
+    SimStream stream;
+    if (!queue->pop(stream, s32MilliSec)) {
+        return RK_ERR_VENC_BUF_EMPTY;
+    }
+
+    // 调用方提供的 pack 数少于本帧 pack 数时，把剩余 pack 合并到最后一个
+    RK_U32 count = static_cast<RK_U32>(stream.size());
+    if (count > pstStream->u32PackCount) {
+        RK_U32 last = pstStream->u32PackCount - 1;
+        size_t total = 0;
+        for (RK_U32 i = last; i < count; i++) {
+            total += stream[i].u32Len;
+        }
+        SimMb* merged = mbAlloc(total);
+        size_t off = 0;
+        for (RK_U32 i = last; i < count; i++) {
+            SimMb* mb = mbFromHandle(stream[i].pMbBlk);
+            memcpy(merged->data + off, mb->data, stream[i].u32Len);
+            off += stream[i].u32Len;
+            mbRelease(mb);
+        }
+        VENC_PACK_S pack = stream[count - 1];
+        pack.pMbBlk = merged;
+        pack.u32Len = static_cast<RK_U32>(total);
+        // 合并包的类型取其中的图像 slice（最后一个）
+        stream.resize(last);
+        stream.push_back(pack);
+        count = static_cast<RK_U32>(stream.size());
+    }
+
+    for (RK_U32 i = 0; i < count; i++) {
+        pstStream->pstPack[i] = stream[i];
+    }
+    pstStream->u32PackCount = count;
+
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    pstStream->u32Seq = chn ? chn->seq++ : 0;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_ReleaseStream(VENC_CHN VeChn, VENC_STREAM_S* pstStream) {
+    (void)VeChn;
+    if (!pstStream || !pstStream->pstPack) {
+        return RK_ERR_VENC_NULL_PTR;
+    }
+    for (RK_U32 i = 0; i < pstStream->u32PackCount; i++) {
+        mbRelease(mbFromHandle(pstStream->pstPack[i].pMbBlk));
+        pstStream->pstPack[i].pMbBlk = nullptr;
+    }
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VENC_GetFd(VENC_CHN VeChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    SimVencChn* chn = findVencChn(VeChn);
+    return chn ? chn->queue->eventFd : -1;
+}
+
+RK_S32 RK_MPI_VENC_CloseFd(VENC_CHN VeChn) {
+    (void)VeChn;
+    return RK_SUCCESS;  // eventfd 随通道销毁关闭
+}
+
+// ==================== VO ====================
+
+RK_S32 RK_MPI_VO_SetPubAttr(VO_DEV VoDev, const VO_PUB_ATTR_S* pstPubAttr) {
+    (void)VoDev;
+    return pstPubAttr ? RK_SUCCESS : RK_DEF_ERR(RK_ID_VO, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+}
+
+RK_S32 RK_MPI_VO_GetPubAttr(VO_DEV VoDev, VO_PUB_ATTR_S* pstPubAttr) {
+    (void)VoDev;
+    if (!pstPubAttr) {
+        return RK_DEF_ERR(RK_ID_VO, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+    }
+    memset(pstPubAttr, 0, sizeof(VO_PUB_ATTR_S));
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_Enable(VO_DEV VoDev) {
+    setupDelay();
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().voDevEnabled[VoDev] = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_Disable(VO_DEV VoDev) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().voDevEnabled[VoDev] = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_BindLayer(VO_LAYER VoLayer, VO_DEV VoDev, VO_LAYER_MODE_E enLayerMode) {
+    (void)VoLayer;
+    (void)VoDev;
+    (void)enLayerMode;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_UnBindLayer(VO_LAYER VoLayer, VO_DEV VoDev) {
+    (void)VoLayer;
+    (void)VoDev;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_SetLayerAttr(VO_LAYER VoLayer, const VO_VIDEO_LAYER_ATTR_S* pstLayerAttr) {
+    (void)VoLayer;
+    return pstLayerAttr ? RK_SUCCESS : RK_DEF_ERR(RK_ID_VO, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+}
+
+RK_S32 RK_MPI_VO_GetLayerAttr(VO_LAYER VoLayer, VO_VIDEO_LAYER_ATTR_S* pstLayerAttr) {
+    (void)VoLayer;
+    if (!pstLayerAttr) {
+        return RK_DEF_ERR(RK_ID_VO, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+    }
+    memset(pstLayerAttr, 0, sizeof(VO_VIDEO_LAYER_ATTR_S));
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_EnableLayer(VO_LAYER VoLayer) {
+    setupDelay();
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().voLayers[VoLayer].enabled = true;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_DisableLayer(VO_LAYER VoLayer) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    sim().voLayers[VoLayer].enabled = false;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_SetChnAttr(VO_LAYER VoLayer, VO_CHN VoChn, const VO_CHN_ATTR_S* pstChnAttr) {
+    (void)VoLayer;
+    (void)VoChn;
+    return pstChnAttr ? RK_SUCCESS : RK_DEF_ERR(RK_ID_VO, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+}
+
+RK_S32 RK_MPI_VO_GetChnAttr(VO_LAYER VoLayer, VO_CHN VoChn, VO_CHN_ATTR_S* pstChnAttr) {
+    (void)VoLayer;
+    (void)VoChn;
+    if (!pstChnAttr) {
+        return RK_DEF_ERR(RK_ID_VO, RK_ERR_LEVEL_ERROR, RK_ERR_NULL_PTR);
+    }
+    memset(pstChnAttr, 0, sizeof(VO_CHN_ATTR_S));
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_EnableChn(VO_LAYER VoLayer, VO_CHN VoChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    if (VoChn >= 0 && VoChn < 16) {
+        sim().voLayers[VoLayer].chnEnabled[VoChn] = true;
+    }
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_DisableChn(VO_LAYER VoLayer, VO_CHN VoChn) {
+    std::lock_guard<std::mutex> lock(sim().mutex);
+    if (VoChn >= 0 && VoChn < 16) {
+        sim().voLayers[VoLayer].chnEnabled[VoChn] = false;
+    }
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_ShowChn(VO_LAYER VoLayer, VO_CHN VoChn) {
+    (void)VoLayer;
+    (void)VoChn;
+    return RK_SUCCESS;
+}
+
+RK_S32 RK_MPI_VO_HideChn(VO_LAYER VoLayer, VO_CHN VoChn) {
+    (void)VoLayer;
+    (void)VoChn;
+    return RK_SUCCESS;
+}
@@ -0,0 +1,573 @@
+#include "DiskWriterSvc.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t alignDown(size_t value, size_t alignment) {
+    return value / alignment * alignment;
+}
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+}  // namespace
+
+DiskWriterSvc::DiskWriterSvc(const DiskWriterConfig& config)
+    : ServiceBase("DiskWriterSvc"),
+      m_config(config),
+      m_chunkBytes(alignUp(config.chunkBytes ? config.chunkBytes : config.alignment, config.alignment)) {
+    memset(&m_stats, 0, sizeof(m_stats));
+    setThreadAttr(ThreadAttr::background());
+    m_writeMetric = MetricsRegistry::instance().histogram(
+        "media_disk_write_duration_seconds", "Duration of write system calls", metricLabels());
+    m_metricsCollector.reset([this](MetricsWriter& writer) { collectMetrics(writer); });
+
+    // 至少两块：一块填充的同时另一块写盘
+    size_t count = std::max<size_t>(config.bufferBytes / m_chunkBytes, 2);
+    void* arena = nullptr;
+    if (posix_memalign(&arena, config.alignment, count * m_chunkBytes) != 0) {
+        std::cerr << "[" << m_name << "] Failed to allocate " << count * m_chunkBytes
+                  << " bytes of write buffer" << std::endl;
+        return;
+    }
+    m_arena = static_cast<uint8_t*>(arena);
+    void* tail = nullptr;
+    if (posix_memalign(&tail, config.alignment, config.alignment) != 0) {
+        std::cerr << "[" << m_name << "] Failed to allocate partial write buffer" << std::endl;
+        free(m_arena);
+        m_arena = nullptr;
+        return;
+    }
+    m_tailBlock = static_cast<uint8_t*>(tail);
+    m_chunks.resize(count);
+    m_freeChunks.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        m_chunks[i].data = m_arena + i * m_chunkBytes;
+        m_freeChunks.push_back(&m_chunks[i]);
+    }
+    m_latencies.reserve(kLatencyWindow);
+}
+
+DiskWriterSvc::~DiskWriterSvc() {
+    stop();
+    join();
+
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::map<int, std::shared_ptr<File>>::iterator it = m_files.begin(); it != m_files.end(); ++it) {
+            ids.push_back(it->first);
+        }
+    }
+    for (size_t i = 0; i < ids.size(); i++) {
+        closeFile(ids[i]);
+    }
+    free(m_arena);
+    free(m_tailBlock);
+}
+
+int DiskWriterSvc::openFile(const std::string& path, uint64_t maxBytes) {
+    if (!m_arena) {
+        return -1;
+    }
+
+    std::shared_ptr<File> file = std::make_shared<File>();
+    file->path = path;
+    file->maxBytes = maxBytes;
+
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (m_config.directIo) {
+        file->fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        file->direct = (file->fd >= 0);
+        if (file->fd < 0 && errno == EINVAL) {
+            std::cerr << "[" << m_name << "] O_DIRECT not supported for " << path
+                      << ", using buffered writes" << std::endl;
+        }
+    }
+    if (file->fd < 0) {
+        file->fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (file->fd < 0) {
+        std::cerr << "[" << m_name << "] Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    file->id = m_nextFileId++;
+    m_files[file->id] = file;
+    return file->id;
+}
+
+bool DiskWriterSvc::closeFile(int id) {
+    std::shared_ptr<File> file;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<int, std::shared_ptr<File>>::iterator it = m_files.find(id);
+        if (it == m_files.end()) {
+            return false;
+        }
+        file = it->second;
+        m_files.erase(it);
+    }
+
+    uint64_t size;
+    {
+        std::lock_guard<std::mutex> lock(file->mutex);
+        file->closing = true;
+        if (file->current) {
+            sealChunk(file, file->current);
+            file->current = nullptr;
+        }
+        size = file->size;
+    }
+
+    // 在调用方线程中写完剩余数据（与服务线程的写盘经 m_ioMutex 串行）
+    std::lock_guard<std::mutex> io(m_ioMutex);
+    writePending();
+
+    bool ok = true;
+    if (ftruncate(file->fd, static_cast<off_t>(size)) != 0 || fdatasync(file->fd) != 0) {
+        std::cerr << "[" << m_name << "] Failed to finish " << file->path << ": " << strerror(errno) << std::endl;
+        ok = false;
+    }
+    if (!file->direct) {
+        posix_fadvise(file->fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    close(file->fd);
+    file->fd = -1;
+    return ok;
+}
+
+std::shared_ptr<DiskWriterSvc::File> DiskWriterSvc::findFile(int id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<int, std::shared_ptr<File>>::const_iterator it = m_files.find(id);
+    return (it == m_files.end()) ? std::shared_ptr<File>() : it->second;
+}
+
+bool DiskWriterSvc::write(int id, const iovec* iov, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += iov[i].iov_len;
+    }
+    if (total == 0) {
+        return true;
+    }
+
+    std::shared_ptr<File> file = findFile(id);
+    if (!file) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(file->mutex);
+    if (file->closing) {
+        return false;
+    }
+    return append(file, iov, count, total);
+}
+
+bool DiskWriterSvc::write(int id, const void* data, size_t size) {
+    iovec iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+    return write(id, &iov, 1);
+}
+
+bool DiskWriterSvc::write(int id, const EncodedFrame& frame) {
+    iovec iov[EncodedFrame::kMaxSegments];
+    for (int i = 0; i < frame.segmentCount; i++) {
+        iov[i].iov_base = const_cast<uint8_t*>(frame.segments[i].data);
+        iov[i].iov_len = frame.segments[i].size;
+    }
+    return write(id, iov, frame.segmentCount);
+}
+
+bool DiskWriterSvc::write(int id, const VideoFrame& frame) {
+    if (!frame.data) {
+        return false;
+    }
+    return write(id, frame.data, frame.size);
+}
+
+uint64_t DiskWriterSvc::fileSize(int id) const {
+    std::shared_ptr<File> file = findFile(id);
+    if (!file) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(file->mutex);
+    return file->size;
+}
+
+bool DiskWriterSvc::append(const std::shared_ptr<File>& file, const iovec* iov, int count, size_t total) {
+    File& f = *file;
+
+    // 达到大小上限：截断从头写（这一帧是新文件的第一帧）
+    if (f.maxBytes && f.size > 0 && f.size + total > f.maxBytes) {
+        if (f.current) {
+            sealChunk(file, f.current);
+            f.current = nullptr;
+        }
+        f.size = 0;
+        f.nextChunkOffset = 0;
+        f.restartNext = true;
+    }
+
+    // 先按整帧申请缓冲块，不足时整帧丢弃
+    size_t room = f.current ? m_chunkBytes - f.current->fill : 0;
+    size_t need = total > room ? (total - room + m_chunkBytes - 1) / m_chunkBytes : 0;
+    std::vector<Chunk*> reserved;
+    if (need > 0 && !reserveChunks(need, reserved)) {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.droppedWrites++;
+        m_stats.droppedBytes += total;
+        return false;
+    }
+
+    size_t next = 0;
+    for (int i = 0; i < count; i++) {
+        const uint8_t* p = static_cast<const uint8_t*>(iov[i].iov_base);
+        size_t left = iov[i].iov_len;
+        while (left > 0) {
+            if (!f.current) {
+                Chunk* chunk = reserved[next++];
+                chunk->fill = 0;
+                chunk->flushed = 0;
+                chunk->fileOffset = f.nextChunkOffset;
+                chunk->restart = f.restartNext;
+                chunk->dirtySince = std::chrono::steady_clock::now();
+                f.nextChunkOffset += m_chunkBytes;
+                f.restartNext = false;
+                f.current = chunk;
+            }
+            Chunk* chunk = f.current;
+            size_t n = std::min(left, m_chunkBytes - chunk->fill);
+            memcpy(chunk->data + chunk->fill, p, n);
+            chunk->fill += n;
+            p += n;
+            left -= n;
+            if (chunk->fill == m_chunkBytes) {
+                sealChunk(file, chunk);
+                f.current = nullptr;
+            }
+        }
+    }
+    f.size += total;
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.bytesAccepted += total;
+    return true;
+}
+
+bool DiskWriterSvc::reserveChunks(size_t count, std::vector<Chunk*>& out) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_freeChunks.size() < count && m_config.blockMs > 0) {
+        m_chunkFreed.wait_for(lock, std::chrono::milliseconds(m_config.blockMs),
+                              [this, count]() { return m_freeChunks.size() >= count; });
+    }
+    if (m_freeChunks.size() < count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out.push_back(m_freeChunks.back());
+        m_freeChunks.pop_back();
+    }
+
+    size_t buffered = (m_chunks.size() - m_freeChunks.size()) * m_chunkBytes;
+    std::lock_guard<std::mutex> statsLock(m_statsMutex);
+    if (buffered > m_stats.peakBufferedBytes) {
+        m_stats.peakBufferedBytes = buffered;
+    }
+    return true;
+}
+
+void DiskWriterSvc::sealChunk(const std::shared_ptr<File>& file, Chunk* chunk) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        wake = m_pending.empty();
+        m_pending.push_back(std::make_pair(file, chunk));
+    }
+    if (wake && isRunning()) {
+        post([this]() {
+            std::lock_guard<std::mutex> io(m_ioMutex);
+            writePending();
+        });
+    }
+}
+
+bool DiskWriterSvc::hasPending(const File* file) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_pending.size(); i++) {
+        if (m_pending[i].first.get() == file) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DiskWriterSvc::run() {
+    // 轮询间隔取滞留时间的一半，部分缓冲块最迟约 1.5 倍 flushIntervalMs 写出
+    int waitMs = static_cast<int>(std::max<uint32_t>(m_config.flushIntervalMs / 2, 10));
+    while (m_running.load()) {
+        waitEvents(waitMs);
+        processTasks();
+
+        std::lock_guard<std::mutex> io(m_ioMutex);
+        writePending();
+        flushPartial(false);
+    }
+
+    std::lock_guard<std::mutex> io(m_ioMutex);
+    writePending();
+    flushPartial(true);
+}
+
+void DiskWriterSvc::writePending() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batch.assign(m_pending.begin(), m_pending.end());
+        m_pending.clear();
+    }
+
+    // 同一文件偏移连续的写满块合并为一次 pwritev（只有组内最后一块可以未写满）
+    size_t i = 0;
+    while (i < m_batch.size()) {
+        File* file = m_batch[i].first.get();
+        m_group.clear();
+        m_group.push_back(m_batch[i].second);
+        size_t j = i + 1;
+        while (j < m_batch.size() && m_group.size() < m_config.maxBatchChunks &&
+               m_batch[j].first.get() == file) {
+            Chunk* prev = m_group.back();
+            Chunk* chunk = m_batch[j].second;
+            if (prev->fill != m_chunkBytes || chunk->restart || chunk->flushed != 0 ||
+                chunk->fileOffset != prev->fileOffset + m_chunkBytes) {
+                break;
+            }
+            m_group.push_back(chunk);
+            j++;
+        }
+        writeChunks(*file, m_group.data(), m_group.size());
+        i = j;
+    }
+    m_batch.clear();
+}
+
+void DiskWriterSvc::writeChunks(File& file, Chunk* const* chunks, size_t count) {
+    const size_t alignment = file.direct ? m_config.alignment : 1;
+    if (chunks[0]->restart && ftruncate(file.fd, 0) != 0) {
+        std::cerr << "[" << m_name << "] Failed to truncate " << file.path << ": " << strerror(errno) << std::endl;
+    }
+
+    m_iov.resize(count);
+    size_t start = alignDown(chunks[0]->flushed, alignment);
+    for (size_t i = 0; i < count; i++) {
+        size_t begin = (i == 0) ? start : 0;
+        size_t end = alignUp(chunks[i]->fill, alignment);
+        m_iov[i].iov_base = chunks[i]->data + begin;
+        m_iov[i].iov_len = end - begin;
+    }
+    pwriteAll(file, m_iov.data(), static_cast<int>(count), chunks[0]->fileOffset + start);
+
+    for (size_t i = 0; i < count; i++) {
+        recycle(chunks[i]);
+    }
+}
+
+void DiskWriterSvc::flushPartial(bool force) {
+    std::vector<std::shared_ptr<File>> files;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::map<int, std::shared_ptr<File>>::iterator it = m_files.begin(); it != m_files.end(); ++it) {
+            files.push_back(it->second);
+        }
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < files.size(); i++) {
+        File& file = *files[i];
+        // 写入方可能正在等待缓冲块（持有文件锁），不等它
+        std::unique_lock<std::mutex> lock(file.mutex, std::defer_lock);
+        if (force) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            continue;
+        }
+
+        Chunk* chunk = file.current;
+        if (!chunk || chunk->fill == chunk->flushed) {
+            continue;
+        }
+        if (!force && now - chunk->dirtySince < std::chrono::milliseconds(m_config.flushIntervalMs)) {
+            continue;
+        }
+        // 截断从头写的块必须排在之前的块之后写
+        if (chunk->restart && hasPending(&file)) {
+            continue;
+        }
+
+        const size_t alignment = file.direct ? m_config.alignment : 1;
+        size_t start = alignDown(chunk->flushed, alignment);
+        size_t fill = chunk->fill;
+        // 写入方只在 fill 之后追加：fill 之前的整块可以不持锁写出；fill 所在的块解锁后
+        // 仍会被追加，先拷到 m_tailBlock（其余补 0）再写
+        size_t head = alignDown(fill, alignment);
+        size_t tail = fill - head;
+        if (tail > 0) {
+            memcpy(m_tailBlock, chunk->data + head, tail);
+            memset(m_tailBlock + tail, 0, alignment - tail);
+        }
+        bool restart = chunk->restart;
+        chunk->restart = false;
+        lock.unlock();
+
+        if (restart && ftruncate(file.fd, 0) != 0) {
+            std::cerr << "[" << m_name << "] Failed to truncate " << file.path << ": " << strerror(errno) << std::endl;
+        }
+        iovec iov[2];
+        int count = 0;
+        if (head > start) {
+            iov[count].iov_base = chunk->data + start;
+            iov[count].iov_len = head - start;
+            count++;
+        }
+        if (tail > 0) {
+            iov[count].iov_base = m_tailBlock;
+            iov[count].iov_len = alignment;
+            count++;
+        }
+        pwriteAll(file, iov, count, chunk->fileOffset + start);
+        chunk->flushed = fill;
+        chunk->dirtySince = now;
+    }
+}
+
+bool DiskWriterSvc::pwriteAll(File& file, const iovec* iov, int count, uint64_t offset) {
+    std::vector<iovec> rest(iov, iov + count);
+    size_t index = 0;
+    uint64_t total = 0;
+    while (index < rest.size()) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ssize_t n = pwritev(file.fd, &rest[index], static_cast<int>(rest.size() - index),
+                            static_cast<off_t>(offset));
+        recordLatency(elapsedUs(start));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL && file.direct) {
+                // 文件系统接受了 O_DIRECT 打开但不支持对齐写：退回普通写
+                int flags = fcntl(file.fd, F_GETFL);
+                if (flags >= 0 && fcntl(file.fd, F_SETFL, flags & ~O_DIRECT) == 0) {
+                    std::cerr << "[" << m_name << "] O_DIRECT write rejected for " << file.path
+                              << ", using buffered writes" << std::endl;
+                    file.direct = false;
+                    continue;
+                }
+            }
+            if (!file.errorLogged) {
+                std::cerr << "[" << m_name << "] Write to " << file.path << " failed: " << strerror(errno) << std::endl;
+                file.errorLogged = true;
+            }
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.writeErrors++;
+            return false;
+        }
+
+        offset += static_cast<uint64_t>(n);
+        total += static_cast<uint64_t>(n);
+        size_t done = static_cast<size_t>(n);
+        while (index < rest.size() && done >= rest[index].iov_len) {
+            done -= rest[index].iov_len;
+            index++;
+        }
+        if (index < rest.size()) {
+            rest[index].iov_base = static_cast<uint8_t*>(rest[index].iov_base) + done;
+            rest[index].iov_len -= done;
+        }
+    }
+
+    if (!file.direct && total > 0) {
+        // 普通写：立即开始回写，避免脏页堆积后集中回写
+        sync_file_range(file.fd, static_cast<off_t>(offset - total), static_cast<off_t>(total),
+                        SYNC_FILE_RANGE_WRITE);
+    }
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.bytesWritten += total;
+    return true;
+}
+
+void DiskWriterSvc::recycle(Chunk* chunk) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeChunks.push_back(chunk);
+    }
+    m_chunkFreed.notify_all();
+}
+
+void DiskWriterSvc::recordLatency(uint64_t us) {
+    m_writeMetric->observe(us);
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.writeCalls++;
+    if (us > m_stats.latencyMaxUs) {
+        m_stats.latencyMaxUs = us;
+    }
+    uint32_t value = static_cast<uint32_t>(std::min<uint64_t>(us, UINT32_MAX));
+    if (m_latencies.size() < kLatencyWindow) {
+        m_latencies.push_back(value);
+    } else {
+        m_latencies[m_latencyNext] = value;
+    }
+    m_latencyNext = (m_latencyNext + 1) % kLatencyWindow;
+}
+
+void DiskWriterSvc::collectMetrics(MetricsWriter& writer) {
+    Stats current = stats();
+    MetricLabels labels = metricLabels();
+    writer.counter("media_disk_bytes_accepted_total", "Bytes accepted from writers", labels,
+                   current.bytesAccepted);
+    writer.counter("media_disk_bytes_written_total", "Bytes written to files including alignment padding",
+                   labels, current.bytesWritten);
+    writer.counter("media_disk_dropped_writes_total", "Writes dropped because the buffer was full", labels,
+                   current.droppedWrites);
+    writer.counter("media_disk_dropped_bytes_total", "Bytes dropped because the buffer was full", labels,
+                   current.droppedBytes);
+    writer.counter("media_disk_write_errors_total", "Failed write system calls", labels, current.writeErrors);
+    writer.gauge("media_disk_buffered_bytes", "Write buffer currently in use", labels,
+                 static_cast<double>(current.bufferedBytes));
+}
+
+DiskWriterSvc::Stats DiskWriterSvc::stats() const {
+    Stats result;
+    std::vector<uint32_t> latencies;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        result = m_stats;
+        latencies = m_latencies;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        result.bufferedBytes = (m_chunks.size() - m_freeChunks.size()) * m_chunkBytes;
+    }
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        size_t last = latencies.size() - 1;
+        result.latencyP50Us = latencies[last * 50 / 100];
+        result.latencyP95Us = latencies[last * 95 / 100];
+        result.latencyP99Us = latencies[last * 99 / 100];
+    }
+    return result;
+}
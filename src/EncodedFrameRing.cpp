@@ -0,0 +1,151 @@
+#include "EncodedFrameRing.h"
+
+EncodedFrameRing::EncodedFrameRing(size_t byteBudget, std::shared_ptr<PacketBufferPool> pool)
+    : m_byteBudget(byteBudget),
+      m_pool(pool ? pool : PacketBufferPool::shared()) {
+}
+
+void EncodedFrameRing::push(const EncodedFrame& frame) {
+    if (frame.size == 0 || !frame.data) {
+        return;
+    }
+
+    // 预算检查与等待关键帧不需要拷贝，先在锁内判断
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (frame.size > m_byteBudget) {
+            // 单帧超出预算：放弃这一帧，后续帧依赖它，直到下一个关键帧
+            m_dropped++;
+            m_waitKeyFrame = true;
+            return;
+        }
+        if (m_waitKeyFrame && !frame.isKeyFrame) {
+            m_dropped++;
+            return;
+        }
+    }
+
+    // 零拷贝帧在锁外拷贝，不阻塞 extract()
+    EncodedFrame stored = frame.zeroCopy ? copyEncodedFrame(frame, *m_pool) : frame;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (stored.size == 0) {
+        m_dropped++;
+        m_waitKeyFrame = true;
+        return;
+    }
+
+    while (!m_frames.empty() && m_bytes + stored.size > m_byteBudget) {
+        evictFront();
+    }
+    if (m_waitKeyFrame && !stored.isKeyFrame) {
+        // 淘汰掉了当前 GOP 的关键帧
+        m_dropped++;
+        return;
+    }
+
+    if (stored.isKeyFrame) {
+        m_keyFrames.push_back(m_headSeq + m_frames.size());
+        m_waitKeyFrame = false;
+    }
+    m_bytes += stored.size;
+    m_frames.push_back(stored);
+    m_pushed++;
+}
+
+void EncodedFrameRing::evictFront() {
+    bool wasKey = !m_keyFrames.empty() && m_keyFrames.front() == m_headSeq;
+
+    m_bytes -= m_frames.front().size;
+    m_frames.pop_front();
+    m_headSeq++;
+    m_evicted++;
+
+    if (!wasKey) {
+        return;
+    }
+
+    // 关键帧被淘汰后，同一 GOP 剩余的帧无法解码，淘汰到下一个关键帧
+    m_keyFrames.pop_front();
+    uint64_t nextKey = m_keyFrames.empty() ? m_headSeq + m_frames.size() : m_keyFrames.front();
+    while (m_headSeq < nextKey) {
+        m_bytes -= m_frames.front().size;
+        m_frames.pop_front();
+        m_headSeq++;
+        m_evicted++;
+    }
+    if (m_frames.empty()) {
+        // 缓冲里只剩下这一个 GOP（当前 GOP 还在继续），新帧要等下一个关键帧
+        m_waitKeyFrame = true;
+    }
+}
+
+uint64_t EncodedFrameRing::findKeyFrame(uint64_t timestamp) const {
+    // 关键帧时间戳递增：二分查找最后一个 <= timestamp 的关键帧
+    size_t lo = 0;
+    size_t hi = m_keyFrames.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (m_frames[m_keyFrames[mid] - m_headSeq].timestamp <= timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return m_keyFrames[lo > 0 ? lo - 1 : 0];
+}
+
+size_t EncodedFrameRing::extract(uint64_t fromTimestamp, uint64_t toTimestamp,
+                                 std::vector<EncodedFrame>& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_keyFrames.empty()) {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (size_t i = findKeyFrame(fromTimestamp) - m_headSeq; i < m_frames.size(); i++) {
+        if (m_frames[i].timestamp > toTimestamp) {
+            break;
+        }
+        out.push_back(m_frames[i]);
+        count++;
+    }
+    return count;
+}
+
+size_t EncodedFrameRing::extractLast(uint64_t durationUs, std::vector<EncodedFrame>& out) const {
+    uint64_t newest;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_frames.empty()) {
+            return 0;
+        }
+        newest = m_frames.back().timestamp;
+    }
+    uint64_t from = newest > durationUs ? newest - durationUs : 0;
+    return extract(from, UINT64_MAX, out);
+}
+
+void EncodedFrameRing::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_headSeq += m_frames.size();
+    m_frames.clear();
+    m_keyFrames.clear();
+    m_bytes = 0;
+    m_waitKeyFrame = true;
+}
+
+EncodedFrameRing::Stats EncodedFrameRing::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s;
+    s.frames = m_frames.size();
+    s.keyFrames = m_keyFrames.size();
+    s.bytes = m_bytes;
+    s.byteBudget = m_byteBudget;
+    s.oldestTimestamp = m_frames.empty() ? 0 : m_frames.front().timestamp;
+    s.newestTimestamp = m_frames.empty() ? 0 : m_frames.back().timestamp;
+    s.pushed = m_pushed;
+    s.evicted = m_evicted;
+    s.dropped = m_dropped;
+    return s;
+}
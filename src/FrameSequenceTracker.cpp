@@ -0,0 +1,201 @@
+#include "FrameSequenceTracker.h"
+#include <algorithm>
+
+FrameSequenceTracker::FrameSequenceTracker(const std::string& stage, const FrameSequenceConfig& config)
+    : m_stage(stage), m_config(config) {
+}
+
+void FrameSequenceTracker::setConfig(const FrameSequenceConfig& config) {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_config = config;
+    m_resetPending.store(true);
+}
+
+FrameSequenceConfig FrameSequenceTracker::config() const {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    return m_config;
+}
+
+void FrameSequenceTracker::setAlertCallback(AlertCallback callback) {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_callback = std::move(callback);
+}
+
+void FrameSequenceTracker::resetSequence() {
+    m_resetPending.store(true);
+}
+
+void FrameSequenceTracker::observe(uint64_t pts, uint64_t nowUs, uint32_t seq, bool hasSeq) {
+    if (m_resetPending.exchange(false)) {
+        {
+            std::lock_guard<std::mutex> lock(m_configMutex);
+            m_active = m_config;
+        }
+        m_intervalUs = m_active.fps > 0 ? static_cast<uint64_t>(1000000.0 / m_active.fps) : 0;
+        m_learnedUs = 0;
+        m_learnCount = 0;
+        m_havePrev = false;
+        m_stallDropped = 0;
+        m_windowStart = nowUs;
+        m_windowFrames = 0;
+        m_windowDropped = 0;
+        m_currentIntervalUs.store(m_intervalUs, std::memory_order_relaxed);
+    }
+
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_windowFrames++;
+
+    if (m_havePrev) {
+        if (pts <= m_prevPts || (hasSeq && m_prevHasSeq && seq == m_prevSeq)) {
+            // 重复或乱序：不作为下一帧的基准
+            m_duplicated.fetch_add(1, std::memory_order_relaxed);
+            if (nowUs - m_windowStart >= m_active.windowMs * 1000ull) {
+                closeWindow(nowUs);
+            }
+            return;
+        }
+
+        uint64_t gap = pts - m_prevPts;
+        if (gap > m_maxGapUs.load(std::memory_order_relaxed)) {
+            m_maxGapUs.store(gap, std::memory_order_relaxed);
+        }
+        if (m_intervalUs == 0) {
+            m_learnedUs = m_learnCount ? std::min(m_learnedUs, gap) : gap;
+            if (++m_learnCount >= kLearnFrames) {
+                m_intervalUs = m_learnedUs;
+                m_currentIntervalUs.store(m_intervalUs, std::memory_order_relaxed);
+            }
+        }
+
+        // 间隔超过 1.5 倍才算丢帧，容忍采集时间戳抖动
+        uint64_t missed = 0;
+        if (m_intervalUs > 0 && gap * 2 > m_intervalUs * 3) {
+            missed = (gap + m_intervalUs / 2) / m_intervalUs - 1;
+        }
+        if (hasSeq && m_prevHasSeq && m_active.seqStep > 0) {
+            uint32_t delta = seq - m_prevSeq;
+            if (delta < 0x80000000u) {  // 序号回退（通道重建）时不计
+                uint64_t steps = delta / m_active.seqStep;
+                missed = std::max<uint64_t>(missed, steps > 0 ? steps - 1 : 0);
+            }
+        }
+        if (m_stallDropped > 0) {
+            // 停顿期间已计入的部分不重复计；实际丢得更少（帧只是迟到）时扣回多计的
+            if (missed >= m_stallDropped) {
+                missed -= m_stallDropped;
+            } else {
+                m_dropped.fetch_sub(m_stallDropped - missed, std::memory_order_relaxed);
+                missed = 0;
+            }
+            m_stallDropped = 0;
+        }
+        if (missed > 0) {
+            m_dropped.fetch_add(missed, std::memory_order_relaxed);
+            m_windowDropped += missed;
+        }
+    }
+
+    if (m_intervalUs > 0 && pts > 0 && nowUs > pts &&
+        static_cast<double>(nowUs - pts) > m_active.lateIntervals * m_intervalUs) {
+        m_late.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    m_havePrev = true;
+    m_prevPts = pts;
+    m_prevArrivalUs = nowUs;
+    m_prevSeq = seq;
+    m_prevHasSeq = hasSeq;
+
+    if (nowUs - m_windowStart >= m_active.windowMs * 1000ull) {
+        closeWindow(nowUs);
+    }
+}
+
+void FrameSequenceTracker::noteTimeout(uint64_t nowUs) {
+    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+    checkStall(nowUs);
+}
+
+void FrameSequenceTracker::checkStall(uint64_t nowUs) {
+    // 尚未开始检查、等待重置（停止/重建期间）或帧间隔未知时不判断停顿
+    if (m_resetPending.load() || !m_havePrev || m_intervalUs == 0) {
+        return;
+    }
+    if (nowUs - m_windowStart < m_active.windowMs * 1000ull) {
+        return;
+    }
+
+    // 与按 PTS 间隔计算一致：超过 1.5 倍间隔才算丢帧
+    uint64_t silent = nowUs > m_prevArrivalUs ? nowUs - m_prevArrivalUs : 0;
+    uint64_t missed = silent * 2 > m_intervalUs * 3 ? silent / m_intervalUs : 0;
+    if (missed > m_stallDropped) {
+        m_dropped.fetch_add(missed - m_stallDropped, std::memory_order_relaxed);
+        m_windowDropped += missed - m_stallDropped;
+        m_stallDropped = missed;
+    }
+    closeWindow(nowUs);
+}
+
+int FrameSequenceTracker::stallCheckMs(uint64_t nowUs, int maxMs) const {
+    if (m_resetPending.load() || !m_havePrev || m_intervalUs == 0) {
+        return maxMs;
+    }
+    uint64_t end = m_windowStart + m_active.windowMs * 1000ull;
+    if (nowUs >= end) {
+        return 0;
+    }
+    uint64_t remainingMs = (end - nowUs + 999) / 1000;
+    return remainingMs < static_cast<uint64_t>(maxMs) ? static_cast<int>(remainingMs) : maxMs;
+}
+
+void FrameSequenceTracker::closeWindow(uint64_t nowUs) {
+    uint64_t expected = m_windowFrames + m_windowDropped;
+    double rate = expected ? static_cast<double>(m_windowDropped) / expected : 0.0;
+    m_windowRatePpm.store(static_cast<uint32_t>(rate * 1e6), std::memory_order_relaxed);
+
+    FrameDropAlert alert;
+    alert.stage = m_stage;
+    alert.dropRate = rate;
+    alert.windowFrames = m_windowFrames;
+    alert.windowDropped = m_windowDropped;
+    bool fire = false;
+    if (!m_alerting && m_windowDropped > 0 && rate >= m_active.dropRateThreshold) {
+        m_alerting = true;
+        alert.active = true;
+        fire = true;
+        m_alerts.fetch_add(1, std::memory_order_relaxed);
+    } else if (m_alerting && rate < m_active.dropRateThreshold / 2) {
+        m_alerting = false;
+        alert.active = false;
+        fire = true;
+    }
+
+    m_windowStart = nowUs;
+    m_windowFrames = 0;
+    m_windowDropped = 0;
+
+    if (fire) {
+        AlertCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_configMutex);
+            callback = m_callback;
+        }
+        if (callback) {
+            callback(alert);
+        }
+    }
+}
+
+FrameSequenceTracker::Stats FrameSequenceTracker::stats() const {
+    Stats s;
+    s.frames = m_frames.load(std::memory_order_relaxed);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.duplicated = m_duplicated.load(std::memory_order_relaxed);
+    s.late = m_late.load(std::memory_order_relaxed);
+    s.timeouts = m_timeouts.load(std::memory_order_relaxed);
+    s.alerts = m_alerts.load(std::memory_order_relaxed);
+    s.maxGapUs = m_maxGapUs.load(std::memory_order_relaxed);
+    s.intervalUs = m_currentIntervalUs.load(std::memory_order_relaxed);
+    s.windowDropRate = m_windowRatePpm.load(std::memory_order_relaxed) / 1e6;
+    return s;
+}
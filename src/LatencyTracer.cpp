@@ -0,0 +1,385 @@
+#include "LatencyTracer.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+// PTS 晚于当前时间超过该值视为无效（时钟不一致或未填写）
+const uint64_t kMaxFutureUs = 1000000;
+
+void appendEscaped(std::string& out, const std::string& text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+}
+
+void appendSeparator(std::string& json) {
+    if (json[json.size() - 1] != '[') {
+        json += ",\n";
+    }
+}
+
+void appendMetadata(std::string& json, int pid, int tid, const char* kind, const std::string& name) {
+    appendSeparator(json);
+    char buf[96];
+    snprintf(buf, sizeof(buf), "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"%s\",\"args\":{\"name\":\"",
+             pid, tid, kind);
+    json += buf;
+    appendEscaped(json, name);
+    json += "\"}}";
+}
+
+}  // namespace
+
+// ==================== LatencyHistogram ====================
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (size_t i = 0; i < kBucketCount; i++) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(UINT64_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t us) {
+    if (us < kSubBuckets) {
+        return static_cast<size_t>(us);
+    }
+    // 最高位在 msb：区间 [2^msb, 2^(msb+1)) 右移 shift 后落在 [64, 128)
+    int msb = 63 - __builtin_clzll(us);
+    int shift = msb - (kSubBucketBits - 1);
+    if (shift > kMaxShift) {
+        return kBucketCount - 1;
+    }
+    return static_cast<size_t>(kSubBuckets + (shift - 1) * kHalfSubBuckets +
+                               ((us >> shift) - kHalfSubBuckets));
+}
+
+uint64_t LatencyHistogram::bucketValue(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int shift = static_cast<int>((index - kSubBuckets) / kHalfSubBuckets) + 1;
+    uint64_t sub = (index - kSubBuckets) % kHalfSubBuckets + kHalfSubBuckets;
+    return (sub << shift) + ((1ull << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    m_buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t cur = m_min.load(std::memory_order_relaxed);
+    while (us < cur && !m_min.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {
+    }
+    cur = m_max.load(std::memory_order_relaxed);
+    while (us > cur && !m_max.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::min() const {
+    uint64_t v = m_min.load(std::memory_order_relaxed);
+    return v == UINT64_MAX ? 0 : v;
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(q * total + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            // 桶代表值不超出实际记录的范围
+            uint64_t v = bucketValue(i);
+            uint64_t lo = min();
+            uint64_t hi = max();
+            return v < lo ? lo : (v > hi ? hi : v);
+        }
+    }
+    return max();
+}
+
+// ==================== LatencyTracer ====================
+
+LatencyTracer::LatencyTracer(const std::string& name, size_t traceEvents)
+    : m_name(name), m_events(traceEvents) {
+}
+
+uint64_t LatencyTracer::nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000ULL;
+}
+
+const char* LatencyTracer::stageName(Stage stage) {
+    switch (stage) {
+    case kStageVpssOutput: return "vpss-output";
+    case kStageYuvDelivery: return "yuv-delivery";
+    case kStageVencOutput: return "venc-output";
+    case kStageVencDelivery: return "venc-delivery";
+    default: return "unknown";
+    }
+}
+
+bool LatencyTracer::validAge(uint64_t pts, uint64_t now, uint64_t& age) {
+    if (pts == 0 || pts > now + kMaxFutureUs) {
+        m_invalid.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    age = now > pts ? now - pts : 0;
+    return true;
+}
+
+void LatencyTracer::recordStage(Stage stage, uint64_t pts, uint64_t now) {
+    uint64_t age;
+    if (stage < 0 || stage >= kStageCount || !validAge(pts, now, age)) {
+        return;
+    }
+    m_stages[stage].record(age);
+
+    TraceEvent event = { pts, now, 0, static_cast<int32_t>(stage) };
+    pushEvent(event);
+}
+
+void LatencyTracer::recordCallback(Path path, const std::string& consumer, uint64_t pts,
+                                   uint64_t startUs, uint64_t endUs) {
+    uint64_t age;
+    if (!validAge(pts, endUs, age)) {
+        return;
+    }
+    uint64_t duration = endUs > startUs ? endUs - startUs : 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int index = findConsumer(path, consumer);
+    if (index < 0) {
+        return;
+    }
+    Consumer& c = *m_consumers[index];
+    c.age.record(age);
+    c.duration.record(duration);
+
+    TraceEvent event = { pts, startUs,
+                         duration > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(duration),
+                         kStageCount + index };
+    pushEventLocked(event);
+}
+
+int LatencyTracer::findConsumer(Path path, const std::string& name) {
+    for (size_t i = 0; i < m_consumers.size(); i++) {
+        if (m_consumers[i]->path == path && m_consumers[i]->name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    if (m_consumers.size() >= static_cast<size_t>(kMaxConsumers)) {
+        return -1;
+    }
+    std::unique_ptr<Consumer> c(new Consumer);
+    c->path = path;
+    c->name = name;
+    c->label = std::string(path == kPathYuv ? "yuv/" : "venc/") + name;
+    m_consumers.push_back(std::move(c));
+    return static_cast<int>(m_consumers.size() - 1);
+}
+
+void LatencyTracer::pushEvent(const TraceEvent& event) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    pushEventLocked(event);
+}
+
+void LatencyTracer::pushEventLocked(const TraceEvent& event) {
+    if (m_events.empty()) {
+        return;
+    }
+    m_events[m_eventNext] = event;
+    m_eventNext = (m_eventNext + 1) % m_events.size();
+    if (m_eventCount < m_events.size()) {
+        m_eventCount++;
+    }
+}
+
+LatencyTracer::Summary LatencyTracer::makeSummary(const std::string& name, const LatencyHistogram& age) {
+    Summary s;
+    s.name = name;
+    s.count = age.count();
+    s.minUs = age.min();
+    s.p50Us = age.percentile(0.50);
+    s.p90Us = age.percentile(0.90);
+    s.p99Us = age.percentile(0.99);
+    s.maxUs = age.max();
+    s.meanUs = age.mean();
+    s.callbackP99Us = 0;
+    s.callbackMaxUs = 0;
+    return s;
+}
+
+LatencyTracer::Summary LatencyTracer::summary(Stage stage) const {
+    if (stage < 0 || stage >= kStageCount) {
+        return makeSummary(stageName(stage), LatencyHistogram());
+    }
+    return makeSummary(stageName(stage), m_stages[stage]);
+}
+
+std::vector<LatencyTracer::Summary> LatencyTracer::summaries() const {
+    std::vector<Summary> result;
+    for (int i = 0; i < kStageCount; i++) {
+        result.push_back(summary(static_cast<Stage>(i)));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_consumers.size(); i++) {
+        const Consumer& c = *m_consumers[i];
+        Summary s = makeSummary(c.label, c.age);
+        s.callbackP99Us = c.duration.percentile(0.99);
+        s.callbackMaxUs = c.duration.max();
+        result.push_back(s);
+    }
+    return result;
+}
+
+void LatencyTracer::reset() {
+    for (int i = 0; i < kStageCount; i++) {
+        m_stages[i].reset();
+    }
+    m_invalid.store(0);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_consumers.size(); i++) {
+        m_consumers[i]->age.reset();
+        m_consumers[i]->duration.reset();
+    }
+    m_eventNext = 0;
+    m_eventCount = 0;
+}
+
+void LatencyTracer::appendEvents(std::string& json, int pid) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 线程 1/2 为 YUV/VENC 通路的逐帧异步区间，回调从 10 开始每个订阅者一行
+    appendMetadata(json, pid, 0, "process_name", m_name);
+    appendMetadata(json, pid, 1, "thread_name", "yuv frames");
+    appendMetadata(json, pid, 2, "thread_name", "venc frames");
+    for (size_t i = 0; i < m_consumers.size(); i++) {
+        appendMetadata(json, pid, 10 + static_cast<int>(i), "thread_name", m_consumers[i]->label);
+    }
+
+    char buf[256];
+    size_t first = m_eventCount ? (m_eventNext + m_events.size() - m_eventCount) % m_events.size() : 0;
+    for (size_t n = 0; n < m_eventCount; n++) {
+        const TraceEvent& e = m_events[(first + n) % m_events.size()];
+        if (e.track < kStageCount) {
+            // 采集 → 阶段：同一帧的各阶段共用 id（PTS），在异步轨道上嵌套显示
+            Stage stage = static_cast<Stage>(e.track);
+            bool yuv = stage == kStageVpssOutput || stage == kStageYuvDelivery;
+            const char* cat = yuv ? "yuv" : "venc";
+            int tid = yuv ? 1 : 2;
+            appendSeparator(json);
+            snprintf(buf, sizeof(buf),
+                     "{\"ph\":\"b\",\"cat\":\"%s\",\"name\":\"capture->%s\",\"id\":\"0x%llx\","
+                     "\"pid\":%d,\"tid\":%d,\"ts\":%llu}",
+                     cat, stageName(stage), static_cast<unsigned long long>(e.pts), pid, tid,
+                     static_cast<unsigned long long>(e.pts));
+            json += buf;
+            json += ",\n";
+            snprintf(buf, sizeof(buf),
+                     "{\"ph\":\"e\",\"cat\":\"%s\",\"name\":\"capture->%s\",\"id\":\"0x%llx\","
+                     "\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"args\":{\"age_us\":%llu}}",
+                     cat, stageName(stage), static_cast<unsigned long long>(e.pts), pid, tid,
+                     static_cast<unsigned long long>(e.ts),
+                     static_cast<unsigned long long>(e.ts - e.pts));
+            json += buf;
+        } else {
+            size_t index = static_cast<size_t>(e.track - kStageCount);
+            if (index >= m_consumers.size()) {
+                continue;
+            }
+            const Consumer& c = *m_consumers[index];
+            appendSeparator(json);
+            json += "{\"ph\":\"X\",\"cat\":\"";
+            json += c.path == kPathYuv ? "yuv" : "venc";
+            json += "\",\"name\":\"";
+            appendEscaped(json, c.name);
+            snprintf(buf, sizeof(buf),
+                     "\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"dur\":%u,"
+                     "\"args\":{\"pts\":%llu,\"age_us\":%llu}}",
+                     pid, 10 + static_cast<int>(index), static_cast<unsigned long long>(e.ts), e.dur,
+                     static_cast<unsigned long long>(e.pts),
+                     static_cast<unsigned long long>(e.ts + e.dur - e.pts));
+            json += buf;
+        }
+    }
+}
+
+bool LatencyTracer::exportChromeTrace(const std::string& path) const {
+    std::vector<const LatencyTracer*> tracers(1, this);
+    return exportChromeTrace(path, tracers);
+}
+
+bool LatencyTracer::exportChromeTrace(const std::string& path,
+                                      const std::vector<const LatencyTracer*>& tracers) {
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < tracers.size(); i++) {
+        if (tracers[i]) {
+            tracers[i]->appendEvents(json, static_cast<int>(i) + 1);
+        }
+    }
+    json += "\n]}\n";
+
+    // 写临时文件后 rename，不会留下半个文件
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[LatencyTracer] Failed to open " << tmpPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    size_t done = 0;
+    while (done < json.size()) {
+        ssize_t n = write(fd, json.data() + done, json.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    if (done != json.size() || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "[LatencyTracer] Failed to write " << path << std::endl;
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
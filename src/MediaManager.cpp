@@ -1,1012 +1,557 @@
 #include "MediaManager.h"
 #include <iostream>
 #include <cstring>
+#include <strings.h>
 
 // MPP 头文件
-#include "rk_mpi_vi.h"
-#include "rk_mpi_vpss.h"
-#include "rk_mpi_venc.h"
-#include "rk_mpi_vo.h"
 #include "rk_mpi_sys.h"
-#include "rk_comm_vi.h"
+#include "rk_mpi_vo.h"
 #include "rk_comm_vpss.h"
 #include "rk_comm_venc.h"
 #include "rk_comm_vo.h"
 #include "rk_common.h"
 
-MediaManager::MediaManager()
-    : m_viDevId(0),
-      m_viPipeId(0),
-      m_viChnId(0),
-      m_vpssGrpId(0),
-      m_vpssChnEnc(0),
-      m_vpssChnVo(1),
-      m_vpssChnYuv(2),
-      m_vencChnId(0),
-      m_voDevId(0),
-      m_voLayerId(0),
-      m_voChnId(0) {
-}
-
-MediaManager::~MediaManager() {
-    deinit();
+namespace {
+
+// MPI 系统引用计数（进程内所有 MediaManager 共享）
+std::mutex g_systemMutex;
+int g_systemRefCount = 0;
+
+/**
+ * @brief 在 [0, maxId) 中找最小的未占用 ID，没有时返回 -1
+ */
+int findFreeId(const std::vector<int>& used, int maxId) {
+    for (int id = 0; id < maxId; id++) {
+        bool taken = false;
+        for (size_t i = 0; i < used.size(); i++) {
+            if (used[i] == id) {
+                taken = true;
+                break;
+            }
+        }
+        if (!taken) {
+            return id;
+        }
+    }
+    return -1;
 }
 
-bool MediaManager::init(int viDevId, int viPipeId, int viChnId, const std::string& entityName) {
-    if (m_initialized) {
-        std::cerr << "[MediaManager] Already initialized" << std::endl;
+/**
+ * @brief 分配或检查一个 ID
+ * @param id    输入 -1 表示自动分配，输出为最终 ID
+ * @param used  已被其他流水线占用的 ID
+ */
+bool assignId(int& id, const std::vector<int>& used, int maxId, const char* name) {
+    if (id < 0) {
+        id = findFreeId(used, maxId);
+        if (id < 0) {
+            std::cerr << "[MediaManager] No free " << name << " (max " << maxId << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (id >= maxId) {
+        std::cerr << "[MediaManager] " << name << " " << id << " out of range (max "
+                  << maxId << ")" << std::endl;
         return false;
     }
-
-    // 保存 VI 参数
-    m_viDevId = viDevId;
-    m_viPipeId = viPipeId;
-    m_viChnId = viChnId;
-    m_entityName = entityName;
-
-    // 创建服务实例（但不启动，等待单独启动）
-    m_encoderSvc = std::make_shared<VideoEncoderSvc>();
-    m_outputSvc = std::make_shared<VideoOutputSvc>();
-    m_yuvSvc = std::make_shared<YUVOutputSvc>();
-
-    // 设置服务的 MPP 参数（让服务知道从哪里获取数据）
-    m_encoderSvc->setMPPParams(m_vencChnId);  // 从 VENC 获取编码流
-    m_outputSvc->setMPPParams(m_voDevId, m_voLayerId, m_voChnId);  // 绑定到 VO，自动显示
-    m_yuvSvc->setMPPParams(m_vpssGrpId, m_vpssChnYuv);  // 从 VPSS 获取 YUV 数据
-
-    // 注意：不在这里初始化VI和绑定，等待第一个服务启动时再初始化
-
-    std::cout << "[MediaManager] Services created (not started yet)" << std::endl;
-
-    m_initialized = true;
+    for (size_t i = 0; i < used.size(); i++) {
+        if (used[i] == id) {
+            std::cerr << "[MediaManager] " << name << " " << id
+                      << " is already used by another pipeline" << std::endl;
+            return false;
+        }
+    }
     return true;
 }
 
-void MediaManager::deinit() {
-    if (!m_initialized) {
-        return;
+}  // namespace
+
+/**
+ * @brief VO 接口名称转换为 VO_INTF_*
+ */
+static bool toVoIntfType(const std::string& name, VO_INTF_TYPE_E& type) {
+    if (name == "hdmi") {
+        type = VO_INTF_HDMI;
+    } else if (name == "edp") {
+        type = VO_INTF_EDP;
+    } else if (name == "dp") {
+        type = VO_INTF_DP;
+    } else if (name == "mipi") {
+        type = VO_INTF_MIPI;
+    } else if (name == "lcd") {
+        type = VO_INTF_LCD;
+    } else {
+        return false;
     }
-
-    // stop() 会自动处理引用计数和清理
-    stop();
-
-    // 清理服务实例
-    m_encoderSvc.reset();
-    m_outputSvc.reset();
-    m_yuvSvc.reset();
-
-    m_initialized = false;
-    std::cout << "[MediaManager] Services destroyed" << std::endl;
+    return true;
 }
 
-void MediaManager::start() {
-    if (!m_initialized) {
-        std::cerr << "[MediaManager] Not initialized" << std::endl;
-        return;
+/**
+ * @brief VO 时序名称转换为 VO_OUTPUT_*，同时给出输出分辨率
+ */
+static bool toVoIntfSync(const std::string& name, VO_INTF_SYNC_E& sync,
+                         uint32_t& width, uint32_t& height) {
+    struct SyncEntry {
+        const char* name;
+        VO_INTF_SYNC_E sync;
+        uint32_t width;
+        uint32_t height;
+    };
+    static const SyncEntry kSyncTable[] = {
+        { "720P50",  VO_OUTPUT_720P50,        1280, 720 },
+        { "720P60",  VO_OUTPUT_720P60,        1280, 720 },
+        { "1080P24", VO_OUTPUT_1080P24,       1920, 1080 },
+        { "1080P25", VO_OUTPUT_1080P25,       1920, 1080 },
+        { "1080P30", VO_OUTPUT_1080P30,       1920, 1080 },
+        { "1080P50", VO_OUTPUT_1080P50,       1920, 1080 },
+        { "1080P60", VO_OUTPUT_1080P60,       1920, 1080 },
+        { "4K24",    VO_OUTPUT_3840x2160_24,  3840, 2160 },
+        { "4K25",    VO_OUTPUT_3840x2160_25,  3840, 2160 },
+        { "4K30",    VO_OUTPUT_3840x2160_30,  3840, 2160 },
+        { "4K50",    VO_OUTPUT_3840x2160_50,  3840, 2160 },
+        { "4K60",    VO_OUTPUT_3840x2160_60,  3840, 2160 },
+    };
+    for (size_t i = 0; i < sizeof(kSyncTable) / sizeof(kSyncTable[0]); i++) {
+        if (strcasecmp(name.c_str(), kSyncTable[i].name) == 0) {
+            sync = kSyncTable[i].sync;
+            width = kSyncTable[i].width;
+            height = kSyncTable[i].height;
+            return true;
+        }
     }
+    return false;
+}
 
-    // 启动所有服务
-    startEncoderService();
-    startOutputService();
-    startYUVService();
-
-    std::cout << "[MediaManager] All services started" << std::endl;
+/**
+ * @brief 两路流水线能否共用同一个 VO 图层
+ */
+static bool sameVoLayerSetup(const VoConfig& a, const VoConfig& b) {
+    return a.devId == b.devId && a.intf == b.intf && strcasecmp(a.sync.c_str(), b.sync.c_str()) == 0 &&
+           a.rectX == b.rectX && a.rectY == b.rectY &&
+           a.rectWidth == b.rectWidth && a.rectHeight == b.rectHeight;
 }
 
-void MediaManager::startEncoderService() {
-    if (m_encoderRunning) {
-        std::cout << "[MediaManager] Encoder service already running" << std::endl;
-        return;
-    }
+MediaManager::MediaManager() {
+}
 
-    // 第一个服务启动时，会在 incrementServiceRef 中初始化 VI/VPSS 并完成 VI→VPSS 绑定
-    incrementServiceRef();
+MediaManager::~MediaManager() {
+    deinit();
+}
 
-    // 如果 VI/VPSS 初始化失败，则不继续启动编码服务
-    if (!m_viInitialized || !m_vpssInitialized) {
-        std::cerr << "[MediaManager] startEncoderService: VI/VPSS not initialized, abort" << std::endl;
-        return;
+bool MediaManager::acquireSystem() {
+    std::lock_guard<std::mutex> lock(g_systemMutex);
+    if (g_systemRefCount == 0) {
+        RK_S32 s32Ret = RK_MPI_SYS_Init();
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << "[MediaManager] RK_MPI_SYS_Init failed: " << s32Ret << std::endl;
+            return false;
+        }
+        std::cout << "[MediaManager] MPI system initialized" << std::endl;
     }
+    g_systemRefCount++;
+    return true;
+}
 
-    // 初始化 VENC 并绑定 VPSS_CHN0 → VENC
-    std::cout << "[MediaManager] startEncoderService: initializeVENC() begin" << std::endl;
-    if (!initializeVENC()) {
-        std::cerr << "[MediaManager] startEncoderService: initializeVENC() failed" << std::endl;
-        decrementServiceRef();
-        return;
+void MediaManager::releaseSystem() {
+    std::lock_guard<std::mutex> lock(g_systemMutex);
+    if (g_systemRefCount > 0 && --g_systemRefCount == 0) {
+        RK_MPI_SYS_Exit();
+        std::cout << "[MediaManager] MPI system exited" << std::endl;
     }
-    std::cout << "[MediaManager] startEncoderService: initializeVENC() ok" << std::endl;
-
-    MPP_CHN_S stSrcChn, stDestChn;
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN0;
-
-    stDestChn.enModId = RK_ID_VENC;
-    stDestChn.s32DevId = 0;
-    stDestChn.s32ChnId = m_vencChnId;
+}
 
-    RK_S32 s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-    std::cout << "[MediaManager] startEncoderService: Bind VPSS_CHN0 -> VENC ret=" << s32Ret << std::endl;
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VPSS_CHN0 to VENC: " << s32Ret << std::endl;
-        cleanupVENC();
-        decrementServiceRef();
-        return;
-    }
-    std::cout << "[MediaManager] VPSS_CHN0 → VENC bound (encoder service)" << std::endl;
-    m_encoderRunning = true;
-    m_encoderSvc->start();
-    std::cout << "[MediaManager] Encoder service started" << std::endl;
+bool MediaManager::init(int viDevId, int viPipeId, int viChnId, const std::string& entityName) {
+    PipelineConfig config;
+    config.vi.devId = viDevId;
+    config.vi.pipeId = viPipeId;
+    config.vi.chnId = viChnId;
+    config.vi.entityName = entityName;
+    return init(config);
 }
 
-void MediaManager::startOutputService() {
-    if (m_outputRunning) {
-        std::cout << "[MediaManager] Output service already running" << std::endl;
-        return;
+bool MediaManager::init(const PipelineConfig& config) {
+    if (getPipelineCount() > 0) {
+        std::cerr << "[MediaManager] Already initialized" << std::endl;
+        return false;
     }
+    return addPipeline(config) >= 0;
+}
 
-    // 引用计数 +1（可能不是第一个服务）
-    incrementServiceRef();
-
-    // 如果 VI/VPSS 初始化失败，则不继续启动显示服务
-    if (!m_viInitialized || !m_vpssInitialized) {
-        std::cerr << "[MediaManager] startOutputService: VI/VPSS not initialized, abort" << std::endl;
-        return;
+int MediaManager::addPipeline(const PipelineConfig& config) {
+    // 在创建任何 MPI 资源前检查配置，错误尽早暴露
+    if (!validatePipelineConfig(config)) {
+        return -1;
     }
-
-    // 初始化 VO 并绑定 VPSS_CHN1 → VO
-    std::cout << "[MediaManager] startOutputService: initializeVO() begin" << std::endl;
-    if (!initializeVO()) {
-        std::cerr << "[MediaManager] startOutputService: initializeVO() failed" << std::endl;
-        decrementServiceRef();
-        return;
+    VO_INTF_TYPE_E intfType;
+    VO_INTF_SYNC_E intfSync;
+    uint32_t syncW, syncH;
+    if (!toVoIntfType(config.vo.intf, intfType) ||
+        !toVoIntfSync(config.vo.sync, intfSync, syncW, syncH)) {
+        std::cerr << "[MediaManager] Unsupported VO interface/sync: " << config.vo.intf
+                  << "/" << config.vo.sync << std::endl;
+        return -1;
     }
-    std::cout << "[MediaManager] startOutputService: initializeVO() ok" << std::endl;
 
-    MPP_CHN_S stSrcChn, stDestChn;
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN1;
+    std::lock_guard<std::mutex> lock(m_pipelinesMutex);
 
-    stDestChn.enModId = RK_ID_VO;
-    stDestChn.s32DevId = m_voLayerId;
-    stDestChn.s32ChnId = m_voChnId;
-
-    RK_S32 s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-    std::cout << "[MediaManager] startOutputService: Bind VPSS_CHN1 -> VO ret=" << s32Ret << std::endl;
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VPSS_CHN1 to VO: " << s32Ret << std::endl;
-        cleanupVO();
-        decrementServiceRef();
-        return;
+    PipelineConfig assigned = config;
+    if (!assignIds(assigned)) {
+        return -1;
     }
-    // 启用 VO 通道
-    s32Ret = RK_MPI_VO_EnableChn(m_voLayerId, m_voChnId);
-    std::cout << "[MediaManager] startOutputService: Enable VO chn ret=" << s32Ret << std::endl;
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to enable VO channel: " << s32Ret << std::endl;
-        RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-        cleanupVO();
-        decrementServiceRef();
-        return;
+
+    // 第一路流水线创建前初始化 MPI 系统，deinit() 时退出
+    if (!m_systemAcquired) {
+        if (!acquireSystem()) {
+            return -1;
+        }
+        m_systemAcquired = true;
     }
-    std::cout << "[MediaManager] VPSS_CHN1 → VO bound (output service)" << std::endl;
-    m_outputRunning = true;
-    m_outputSvc->start();
-    std::cout << "[MediaManager] Output service started" << std::endl;
-}
 
-void MediaManager::startYUVService() {
-    if (m_yuvRunning) {
-        std::cout << "[MediaManager] YUV service already running" << std::endl;
-        return;
+    int index = static_cast<int>(m_pipelines.size());
+    std::shared_ptr<MediaPipeline> pipeline = std::make_shared<MediaPipeline>(*this, index, assigned);
+    if (!pipeline->init()) {
+        return -1;
     }
+    m_pipelines.push_back(pipeline);
 
-    incrementServiceRef();
-    m_yuvRunning = true;
-    m_yuvSvc->start();
-    std::cout << "[MediaManager] YUV service started" << std::endl;
+    std::cout << "[MediaManager] Pipeline " << index << " added (VI " << assigned.vi.devId << "/"
+              << assigned.vi.pipeId << "/" << assigned.vi.chnId << ")" << std::endl;
+    return index;
 }
 
-void MediaManager::stopEncoderService() {
-    if (!m_encoderRunning) {
-        return;
-    }
+bool MediaManager::assignIds(PipelineConfig& config) {
+    std::vector<int> usedVpss;
+    std::vector<int> usedVenc;
+    std::vector<int> usedVoChn;  // 同一 VO 图层内
 
-    // 先停止服务线程
-    m_encoderSvc->stop();
-    m_encoderSvc->join();
-    m_encoderRunning = false;
+    for (size_t i = 0; i < m_pipelines.size(); i++) {
+        if (!m_pipelines[i]) {
+            continue;
+        }
+        const PipelineConfig& other = m_pipelines[i]->getConfig();
 
-    // 解绑 VPSS_CHN0 → VENC 并清理 VENC
-    MPP_CHN_S stSrcChn, stDestChn;
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN0;
+        if (other.vi.devId == config.vi.devId ||
+            (other.vi.pipeId == config.vi.pipeId && other.vi.chnId == config.vi.chnId)) {
+            std::cerr << "[MediaManager] VI " << config.vi.devId << "/" << config.vi.pipeId << "/"
+                      << config.vi.chnId << " conflicts with pipeline " << i << std::endl;
+            return false;
+        }
 
-    stDestChn.enModId = RK_ID_VENC;
-    stDestChn.s32DevId = 0;
-    stDestChn.s32ChnId = m_vencChnId;
+        if (other.vo.layerId == config.vo.layerId) {
+            if (!sameVoLayerSetup(other.vo, config.vo)) {
+                std::cerr << "[MediaManager] VO layer " << config.vo.layerId
+                          << " is shared with pipeline " << i
+                          << " but device/intf/sync/rect differ" << std::endl;
+                return false;
+            }
+            usedVoChn.push_back(other.vo.chnId);
+        }
 
-    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-    cleanupVENC();
+        usedVpss.push_back(other.vpssGrpId);
+        usedVenc.push_back(other.vencChnId);
+    }
 
-    decrementServiceRef();
-    std::cout << "[MediaManager] Encoder service stopped" << std::endl;
+    return assignId(config.vpssGrpId, usedVpss, VPSS_MAX_GRP_NUM, "VPSS group") &&
+           assignId(config.vencChnId, usedVenc, VENC_MAX_CHN_NUM, "VENC channel") &&
+           assignId(config.vo.chnId, usedVoChn, VO_MAX_CHN_NUM, "VO channel");
 }
 
-void MediaManager::stopOutputService() {
-    if (!m_outputRunning) {
-        return;
+bool MediaManager::removePipeline(int index) {
+    std::shared_ptr<MediaPipeline> pipeline;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelinesMutex);
+        if (index < 0 || index >= static_cast<int>(m_pipelines.size()) || !m_pipelines[index]) {
+            std::cerr << "[MediaManager] No pipeline " << index << std::endl;
+            return false;
+        }
+        pipeline.swap(m_pipelines[index]);
     }
 
-    // 先停止服务线程
-    m_outputSvc->stop();
-    m_outputSvc->join();
-    m_outputRunning = false;
-
-    // 解绑 VPSS_CHN1 → VO 并清理 VO
-    MPP_CHN_S stSrcChn, stDestChn;
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN1;
-
-    stDestChn.enModId = RK_ID_VO;
-    stDestChn.s32DevId = m_voLayerId;
-    stDestChn.s32ChnId = m_voChnId;
-
-    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-    RK_MPI_VO_DisableChn(m_voLayerId, m_voChnId);
-    cleanupVO();
-
-    decrementServiceRef();
-    std::cout << "[MediaManager] Output service stopped" << std::endl;
+    // 在锁外停止，避免阻塞其他流水线的查询
+    pipeline->deinit();
+    std::cout << "[MediaManager] Pipeline " << index << " removed" << std::endl;
+    return true;
 }
 
-void MediaManager::stopYUVService() {
-    if (!m_yuvRunning) {
-        return;
+std::shared_ptr<MediaPipeline> MediaManager::getPipeline(int index) {
+    std::lock_guard<std::mutex> lock(m_pipelinesMutex);
+    if (index < 0 || index >= static_cast<int>(m_pipelines.size())) {
+        return nullptr;
     }
+    return m_pipelines[index];
+}
 
-    m_yuvSvc->stop();
-    m_yuvSvc->join();
-    m_yuvRunning = false;
-    decrementServiceRef();
-    std::cout << "[MediaManager] YUV service stopped" << std::endl;
+int MediaManager::getPipelineCount() {
+    std::lock_guard<std::mutex> lock(m_pipelinesMutex);
+    return static_cast<int>(m_pipelines.size());
 }
 
-void MediaManager::stop() {
-    // 停止所有服务
-    if (m_encoderSvc) {
-        m_encoderSvc->stop();
-        m_encoderSvc->join();
-    }
+const PipelineConfig& MediaManager::getConfig() {
+    static const PipelineConfig kEmptyConfig;
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    return pipeline ? pipeline->getConfig() : kEmptyConfig;
+}
 
-    if (m_outputSvc) {
-        m_outputSvc->stop();
-        m_outputSvc->join();
+void MediaManager::deinit() {
+    std::vector<std::shared_ptr<MediaPipeline>> pipelines;
+    bool releaseSys;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelinesMutex);
+        pipelines.swap(m_pipelines);
+        releaseSys = m_systemAcquired;
+        m_systemAcquired = false;
+    }
+
+    // 先让所有流水线的服务线程并行退出，再逐路释放 MPI 资源
+    for (auto& pipeline : pipelines) {
+        if (pipeline) {
+            pipeline->stop();
+        }
     }
-
-    if (m_yuvSvc) {
-        m_yuvSvc->stop();
-        m_yuvSvc->join();
+    for (auto& pipeline : pipelines) {
+        if (pipeline) {
+            pipeline->deinit();
+        }
     }
+    pipelines.clear();
 
-    std::cout << "[MediaManager] All services stopped" << std::endl;
+    if (releaseSys) {
+        releaseSystem();
+        std::cout << "[MediaManager] Services destroyed" << std::endl;
+    }
 }
 
-bool MediaManager::setupBindings() {
-    RK_S32 s32Ret = RK_FAILURE;
-    MPP_CHN_S stSrcChn, stDestChn;
-
-    // ========== 1. 初始化 VPSS ==========
-    VPSS_GRP_ATTR_S stGrpAttr;
-    memset(&stGrpAttr, 0, sizeof(VPSS_GRP_ATTR_S));
-    stGrpAttr.u32MaxW = 4096;
-    stGrpAttr.u32MaxH = 4096;
-    stGrpAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stGrpAttr.stFrameRate.s32SrcFrameRate = -1;
-    stGrpAttr.stFrameRate.s32DstFrameRate = -1;
-    stGrpAttr.enCompressMode = COMPRESS_MODE_NONE;
-
-    s32Ret = RK_MPI_VPSS_CreateGrp(m_vpssGrpId, &stGrpAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to create VPSS group: " << s32Ret << std::endl;
-        return false;
+bool MediaManager::start(unsigned services) {
+    std::vector<std::shared_ptr<MediaPipeline>> pipelines;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelinesMutex);
+        pipelines = m_pipelines;
     }
-
-    // 配置 VPSS 通道0（用于编码）
-    VPSS_CHN_ATTR_S stChnAttr;
-    memset(&stChnAttr, 0, sizeof(VPSS_CHN_ATTR_S));
-    stChnAttr.enChnMode = VPSS_CHN_MODE_PASSTHROUGH;
-    stChnAttr.enDynamicRange = DYNAMIC_RANGE_SDR8;
-    stChnAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stChnAttr.stFrameRate.s32SrcFrameRate = -1;
-    stChnAttr.stFrameRate.s32DstFrameRate = -1;
-    stChnAttr.u32Width = 1920;
-    stChnAttr.u32Height = 1080;
-    stChnAttr.enCompressMode = COMPRESS_MODE_NONE;
-
-    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, VPSS_CHN0, &stChnAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VPSS channel 0: " << s32Ret << std::endl;
+    if (pipelines.empty()) {
+        std::cerr << "[MediaManager] Not initialized" << std::endl;
         return false;
     }
-    RK_MPI_VPSS_EnableChn(m_vpssGrpId, VPSS_CHN0);
 
-    // 配置 VPSS 通道1（用于显示）
-    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, VPSS_CHN1, &stChnAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VPSS channel 1: " << s32Ret << std::endl;
-        return false;
-    }
-    RK_MPI_VPSS_EnableChn(m_vpssGrpId, VPSS_CHN1);
+    // 同一时间只有一次启动在进行，避免同一路流水线的阶段交错
+    std::lock_guard<std::mutex> startupLock(m_startupMutex);
 
-    // 配置 VPSS 通道2（用于 YUV 输出）
-    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, VPSS_CHN2, &stChnAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VPSS channel 2: " << s32Ret << std::endl;
-        return false;
+    StartupScheduler scheduler;
+    if (m_startupThreads > 0) {
+        scheduler.setMaxThreads(m_startupThreads);
     }
-    RK_MPI_VPSS_EnableChn(m_vpssGrpId, VPSS_CHN2);
-
-    // 启动 VPSS 组
-    s32Ret = RK_MPI_VPSS_StartGrp(m_vpssGrpId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to start VPSS group: " << s32Ret << std::endl;
-        return false;
+    for (auto& pipeline : pipelines) {
+        if (pipeline) {
+            pipeline->addStartupStages(scheduler, services);
+        }
     }
+    scheduler.run();
 
-    // ========== 2. 绑定 VI → VPSS ==========
-    stSrcChn.enModId = RK_ID_VI;
-    stSrcChn.s32DevId = m_viDevId;
-    stSrcChn.s32ChnId = m_viChnId;
-
-    stDestChn.enModId = RK_ID_VPSS;
-    stDestChn.s32DevId = m_vpssGrpId;
-    stDestChn.s32ChnId = 0;  // VPSS 组输入
-
-    s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VI to VPSS: " << s32Ret << std::endl;
-        return false;
-    }
-    std::cout << "[MediaManager] VI → VPSS bound" << std::endl;
-
-    // ========== 3. 初始化 VENC ==========
-    VENC_CHN_ATTR_S stVencAttr;
-    memset(&stVencAttr, 0, sizeof(VENC_CHN_ATTR_S));
-    stVencAttr.stVencAttr.enType = RK_VIDEO_ID_AVC;  // H264
-    stVencAttr.stVencAttr.u32PicWidth = 1920;
-    stVencAttr.stVencAttr.u32PicHeight = 1080;
-    stVencAttr.stVencAttr.u32VirWidth = 1920;
-    stVencAttr.stVencAttr.u32VirHeight = 1080;
-    stVencAttr.stVencAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stVencAttr.stVencAttr.enType = RK_VIDEO_ID_AVC;
-    stVencAttr.stVencAttr.u32Profile = H264E_PROFILE_HIGH;
-    stVencAttr.stRcAttr.enRcMode = VENC_RC_MODE_H264CBR;
-    stVencAttr.stRcAttr.stH264Cbr.u32Gop = 30;
-    stVencAttr.stRcAttr.stH264Cbr.u32BitRate = 2000;  // 2Mbps (单位是kbps)
-    stVencAttr.stRcAttr.stH264Cbr.u32StatTime = 1;
-    stVencAttr.stRcAttr.stH264Cbr.fr32DstFrameRateDen = 1;
-    stVencAttr.stRcAttr.stH264Cbr.fr32DstFrameRateNum = 30;
-    stVencAttr.stRcAttr.stH264Cbr.u32SrcFrameRateNum = 30;
-    stVencAttr.stRcAttr.stH264Cbr.u32SrcFrameRateDen = 1;
-
-    s32Ret = RK_MPI_VENC_CreateChn(m_vencChnId, &stVencAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to create VENC channel: " << s32Ret << std::endl;
-        return false;
+    bool ok = true;
+    for (auto& pipeline : pipelines) {
+        if (pipeline && !pipeline->finishStartup(scheduler)) {
+            ok = false;
+        }
     }
 
-    // ========== 4. 绑定 VPSS_CHN0 → VENC ==========
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN0;
+    m_startupTimings = scheduler.getTimings();
+    if (scheduler.getStageCount() > 0) {
+        std::cout << "[MediaManager] Startup stages:" << std::endl;
+        scheduler.printTimings(std::cout);
+    }
+    std::cout << "[MediaManager] " << (ok ? "All services started" : "Some services failed to start")
+              << std::endl;
+    return ok;
+}
 
-    stDestChn.enModId = RK_ID_VENC;
-    stDestChn.s32DevId = 0;
-    stDestChn.s32ChnId = m_vencChnId;
+std::vector<StartupStageTiming> MediaManager::getStartupTimings() {
+    std::lock_guard<std::mutex> lock(m_startupMutex);
+    return m_startupTimings;
+}
 
-    s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VPSS to VENC: " << s32Ret << std::endl;
-        return false;
+void MediaManager::stop() {
+    std::vector<std::shared_ptr<MediaPipeline>> pipelines;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelinesMutex);
+        pipelines = m_pipelines;
     }
-    std::cout << "[MediaManager] VPSS_CHN0 → VENC bound" << std::endl;
 
-    // ========== 5. 初始化 VO ==========
-    VO_PUB_ATTR_S stPubAttr;
-    memset(&stPubAttr, 0, sizeof(VO_PUB_ATTR_S));
-    stPubAttr.enIntfType = VO_INTF_HDMI;
-    stPubAttr.enIntfSync = VO_OUTPUT_1080P60;
-    s32Ret = RK_MPI_VO_SetPubAttr(m_voDevId, &stPubAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VO pub attr: " << s32Ret << std::endl;
-        return false;
+    for (auto& pipeline : pipelines) {
+        if (pipeline) {
+            pipeline->stop();
+        }
     }
 
-    s32Ret = RK_MPI_VO_Enable(m_voDevId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to enable VO: " << s32Ret << std::endl;
-        return false;
-    }
+    std::cout << "[MediaManager] All services stopped" << std::endl;
+}
 
-    s32Ret = RK_MPI_VO_BindLayer(m_voLayerId, m_voDevId, VO_LAYER_MODE_VIDEO);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VO layer: " << s32Ret << std::endl;
-        return false;
+void MediaManager::startEncoderService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    if (pipeline) {
+        pipeline->startEncoderService();
     }
+}
 
-    VO_VIDEO_LAYER_ATTR_S stLayerAttr;
-    memset(&stLayerAttr, 0, sizeof(VO_VIDEO_LAYER_ATTR_S));
-    stLayerAttr.stDispRect.s32X = 0;
-    stLayerAttr.stDispRect.s32Y = 0;
-    stLayerAttr.stDispRect.u32Width = 1920;
-    stLayerAttr.stDispRect.u32Height = 1080;
-    stLayerAttr.enPixFormat = RK_FMT_YUV420SP;
-    s32Ret = RK_MPI_VO_SetLayerAttr(m_voLayerId, &stLayerAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VO layer attr: " << s32Ret << std::endl;
-        return false;
+void MediaManager::startOutputService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    if (pipeline) {
+        pipeline->startOutputService();
     }
+}
 
-    s32Ret = RK_MPI_VO_EnableLayer(m_voLayerId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to enable VO layer: " << s32Ret << std::endl;
-        return false;
+void MediaManager::startYUVService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    if (pipeline) {
+        pipeline->startYUVService();
     }
+}
 
-    // ========== 6. 绑定 VPSS_CHN1 → VO ==========
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN1;
-
-    stDestChn.enModId = RK_ID_VO;
-    stDestChn.s32DevId = m_voLayerId;
-    stDestChn.s32ChnId = m_voChnId;
-
-    s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VPSS to VO: " << s32Ret << std::endl;
-        return false;
+void MediaManager::stopEncoderService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    if (pipeline) {
+        pipeline->stopEncoderService();
     }
-    std::cout << "[MediaManager] VPSS_CHN1 → VO bound" << std::endl;
+}
 
-    s32Ret = RK_MPI_VO_EnableChn(m_voLayerId, m_voChnId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to enable VO channel: " << s32Ret << std::endl;
-        return false;
+void MediaManager::stopOutputService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    if (pipeline) {
+        pipeline->stopOutputService();
     }
-
-    m_bindingsSetup = true;
-    return true;
 }
 
-void MediaManager::teardownBindings() {
-    if (!m_bindingsSetup) {
-        return;
+void MediaManager::stopYUVService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    if (pipeline) {
+        pipeline->stopYUVService();
     }
+}
 
-    MPP_CHN_S stSrcChn, stDestChn;
-
-    // 解绑 VPSS → VO
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN1;
-    stDestChn.enModId = RK_ID_VO;
-    stDestChn.s32DevId = m_voLayerId;
-    stDestChn.s32ChnId = m_voChnId;
-    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-    RK_MPI_VO_DisableChn(m_voLayerId, m_voChnId);
-    RK_MPI_VO_DisableLayer(m_voLayerId);
-    RK_MPI_VO_Disable(m_voDevId);
-
-    // 解绑 VPSS → VENC
-    stSrcChn.enModId = RK_ID_VPSS;
-    stSrcChn.s32DevId = m_vpssGrpId;
-    stSrcChn.s32ChnId = VPSS_CHN0;
-    stDestChn.enModId = RK_ID_VENC;
-    stDestChn.s32DevId = 0;
-    stDestChn.s32ChnId = m_vencChnId;
-    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-    RK_MPI_VENC_DestroyChn(m_vencChnId);
-
-    // 解绑 VI → VPSS
-    stSrcChn.enModId = RK_ID_VI;
-    stSrcChn.s32DevId = m_viDevId;
-    stSrcChn.s32ChnId = m_viChnId;
-    stDestChn.enModId = RK_ID_VPSS;
-    stDestChn.s32DevId = m_vpssGrpId;
-    stDestChn.s32ChnId = 0;
-    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-
-    // 停止并销毁 VPSS
-    RK_MPI_VPSS_StopGrp(m_vpssGrpId);
-    RK_MPI_VPSS_DestroyGrp(m_vpssGrpId);
-
-    m_bindingsSetup = false;
-    std::cout << "[MediaManager] All bindings teardown" << std::endl;
-}
-
-void MediaManager::incrementServiceRef() {
-    std::lock_guard<std::mutex> lock(m_refCountMutex);
-    int oldCount = m_serviceRefCount.fetch_add(1);
-
-    std::cout << "[MediaManager] Service ref count: "
-              << oldCount << " -> " << (oldCount + 1) << std::endl;
-
-    // 如果是第一个服务启动，初始化VI和VPSS，并完成 VI→VPSS 绑定
-    if (oldCount == 0) {
-        std::cout << "[MediaManager] incrementServiceRef: first service, initialize VI/VPSS" << std::endl;
-
-        std::cout << "[MediaManager] initializeVI() begin" << std::endl;
-        if (!initializeVI()) {
-            std::cerr << "[MediaManager] initializeVI() failed" << std::endl;
-            m_serviceRefCount.fetch_sub(1);  // 回滚
-            return;
-        }
-        std::cout << "[MediaManager] initializeVI() ok" << std::endl;
-
-        std::cout << "[MediaManager] initializeVPSS() begin" << std::endl;
-        if (!initializeVPSS()) {
-            std::cerr << "[MediaManager] initializeVPSS() failed" << std::endl;
-            cleanupVI();
-            m_serviceRefCount.fetch_sub(1);  // 回滚
-            return;
-        }
-        std::cout << "[MediaManager] initializeVPSS() ok" << std::endl;
-
-        std::cout << "[MediaManager] bind VI->VPSS begin" << std::endl;
-        MPP_CHN_S stSrcChn, stDestChn;
-        stSrcChn.enModId = RK_ID_VI;
-        stSrcChn.s32DevId = m_viDevId;
-        stSrcChn.s32ChnId = m_viChnId;
-
-        stDestChn.enModId = RK_ID_VPSS;
-        stDestChn.s32DevId = m_vpssGrpId;
-        stDestChn.s32ChnId = 0;  // VPSS 组输入
-
-        RK_S32 s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-        std::cout << "[MediaManager] RK_MPI_SYS_Bind(VI->VPSS) ret=" << s32Ret << std::endl;
-        if (s32Ret != RK_SUCCESS) {
-            std::cerr << "[MediaManager] Failed to bind VI to VPSS: " << s32Ret << std::endl;
-            cleanupVPSS();
-            cleanupVI();
-            m_serviceRefCount.fetch_sub(1);  // 回滚
-            return;
-        }
-
-        m_bindingsSetup = true;
-        std::cout << "[MediaManager] VI → VPSS bound (first service path done)" << std::endl;
-    }
+std::shared_ptr<VideoEncoderSvc> MediaManager::getEncoderService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    return pipeline ? pipeline->getEncoderService() : nullptr;
+}
 
-    // 当前版本中，VENC/VO 的绑定在各自的 startXxxService 中完成
+std::shared_ptr<VideoOutputSvc> MediaManager::getOutputService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    return pipeline ? pipeline->getOutputService() : nullptr;
 }
 
-int MediaManager::decrementServiceRef() {
-    std::lock_guard<std::mutex> lock(m_refCountMutex);
-    int newCount = m_serviceRefCount.fetch_sub(1) - 1;
-    
-    std::cout << "[MediaManager] Service ref count: " << (newCount + 1) << " -> " << newCount << std::endl;
-    
-    // 如果是最后一个服务停止，清理VI和VPSS
-    if (newCount == 0) {
-        // 解绑所有连接
-        teardownBindings();
-        
-        // 清理VPSS和VI
-        cleanupVPSS();
-        cleanupVI();
-        
-        m_bindingsSetup = false;
-        std::cout << "[MediaManager] All services stopped, VI and VPSS cleaned up" << std::endl;
-    }
-    
-    return newCount;
+std::shared_ptr<YUVOutputSvc> MediaManager::getYUVService() {
+    std::shared_ptr<MediaPipeline> pipeline = getPipeline(0);
+    return pipeline ? pipeline->getYUVService() : nullptr;
 }
 
-void MediaManager::updateBindings() {
-    // 根据服务运行状态动态绑定/解绑
-    MPP_CHN_S stSrcChn, stDestChn;
-    RK_S32 s32Ret = RK_FAILURE;
-    
-    // 编码服务绑定
-    if (m_encoderRunning && !m_bindingsSetup) {
-        // 确保VENC已初始化
-        if (!initializeVENC()) {
-            std::cerr << "[MediaManager] Failed to initialize VENC" << std::endl;
-            return;
-        }
-        
-        // 绑定 VPSS_CHN0 → VENC
-        stSrcChn.enModId = RK_ID_VPSS;
-        stSrcChn.s32DevId = m_vpssGrpId;
-        stSrcChn.s32ChnId = VPSS_CHN0;
-        
-        stDestChn.enModId = RK_ID_VENC;
-        stDestChn.s32DevId = 0;
-        stDestChn.s32ChnId = m_vencChnId;
-        
-        s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-        if (s32Ret == RK_SUCCESS) {
-            std::cout << "[MediaManager] VPSS_CHN0 → VENC bound" << std::endl;
-        }
-    } else if (!m_encoderRunning && m_bindingsSetup) {
-        // 解绑 VPSS → VENC
-        stSrcChn.enModId = RK_ID_VPSS;
-        stSrcChn.s32DevId = m_vpssGrpId;
-        stSrcChn.s32ChnId = VPSS_CHN0;
-        
-        stDestChn.enModId = RK_ID_VENC;
-        stDestChn.s32DevId = 0;
-        stDestChn.s32ChnId = m_vencChnId;
-        
-        RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-        cleanupVENC();
-        std::cout << "[MediaManager] VPSS_CHN0 → VENC unbound" << std::endl;
-    }
-    
-    // 显示服务绑定
-    if (m_outputRunning && !m_bindingsSetup) {
-        // 确保VO已初始化
-        if (!initializeVO()) {
-            std::cerr << "[MediaManager] Failed to initialize VO" << std::endl;
-            return;
-        }
-        
-        // 绑定 VPSS_CHN1 → VO
-        stSrcChn.enModId = RK_ID_VPSS;
-        stSrcChn.s32DevId = m_vpssGrpId;
-        stSrcChn.s32ChnId = VPSS_CHN1;
-        
-        stDestChn.enModId = RK_ID_VO;
-        stDestChn.s32DevId = m_voLayerId;
-        stDestChn.s32ChnId = m_voChnId;
-        
-        s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
-        if (s32Ret == RK_SUCCESS) {
-            RK_MPI_VO_EnableChn(m_voLayerId, m_voChnId);
-            std::cout << "[MediaManager] VPSS_CHN1 → VO bound" << std::endl;
-        }
-    } else if (!m_outputRunning && m_bindingsSetup) {
-        // 解绑 VPSS → VO
-        stSrcChn.enModId = RK_ID_VPSS;
-        stSrcChn.s32DevId = m_vpssGrpId;
-        stSrcChn.s32ChnId = VPSS_CHN1;
-        
-        stDestChn.enModId = RK_ID_VO;
-        stDestChn.s32DevId = m_voLayerId;
-        stDestChn.s32ChnId = m_voChnId;
-        
-        RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
-        RK_MPI_VO_DisableChn(m_voLayerId, m_voChnId);
-        cleanupVO();
-        std::cout << "[MediaManager] VPSS_CHN1 → VO unbound" << std::endl;
-    }
-    
-    // YUV服务不需要额外绑定，直接从VPSS_CHN2获取数据
-}
-
-bool MediaManager::initializeVI() {
-    if (m_viInitialized) {
+bool MediaManager::acquireVoLayer(const VoConfig& vo, uint32_t& layerWidth, uint32_t& layerHeight) {
+    std::lock_guard<std::mutex> lock(m_voMutex);
+
+    VoLayerState& layer = m_voLayers[vo.layerId];
+    if (layer.refCount > 0) {
+        layer.refCount++;
+        layerWidth = layer.width;
+        layerHeight = layer.height;
         return true;
     }
-    
+
     RK_S32 s32Ret = RK_FAILURE;
-    std::cout << "[MediaManager] initializeVI: start, viDev=" << m_viDevId
-              << " pipe=" << m_viPipeId
-              << " chn=" << m_viChnId
-              << " entity=" << m_entityName << std::endl;
-    
-    // 1. 获取/检查 VI 设备属性（参考 test_mpi_vi：如未配置则用当前结构进行一次 SetDevAttr）
-    VI_DEV_ATTR_S stDevAttr;
-    memset(&stDevAttr, 0, sizeof(VI_DEV_ATTR_S));
-
-    s32Ret = RK_MPI_VI_GetDevAttr(m_viDevId, &stDevAttr);
-    if (s32Ret == RK_ERR_VI_NOT_CONFIG) {
-        // 与 test_mpi_vi 一致：如果未配置，则使用当前 stDevAttr 调用一次 SetDevAttr
-        s32Ret = RK_MPI_VI_SetDevAttr(m_viDevId, &stDevAttr);
-        if (s32Ret != RK_SUCCESS) {
-            std::cerr << "[MediaManager] RK_MPI_VI_SetDevAttr failed: " << s32Ret << std::endl;
-            return false;
+    uint32_t syncW = 0;
+    uint32_t syncH = 0;
+
+    // 同一 VO 设备上已有其他图层在用时，设备已经打开
+    bool devInUse = false;
+    for (auto& entry : m_voLayers) {
+        if (entry.first != vo.layerId && entry.second.refCount > 0 && entry.second.config.devId == vo.devId) {
+            devInUse = true;
+            break;
         }
     }
 
-    // 2. 启用设备
-    s32Ret = RK_MPI_VI_GetDevIsEnable(m_viDevId);
-    if (s32Ret != RK_SUCCESS) {
-        s32Ret = RK_MPI_VI_EnableDev(m_viDevId);
+    VO_PUB_ATTR_S stPubAttr;
+    memset(&stPubAttr, 0, sizeof(VO_PUB_ATTR_S));
+    toVoIntfType(vo.intf, stPubAttr.enIntfType);
+    toVoIntfSync(vo.sync, stPubAttr.enIntfSync, syncW, syncH);
+    if (!devInUse) {
+        s32Ret = RK_MPI_VO_SetPubAttr(vo.devId, &stPubAttr);
         if (s32Ret != RK_SUCCESS) {
-            std::cerr << "[MediaManager] RK_MPI_VI_EnableDev failed: " << s32Ret << std::endl;
+            std::cerr << "[MediaManager] Failed to set VO pub attr: " << s32Ret << std::endl;
+            m_voLayers.erase(vo.layerId);
             return false;
         }
-        
-        // 3. 绑定设备到管道
-        VI_DEV_BIND_PIPE_S stBindPipe;
-        memset(&stBindPipe, 0, sizeof(VI_DEV_BIND_PIPE_S));
-        stBindPipe.u32Num = 1;
-        stBindPipe.PipeId[0] = m_viPipeId;
-        stBindPipe.bDataOffline = RK_FALSE;
-        stBindPipe.bUserStartPipe[0] = RK_FALSE;
-        
-        s32Ret = RK_MPI_VI_SetDevBindPipe(m_viDevId, &stBindPipe);
+
+        s32Ret = RK_MPI_VO_Enable(vo.devId);
         if (s32Ret != RK_SUCCESS) {
-            std::cerr << "[MediaManager] RK_MPI_VI_SetDevBindPipe failed: " << s32Ret << std::endl;
+            std::cerr << "[MediaManager] Failed to enable VO: " << s32Ret << std::endl;
+            m_voLayers.erase(vo.layerId);
             return false;
         }
     }
-    
-    // 4. 配置通道属性（参考 test_mpi_vi：只设置必要字段，避免与 ISP 默认配置冲突）
-    VI_CHN_ATTR_S stChnAttr;
-    memset(&stChnAttr, 0, sizeof(VI_CHN_ATTR_S));
-    stChnAttr.stSize.u32Width  = 3840;
-    stChnAttr.stSize.u32Height = 2160;
-    stChnAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stChnAttr.enDynamicRange = DYNAMIC_RANGE_SDR8;
-    stChnAttr.enVideoFormat = VIDEO_FORMAT_LINEAR;
-    stChnAttr.enCompressMode = COMPRESS_MODE_NONE;
-    stChnAttr.bMirror = RK_FALSE;
-    stChnAttr.bFlip = RK_FALSE;
-    // 对齐 test_mpi_vi 在绑定 VENC 模式下的配置：u32Depth = 0，由绑定模块控制缓冲
-    stChnAttr.u32Depth = 0;
-    stChnAttr.stFrameRate.s32SrcFrameRate = -1;
-    stChnAttr.stFrameRate.s32DstFrameRate = -1;
-    stChnAttr.enAllocBufType = VI_ALLOC_BUF_TYPE_INTERNAL;
-
-    // 设置 entity 名称（与 test_mpi_vi 一致）
-    if (!m_entityName.empty()) {
-        strncpy(stChnAttr.stIspOpt.aEntityName, m_entityName.c_str(), MAX_VI_ENTITY_NAME_LEN - 1);
-        stChnAttr.stIspOpt.aEntityName[MAX_VI_ENTITY_NAME_LEN - 1] = '\0';
-    }
-    // 与 test_mpi_vi 参数对应：
-    // - enMemoryType 由 -t 4 指定为 DMABUF
-    // - enCaptureType 保持为 VIDEO_CAPTURE（单平面），不要强行使用 MPLANE
-    stChnAttr.stIspOpt.enMemoryType  = VI_V4L2_MEMORY_TYPE_DMABUF;
-    stChnAttr.stIspOpt.enCaptureType = VI_V4L2_CAPTURE_TYPE_VIDEO_CAPTURE;
-    // 与 demo 命令 --buf_count 6 对应
-    stChnAttr.stIspOpt.u32BufCount   = 6;
-    stChnAttr.stIspOpt.bNoUseLibV4L2 = RK_FALSE;
-    
-    s32Ret = RK_MPI_VI_SetChnAttr(m_viPipeId, m_viChnId, &stChnAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] RK_MPI_VI_SetChnAttr failed: " << s32Ret << std::endl;
-        return false;
-    }
-    
-    // 6. 启用通道
-    s32Ret = RK_MPI_VI_EnableChn(m_viPipeId, m_viChnId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] RK_MPI_VI_EnableChn failed: " << s32Ret << std::endl;
-        return false;
-    }
-    
-    // 7. 启动管道
-    // 说明：在 rockit 官方 demo（test_mpi_vi）中，并未显式调用 RK_MPI_VI_StartPipe，
-    // 实际使用中由驱动/ISP 内部完成，我们这里也不再手动 StartPipe，避免无效调用。
-    m_viInitialized = true;
-    std::cout << "[MediaManager] VI initialized" << std::endl;
-
-    // 8. 读取实际通道属性，记录真实宽高，用于后续 VPSS/VENC
-    VI_CHN_ATTR_S stChnAttrGet;
-    memset(&stChnAttrGet, 0, sizeof(VI_CHN_ATTR_S));
-    s32Ret = RK_MPI_VI_GetChnAttr(m_viPipeId, m_viChnId, &stChnAttrGet);
-    if (s32Ret == RK_SUCCESS) {
-        m_imgWidth  = stChnAttrGet.stSize.u32Width;
-        m_imgHeight = stChnAttrGet.stSize.u32Height;
-    } else {
-        // 回退到期望值
-        m_imgWidth  = 3840;
-        m_imgHeight = 2160;
-    }
-    std::cout << "[MediaManager] VI actual size: "
-              << m_imgWidth << "x" << m_imgHeight << std::endl;
 
-    return true;
-}
-
-void MediaManager::cleanupVI() {
-    if (!m_viInitialized) {
-        return;
-    }
-    
-    RK_MPI_VI_DisableChn(m_viPipeId, m_viChnId);
-    RK_MPI_VI_DisableDev(m_viDevId);
-    
-    m_viInitialized = false;
-    std::cout << "[MediaManager] VI cleaned up" << std::endl;
-}
-
-bool MediaManager::initializeVPSS() {
-    if (m_vpssInitialized) {
-        return true;
-    }
-    
-    RK_S32 s32Ret = RK_FAILURE;
-
-    // ========== 初始化 VPSS ==========
-    // 使用实际图像宽高（来自 VI 通道）
-    RK_U32 vpssW = m_imgWidth  > 0 ? static_cast<RK_U32>(m_imgWidth)  : 3840;
-    RK_U32 vpssH = m_imgHeight > 0 ? static_cast<RK_U32>(m_imgHeight) : 2160;
-
-    VPSS_GRP_ATTR_S stGrpAttr;
-    memset(&stGrpAttr, 0, sizeof(VPSS_GRP_ATTR_S));
-    stGrpAttr.u32MaxW = 4096;
-    stGrpAttr.u32MaxH = 4096;
-    stGrpAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stGrpAttr.stFrameRate.s32SrcFrameRate = -1;
-    stGrpAttr.stFrameRate.s32DstFrameRate = -1;
-    stGrpAttr.enCompressMode = COMPRESS_MODE_NONE;
-
-    s32Ret = RK_MPI_VPSS_CreateGrp(m_vpssGrpId, &stGrpAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to create VPSS group: " << s32Ret << std::endl;
-        return false;
-    }
-
-    // 配置 VPSS 通道0（用于编码）
-    VPSS_CHN_ATTR_S stChnAttr;
-    memset(&stChnAttr, 0, sizeof(VPSS_CHN_ATTR_S));
-    stChnAttr.enChnMode = VPSS_CHN_MODE_PASSTHROUGH;
-    stChnAttr.enDynamicRange = DYNAMIC_RANGE_SDR8;
-    stChnAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stChnAttr.stFrameRate.s32SrcFrameRate = -1;
-    stChnAttr.stFrameRate.s32DstFrameRate = -1;
-    stChnAttr.u32Width  = vpssW;
-    stChnAttr.u32Height = vpssH;
-    stChnAttr.enCompressMode = COMPRESS_MODE_NONE;
-
-    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, VPSS_CHN0, &stChnAttr);
+    s32Ret = RK_MPI_VO_BindLayer(vo.layerId, vo.devId, VO_LAYER_MODE_VIDEO);
     if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VPSS channel 0: " << s32Ret << std::endl;
-        return false;
-    }
-    RK_MPI_VPSS_EnableChn(m_vpssGrpId, VPSS_CHN0);
-
-    // 配置 VPSS 通道1（用于显示）
-    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, VPSS_CHN1, &stChnAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VPSS channel 1: " << s32Ret << std::endl;
-        return false;
-    }
-    RK_MPI_VPSS_EnableChn(m_vpssGrpId, VPSS_CHN1);
-
-    // 配置 VPSS 通道2（用于 YUV 输出）
-    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, VPSS_CHN2, &stChnAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VPSS channel 2: " << s32Ret << std::endl;
-        return false;
-    }
-    RK_MPI_VPSS_EnableChn(m_vpssGrpId, VPSS_CHN2);
-
-    // 启动 VPSS 组
-    s32Ret = RK_MPI_VPSS_StartGrp(m_vpssGrpId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to start VPSS group: " << s32Ret << std::endl;
+        std::cerr << "[MediaManager] Failed to bind VO layer: " << s32Ret << std::endl;
+        if (!devInUse) {
+            RK_MPI_VO_Disable(vo.devId);
+        }
+        m_voLayers.erase(vo.layerId);
         return false;
     }
 
-    m_vpssInitialized = true;
-    std::cout << "[MediaManager] VPSS initialized" << std::endl;
-    return true;
-}
-
-void MediaManager::cleanupVPSS() {
-    if (!m_vpssInitialized) {
-        return;
+    VO_VIDEO_LAYER_ATTR_S stLayerAttr;
+    memset(&stLayerAttr, 0, sizeof(VO_VIDEO_LAYER_ATTR_S));
+    stLayerAttr.stDispRect.s32X = vo.rectX;
+    stLayerAttr.stDispRect.s32Y = vo.rectY;
+    stLayerAttr.stDispRect.u32Width = vo.rectWidth > 0 ? vo.rectWidth : syncW;
+    stLayerAttr.stDispRect.u32Height = vo.rectHeight > 0 ? vo.rectHeight : syncH;
+    stLayerAttr.enPixFormat = RK_FMT_YUV420SP;
+    s32Ret = RK_MPI_VO_SetLayerAttr(vo.layerId, &stLayerAttr);
+    if (s32Ret == RK_SUCCESS) {
+        s32Ret = RK_MPI_VO_EnableLayer(vo.layerId);
     }
-    
-    RK_MPI_VPSS_StopGrp(m_vpssGrpId);
-    RK_MPI_VPSS_DestroyGrp(m_vpssGrpId);
-    
-    m_vpssInitialized = false;
-    std::cout << "[MediaManager] VPSS cleaned up" << std::endl;
-}
-
-bool MediaManager::initializeVENC() {
-    RK_S32 s32Ret = RK_FAILURE;
-    
-    VENC_CHN_ATTR_S stVencAttr;
-    memset(&stVencAttr, 0, sizeof(VENC_CHN_ATTR_S));
-    stVencAttr.stVencAttr.enType = RK_VIDEO_ID_AVC;  // H264
-
-    // 使用实际图像宽高（与 VPSS 一致）
-    RK_U32 vencW = m_imgWidth  > 0 ? static_cast<RK_U32>(m_imgWidth)  : 3840;
-    RK_U32 vencH = m_imgHeight > 0 ? static_cast<RK_U32>(m_imgHeight) : 2160;
-    stVencAttr.stVencAttr.u32PicWidth  = vencW;
-    stVencAttr.stVencAttr.u32PicHeight = vencH;
-    stVencAttr.stVencAttr.u32VirWidth  = vencW;
-    stVencAttr.stVencAttr.u32VirHeight = vencH;
-    stVencAttr.stVencAttr.enPixelFormat = RK_FMT_YUV420SP;
-    stVencAttr.stVencAttr.u32Profile = H264E_PROFILE_HIGH;
-    stVencAttr.stRcAttr.enRcMode = VENC_RC_MODE_H264CBR;
-    stVencAttr.stRcAttr.stH264Cbr.u32Gop = 30;
-    stVencAttr.stRcAttr.stH264Cbr.u32BitRate = 2000;  // 2Mbps (单位是kbps)
-    stVencAttr.stRcAttr.stH264Cbr.u32StatTime = 1;
-    stVencAttr.stRcAttr.stH264Cbr.fr32DstFrameRateDen = 1;
-    stVencAttr.stRcAttr.stH264Cbr.fr32DstFrameRateNum = 30;
-    stVencAttr.stRcAttr.stH264Cbr.u32SrcFrameRateNum = 30;
-    stVencAttr.stRcAttr.stH264Cbr.u32SrcFrameRateDen = 1;
-
-    s32Ret = RK_MPI_VENC_CreateChn(m_vencChnId, &stVencAttr);
     if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to create VENC channel: " << s32Ret << std::endl;
+        std::cerr << "[MediaManager] Failed to set up VO layer " << vo.layerId << ": " << s32Ret << std::endl;
+        RK_MPI_VO_UnBindLayer(vo.layerId, vo.devId);
+        if (!devInUse) {
+            RK_MPI_VO_Disable(vo.devId);
+        }
+        m_voLayers.erase(vo.layerId);
         return false;
     }
 
-    // 启动接收帧（-1 表示不限帧数）
-    VENC_RECV_PIC_PARAM_S stRecvParam;
-    memset(&stRecvParam, 0, sizeof(VENC_RECV_PIC_PARAM_S));
-    stRecvParam.s32RecvPicNum = -1;
-
-    s32Ret = RK_MPI_VENC_StartRecvFrame(m_vencChnId, &stRecvParam);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] RK_MPI_VENC_StartRecvFrame failed: " << s32Ret << std::endl;
-        RK_MPI_VENC_DestroyChn(m_vencChnId);
-        return false;
-    }
-    
-    std::cout << "[MediaManager] VENC initialized" << std::endl;
+    layer.config = vo;
+    layer.width = stLayerAttr.stDispRect.u32Width;
+    layer.height = stLayerAttr.stDispRect.u32Height;
+    layer.refCount = 1;
+    layerWidth = layer.width;
+    layerHeight = layer.height;
+    std::cout << "[MediaManager] VO layer " << vo.layerId << " initialized ("
+              << layer.width << "x" << layer.height << ")" << std::endl;
     return true;
 }
 
-void MediaManager::cleanupVENC() {
-    RK_MPI_VENC_DestroyChn(m_vencChnId);
-    std::cout << "[MediaManager] VENC cleaned up" << std::endl;
-}
+void MediaManager::releaseVoLayer(const VoConfig& vo) {
+    std::lock_guard<std::mutex> lock(m_voMutex);
 
-bool MediaManager::initializeVO() {
-    RK_S32 s32Ret = RK_FAILURE;
-    
-    VO_PUB_ATTR_S stPubAttr;
-    memset(&stPubAttr, 0, sizeof(VO_PUB_ATTR_S));
-    stPubAttr.enIntfType = VO_INTF_HDMI;
-    stPubAttr.enIntfSync = VO_OUTPUT_1080P60;
-    s32Ret = RK_MPI_VO_SetPubAttr(m_voDevId, &stPubAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VO pub attr: " << s32Ret << std::endl;
-        return false;
+    std::map<int, VoLayerState>::iterator it = m_voLayers.find(vo.layerId);
+    if (it == m_voLayers.end() || it->second.refCount <= 0) {
+        return;
     }
-
-    s32Ret = RK_MPI_VO_Enable(m_voDevId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to enable VO: " << s32Ret << std::endl;
-        return false;
+    if (--it->second.refCount > 0) {
+        return;
     }
+    m_voLayers.erase(it);
 
-    s32Ret = RK_MPI_VO_BindLayer(m_voLayerId, m_voDevId, VO_LAYER_MODE_VIDEO);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to bind VO layer: " << s32Ret << std::endl;
-        return false;
-    }
+    RK_MPI_VO_DisableLayer(vo.layerId);
+    RK_MPI_VO_UnBindLayer(vo.layerId, vo.devId);
 
-    VO_VIDEO_LAYER_ATTR_S stLayerAttr;
-    memset(&stLayerAttr, 0, sizeof(VO_VIDEO_LAYER_ATTR_S));
-    stLayerAttr.stDispRect.s32X = 0;
-    stLayerAttr.stDispRect.s32Y = 0;
-    stLayerAttr.stDispRect.u32Width = 1920;
-    stLayerAttr.stDispRect.u32Height = 1080;
-    stLayerAttr.enPixFormat = RK_FMT_YUV420SP;
-    s32Ret = RK_MPI_VO_SetLayerAttr(m_voLayerId, &stLayerAttr);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to set VO layer attr: " << s32Ret << std::endl;
-        return false;
+    bool devInUse = false;
+    for (auto& entry : m_voLayers) {
+        if (entry.second.refCount > 0 && entry.second.config.devId == vo.devId) {
+            devInUse = true;
+            break;
+        }
     }
-
-    s32Ret = RK_MPI_VO_EnableLayer(m_voLayerId);
-    if (s32Ret != RK_SUCCESS) {
-        std::cerr << "[MediaManager] Failed to enable VO layer: " << s32Ret << std::endl;
-        return false;
+    if (!devInUse) {
+        RK_MPI_VO_Disable(vo.devId);
     }
-    
-    std::cout << "[MediaManager] VO initialized" << std::endl;
-    return true;
-}
-
-void MediaManager::cleanupVO() {
-    RK_MPI_VO_DisableLayer(m_voLayerId);
-    RK_MPI_VO_Disable(m_voDevId);
-    std::cout << "[MediaManager] VO cleaned up" << std::endl;
+    std::cout << "[MediaManager] VO layer " << vo.layerId << " cleaned up" << std::endl;
 }
-
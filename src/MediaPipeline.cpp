@@ -0,0 +1,997 @@
+#include "MediaPipeline.h"
+#include "MediaManager.h"
+#include "StartupScheduler.h"
+#include <iostream>
+#include <cstring>
+
+// MPP 头文件
+#include "rk_mpi_vi.h"
+#include "rk_mpi_vpss.h"
+#include "rk_mpi_venc.h"
+#include "rk_mpi_vo.h"
+#include "rk_mpi_sys.h"
+#include "rk_comm_vi.h"
+#include "rk_comm_vpss.h"
+#include "rk_comm_venc.h"
+#include "rk_comm_vo.h"
+#include "rk_common.h"
+
+// 等待服务线程退出的超时（超时后打印告警）
+static const int kServiceStopTimeoutMs = 3000;
+
+/**
+ * @brief V4L2 像素格式转换为 MPI 像素格式
+ */
+static bool toRkPixelFormat(uint32_t v4l2Format, PIXEL_FORMAT_E& format) {
+    switch (v4l2Format) {
+    case V4L2_PIX_FMT_NV12: format = RK_FMT_YUV420SP;    return true;
+    case V4L2_PIX_FMT_NV21: format = RK_FMT_YUV420SP_VU; return true;
+    case V4L2_PIX_FMT_NV16: format = RK_FMT_YUV422SP;    return true;
+    default:                return false;
+    }
+}
+
+MediaPipeline::MediaPipeline(MediaManager& owner, int index, const PipelineConfig& config)
+    : m_owner(owner),
+      m_index(index),
+      m_tag("[MediaPipeline " + std::to_string(index) + "] "),
+      m_config(config),
+      m_viDevId(config.vi.devId),
+      m_viPipeId(config.vi.pipeId),
+      m_viChnId(config.vi.chnId),
+      m_entityName(config.vi.entityName),
+      m_vpssGrpId(config.vpssGrpId),
+      m_vpssChnEnc(kVpssChnEncoder),
+      m_vpssChnVo(kVpssChnDisplay),
+      m_vpssChnYuv(kVpssChnYuv),
+      m_vencChnId(config.vencChnId),
+      m_voDevId(config.vo.devId),
+      m_voLayerId(config.vo.layerId),
+      m_voChnId(config.vo.chnId) {
+}
+
+MediaPipeline::~MediaPipeline() {
+    deinit();
+}
+
+bool MediaPipeline::init() {
+    if (m_initialized) {
+        std::cerr << m_tag << "Already initialized" << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < kVpssChnCount; i++) {
+        PIXEL_FORMAT_E format;
+        if (!toRkPixelFormat(m_config.vpss[i].pixelFormat, format)) {
+            std::cerr << m_tag << "Unsupported VPSS channel " << i << " pixel format" << std::endl;
+            return false;
+        }
+    }
+
+    // 创建服务实例（但不启动，等待单独启动）
+    m_encoderSvc = std::make_shared<VideoEncoderSvc>();
+    m_outputSvc = std::make_shared<VideoOutputSvc>();
+    m_yuvSvc = std::make_shared<YUVOutputSvc>();
+
+    // 设置服务的 MPP 参数（让服务知道从哪里获取数据）
+    m_encoderSvc->setMPPParams(m_vencChnId);  // 从 VENC 获取编码流
+    m_encoderSvc->setEncodeParams(m_config.venc);
+    m_encoderSvc->setChannelRebuilder([this]() { return rebuildEncoderChannel(); });
+    int encFps = m_config.vpss[kVpssChnEncoder].fps > 0 ? m_config.vpss[kVpssChnEncoder].fps
+                                                        : m_config.vi.fps;
+    m_encoderSvc->setInputFrameRate(encFps > 0 ? static_cast<uint32_t>(encFps) : 0);
+    m_outputSvc->setMPPParams(m_voDevId, m_voLayerId, m_voChnId);  // 绑定到 VO，自动显示
+    m_yuvSvc->setMPPParams(m_vpssGrpId, m_vpssChnYuv);  // 从 VPSS 获取 YUV 数据
+    int yuvFps = m_config.vpss[kVpssChnYuv].fps > 0 ? m_config.vpss[kVpssChnYuv].fps : m_config.vi.fps;
+    FrameSequenceConfig yuvSequence;
+    yuvSequence.fps = yuvFps > 0 ? yuvFps : 0;  // 跟随 sensor 时从帧间隔学习
+    m_yuvSvc->getSequenceTracker().setConfig(yuvSequence);
+
+    // 注意：不在这里初始化VI和绑定，等待第一个服务启动时再初始化
+
+    std::cout << m_tag << "Services created (VPSS grp " << m_vpssGrpId << ", VENC chn "
+              << m_vencChnId << ", VO chn " << m_voChnId << ")" << std::endl;
+
+    m_initialized = true;
+    return true;
+}
+
+void MediaPipeline::deinit() {
+    if (!m_initialized) {
+        return;
+    }
+
+    // 先并行停止服务线程，再逐个解绑并释放 MPI 资源（最后一个服务停止时清理 VI/VPSS）
+    stop();
+    stopEncoderService();
+    stopOutputService();
+    stopYUVService();
+
+    // 清理服务实例
+    m_encoderSvc.reset();
+    m_outputSvc.reset();
+    m_yuvSvc.reset();
+
+    m_initialized = false;
+    std::cout << m_tag << "Services destroyed" << std::endl;
+}
+
+std::shared_ptr<LatencyTracer> MediaPipeline::enableLatencyTracing(size_t traceEvents) {
+    if (!m_initialized) {
+        std::cerr << m_tag << "Cannot enable latency tracing before init()" << std::endl;
+        return nullptr;
+    }
+    std::shared_ptr<LatencyTracer> tracer =
+        std::make_shared<LatencyTracer>("pipeline " + std::to_string(m_index), traceEvents);
+    m_encoderSvc->setLatencyTracer(tracer);
+    m_yuvSvc->setLatencyTracer(tracer);
+    return tracer;
+}
+
+void MediaPipeline::disableLatencyTracing() {
+    if (!m_initialized) {
+        return;
+    }
+    m_encoderSvc->setLatencyTracer(nullptr);
+    m_yuvSvc->setLatencyTracer(nullptr);
+}
+
+std::shared_ptr<LatencyTracer> MediaPipeline::getLatencyTracer() {
+    return m_encoderSvc ? m_encoderSvc->getLatencyTracer() : nullptr;
+}
+
+void MediaPipeline::setFrameDropCallback(FrameSequenceTracker::AlertCallback callback) {
+    if (!m_initialized) {
+        std::cerr << m_tag << "Cannot set frame drop callback before init()" << std::endl;
+        return;
+    }
+    FrameSequenceTracker* trackers[] = { &m_encoderSvc->getSequenceTracker(),
+                                         &m_yuvSvc->getSequenceTracker() };
+    for (size_t i = 0; i < sizeof(trackers) / sizeof(trackers[0]); i++) {
+        if (!callback) {
+            trackers[i]->setAlertCallback(nullptr);
+            continue;
+        }
+        std::string stage = "pipe" + std::to_string(m_index) + "." + trackers[i]->stage();
+        trackers[i]->setAlertCallback([callback, stage](const FrameDropAlert& alert) {
+            FrameDropAlert named = alert;
+            named.stage = stage;
+            callback(named);
+        });
+    }
+}
+
+void MediaPipeline::start() {
+    if (!m_initialized) {
+        std::cerr << m_tag << "Not initialized" << std::endl;
+        return;
+    }
+
+    // 启动所有服务（各模块按依赖并行初始化）
+    startServices(kServiceAll);
+
+    std::cout << m_tag << "All services started" << std::endl;
+}
+
+void MediaPipeline::startEncoderService() {
+    startServices(kServiceEncoder);
+}
+
+void MediaPipeline::startOutputService() {
+    startServices(kServiceOutput);
+}
+
+void MediaPipeline::startYUVService() {
+    startServices(kServiceYuv);
+}
+
+bool MediaPipeline::startServices(unsigned services) {
+    StartupScheduler scheduler;
+    addStartupStages(scheduler, services);
+    scheduler.run();
+    bool ok = finishStartup(scheduler);
+    if (scheduler.getStageCount() > 0) {
+        std::cout << m_tag << "Startup stages:" << std::endl;
+        scheduler.printTimings(std::cout);
+    }
+    return ok;
+}
+
+void MediaPipeline::addStartupStages(StartupScheduler& scheduler, unsigned services) {
+    m_startup = StartupStages();
+    if (!m_initialized) {
+        std::cerr << m_tag << "Not initialized" << std::endl;
+        return;
+    }
+
+    if ((services & kServiceEncoder) && m_encoderRunning) {
+        std::cout << m_tag << "Encoder service already running" << std::endl;
+        services &= ~kServiceEncoder;
+    }
+    if ((services & kServiceOutput) && m_outputRunning) {
+        std::cout << m_tag << "Output service already running" << std::endl;
+        services &= ~kServiceOutput;
+    }
+    if ((services & kServiceYuv) && m_yuvRunning) {
+        std::cout << m_tag << "YUV service already running" << std::endl;
+        services &= ~kServiceYuv;
+    }
+    m_startup.services = services;
+    if (services == 0) {
+        return;
+    }
+
+    const std::string prefix = "pipe" + std::to_string(m_index) + ".";
+    std::vector<int> sourceDeps;
+
+    // 第一个服务启动时建立 VI → VPSS（已有服务在运行时已经就绪）
+    if (!m_bindingsSetup) {
+        planVpssChannels();
+        int vi = scheduler.addStage(prefix + "vi", [this]() { return initializeVI(); });
+        int vpss = scheduler.addStage(prefix + "vpss", [this]() { return initializeVPSS(); }, { vi });
+        scheduler.addStage(prefix + "bind.vi-vpss", [this]() { return bindViToVpss(); }, { vi, vpss });
+        sourceDeps.push_back(vpss);
+    }
+
+    // VENC 通道按规划的编码通道尺寸创建，与 VI/VPSS 初始化并行；
+    // 下游先于 VI → VPSS 绑定完成，第一帧不会因为 VENC 未就绪而丢弃
+    if (services & kServiceEncoder) {
+        uint32_t vencW = m_vpssChnWidth[kVpssChnEncoder];
+        uint32_t vencH = m_vpssChnHeight[kVpssChnEncoder];
+        int venc = scheduler.addStage(prefix + "venc", [this, vencW, vencH]() {
+            return initializeVENC(vencW, vencH);
+        });
+        std::vector<int> deps(sourceDeps);
+        deps.push_back(venc);
+        m_startup.encoder = scheduler.addStage(prefix + "bind.vpss-venc",
+                                               [this]() { return bindVpssToVenc(); }, deps);
+    }
+
+    if (services & kServiceOutput) {
+        int vo = scheduler.addStage(prefix + "vo", [this]() { return initializeVO(); });
+        std::vector<int> deps(sourceDeps);
+        deps.push_back(vo);
+        m_startup.output = scheduler.addStage(prefix + "bind.vpss-vo",
+                                              [this]() { return bindVpssToVo(); }, deps);
+    }
+}
+
+bool MediaPipeline::finishStartup(const StartupScheduler& scheduler) {
+    unsigned services = m_startup.services;
+    StartupStages stages = m_startup;
+    m_startup = StartupStages();
+    if (services == 0) {
+        return true;
+    }
+
+    bool ok = true;
+    bool sourceReady = m_viInitialized && m_vpssInitialized && m_bindingsSetup;
+
+    if (services & kServiceEncoder) {
+        if (sourceReady && scheduler.getStatus(stages.encoder) == TaskStatus::Done) {
+            m_serviceRefCount.fetch_add(1);
+            m_encoderRunning = true;
+            m_encoderSvc->start();
+            std::cout << m_tag << "Encoder service started" << std::endl;
+        } else {
+            std::cerr << m_tag << "Encoder service failed to start" << std::endl;
+            unbindVpssFromVenc();
+            cleanupVENC();
+            ok = false;
+        }
+    }
+
+    if (services & kServiceOutput) {
+        if (sourceReady && scheduler.getStatus(stages.output) == TaskStatus::Done) {
+            m_serviceRefCount.fetch_add(1);
+            m_outputRunning = true;
+            m_outputSvc->start();
+            std::cout << m_tag << "Output service started" << std::endl;
+        } else {
+            std::cerr << m_tag << "Output service failed to start" << std::endl;
+            unbindVpssFromVo();
+            cleanupVO();
+            ok = false;
+        }
+    }
+
+    if (services & kServiceYuv) {
+        if (sourceReady) {
+            m_serviceRefCount.fetch_add(1);
+            m_yuvRunning = true;
+            m_yuvSvc->start();
+            std::cout << m_tag << "YUV service started" << std::endl;
+        } else {
+            std::cerr << m_tag << "YUV service failed to start" << std::endl;
+            ok = false;
+        }
+    }
+
+    // 没有任何服务在运行时回滚 VI/VPSS
+    std::lock_guard<std::mutex> lock(m_refCountMutex);
+    if (m_serviceRefCount.load() == 0) {
+        teardownBindings();
+        cleanupVPSS();
+        cleanupVI();
+    }
+    std::cout << m_tag << "Service ref count: " << m_serviceRefCount.load() << std::endl;
+    return ok;
+}
+
+void MediaPipeline::stopEncoderService() {
+    if (!m_encoderRunning) {
+        return;
+    }
+
+    // 先停止服务线程
+    m_encoderSvc->stop();
+    m_encoderSvc->join();
+    m_encoderRunning = false;
+
+    // 解绑 VPSS_CHN0 → VENC 并清理 VENC
+    unbindVpssFromVenc();
+    cleanupVENC();
+
+    decrementServiceRef();
+    std::cout << m_tag << "Encoder service stopped" << std::endl;
+}
+
+void MediaPipeline::stopOutputService() {
+    if (!m_outputRunning) {
+        return;
+    }
+
+    // 先停止服务线程
+    m_outputSvc->stop();
+    m_outputSvc->join();
+    m_outputRunning = false;
+
+    // 解绑 VPSS_CHN1 → VO 并清理 VO
+    unbindVpssFromVo();
+    cleanupVO();
+
+    decrementServiceRef();
+    std::cout << m_tag << "Output service stopped" << std::endl;
+}
+
+void MediaPipeline::stopYUVService() {
+    if (!m_yuvRunning) {
+        return;
+    }
+
+    m_yuvSvc->stop();
+    m_yuvSvc->join();
+    m_yuvRunning = false;
+    decrementServiceRef();
+    std::cout << m_tag << "YUV service stopped" << std::endl;
+}
+
+void MediaPipeline::stop() {
+    // 先向所有服务发出停止请求，再统一等待，服务线程并行退出
+    std::shared_ptr<ServiceBase> services[] = { m_encoderSvc, m_outputSvc, m_yuvSvc };
+    for (auto& svc : services) {
+        if (svc) {
+            svc->stop();
+        }
+    }
+
+    for (auto& svc : services) {
+        if (svc && !svc->join(kServiceStopTimeoutMs)) {
+            // 超时说明服务线程卡在 MPI 调用或任务中，记录后继续等待
+            std::cerr << m_tag << "Service thread is stuck, waiting..." << std::endl;
+            svc->join();
+        }
+    }
+
+    std::cout << m_tag << "All services stopped" << std::endl;
+}
+
+bool MediaPipeline::bindViToVpss() {
+    MPP_CHN_S stSrcChn, stDestChn;
+    stSrcChn.enModId = RK_ID_VI;
+    stSrcChn.s32DevId = m_viDevId;
+    stSrcChn.s32ChnId = m_viChnId;
+
+    stDestChn.enModId = RK_ID_VPSS;
+    stDestChn.s32DevId = m_vpssGrpId;
+    stDestChn.s32ChnId = 0;  // VPSS 组输入
+
+    RK_S32 s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to bind VI to VPSS: " << s32Ret << std::endl;
+        return false;
+    }
+
+    m_bindingsSetup = true;
+    std::cout << m_tag << "VI → VPSS bound" << std::endl;
+    return true;
+}
+
+bool MediaPipeline::bindVpssToVenc() {
+    // VENC 按规划尺寸创建；VI 实际尺寸与配置不同导致 VPSS 输出变化时，按实际尺寸重建
+    uint32_t chnW = m_vpssChnWidth[kVpssChnEncoder];
+    uint32_t chnH = m_vpssChnHeight[kVpssChnEncoder];
+    if (chnW != m_vencWidth || chnH != m_vencHeight) {
+        std::cerr << m_tag << "VENC was created for " << m_vencWidth << "x" << m_vencHeight
+                  << ", VPSS outputs " << chnW << "x" << chnH << ", recreating" << std::endl;
+        cleanupVENC();
+        if (!initializeVENC(chnW, chnH)) {
+            return false;
+        }
+    }
+
+    MPP_CHN_S stSrcChn, stDestChn;
+    stSrcChn.enModId = RK_ID_VPSS;
+    stSrcChn.s32DevId = m_vpssGrpId;
+    stSrcChn.s32ChnId = m_vpssChnEnc;
+
+    stDestChn.enModId = RK_ID_VENC;
+    stDestChn.s32DevId = 0;
+    stDestChn.s32ChnId = m_vencChnId;
+
+    RK_S32 s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to bind VPSS_CHN0 to VENC: " << s32Ret << std::endl;
+        return false;
+    }
+
+    m_vencBound = true;
+    std::cout << m_tag << "VPSS_CHN0 → VENC bound" << std::endl;
+    return true;
+}
+
+void MediaPipeline::unbindVpssFromVenc() {
+    if (!m_vencBound) {
+        return;
+    }
+
+    MPP_CHN_S stSrcChn, stDestChn;
+    stSrcChn.enModId = RK_ID_VPSS;
+    stSrcChn.s32DevId = m_vpssGrpId;
+    stSrcChn.s32ChnId = m_vpssChnEnc;
+
+    stDestChn.enModId = RK_ID_VENC;
+    stDestChn.s32DevId = 0;
+    stDestChn.s32ChnId = m_vencChnId;
+
+    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
+    m_vencBound = false;
+}
+
+bool MediaPipeline::bindVpssToVo() {
+    MPP_CHN_S stSrcChn, stDestChn;
+    stSrcChn.enModId = RK_ID_VPSS;
+    stSrcChn.s32DevId = m_vpssGrpId;
+    stSrcChn.s32ChnId = m_vpssChnVo;
+
+    stDestChn.enModId = RK_ID_VO;
+    stDestChn.s32DevId = m_voLayerId;
+    stDestChn.s32ChnId = m_voChnId;
+
+    RK_S32 s32Ret = RK_MPI_SYS_Bind(&stSrcChn, &stDestChn);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to bind VPSS_CHN1 to VO: " << s32Ret << std::endl;
+        return false;
+    }
+    m_voBound = true;
+
+    // 启用 VO 通道
+    s32Ret = RK_MPI_VO_EnableChn(m_voLayerId, m_voChnId);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to enable VO channel: " << s32Ret << std::endl;
+        return false;
+    }
+
+    std::cout << m_tag << "VPSS_CHN1 → VO bound" << std::endl;
+    return true;
+}
+
+void MediaPipeline::unbindVpssFromVo() {
+    if (!m_voBound) {
+        return;
+    }
+
+    MPP_CHN_S stSrcChn, stDestChn;
+    stSrcChn.enModId = RK_ID_VPSS;
+    stSrcChn.s32DevId = m_vpssGrpId;
+    stSrcChn.s32ChnId = m_vpssChnVo;
+
+    stDestChn.enModId = RK_ID_VO;
+    stDestChn.s32DevId = m_voLayerId;
+    stDestChn.s32ChnId = m_voChnId;
+
+    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
+    RK_MPI_VO_DisableChn(m_voLayerId, m_voChnId);
+    m_voBound = false;
+}
+
+void MediaPipeline::teardownBindings() {
+    if (!m_bindingsSetup) {
+        return;
+    }
+
+    // VENC/VO 在各自服务停止时已解绑，这里只剩 VI → VPSS
+    MPP_CHN_S stSrcChn, stDestChn;
+    stSrcChn.enModId = RK_ID_VI;
+    stSrcChn.s32DevId = m_viDevId;
+    stSrcChn.s32ChnId = m_viChnId;
+    stDestChn.enModId = RK_ID_VPSS;
+    stDestChn.s32DevId = m_vpssGrpId;
+    stDestChn.s32ChnId = 0;
+    RK_MPI_SYS_UnBind(&stSrcChn, &stDestChn);
+
+    m_bindingsSetup = false;
+    std::cout << m_tag << "All bindings teardown" << std::endl;
+}
+
+int MediaPipeline::decrementServiceRef() {
+    std::lock_guard<std::mutex> lock(m_refCountMutex);
+    int newCount = m_serviceRefCount.fetch_sub(1) - 1;
+
+    std::cout << m_tag << "Service ref count: " << (newCount + 1) << " -> " << newCount << std::endl;
+
+    // 如果是最后一个服务停止，清理VI和VPSS
+    if (newCount == 0) {
+        // 解绑所有连接
+        teardownBindings();
+
+        // 清理VPSS和VI
+        cleanupVPSS();
+        cleanupVI();
+
+        std::cout << m_tag << "All services stopped, VI and VPSS cleaned up" << std::endl;
+    }
+
+    return newCount;
+}
+
+bool MediaPipeline::initializeVI() {
+    if (m_viInitialized) {
+        return true;
+    }
+    
+    RK_S32 s32Ret = RK_FAILURE;
+    std::cout << m_tag << "initializeVI: start, viDev=" << m_viDevId
+              << " pipe=" << m_viPipeId
+              << " chn=" << m_viChnId
+              << " entity=" << m_entityName << std::endl;
+    
+    // 1. 获取/检查 VI 设备属性（参考 test_mpi_vi：如未配置则用当前结构进行一次 SetDevAttr）
+    VI_DEV_ATTR_S stDevAttr;
+    memset(&stDevAttr, 0, sizeof(VI_DEV_ATTR_S));
+
+    s32Ret = RK_MPI_VI_GetDevAttr(m_viDevId, &stDevAttr);
+    if (s32Ret == RK_ERR_VI_NOT_CONFIG) {
+        // 与 test_mpi_vi 一致：如果未配置，则使用当前 stDevAttr 调用一次 SetDevAttr
+        s32Ret = RK_MPI_VI_SetDevAttr(m_viDevId, &stDevAttr);
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << m_tag << "RK_MPI_VI_SetDevAttr failed: " << s32Ret << std::endl;
+            return false;
+        }
+    }
+
+    // 2. 启用设备
+    s32Ret = RK_MPI_VI_GetDevIsEnable(m_viDevId);
+    if (s32Ret != RK_SUCCESS) {
+        s32Ret = RK_MPI_VI_EnableDev(m_viDevId);
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << m_tag << "RK_MPI_VI_EnableDev failed: " << s32Ret << std::endl;
+            return false;
+        }
+        
+        // 3. 绑定设备到管道
+        VI_DEV_BIND_PIPE_S stBindPipe;
+        memset(&stBindPipe, 0, sizeof(VI_DEV_BIND_PIPE_S));
+        stBindPipe.u32Num = 1;
+        stBindPipe.PipeId[0] = m_viPipeId;
+        stBindPipe.bDataOffline = RK_FALSE;
+        stBindPipe.bUserStartPipe[0] = RK_FALSE;
+        
+        s32Ret = RK_MPI_VI_SetDevBindPipe(m_viDevId, &stBindPipe);
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << m_tag << "RK_MPI_VI_SetDevBindPipe failed: " << s32Ret << std::endl;
+            return false;
+        }
+    }
+    
+    // 4. 配置通道属性（参考 test_mpi_vi：只设置必要字段，避免与 ISP 默认配置冲突）
+    VI_CHN_ATTR_S stChnAttr;
+    memset(&stChnAttr, 0, sizeof(VI_CHN_ATTR_S));
+    stChnAttr.stSize.u32Width  = m_config.vi.width;
+    stChnAttr.stSize.u32Height = m_config.vi.height;
+    stChnAttr.enPixelFormat = RK_FMT_YUV420SP;
+    stChnAttr.enDynamicRange = DYNAMIC_RANGE_SDR8;
+    stChnAttr.enVideoFormat = VIDEO_FORMAT_LINEAR;
+    stChnAttr.enCompressMode = COMPRESS_MODE_NONE;
+    stChnAttr.bMirror = RK_FALSE;
+    stChnAttr.bFlip = RK_FALSE;
+    // 对齐 test_mpi_vi 在绑定 VENC 模式下的配置：u32Depth = 0，由绑定模块控制缓冲
+    stChnAttr.u32Depth = m_config.vi.depth;
+    stChnAttr.stFrameRate.s32SrcFrameRate = -1;
+    stChnAttr.stFrameRate.s32DstFrameRate = m_config.vi.fps;
+    stChnAttr.enAllocBufType = VI_ALLOC_BUF_TYPE_INTERNAL;
+
+    // 设置 entity 名称（与 test_mpi_vi 一致）
+    if (!m_entityName.empty()) {
+        strncpy(stChnAttr.stIspOpt.aEntityName, m_entityName.c_str(), MAX_VI_ENTITY_NAME_LEN - 1);
+        stChnAttr.stIspOpt.aEntityName[MAX_VI_ENTITY_NAME_LEN - 1] = '\0';
+    }
+    // 与 test_mpi_vi 参数对应：
+    // - enMemoryType 由 -t 4 指定为 DMABUF
+    // - enCaptureType 保持为 VIDEO_CAPTURE（单平面），不要强行使用 MPLANE
+    stChnAttr.stIspOpt.enMemoryType  = VI_V4L2_MEMORY_TYPE_DMABUF;
+    stChnAttr.stIspOpt.enCaptureType = VI_V4L2_CAPTURE_TYPE_VIDEO_CAPTURE;
+    // 与 demo 命令 --buf_count 对应（默认 6）
+    stChnAttr.stIspOpt.u32BufCount   = m_config.vi.bufCount;
+    stChnAttr.stIspOpt.bNoUseLibV4L2 = RK_FALSE;
+    
+    s32Ret = RK_MPI_VI_SetChnAttr(m_viPipeId, m_viChnId, &stChnAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "RK_MPI_VI_SetChnAttr failed: " << s32Ret << std::endl;
+        return false;
+    }
+    
+    // 6. 启用通道
+    s32Ret = RK_MPI_VI_EnableChn(m_viPipeId, m_viChnId);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "RK_MPI_VI_EnableChn failed: " << s32Ret << std::endl;
+        return false;
+    }
+    
+    // 7. 启动管道
+    // 说明：在 rockit 官方 demo（test_mpi_vi）中，并未显式调用 RK_MPI_VI_StartPipe，
+    // 实际使用中由驱动/ISP 内部完成，我们这里也不再手动 StartPipe，避免无效调用。
+    m_viInitialized = true;
+    std::cout << m_tag << "VI initialized" << std::endl;
+
+    // 8. 读取实际通道属性，记录真实宽高，用于后续 VPSS/VENC
+    VI_CHN_ATTR_S stChnAttrGet;
+    memset(&stChnAttrGet, 0, sizeof(VI_CHN_ATTR_S));
+    s32Ret = RK_MPI_VI_GetChnAttr(m_viPipeId, m_viChnId, &stChnAttrGet);
+    if (s32Ret == RK_SUCCESS) {
+        m_imgWidth  = stChnAttrGet.stSize.u32Width;
+        m_imgHeight = stChnAttrGet.stSize.u32Height;
+    } else {
+        // 回退到期望值
+        m_imgWidth  = m_config.vi.width;
+        m_imgHeight = m_config.vi.height;
+    }
+    std::cout << m_tag << "VI actual size: "
+              << m_imgWidth << "x" << m_imgHeight << std::endl;
+
+    return true;
+}
+
+void MediaPipeline::cleanupVI() {
+    if (!m_viInitialized) {
+        return;
+    }
+    
+    RK_MPI_VI_DisableChn(m_viPipeId, m_viChnId);
+    RK_MPI_VI_DisableDev(m_viDevId);
+    
+    m_viInitialized = false;
+    std::cout << m_tag << "VI cleaned up" << std::endl;
+}
+
+void MediaPipeline::resolveVpssChnSize(int chn, uint32_t inWidth, uint32_t inHeight,
+                                       uint32_t& width, uint32_t& height) {
+    const VpssChnConfig& chnCfg = m_config.vpss[chn];
+    if (!chnCfg.enabled) {
+        width = 0;
+        height = 0;
+        return;
+    }
+
+    width = chnCfg.width;
+    height = chnCfg.height;
+    if (width == 0 && chn == kVpssChnEncoder) {
+        // 编码通道未指定尺寸时使用编码参数中的尺寸（由 VPSS 缩放，VENC 本身不缩放）
+        EncodeParams encParams = m_encoderSvc ? m_encoderSvc->getEncodeParams() : m_config.venc;
+        width = encParams.width;
+        height = encParams.height;
+    }
+    if (width == 0) {
+        width = inWidth;
+        height = inHeight;
+    }
+}
+
+void MediaPipeline::planVpssChannels() {
+    // VI 尚未初始化时按配置尺寸规划，initializeVPSS() 再按 VI 实际尺寸确定
+    uint32_t inW = m_imgWidth  > 0 ? static_cast<uint32_t>(m_imgWidth)  : m_config.vi.width;
+    uint32_t inH = m_imgHeight > 0 ? static_cast<uint32_t>(m_imgHeight) : m_config.vi.height;
+    for (int i = 0; i < kVpssChnCount; i++) {
+        resolveVpssChnSize(i, inW, inH, m_vpssChnWidth[i], m_vpssChnHeight[i]);
+    }
+}
+
+bool MediaPipeline::initializeVPSS() {
+    if (m_vpssInitialized) {
+        return true;
+    }
+    
+    RK_S32 s32Ret = RK_FAILURE;
+
+    // ========== 初始化 VPSS ==========
+    // 使用实际图像宽高（来自 VI 通道）
+    RK_U32 vpssW = m_imgWidth  > 0 ? static_cast<RK_U32>(m_imgWidth)  : m_config.vi.width;
+    RK_U32 vpssH = m_imgHeight > 0 ? static_cast<RK_U32>(m_imgHeight) : m_config.vi.height;
+
+    VPSS_GRP_ATTR_S stGrpAttr;
+    memset(&stGrpAttr, 0, sizeof(VPSS_GRP_ATTR_S));
+    stGrpAttr.u32MaxW = vpssW > 4096 ? vpssW : 4096;
+    stGrpAttr.u32MaxH = vpssH > 4096 ? vpssH : 4096;
+    stGrpAttr.enPixelFormat = RK_FMT_YUV420SP;
+    stGrpAttr.stFrameRate.s32SrcFrameRate = -1;
+    stGrpAttr.stFrameRate.s32DstFrameRate = -1;
+    stGrpAttr.enCompressMode = COMPRESS_MODE_NONE;
+
+    s32Ret = RK_MPI_VPSS_CreateGrp(m_vpssGrpId, &stGrpAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to create VPSS group: " << s32Ret << std::endl;
+        return false;
+    }
+
+    // 配置各输出通道：0 编码、1 显示、2 YUV 输出
+    for (int i = 0; i < kVpssChnCount; i++) {
+        const VpssChnConfig& chnCfg = m_config.vpss[i];
+        uint32_t chnW = 0;
+        uint32_t chnH = 0;
+        resolveVpssChnSize(i, vpssW, vpssH, chnW, chnH);
+        if (chnW == 0) {
+            m_vpssChnWidth[i] = 0;
+            m_vpssChnHeight[i] = 0;
+            continue;
+        }
+
+        PIXEL_FORMAT_E format = RK_FMT_YUV420SP;
+        toRkPixelFormat(chnCfg.pixelFormat, format);
+
+        // 抽帧：源帧率为 VI 输出帧率
+        bool decimate = (chnCfg.fps > 0 && m_config.vi.fps > 0 && chnCfg.fps < m_config.vi.fps);
+
+        // YUV 通道由用户 GetChnFrame 取帧，必须有深度；绑定通道默认 0
+        RK_U32 depth = chnCfg.depth;
+        if (depth == 0 && i == kVpssChnYuv) {
+            depth = 2;
+        }
+
+        VPSS_CHN_ATTR_S stChnAttr;
+        memset(&stChnAttr, 0, sizeof(VPSS_CHN_ATTR_S));
+        // 尺寸、格式、帧率都与输入一致时直通（不做额外拷贝），否则由硬件缩放/转换/抽帧
+        bool passthrough = (chnW == vpssW && chnH == vpssH && format == RK_FMT_YUV420SP && !decimate);
+        stChnAttr.enChnMode = passthrough ? VPSS_CHN_MODE_PASSTHROUGH : VPSS_CHN_MODE_USER;
+        stChnAttr.enDynamicRange = DYNAMIC_RANGE_SDR8;
+        stChnAttr.enPixelFormat = format;
+        stChnAttr.stFrameRate.s32SrcFrameRate = decimate ? m_config.vi.fps : -1;
+        stChnAttr.stFrameRate.s32DstFrameRate = decimate ? chnCfg.fps : -1;
+        stChnAttr.u32Width  = chnW;
+        stChnAttr.u32Height = chnH;
+        stChnAttr.enCompressMode = COMPRESS_MODE_NONE;
+        stChnAttr.u32Depth = depth;
+        stChnAttr.u32FrameBufCnt = chnCfg.bufCount;
+
+        s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, i, &stChnAttr);
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << m_tag << "Failed to set VPSS channel " << i << ": " << s32Ret << std::endl;
+            RK_MPI_VPSS_DestroyGrp(m_vpssGrpId);
+            return false;
+        }
+        RK_MPI_VPSS_EnableChn(m_vpssGrpId, i);
+
+        m_vpssChnWidth[i] = chnW;
+        m_vpssChnHeight[i] = chnH;
+        std::cout << m_tag << "VPSS channel " << i << ": " << chnW << "x" << chnH;
+        if (decimate) {
+            std::cout << " @" << chnCfg.fps << "/" << m_config.vi.fps << "fps";
+        }
+        std::cout << (passthrough ? " (passthrough)" : " (scaled)") << std::endl;
+    }
+
+    // 启动 VPSS 组
+    s32Ret = RK_MPI_VPSS_StartGrp(m_vpssGrpId);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to start VPSS group: " << s32Ret << std::endl;
+        RK_MPI_VPSS_DestroyGrp(m_vpssGrpId);
+        return false;
+    }
+
+    m_vpssInitialized = true;
+    std::cout << m_tag << "VPSS initialized" << std::endl;
+    return true;
+}
+
+void MediaPipeline::cleanupVPSS() {
+    if (!m_vpssInitialized) {
+        return;
+    }
+    
+    RK_MPI_VPSS_StopGrp(m_vpssGrpId);
+    RK_MPI_VPSS_DestroyGrp(m_vpssGrpId);
+    
+    m_vpssInitialized = false;
+    std::cout << m_tag << "VPSS cleaned up" << std::endl;
+}
+
+bool MediaPipeline::initializeVENC(uint32_t width, uint32_t height) {
+    RK_S32 s32Ret = RK_FAILURE;
+
+    // VENC 输入为 VPSS 编码通道的输出
+    if (width == 0 || height == 0) {
+        std::cerr << m_tag << "VPSS encoder channel is disabled" << std::endl;
+        return false;
+    }
+
+    EncodeParams params = m_encoderSvc->getEncodeParams();
+    if (params.width > 0 && (params.width != width || params.height != height)) {
+        // VPSS 已按其他尺寸启动（例如编码参数在 VPSS 初始化后才修改），以实际输入为准
+        std::cerr << m_tag << "Encode size " << params.width << "x" << params.height
+                  << " differs from VPSS output " << width << "x" << height
+                  << ", using VPSS output" << std::endl;
+        params.width = 0;
+        params.height = 0;
+        m_encoderSvc->setEncodeParams(params);
+    }
+
+    VENC_CHN_ATTR_S stVencAttr;
+    m_encoderSvc->fillChnAttr(stVencAttr, width, height);
+
+    s32Ret = RK_MPI_VENC_CreateChn(m_vencChnId, &stVencAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to create VENC channel: " << s32Ret << std::endl;
+        return false;
+    }
+
+    // 启动接收帧（-1 表示不限帧数）
+    VENC_RECV_PIC_PARAM_S stRecvParam;
+    memset(&stRecvParam, 0, sizeof(VENC_RECV_PIC_PARAM_S));
+    stRecvParam.s32RecvPicNum = -1;
+
+    s32Ret = RK_MPI_VENC_StartRecvFrame(m_vencChnId, &stRecvParam);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "RK_MPI_VENC_StartRecvFrame failed: " << s32Ret << std::endl;
+        RK_MPI_VENC_DestroyChn(m_vencChnId);
+        return false;
+    }
+
+    m_vencCreated = true;
+    m_vencWidth = width;
+    m_vencHeight = height;
+    std::cout << m_tag << "VENC initialized (" << width << "x" << height << ")" << std::endl;
+    return true;
+}
+
+void MediaPipeline::cleanupVENC() {
+    if (!m_vencCreated) {
+        return;
+    }
+
+    RK_MPI_VENC_StopRecvFrame(m_vencChnId);
+    RK_MPI_VENC_DestroyChn(m_vencChnId);
+    m_vencCreated = false;
+    m_vencWidth = 0;
+    m_vencHeight = 0;
+    std::cout << m_tag << "VENC cleaned up" << std::endl;
+}
+
+bool MediaPipeline::rebuildEncoderChannel() {
+    unbindVpssFromVenc();
+    cleanupVENC();
+
+    // 编码尺寸由 VPSS 编码通道缩放得到（VENC 本身不缩放）
+    uint32_t inW = m_imgWidth  > 0 ? static_cast<uint32_t>(m_imgWidth)  : m_config.vi.width;
+    uint32_t inH = m_imgHeight > 0 ? static_cast<uint32_t>(m_imgHeight) : m_config.vi.height;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    resolveVpssChnSize(kVpssChnEncoder, inW, inH, width, height);
+
+    EncodeParams params = m_encoderSvc->getEncodeParams();
+    if (params.width > 0 && (params.width != width || params.height != height)) {
+        std::cerr << m_tag << "Encode size " << params.width << "x" << params.height
+                  << " conflicts with vpss.enc size " << width << "x" << height << std::endl;
+        return false;
+    }
+
+    if (width != m_vpssChnWidth[kVpssChnEncoder] || height != m_vpssChnHeight[kVpssChnEncoder]) {
+        if (!resizeVpssChn(kVpssChnEncoder, width, height)) {
+            return false;
+        }
+    }
+
+    if (!initializeVENC(width, height)) {
+        return false;
+    }
+    return bindVpssToVenc();
+}
+
+bool MediaPipeline::resizeVpssChn(int chn, uint32_t width, uint32_t height) {
+    uint32_t inW = m_imgWidth  > 0 ? static_cast<uint32_t>(m_imgWidth)  : m_config.vi.width;
+    uint32_t inH = m_imgHeight > 0 ? static_cast<uint32_t>(m_imgHeight) : m_config.vi.height;
+    if (width == 0 || height == 0 || (width & 1) || (height & 1) ||
+        width > kVpssMaxOutputSize || height > kVpssMaxOutputSize ||
+        width * kVpssMaxScaleDown < inW || height * kVpssMaxScaleDown < inH ||
+        width > inW * kVpssMaxScaleUp || height > inH * kVpssMaxScaleUp) {
+        std::cerr << m_tag << "VPSS channel " << chn << " size " << width << "x" << height
+                  << " is out of scaler range for input " << inW << "x" << inH << std::endl;
+        return false;
+    }
+
+    VPSS_CHN_ATTR_S stChnAttr;
+    memset(&stChnAttr, 0, sizeof(VPSS_CHN_ATTR_S));
+    RK_S32 s32Ret = RK_MPI_VPSS_GetChnAttr(m_vpssGrpId, chn, &stChnAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to get VPSS channel " << chn << ": " << s32Ret << std::endl;
+        return false;
+    }
+    VPSS_CHN_ATTR_S stOldAttr = stChnAttr;
+
+    bool decimate = stChnAttr.stFrameRate.s32DstFrameRate > 0 &&
+                    stChnAttr.stFrameRate.s32DstFrameRate < stChnAttr.stFrameRate.s32SrcFrameRate;
+    bool passthrough = (width == inW && height == inH &&
+                        stChnAttr.enPixelFormat == RK_FMT_YUV420SP && !decimate);
+    stChnAttr.enChnMode = passthrough ? VPSS_CHN_MODE_PASSTHROUGH : VPSS_CHN_MODE_USER;
+    stChnAttr.u32Width = width;
+    stChnAttr.u32Height = height;
+
+    // 只停这一个通道，VPSS 组和其他通道继续出帧
+    RK_MPI_VPSS_DisableChn(m_vpssGrpId, chn);
+    s32Ret = RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, chn, &stChnAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to resize VPSS channel " << chn << ": " << s32Ret << std::endl;
+        RK_MPI_VPSS_SetChnAttr(m_vpssGrpId, chn, &stOldAttr);
+        RK_MPI_VPSS_EnableChn(m_vpssGrpId, chn);
+        return false;
+    }
+    RK_MPI_VPSS_EnableChn(m_vpssGrpId, chn);
+
+    m_vpssChnWidth[chn] = width;
+    m_vpssChnHeight[chn] = height;
+    std::cout << m_tag << "VPSS channel " << chn << " resized to " << width << "x" << height
+              << (passthrough ? " (passthrough)" : " (scaled)") << std::endl;
+    return true;
+}
+
+bool MediaPipeline::initializeVO() {
+    if (m_voInitialized) {
+        return true;
+    }
+
+    // VO 设备和视频层按 layerId 共享，第一路流水线使用时才真正打开
+    uint32_t layerW = 0;
+    uint32_t layerH = 0;
+    if (!m_owner.acquireVoLayer(m_config.vo, layerW, layerH)) {
+        std::cerr << m_tag << "Failed to acquire VO layer " << m_voLayerId << std::endl;
+        return false;
+    }
+
+    // 通道显示区域，未指定时铺满视频层
+    VO_CHN_ATTR_S stChnAttr;
+    memset(&stChnAttr, 0, sizeof(VO_CHN_ATTR_S));
+    stChnAttr.stRect.s32X = m_config.vo.chnRectX;
+    stChnAttr.stRect.s32Y = m_config.vo.chnRectY;
+    stChnAttr.stRect.u32Width = m_config.vo.chnRectWidth > 0 ? m_config.vo.chnRectWidth : layerW;
+    stChnAttr.stRect.u32Height = m_config.vo.chnRectHeight > 0 ? m_config.vo.chnRectHeight : layerH;
+    stChnAttr.u32FgAlpha = 255;
+    stChnAttr.u32BgAlpha = 0;
+    RK_S32 s32Ret = RK_MPI_VO_SetChnAttr(m_voLayerId, m_voChnId, &stChnAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << m_tag << "Failed to set VO channel attr: " << s32Ret << std::endl;
+        m_owner.releaseVoLayer(m_config.vo);
+        return false;
+    }
+
+    m_voInitialized = true;
+    std::cout << m_tag << "VO initialized" << std::endl;
+    return true;
+}
+
+void MediaPipeline::cleanupVO() {
+    if (!m_voInitialized) {
+        return;
+    }
+
+    m_owner.releaseVoLayer(m_config.vo);
+    m_voInitialized = false;
+    std::cout << m_tag << "VO cleaned up" << std::endl;
+}
@@ -0,0 +1,361 @@
+#include "MetricsRegistry.h"
+#include <cstdio>
+
+namespace {
+
+void appendLine(std::string& out, const std::string& name, const std::string& labels, const char* value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+std::string joinLabels(const std::string& labels, const std::string& extra) {
+    return labels.empty() ? extra : labels + "," + extra;
+}
+
+std::string formatSeconds(uint64_t us) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6g", us / 1e6);
+    return buf;
+}
+
+const char* typeName(int type) {
+    switch (type) {
+    case 0: return "counter";
+    case 1: return "gauge";
+    default: return "histogram";
+    }
+}
+
+}  // namespace
+
+// ==================== 指标 ====================
+
+unsigned Metric::shardIndex() {
+    static std::atomic<unsigned> next(0);
+    static thread_local unsigned index = next.fetch_add(1) % kShards;
+    return index;
+}
+
+MetricCounter::MetricCounter() {
+    for (unsigned i = 0; i < kShards; i++) {
+        m_shards[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t MetricCounter::value() const {
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < kShards; i++) {
+        sum += m_shards[i].value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void MetricCounter::render(std::string& out, const std::string& name, const std::string& labels) const {
+    appendLine(out, name, labels, std::to_string(value()).c_str());
+}
+
+void MetricGauge::render(std::string& out, const std::string& name, const std::string& labels) const {
+    appendLine(out, name, labels, std::to_string(value()).c_str());
+}
+
+const std::vector<uint64_t>& MetricHistogram::defaultBounds() {
+    static const std::vector<uint64_t> bounds = {
+        50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000,
+    };
+    return bounds;
+}
+
+MetricHistogram::MetricHistogram(const std::vector<uint64_t>& boundsUs) {
+    const std::vector<uint64_t>& bounds = boundsUs.empty() ? defaultBounds() : boundsUs;
+    m_boundCount = bounds.size() < kMaxBuckets ? bounds.size() : kMaxBuckets;
+    for (size_t i = 0; i < m_boundCount; i++) {
+        m_bounds[i] = bounds[i];
+    }
+    for (unsigned s = 0; s < kShards; s++) {
+        for (size_t i = 0; i <= kMaxBuckets; i++) {
+            m_shards[s].buckets[i].store(0, std::memory_order_relaxed);
+        }
+        m_shards[s].sum.store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::observe(uint64_t us) {
+    size_t bucket = 0;
+    while (bucket < m_boundCount && us > m_bounds[bucket]) {
+        bucket++;
+    }
+    Shard& shard = m_shards[shardIndex()];
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(us, std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::count() const {
+    uint64_t total = 0;
+    for (unsigned s = 0; s < kShards; s++) {
+        for (size_t i = 0; i <= m_boundCount; i++) {
+            total += m_shards[s].buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+uint64_t MetricHistogram::sumUs() const {
+    uint64_t sum = 0;
+    for (unsigned s = 0; s < kShards; s++) {
+        sum += m_shards[s].sum.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void MetricHistogram::render(std::string& out, const std::string& name, const std::string& labels) const {
+    uint64_t counts[kMaxBuckets + 1] = {};
+    uint64_t sum = 0;
+    for (unsigned s = 0; s < kShards; s++) {
+        for (size_t i = 0; i <= m_boundCount; i++) {
+            counts[i] += m_shards[s].buckets[i].load(std::memory_order_relaxed);
+        }
+        sum += m_shards[s].sum.load(std::memory_order_relaxed);
+    }
+
+    // 桶计数按 Prometheus 约定累计输出
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= m_boundCount; i++) {
+        cumulative += counts[i];
+        std::string le = i < m_boundCount ? formatSeconds(m_bounds[i]) : "+Inf";
+        appendLine(out, name + "_bucket", joinLabels(labels, "le=\"" + le + "\""),
+                   std::to_string(cumulative).c_str());
+    }
+    appendLine(out, name + "_sum", labels, formatSeconds(sum).c_str());
+    appendLine(out, name + "_count", labels, std::to_string(cumulative).c_str());
+}
+
+// ==================== MetricsWriter ====================
+
+void MetricsWriter::counter(const std::string& name, const std::string& help, const MetricLabels& labels,
+                            uint64_t value) {
+    Sample s = { name, help, true, MetricsRegistry::formatLabels(labels), static_cast<double>(value) };
+    m_samples.push_back(s);
+}
+
+void MetricsWriter::gauge(const std::string& name, const std::string& help, const MetricLabels& labels,
+                          double value) {
+    Sample s = { name, help, false, MetricsRegistry::formatLabels(labels), value };
+    m_samples.push_back(s);
+}
+
+// ==================== MetricsRegistry ====================
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::string MetricsRegistry::formatLabels(const MetricLabels& labels) {
+    std::string out;
+    for (size_t i = 0; i < labels.size(); i++) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += labels[i].first;
+        out += "=\"";
+        const std::string& v = labels[i].second;
+        for (size_t j = 0; j < v.size(); j++) {
+            if (v[j] == '"' || v[j] == '\\') {
+                out += '\\';
+                out += v[j];
+            } else if (v[j] == '\n') {
+                out += "\\n";
+            } else {
+                out += v[j];
+            }
+        }
+        out += '"';
+    }
+    return out;
+}
+
+MetricsRegistry::Family* MetricsRegistry::family(const std::string& name, const std::string& help, Type type) {
+    std::map<std::string, Family>::iterator it = m_families.find(name);
+    if (it == m_families.end()) {
+        Family f;
+        f.help = help;
+        f.type = type;
+        it = m_families.insert(std::make_pair(name, f)).first;
+    }
+    return it->second.type == type ? &it->second : nullptr;
+}
+
+std::shared_ptr<Metric> MetricsRegistry::findSeries(Family& family, const std::string& labels) {
+    std::shared_ptr<Metric> found;
+    std::vector<Series>::iterator it = family.series.begin();
+    while (it != family.series.end()) {
+        std::shared_ptr<Metric> metric = it->metric.lock();
+        if (!metric) {
+            it = family.series.erase(it);
+            continue;
+        }
+        if (it->labels == labels) {
+            found = metric;
+        }
+        ++it;
+    }
+    return found;
+}
+
+std::shared_ptr<MetricCounter> MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                                        const MetricLabels& labels) {
+    std::string text = formatLabels(labels);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family* f = family(name, help, kCounter);
+    if (!f) {
+        // 同名不同类型：返回不注册的对象，调用方照常计数但不会输出
+        return std::make_shared<MetricCounter>();
+    }
+    std::shared_ptr<Metric> existing = findSeries(*f, text);
+    if (existing) {
+        return std::static_pointer_cast<MetricCounter>(existing);
+    }
+    std::shared_ptr<MetricCounter> metric = std::make_shared<MetricCounter>();
+    Series s = { text, metric };
+    f->series.push_back(s);
+    return metric;
+}
+
+std::shared_ptr<MetricGauge> MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                                                    const MetricLabels& labels) {
+    std::string text = formatLabels(labels);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family* f = family(name, help, kGauge);
+    if (!f) {
+        return std::make_shared<MetricGauge>();
+    }
+    std::shared_ptr<Metric> existing = findSeries(*f, text);
+    if (existing) {
+        return std::static_pointer_cast<MetricGauge>(existing);
+    }
+    std::shared_ptr<MetricGauge> metric = std::make_shared<MetricGauge>();
+    Series s = { text, metric };
+    f->series.push_back(s);
+    return metric;
+}
+
+std::shared_ptr<MetricHistogram> MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                                            const MetricLabels& labels,
+                                                            const std::vector<uint64_t>& boundsUs) {
+    std::string text = formatLabels(labels);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family* f = family(name, help, kHistogram);
+    if (!f) {
+        return std::make_shared<MetricHistogram>(boundsUs);
+    }
+    std::shared_ptr<Metric> existing = findSeries(*f, text);
+    if (existing) {
+        return std::static_pointer_cast<MetricHistogram>(existing);
+    }
+    std::shared_ptr<MetricHistogram> metric = std::make_shared<MetricHistogram>(boundsUs);
+    Series s = { text, metric };
+    f->series.push_back(s);
+    return metric;
+}
+
+int MetricsRegistry::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int id = m_nextCollectorId++;
+    m_collectors[id] = std::move(collector);
+    return id;
+}
+
+void MetricsRegistry::removeCollector(int id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_collectors.erase(id);
+}
+
+int MetricsRegistry::acquireInstance(const std::string& service) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<bool>& used = m_instances[service];
+    for (size_t i = 0; i < used.size(); i++) {
+        if (!used[i]) {
+            used[i] = true;
+            return static_cast<int>(i);
+        }
+    }
+    used.push_back(true);
+    return static_cast<int>(used.size() - 1);
+}
+
+void MetricsRegistry::releaseInstance(const std::string& service, int instance) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<bool>& used = m_instances[service];
+    if (instance >= 0 && static_cast<size_t>(instance) < used.size()) {
+        used[instance] = false;
+    }
+}
+
+std::string MetricsRegistry::render() {
+    // 按指标名汇总：注册对象与 collector 样本同名时合并为一组（只输出一次 HELP/TYPE）
+    struct Group {
+        std::string help;
+        int type;
+        std::string lines;
+    };
+    std::map<std::string, Group> groups;
+
+    // 持锁期间 collector 不会被移除，它捕获的对象保持有效
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::map<std::string, Family>::iterator it = m_families.begin(); it != m_families.end(); ++it) {
+        Family& f = it->second;
+        Group& g = groups[it->first];
+        g.help = f.help;
+        g.type = f.type;
+        std::vector<Series>::iterator s = f.series.begin();
+        while (s != f.series.end()) {
+            std::shared_ptr<Metric> metric = s->metric.lock();
+            if (!metric) {
+                s = f.series.erase(s);
+                continue;
+            }
+            metric->render(g.lines, it->first, s->labels);
+            ++s;
+        }
+    }
+
+    MetricsWriter writer;
+    for (std::map<int, Collector>::iterator it = m_collectors.begin(); it != m_collectors.end(); ++it) {
+        it->second(writer);
+    }
+    char value[32];
+    for (size_t i = 0; i < writer.m_samples.size(); i++) {
+        const MetricsWriter::Sample& sample = writer.m_samples[i];
+        std::map<std::string, Group>::iterator it = groups.find(sample.name);
+        if (it == groups.end()) {
+            Group g;
+            g.help = sample.help;
+            g.type = sample.isCounter ? kCounter : kGauge;
+            it = groups.insert(std::make_pair(sample.name, g)).first;
+        }
+        if (sample.isCounter) {
+            snprintf(value, sizeof(value), "%.0f", sample.value);
+        } else {
+            snprintf(value, sizeof(value), "%.15g", sample.value);
+        }
+        appendLine(it->second.lines, sample.name, sample.labels, value);
+    }
+
+    std::string out;
+    for (std::map<std::string, Group>::iterator it = groups.begin(); it != groups.end(); ++it) {
+        if (it->second.lines.empty()) {
+            continue;
+        }
+        out += "# HELP " + it->first + " " + it->second.help + "\n";
+        out += "# TYPE " + it->first + " " + typeName(it->second.type) + "\n";
+        out += it->second.lines;
+    }
+    return out;
+}
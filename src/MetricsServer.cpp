@@ -0,0 +1,372 @@
+#include "MetricsServer.h"
+#include "MetricsRegistry.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// epoll 事件标识（连接 socket 直接以 fd 标识）
+const int kTagTcp = -1;
+const int kTagUnix = -2;
+
+const size_t kMaxRequestBytes = 8 * 1024;
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+bool addToPoll(int pollFd, int fd, int tag) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = tag;
+    return epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(const MetricsServerConfig& config)
+    : ServiceBase("MetricsServer"), m_config(config) {
+    setThreadAttr(ThreadAttr::background());
+    memset(&m_stats, 0, sizeof(m_stats));
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_scrapeMetric = registry.counter("media_metrics_scrapes_total", "Successful metrics scrapes",
+                                      metricLabels());
+    m_renderMetric = registry.histogram("media_metrics_render_duration_seconds",
+                                        "Time spent rendering the metrics page", metricLabels());
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+    join();
+    closeSockets();
+}
+
+bool MetricsServer::open() {
+    if (m_pollFd >= 0) {
+        return true;
+    }
+    if (m_config.unixPath.empty() && m_config.tcpPort == 0) {
+        std::cerr << "[" << m_name << "] Neither unix socket nor TCP port configured" << std::endl;
+        return false;
+    }
+
+    m_pollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_pollFd < 0) {
+        std::cerr << "[" << m_name << "] epoll_create1 failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (!m_config.unixPath.empty()) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (m_config.unixPath.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "[" << m_name << "] Unix socket path too long: " << m_config.unixPath << std::endl;
+            closeSockets();
+            return false;
+        }
+        memcpy(addr.sun_path, m_config.unixPath.c_str(), m_config.unixPath.size());
+        unlink(m_config.unixPath.c_str());  // 上次异常退出留下的文件
+
+        m_unixFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_unixFd < 0 || bind(m_unixFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(m_unixFd, 16) != 0 || !addToPoll(m_pollFd, m_unixFd, kTagUnix)) {
+            std::cerr << "[" << m_name << "] Failed to listen on " << m_config.unixPath << ": "
+                      << strerror(errno) << std::endl;
+            closeSockets();
+            return false;
+        }
+    }
+
+    if (m_config.tcpPort != 0) {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(m_config.tcpPort);
+        if (inet_pton(AF_INET, m_config.bindAddress.c_str(), &addr.sin_addr) != 1) {
+            std::cerr << "[" << m_name << "] Invalid bind address: " << m_config.bindAddress << std::endl;
+            closeSockets();
+            return false;
+        }
+
+        m_tcpFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(m_tcpFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (m_tcpFd < 0 || bind(m_tcpFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(m_tcpFd, 16) != 0 || !addToPoll(m_pollFd, m_tcpFd, kTagTcp)) {
+            std::cerr << "[" << m_name << "] Failed to listen on " << m_config.bindAddress << ":"
+                      << m_config.tcpPort << ": " << strerror(errno) << std::endl;
+            closeSockets();
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(m_tcpFd, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+    }
+
+    std::cout << "[" << m_name << "] Serving /metrics on";
+    if (m_unixFd >= 0) {
+        std::cout << " unix:" << m_config.unixPath;
+    }
+    if (m_tcpFd >= 0) {
+        std::cout << " http://" << m_config.bindAddress << ":" << m_port;
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+MetricsServer::Stats MetricsServer::stats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void MetricsServer::run() {
+    if (m_pollFd < 0 && !open()) {
+        std::cerr << "[" << m_name << "] Not started: sockets unavailable" << std::endl;
+        return;
+    }
+    setChannelFd(m_pollFd);
+    m_lastExpireCheck = std::chrono::steady_clock::now();
+
+    while (m_running.load()) {
+        int events = waitEvents(1000);
+        if (events & WAIT_TASK) {
+            processTasks();
+        }
+        if (events & WAIT_CHANNEL) {
+            handleSocketEvents();
+        }
+        expireConnections();
+    }
+
+    closeAll();
+}
+
+void MetricsServer::handleSocketEvents() {
+    struct epoll_event events[32];
+    int n = epoll_wait(m_pollFd, events, 32, 0);
+    for (int i = 0; i < n; i++) {
+        int tag = events[i].data.fd;
+        if (tag == kTagTcp) {
+            acceptConnections(m_tcpFd);
+            continue;
+        }
+        if (tag == kTagUnix) {
+            acceptConnections(m_unixFd);
+            continue;
+        }
+        std::map<int, Connection>::iterator it = m_connections.find(tag);
+        if (it == m_connections.end()) {
+            continue;
+        }
+        if (it->second.output.empty()) {
+            readConnection(it->second);
+        } else {
+            writeConnection(it->second);
+        }
+    }
+}
+
+void MetricsServer::acceptConnections(int listenFd) {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "[" << m_name << "] accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        if (m_connections.size() >= m_config.maxConnections || !addToPoll(m_pollFd, fd, fd)) {
+            close(fd);
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.rejected++;
+            continue;
+        }
+
+        Connection& conn = m_connections[fd];
+        conn.fd = fd;
+        conn.input.clear();
+        conn.output.clear();
+        conn.sent = 0;
+        conn.accepted = std::chrono::steady_clock::now();
+    }
+}
+
+void MetricsServer::readConnection(Connection& conn) {
+    int fd = conn.fd;
+    char buf[2048];
+    while (true) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            conn.input.append(buf, static_cast<size_t>(n));
+            if (conn.input.size() > kMaxRequestBytes) {
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        closeConnection(fd);  // 对端关闭或出错
+        return;
+    }
+
+    size_t end = conn.input.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        end = conn.input.find("\n\n");  // 手工输入（nc 等）只有 LF
+    }
+    if (end == std::string::npos && conn.input.size() <= kMaxRequestBytes) {
+        return;  // 请求头未收完
+    }
+    if (end == std::string::npos || !handleRequest(conn, conn.input.substr(0, end))) {
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.badRequests++;
+        }
+        respond(conn, 400, "Bad Request", "bad request\n", false);
+    }
+    writeConnection(conn);
+}
+
+bool MetricsServer::handleRequest(Connection& conn, const std::string& head) {
+    // 只看请求行：<方法> <路径> HTTP/1.x，请求体与其他头部忽略
+    std::string line = head.substr(0, head.find_first_of("\r\n"));
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string::npos ? std::string::npos : line.find(' ', sp1 + 1);
+    if (sp2 == std::string::npos || line.compare(sp2 + 1, 5, "HTTP/") != 0) {
+        return false;
+    }
+    std::string method = line.substr(0, sp1);
+    std::string path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (path != "/metrics" && path != "/") {
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.notFound++;
+        }
+        respond(conn, 404, "Not Found", "not found\n", method == "HEAD");
+        return true;
+    }
+    if (method != "GET" && method != "HEAD") {
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.notFound++;
+        }
+        respond(conn, 405, "Method Not Allowed", "method not allowed\n", false);
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string body = MetricsRegistry::instance().render();
+    uint64_t renderUs = elapsedUs(start);
+    m_renderMetric->observe(renderUs);
+    m_scrapeMetric->inc();
+    respond(conn, 200, "OK", body, method == "HEAD");
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.scrapes++;
+    m_stats.lastRenderUs = renderUs;
+    m_stats.lastResponseBytes = body.size();
+    return true;
+}
+
+void MetricsServer::respond(Connection& conn, int code, const char* reason, const std::string& body,
+                            bool headOnly) {
+    conn.output = "HTTP/1.0 " + std::to_string(code) + " " + reason + "\r\n";
+    if (code == 200) {
+        conn.output += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+    } else {
+        conn.output += "Content-Type: text/plain; charset=utf-8\r\n";
+    }
+    conn.output += "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    if (!headOnly) {
+        conn.output += body;
+    }
+    conn.sent = 0;
+
+    // 之后只等待可写
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLOUT;
+    ev.data.fd = conn.fd;
+    epoll_ctl(m_pollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void MetricsServer::writeConnection(Connection& conn) {
+    while (conn.sent < conn.output.size()) {
+        ssize_t n = send(conn.fd, conn.output.data() + conn.sent, conn.output.size() - conn.sent,
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;  // 发送缓冲满，等待可写
+        }
+        break;
+    }
+    closeConnection(conn.fd);
+}
+
+void MetricsServer::closeConnection(int fd) {
+    epoll_ctl(m_pollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_connections.erase(fd);
+}
+
+void MetricsServer::expireConnections() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - m_lastExpireCheck < std::chrono::seconds(1)) {
+        return;
+    }
+    m_lastExpireCheck = now;
+
+    std::vector<int> expired;
+    for (std::map<int, Connection>::iterator it = m_connections.begin(); it != m_connections.end(); ++it) {
+        if (now - it->second.accepted > std::chrono::milliseconds(m_config.requestTimeoutMs)) {
+            expired.push_back(it->first);
+        }
+    }
+    for (size_t i = 0; i < expired.size(); i++) {
+        closeConnection(expired[i]);
+    }
+    if (!expired.empty()) {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.timeouts += expired.size();
+    }
+}
+
+void MetricsServer::closeAll() {
+    while (!m_connections.empty()) {
+        closeConnection(m_connections.begin()->first);
+    }
+}
+
+void MetricsServer::closeSockets() {
+    if (m_unixFd >= 0) {
+        unlink(m_config.unixPath.c_str());
+    }
+    int* fds[] = { &m_tcpFd, &m_unixFd, &m_pollFd };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (*fds[i] >= 0) {
+            close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+}
@@ -0,0 +1,733 @@
+#include "Mp4Muxer.h"
+#include "AnnexB.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t kTimescale = 90000;  // 视频轨时间刻度
+const uint32_t kTrackId = 1;
+
+// trun 样本标志：关键帧不依赖其他帧；非关键帧依赖其他帧且不是同步样本
+const uint32_t kSyncSampleFlags = 0x02000000;
+const uint32_t kNonSyncSampleFlags = 0x01010000;
+
+// H264 NAL 类型
+const int kH264NalSps = 7;
+const int kH264NalPps = 8;
+const int kH264NalAud = 9;
+// H265 NAL 类型
+const int kH265NalVps = 32;
+const int kH265NalSps = 33;
+const int kH265NalPps = 34;
+const int kH265NalAud = 35;
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void put8(std::vector<uint8_t>& b, uint8_t v) {
+    b.push_back(v);
+}
+
+void put16(std::vector<uint8_t>& b, uint16_t v) {
+    b.push_back(static_cast<uint8_t>(v >> 8));
+    b.push_back(static_cast<uint8_t>(v));
+}
+
+void put32(std::vector<uint8_t>& b, uint32_t v) {
+    put16(b, static_cast<uint16_t>(v >> 16));
+    put16(b, static_cast<uint16_t>(v));
+}
+
+void put64(std::vector<uint8_t>& b, uint64_t v) {
+    put32(b, static_cast<uint32_t>(v >> 32));
+    put32(b, static_cast<uint32_t>(v));
+}
+
+void putBytes(std::vector<uint8_t>& b, const uint8_t* data, size_t size) {
+    b.insert(b.end(), data, data + size);
+}
+
+void putZeros(std::vector<uint8_t>& b, size_t count) {
+    b.insert(b.end(), count, 0);
+}
+
+void write32At(std::vector<uint8_t>& b, size_t pos, uint32_t v) {
+    b[pos] = static_cast<uint8_t>(v >> 24);
+    b[pos + 1] = static_cast<uint8_t>(v >> 16);
+    b[pos + 2] = static_cast<uint8_t>(v >> 8);
+    b[pos + 3] = static_cast<uint8_t>(v);
+}
+
+/** 开始一个 box，返回其起始位置（大小在 endBox 中回填） */
+size_t beginBox(std::vector<uint8_t>& b, const char* type) {
+    size_t pos = b.size();
+    put32(b, 0);
+    putBytes(b, reinterpret_cast<const uint8_t*>(type), 4);
+    return pos;
+}
+
+size_t beginFullBox(std::vector<uint8_t>& b, const char* type, uint8_t version, uint32_t flags) {
+    size_t pos = beginBox(b, type);
+    put32(b, (static_cast<uint32_t>(version) << 24) | (flags & 0xFFFFFF));
+    return pos;
+}
+
+void endBox(std::vector<uint8_t>& b, size_t pos) {
+    write32At(b, pos, static_cast<uint32_t>(b.size() - pos));
+}
+
+void putMatrix(std::vector<uint8_t>& b) {
+    static const uint32_t kUnity[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+    for (int i = 0; i < 9; i++) {
+        put32(b, kUnity[i]);
+    }
+}
+
+/** 去掉防竞争字节（00 00 03），只取前 maxBytes 个 RBSP 字节 */
+size_t unescapeRbsp(const uint8_t* p, size_t size, uint8_t* out, size_t maxBytes) {
+    size_t n = 0;
+    int zeros = 0;
+    for (size_t i = 0; i < size && n < maxBytes; i++) {
+        if (zeros >= 2 && p[i] == 3) {
+            zeros = 0;
+            continue;
+        }
+        zeros = (p[i] == 0) ? zeros + 1 : 0;
+        out[n++] = p[i];
+    }
+    return n;
+}
+
+void putAvcC(std::vector<uint8_t>& b, const std::vector<uint8_t>& sps, const std::vector<uint8_t>& pps) {
+    size_t box = beginBox(b, "avcC");
+    uint8_t profile = sps[1];
+    put8(b, 1);              // configurationVersion
+    put8(b, profile);
+    put8(b, sps[2]);         // profile_compatibility
+    put8(b, sps[3]);         // level
+    put8(b, 0xFF);           // lengthSizeMinusOne = 3
+    put8(b, 0xE1);           // 1 个 SPS
+    put16(b, static_cast<uint16_t>(sps.size()));
+    putBytes(b, sps.data(), sps.size());
+    put8(b, 1);              // 1 个 PPS
+    put16(b, static_cast<uint16_t>(pps.size()));
+    putBytes(b, pps.data(), pps.size());
+    if (profile == 100 || profile == 110 || profile == 122 || profile == 244) {
+        // High 系列的扩展字段：VENC 输入为 NV12，固定 4:2:0 8bit
+        put8(b, 0xFC | 1);   // chroma_format_idc
+        put8(b, 0xF8 | 0);   // bit_depth_luma_minus8
+        put8(b, 0xF8 | 0);   // bit_depth_chroma_minus8
+        put8(b, 0);          // numOfSequenceParameterSetExt
+    }
+    endBox(b, box);
+}
+
+void putHvcC(std::vector<uint8_t>& b, const std::vector<uint8_t>& vps, const std::vector<uint8_t>& sps,
+             const std::vector<uint8_t>& pps) {
+    // SPS（去掉 2 字节 NAL 头）：vps_id(4) max_sub_layers_minus1(3) temporal_id_nesting(1)，
+    // 之后是 12 字节 general profile_tier_level
+    uint8_t rbsp[13] = { 0 };
+    size_t n = sps.size() > 2 ? unescapeRbsp(sps.data() + 2, sps.size() - 2, rbsp, sizeof(rbsp)) : 0;
+    uint8_t maxSubLayersMinus1 = 0;
+    bool nested = true;
+    if (n < sizeof(rbsp)) {
+        memset(rbsp, 0, sizeof(rbsp));
+    } else {
+        maxSubLayersMinus1 = (rbsp[0] >> 1) & 0x07;
+        nested = (rbsp[0] & 0x01) != 0;
+    }
+    const uint8_t* ptl = rbsp + 1;
+
+    size_t box = beginBox(b, "hvcC");
+    put8(b, 1);                  // configurationVersion
+    put8(b, ptl[0]);             // profile_space / tier / profile_idc
+    putBytes(b, ptl + 1, 4);     // profile_compatibility_flags
+    putBytes(b, ptl + 5, 6);     // constraint_indicator_flags
+    put8(b, ptl[11]);            // level_idc
+    put16(b, 0xF000);            // min_spatial_segmentation_idc = 0
+    put8(b, 0xFC);               // parallelismType = 0
+    put8(b, 0xFC | 1);           // chroma_format_idc = 4:2:0
+    put8(b, 0xF8 | 0);           // bit_depth_luma_minus8
+    put8(b, 0xF8 | 0);           // bit_depth_chroma_minus8
+    put16(b, 0);                 // avgFrameRate
+    put8(b, static_cast<uint8_t>(((maxSubLayersMinus1 + 1) & 0x07) << 3 | (nested ? 1 : 0) << 2 | 3));
+
+    const std::vector<uint8_t>* sets[3] = { &vps, &sps, &pps };
+    const int types[3] = { kH265NalVps, kH265NalSps, kH265NalPps };
+    put8(b, 3);                  // numOfArrays
+    for (int i = 0; i < 3; i++) {
+        put8(b, static_cast<uint8_t>(0x80 | types[i]));  // array_completeness = 1
+        put16(b, 1);
+        put16(b, static_cast<uint16_t>(sets[i]->size()));
+        putBytes(b, sets[i]->data(), sets[i]->size());
+    }
+    endBox(b, box);
+}
+
+/** 文件所在目录（fsync 目录项用） */
+std::string dirName(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+}  // namespace
+
+Mp4Muxer::Mp4Muxer(const Mp4MuxerConfig& config, std::shared_ptr<PacketBufferPool> pool)
+    : m_config(config),
+      m_pool(pool ? pool : PacketBufferPool::shared()) {
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+Mp4Muxer::~Mp4Muxer() {
+    close();
+}
+
+bool Mp4Muxer::open() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd >= 0) {
+        return true;
+    }
+    if (m_config.path.empty()) {
+        std::cerr << "[Mp4Muxer] Output path is empty" << std::endl;
+        return false;
+    }
+    m_fileIndex = 0;
+    return openFile();
+}
+
+bool Mp4Muxer::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) {
+        return true;
+    }
+    bool ok = flushFragment(0);
+    closeFile();
+    return ok;
+}
+
+bool Mp4Muxer::isOpen() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fd >= 0;
+}
+
+std::string Mp4Muxer::currentPath() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_path;
+}
+
+Mp4Muxer::Stats Mp4Muxer::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string Mp4Muxer::pathForIndex(uint64_t index) const {
+    if (index == 0) {
+        return m_config.path;
+    }
+    // rec.mp4 -> rec_1.mp4
+    std::string suffix = "_" + std::to_string(index);
+    size_t dot = m_config.path.rfind('.');
+    size_t slash = m_config.path.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return m_config.path + suffix;
+    }
+    return m_config.path.substr(0, dot) + suffix + m_config.path.substr(dot);
+}
+
+bool Mp4Muxer::openFile() {
+    m_path = pathForIndex(m_fileIndex);
+    m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        std::cerr << "[Mp4Muxer] Failed to open " << m_path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    m_offset = 0;
+    m_allocated = 0;
+    m_cachedFrom = 0;
+    m_preallocate = m_config.preallocateBytes > 0;
+    m_initWritten = false;
+    m_stats.files++;
+    return true;
+}
+
+void Mp4Muxer::closeFile() {
+    if (m_fd < 0) {
+        return;
+    }
+    if (m_allocated > m_offset) {
+        // 释放 KEEP_SIZE 预分配的尾部空间
+        if (ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0) {
+            std::cerr << "[Mp4Muxer] ftruncate failed: " << strerror(errno) << std::endl;
+        }
+    }
+    fdatasync(m_fd);
+    ::close(m_fd);
+    m_fd = -1;
+    m_initWritten = false;
+    m_samples.clear();
+    m_nals.clear();
+    m_pendingBytes = 0;
+}
+
+void Mp4Muxer::parseFrame(const EncodedFrame& frame) {
+    m_frameNals.clear();
+    m_frameVps.clear();
+    m_frameSps.clear();
+    m_framePps.clear();
+
+    forEachNal(frame, [this, &frame](const uint8_t* nal, size_t nalSize) {
+        int type = nalUnitType(nal, frame.isH265);
+        if (frame.isH265) {
+            if (type == kH265NalVps) {
+                m_frameVps.assign(nal, nal + nalSize);
+                return;
+            }
+            if (type == kH265NalSps) {
+                m_frameSps.assign(nal, nal + nalSize);
+                return;
+            }
+            if (type == kH265NalPps) {
+                m_framePps.assign(nal, nal + nalSize);
+                return;
+            }
+            if (type == kH265NalAud) {
+                return;
+            }
+        } else {
+            if (type == kH264NalSps) {
+                if (nalSize >= 4) {
+                    m_frameSps.assign(nal, nal + nalSize);
+                }
+                return;
+            }
+            if (type == kH264NalPps) {
+                m_framePps.assign(nal, nal + nalSize);
+                return;
+            }
+            if (type == kH264NalAud) {
+                return;
+            }
+        }
+
+        Nal entry;
+        entry.data = nal;
+        entry.size = static_cast<uint32_t>(nalSize);
+        m_frameNals.push_back(entry);
+    });
+}
+
+bool Mp4Muxer::parameterSetsChanged(const EncodedFrame& frame) const {
+    return frame.isH265 != m_isH265 || frame.width != m_width || frame.height != m_height ||
+           m_frameSps != m_sps || m_framePps != m_pps || m_frameVps != m_vps;
+}
+
+uint64_t Mp4Muxer::toDts(uint64_t timestamp) const {
+    if (timestamp <= m_startTimestamp) {
+        return 0;
+    }
+    return (timestamp - m_startTimestamp) * kTimescale / 1000000;
+}
+
+bool Mp4Muxer::writeFrame(const EncodedFrame& frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) {
+        return false;
+    }
+    if (frame.size == 0 || frame.segmentCount == 0) {
+        return true;
+    }
+
+    // 帧要在分片缓冲中停留到下一个关键帧，零拷贝帧先转存到缓冲池
+    EncodedFrame stored = frame.zeroCopy ? copyEncodedFrame(frame, *m_pool) : frame;
+    if (stored.size == 0) {
+        m_stats.droppedFrames++;
+        return false;
+    }
+    parseFrame(stored);
+
+    bool hasParameterSets = !m_frameSps.empty() && !m_framePps.empty() &&
+                            (!stored.isH265 || !m_frameVps.empty());
+    if (stored.isKeyFrame && hasParameterSets && (!m_initWritten || parameterSetsChanged(stored))) {
+        if (m_initWritten) {
+            // 参数集变化需要新的 moov：结束当前文件，从这个关键帧开始新文件
+            flushFragment(stored.timestamp);
+            closeFile();
+            m_fileIndex++;
+            if (!openFile()) {
+                return false;
+            }
+            std::cout << "[Mp4Muxer] Parameter sets changed, continuing in " << m_path << std::endl;
+        }
+        if (!writeInit(stored)) {
+            m_stats.droppedFrames++;
+            return false;
+        }
+    }
+    if (!m_initWritten || m_frameNals.empty()) {
+        // 第一个带参数集的关键帧之前的帧无法解码
+        m_stats.droppedFrames++;
+        return true;
+    }
+
+    bool ok = true;
+    if (!m_samples.empty()) {
+        uint64_t fragmentStart = m_samples.front().frame.timestamp;
+        bool due = stored.isKeyFrame &&
+                   (stored.timestamp < fragmentStart ||
+                    stored.timestamp - fragmentStart >= static_cast<uint64_t>(m_config.minFragmentMs) * 1000);
+        bool full = m_samples.size() >= m_config.maxFragmentFrames ||
+                    m_pendingBytes + stored.size > m_config.maxFragmentBytes;
+        if (due || full) {
+            ok = flushFragment(stored.timestamp);
+        }
+    }
+
+    Sample sample;
+    sample.frame = stored;
+    sample.dts = toDts(stored.timestamp);
+    if (!m_samples.empty() && sample.dts < m_samples.back().dts) {
+        sample.dts = m_samples.back().dts;  // 时间戳回退时保持 DTS 单调
+    }
+    if (m_samples.empty() && sample.dts < m_lastDts) {
+        sample.dts = m_lastDts;
+    }
+    sample.firstNal = static_cast<uint32_t>(m_nals.size());
+    sample.nalCount = static_cast<uint32_t>(m_frameNals.size());
+    sample.size = 0;
+    for (size_t i = 0; i < m_frameNals.size(); i++) {
+        sample.size += 4 + m_frameNals[i].size;
+    }
+    m_nals.insert(m_nals.end(), m_frameNals.begin(), m_frameNals.end());
+    m_pendingBytes += sample.size;
+    m_samples.push_back(sample);
+    return ok;
+}
+
+bool Mp4Muxer::writeInit(const EncodedFrame& frame) {
+    m_isH265 = frame.isH265;
+    m_width = frame.width;
+    m_height = frame.height;
+    m_vps = m_frameVps;
+    m_sps = m_frameSps;
+    m_pps = m_framePps;
+    m_startTimestamp = frame.timestamp;
+    m_sequence = 0;
+    m_lastDts = 0;
+
+    std::vector<uint8_t>& b = m_header;
+    b.clear();
+
+    size_t ftyp = beginBox(b, "ftyp");
+    putBytes(b, reinterpret_cast<const uint8_t*>("isom"), 4);
+    put32(b, 0x200);
+    putBytes(b, reinterpret_cast<const uint8_t*>("isomiso5iso6mp41"), 16);
+    endBox(b, ftyp);
+
+    size_t moov = beginBox(b, "moov");
+
+    size_t mvhd = beginFullBox(b, "mvhd", 0, 0);
+    put32(b, 0);                 // creation_time
+    put32(b, 0);                 // modification_time
+    put32(b, 1000);              // timescale
+    put32(b, 0);                 // duration（分片文件为 0）
+    put32(b, 0x00010000);        // rate
+    put16(b, 0x0100);            // volume
+    putZeros(b, 10);
+    putMatrix(b);
+    putZeros(b, 24);             // pre_defined
+    put32(b, kTrackId + 1);      // next_track_ID
+    endBox(b, mvhd);
+
+    size_t trak = beginBox(b, "trak");
+    size_t tkhd = beginFullBox(b, "tkhd", 0, 0x000003);  // enabled | in_movie
+    put32(b, 0);
+    put32(b, 0);
+    put32(b, kTrackId);
+    put32(b, 0);
+    put32(b, 0);                 // duration
+    putZeros(b, 8);
+    put16(b, 0);                 // layer
+    put16(b, 0);                 // alternate_group
+    put16(b, 0);                 // volume
+    put16(b, 0);
+    putMatrix(b);
+    put32(b, m_width << 16);
+    put32(b, m_height << 16);
+    endBox(b, tkhd);
+
+    size_t mdia = beginBox(b, "mdia");
+    size_t mdhd = beginFullBox(b, "mdhd", 0, 0);
+    put32(b, 0);
+    put32(b, 0);
+    put32(b, kTimescale);
+    put32(b, 0);
+    put16(b, 0x55C4);            // language = "und"
+    put16(b, 0);
+    endBox(b, mdhd);
+
+    size_t hdlr = beginFullBox(b, "hdlr", 0, 0);
+    put32(b, 0);
+    putBytes(b, reinterpret_cast<const uint8_t*>("vide"), 4);
+    putZeros(b, 12);
+    putBytes(b, reinterpret_cast<const uint8_t*>("VideoHandler"), 13);  // 含结尾 '\0'
+    endBox(b, hdlr);
+
+    size_t minf = beginBox(b, "minf");
+    size_t vmhd = beginFullBox(b, "vmhd", 0, 1);
+    putZeros(b, 8);              // graphicsmode + opcolor
+    endBox(b, vmhd);
+
+    size_t dinf = beginBox(b, "dinf");
+    size_t dref = beginFullBox(b, "dref", 0, 0);
+    put32(b, 1);
+    size_t url = beginFullBox(b, "url ", 0, 1);  // 数据在本文件中
+    endBox(b, url);
+    endBox(b, dref);
+    endBox(b, dinf);
+
+    size_t stbl = beginBox(b, "stbl");
+    size_t stsd = beginFullBox(b, "stsd", 0, 0);
+    put32(b, 1);
+    size_t entry = beginBox(b, m_isH265 ? "hvc1" : "avc1");
+    putZeros(b, 6);
+    put16(b, 1);                 // data_reference_index
+    putZeros(b, 16);             // pre_defined / reserved
+    put16(b, static_cast<uint16_t>(m_width));
+    put16(b, static_cast<uint16_t>(m_height));
+    put32(b, 0x00480000);        // 72 dpi
+    put32(b, 0x00480000);
+    put32(b, 0);
+    put16(b, 1);                 // frame_count
+    putZeros(b, 32);             // compressorname
+    put16(b, 0x0018);            // depth
+    put16(b, 0xFFFF);            // pre_defined = -1
+    if (m_isH265) {
+        putHvcC(b, m_vps, m_sps, m_pps);
+    } else {
+        putAvcC(b, m_sps, m_pps);
+    }
+    endBox(b, entry);
+    endBox(b, stsd);
+
+    // 样本表为空，样本都在分片中
+    const char* emptyTables[3] = { "stts", "stsc", "stco" };
+    for (int i = 0; i < 3; i++) {
+        size_t table = beginFullBox(b, emptyTables[i], 0, 0);
+        put32(b, 0);
+        endBox(b, table);
+    }
+    size_t stsz = beginFullBox(b, "stsz", 0, 0);
+    put32(b, 0);
+    put32(b, 0);
+    endBox(b, stsz);
+    endBox(b, stbl);
+    endBox(b, minf);
+    endBox(b, mdia);
+    endBox(b, trak);
+
+    size_t mvex = beginBox(b, "mvex");
+    size_t trex = beginFullBox(b, "trex", 0, 0);
+    put32(b, kTrackId);
+    put32(b, 1);                 // default_sample_description_index
+    put32(b, 0);
+    put32(b, 0);
+    put32(b, 0);
+    endBox(b, trex);
+    endBox(b, mvex);
+    endBox(b, moov);
+
+    preallocate(b.size());
+    iovec iov;
+    iov.iov_base = b.data();
+    iov.iov_len = b.size();
+    if (!writeBuffers(&iov, 1, b.size())) {
+        return false;
+    }
+
+    // 文件头和目录项落盘后，之后每个分片只需要 fdatasync
+    if (m_config.syncFragments) {
+        fdatasync(m_fd);
+        int dirFd = ::open(dirName(m_path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+    m_initWritten = true;
+    return true;
+}
+
+bool Mp4Muxer::flushFragment(uint64_t nextTimestamp) {
+    if (m_samples.empty() || m_fd < 0) {
+        return true;
+    }
+
+    size_t count = m_samples.size();
+    uint64_t lastDts = m_samples.back().dts;
+    uint32_t lastDuration = m_lastDuration;
+    if (nextTimestamp != 0 && toDts(nextTimestamp) > lastDts) {
+        lastDuration = static_cast<uint32_t>(toDts(nextTimestamp) - lastDts);
+    }
+
+    std::vector<uint8_t>& b = m_header;
+    b.clear();
+
+    size_t moof = beginBox(b, "moof");
+    size_t mfhd = beginFullBox(b, "mfhd", 0, 0);
+    put32(b, ++m_sequence);
+    endBox(b, mfhd);
+
+    size_t traf = beginBox(b, "traf");
+    size_t tfhd = beginFullBox(b, "tfhd", 0, 0x020000);  // default-base-is-moof
+    put32(b, kTrackId);
+    endBox(b, tfhd);
+
+    size_t tfdt = beginFullBox(b, "tfdt", 1, 0);
+    put64(b, m_samples.front().dts);
+    endBox(b, tfdt);
+
+    // data-offset | sample-duration | sample-size | sample-flags
+    size_t trun = beginFullBox(b, "trun", 0, 0x000701);
+    put32(b, static_cast<uint32_t>(count));
+    size_t dataOffsetPos = b.size();
+    put32(b, 0);
+    for (size_t i = 0; i < count; i++) {
+        const Sample& s = m_samples[i];
+        uint32_t duration = lastDuration;
+        if (i + 1 < count) {
+            uint64_t delta = m_samples[i + 1].dts - s.dts;
+            duration = delta > 0 ? static_cast<uint32_t>(delta) : 1;
+            m_lastDuration = duration;
+        }
+        put32(b, duration);
+        put32(b, s.size);
+        put32(b, s.frame.isKeyFrame ? kSyncSampleFlags : kNonSyncSampleFlags);
+    }
+    endBox(b, trun);
+    endBox(b, traf);
+    endBox(b, moof);
+
+    write32At(b, dataOffsetPos, static_cast<uint32_t>(b.size() - moof + 8));
+    put32(b, static_cast<uint32_t>(8 + m_pendingBytes));
+    putBytes(b, reinterpret_cast<const uint8_t*>("mdat"), 4);
+
+    // 长度前缀 + NAL 交替，帧数据不拷贝
+    m_prefixes.resize(m_nals.size() * 4);
+    m_iov.resize(1 + m_nals.size() * 2);
+    m_iov[0].iov_base = b.data();
+    m_iov[0].iov_len = b.size();
+    for (size_t i = 0; i < m_nals.size(); i++) {
+        uint8_t* prefix = &m_prefixes[i * 4];
+        uint32_t size = m_nals[i].size;
+        prefix[0] = static_cast<uint8_t>(size >> 24);
+        prefix[1] = static_cast<uint8_t>(size >> 16);
+        prefix[2] = static_cast<uint8_t>(size >> 8);
+        prefix[3] = static_cast<uint8_t>(size);
+        m_iov[1 + i * 2].iov_base = prefix;
+        m_iov[1 + i * 2].iov_len = 4;
+        m_iov[2 + i * 2].iov_base = const_cast<uint8_t*>(m_nals[i].data);
+        m_iov[2 + i * 2].iov_len = size;
+    }
+
+    size_t total = b.size() + m_pendingBytes;
+    int64_t begin = nowUs();
+    preallocate(total);
+    bool ok = writeBuffers(m_iov.data(), m_iov.size(), total);
+    if (ok) {
+        if (m_config.syncFragments) {
+            fdatasync(m_fd);
+            if (m_config.dropCache) {
+                // 已落盘的页不会再读，丢弃以免 16 路录像占满页缓存
+                posix_fadvise(m_fd, static_cast<off_t>(m_cachedFrom),
+                              static_cast<off_t>(m_offset - m_cachedFrom), POSIX_FADV_DONTNEED);
+                m_cachedFrom = m_offset;
+            }
+        }
+        uint64_t elapsed = static_cast<uint64_t>(nowUs() - begin);
+        m_stats.fragments++;
+        m_stats.frames += count;
+        m_stats.lastFragmentUs = elapsed;
+        if (elapsed > m_stats.maxFragmentUs) {
+            m_stats.maxFragmentUs = elapsed;
+        }
+    } else {
+        m_stats.droppedFrames += count;
+    }
+
+    m_lastDts = lastDts + lastDuration;
+    m_samples.clear();
+    m_nals.clear();
+    m_pendingBytes = 0;
+    return ok;
+}
+
+void Mp4Muxer::preallocate(size_t bytes) {
+    if (!m_preallocate || m_offset + bytes <= m_allocated) {
+        return;
+    }
+    // 按步长预分配，多路同时写入时文件在盘上保持连续，也减少每次写入的块分配
+    uint64_t length = m_config.preallocateBytes;
+    while (m_allocated + length < m_offset + bytes) {
+        length += m_config.preallocateBytes;
+    }
+    if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_allocated),
+                  static_cast<off_t>(length)) == 0) {
+        m_allocated += length;
+    } else if (errno == EOPNOTSUPP || errno == ENOSYS) {
+        m_preallocate = false;
+    }
+}
+
+bool Mp4Muxer::writeBuffers(iovec* iov, size_t count, size_t total) {
+    uint64_t offset = m_offset;
+    size_t index = 0;
+    while (index < count) {
+        if (iov[index].iov_len == 0) {
+            index++;
+            continue;
+        }
+        int batch = static_cast<int>(count - index < IOV_MAX ? count - index : IOV_MAX);
+        ssize_t n = pwritev(m_fd, iov + index, batch, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[Mp4Muxer] Write to " << m_path << " failed: " << strerror(errno) << std::endl;
+            m_stats.writeErrors++;
+            // 截掉写了一半的 box，后续分片仍接在完整的分片之后
+            if (ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0) {
+                std::cerr << "[Mp4Muxer] ftruncate failed: " << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+        offset += static_cast<uint64_t>(n);
+
+        // 跳过已写完的 iovec，部分写入的调整起点
+        size_t done = static_cast<size_t>(n);
+        while (done > 0 && index < count) {
+            if (done >= iov[index].iov_len) {
+                done -= iov[index].iov_len;
+                index++;
+            } else {
+                iov[index].iov_base = static_cast<uint8_t*>(iov[index].iov_base) + done;
+                iov[index].iov_len -= done;
+                done = 0;
+            }
+        }
+    }
+
+    m_offset += total;
+    m_stats.bytes += total;
+    return true;
+}
@@ -0,0 +1,227 @@
+#include "PacketBufferPool.h"
+#include <iostream>
+#include <new>
+
+/**
+ * @brief 控制块分配器：优先使用缓冲区头部的预留空间
+ *
+ * shared_ptr 在删除器执行且弱引用归零后才调用 deallocate()，
+ * 因此控制块放在缓冲区内部时，由 deallocate() 负责归还缓冲区。
+ */
+template<typename T>
+struct PacketBufferPool::CtrlAllocator {
+    typedef T value_type;
+
+    Block* block;
+
+    explicit CtrlAllocator(Block* b) : block(b) {}
+    template<typename U>
+    CtrlAllocator(const CtrlAllocator<U>& other) : block(other.block) {}
+
+    T* allocate(size_t n) {
+        if (n * sizeof(T) <= kCtrlSpace && alignof(T) <= alignof(std::max_align_t)) {
+            block->ctrlInline = true;
+            return reinterpret_cast<T*>(&block->ctrl);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+        if (reinterpret_cast<void*>(p) == reinterpret_cast<void*>(&block->ctrl)) {
+            releaseBlock(block);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template<typename U>
+    bool operator==(const CtrlAllocator<U>& other) const { return block == other.block; }
+    template<typename U>
+    bool operator!=(const CtrlAllocator<U>& other) const { return block != other.block; }
+};
+
+/**
+ * @brief 删除器：控制块不在缓冲区内时由这里归还缓冲区
+ */
+struct PacketBufferPool::Deleter {
+    Block* block;
+
+    void operator()(uint8_t*) const {
+        if (!block->ctrlInline) {
+            releaseBlock(block);
+        }
+    }
+};
+
+uint8_t* PacketBufferPool::Block::payload() {
+    return reinterpret_cast<uint8_t*>(this) + dataOffset();
+}
+
+std::shared_ptr<PacketBufferPool> PacketBufferPool::create(size_t maxCachedBytes) {
+    return std::shared_ptr<PacketBufferPool>(new PacketBufferPool(maxCachedBytes));
+}
+
+std::shared_ptr<PacketBufferPool> PacketBufferPool::shared() {
+    static std::shared_ptr<PacketBufferPool> pool = create();
+    return pool;
+}
+
+PacketBufferPool::PacketBufferPool(size_t maxCachedBytes)
+    : m_maxCachedBytes(maxCachedBytes) {
+}
+
+PacketBufferPool::~PacketBufferPool() {
+    trim();
+}
+
+int PacketBufferPool::classFor(size_t size) {
+    size_t cap = kMinClassSize;
+    for (int i = 0; i < kNumClasses; i++) {
+        if (size <= cap) {
+            return i;
+        }
+        cap <<= 1;
+    }
+    return -1;
+}
+
+size_t PacketBufferPool::classSize(int sizeClass) {
+    return kMinClassSize << sizeClass;
+}
+
+size_t PacketBufferPool::dataOffset() {
+    // 数据区按缓存行对齐
+    return (sizeof(Block) + 63) & ~static_cast<size_t>(63);
+}
+
+PacketBufferPool::Block* PacketBufferPool::allocBlock(size_t capacity, int sizeClass) {
+    void* mem = ::operator new(dataOffset() + capacity, std::nothrow);
+    if (!mem) {
+        std::cerr << "[PacketBufferPool] Failed to allocate " << capacity << " bytes" << std::endl;
+        return nullptr;
+    }
+    Block* block = new (mem) Block();
+    block->capacity = capacity;
+    block->sizeClass = sizeClass;
+    block->ctrlInline = false;
+    block->next = nullptr;
+    return block;
+}
+
+void PacketBufferPool::freeBlock(Block* block) {
+    block->~Block();
+    ::operator delete(static_cast<void*>(block));
+}
+
+std::shared_ptr<uint8_t> PacketBufferPool::acquire(size_t size, size_t* capacity) {
+    int sizeClass = classFor(size);
+    Block* block = nullptr;
+
+    if (sizeClass >= 0) {
+        ClassList& list = m_classes[sizeClass];
+        {
+            std::lock_guard<std::mutex> lock(list.mutex);
+            block = list.head;
+            if (block) {
+                list.head = block->next;
+                list.count--;
+            }
+        }
+        if (block) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            m_cachedBytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+        } else {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            block = allocBlock(classSize(sizeClass), sizeClass);
+        }
+    } else {
+        m_oversize.fetch_add(1, std::memory_order_relaxed);
+        block = allocBlock(size, -1);
+    }
+
+    if (!block) {
+        return std::shared_ptr<uint8_t>();
+    }
+
+    block->owner = shared_from_this();
+    block->ctrlInline = false;
+    block->next = nullptr;
+
+    m_outstandingBlocks.fetch_add(1, std::memory_order_relaxed);
+    uint64_t outstanding =
+        m_outstandingBytes.fetch_add(block->capacity, std::memory_order_relaxed) + block->capacity;
+    updatePeak(m_peakOutstandingBytes, outstanding);
+
+    if (capacity) {
+        *capacity = block->capacity;
+    }
+
+    // 控制块分配失败时 shared_ptr 会调用删除器，缓冲区照常归还
+    Deleter deleter = { block };
+    return std::shared_ptr<uint8_t>(block->payload(), deleter, CtrlAllocator<uint8_t>(block));
+}
+
+void PacketBufferPool::releaseBlock(Block* block) {
+    // 先取出 owner：recycle() 返回后才可能析构缓冲池
+    std::shared_ptr<PacketBufferPool> owner = std::move(block->owner);
+    owner->recycle(block);
+}
+
+void PacketBufferPool::recycle(Block* block) {
+    m_outstandingBlocks.fetch_sub(1, std::memory_order_relaxed);
+    m_outstandingBytes.fetch_sub(block->capacity, std::memory_order_relaxed);
+
+    if (block->sizeClass < 0 ||
+        m_cachedBytes.load(std::memory_order_relaxed) + block->capacity > m_maxCachedBytes) {
+        freeBlock(block);
+        return;
+    }
+
+    ClassList& list = m_classes[block->sizeClass];
+    {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        block->next = list.head;
+        list.head = block;
+        list.count++;
+    }
+    uint64_t cached =
+        m_cachedBytes.fetch_add(block->capacity, std::memory_order_relaxed) + block->capacity;
+    updatePeak(m_peakCachedBytes, cached);
+}
+
+void PacketBufferPool::trim() {
+    for (int i = 0; i < kNumClasses; i++) {
+        Block* head;
+        {
+            std::lock_guard<std::mutex> lock(m_classes[i].mutex);
+            head = m_classes[i].head;
+            m_classes[i].head = nullptr;
+            m_classes[i].count = 0;
+        }
+        while (head) {
+            Block* next = head->next;
+            m_cachedBytes.fetch_sub(head->capacity, std::memory_order_relaxed);
+            freeBlock(head);
+            head = next;
+        }
+    }
+}
+
+PacketBufferPool::Stats PacketBufferPool::stats() const {
+    Stats s;
+    s.hits = m_hits.load(std::memory_order_relaxed);
+    s.misses = m_misses.load(std::memory_order_relaxed);
+    s.oversize = m_oversize.load(std::memory_order_relaxed);
+    s.outstandingBlocks = m_outstandingBlocks.load(std::memory_order_relaxed);
+    s.outstandingBytes = m_outstandingBytes.load(std::memory_order_relaxed);
+    s.peakOutstandingBytes = m_peakOutstandingBytes.load(std::memory_order_relaxed);
+    s.cachedBytes = m_cachedBytes.load(std::memory_order_relaxed);
+    s.peakCachedBytes = m_peakCachedBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+void PacketBufferPool::updatePeak(std::atomic<uint64_t>& peak, uint64_t value) {
+    uint64_t cur = peak.load(std::memory_order_relaxed);
+    while (value > cur && !peak.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+    }
+}
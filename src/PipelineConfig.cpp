@@ -0,0 +1,437 @@
+#include "PipelineConfig.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t begin = 0;
+    size_t end = s.size();
+    while (begin < end && isspace(static_cast<unsigned char>(s[begin]))) {
+        begin++;
+    }
+    while (end > begin && isspace(static_cast<unsigned char>(s[end - 1]))) {
+        end--;
+    }
+    return s.substr(begin, end - begin);
+}
+
+std::string toLower(std::string s) {
+    for (size_t i = 0; i < s.size(); i++) {
+        s[i] = static_cast<char>(tolower(static_cast<unsigned char>(s[i])));
+    }
+    return s;
+}
+
+bool parseInt(const std::string& value, int& out) {
+    if (value.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    long v = strtol(value.c_str(), &end, 0);
+    if (errno != 0 || *end != '\0' || v < -2147483647L || v > 2147483647L) {
+        return false;
+    }
+    out = static_cast<int>(v);
+    return true;
+}
+
+/**
+ * @brief 解析无符号数，支持 k/K、m/M 后缀（用于码率，例如 4M = 4000000）
+ */
+bool parseUint(const std::string& value, uint32_t& out) {
+    if (value.empty() || value[0] == '-') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long v = strtoull(value.c_str(), &end, 0);
+    if (errno != 0) {
+        return false;
+    }
+    if (*end == 'k' || *end == 'K') {
+        v *= 1000ULL;
+        end++;
+    } else if (*end == 'm' || *end == 'M') {
+        v *= 1000000ULL;
+        end++;
+    }
+    if (*end != '\0' || v > 0xffffffffULL) {
+        return false;
+    }
+    out = static_cast<uint32_t>(v);
+    return true;
+}
+
+bool parseBool(const std::string& value, bool& out) {
+    std::string v = toLower(value);
+    if (v == "1" || v == "true" || v == "yes" || v == "on") {
+        out = true;
+        return true;
+    }
+    if (v == "0" || v == "false" || v == "no" || v == "off") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+bool parsePixelFormat(const std::string& value, uint32_t& out) {
+    std::string v = toLower(value);
+    if (v == "nv12") {
+        out = V4L2_PIX_FMT_NV12;
+    } else if (v == "nv21") {
+        out = V4L2_PIX_FMT_NV21;
+    } else if (v == "nv16") {
+        out = V4L2_PIX_FMT_NV16;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 档次名称转换为 rockit 的 H264E_PROFILE_* / H265E_PROFILE_* 取值
+ *
+ * H264 与 H265 的同名档次取值不同，需要在确定编码格式后转换。
+ */
+bool resolveProfile(const std::string& name, bool h265, uint32_t& out) {
+    if (name == "default") {
+        out = 0;
+    } else if (!h265 && name == "baseline") {
+        out = 66;
+    } else if (!h265 && name == "main") {
+        out = 77;
+    } else if (!h265 && name == "high") {
+        out = 100;
+    } else if (h265 && name == "main") {
+        out = 0;
+    } else if (h265 && name == "main10") {
+        out = 1;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/** x,y,w,h */
+bool parseRect(const std::string& value, int& x, int& y, uint32_t& width, uint32_t& height) {
+    std::stringstream ss(value);
+    std::string part[4];
+    for (int i = 0; i < 4; i++) {
+        if (!std::getline(ss, part[i], ',')) {
+            return false;
+        }
+        part[i] = trim(part[i]);
+    }
+    std::string rest;
+    if (std::getline(ss, rest)) {
+        return false;
+    }
+    return parseInt(part[0], x) && parseInt(part[1], y) &&
+           parseUint(part[2], width) && parseUint(part[3], height);
+}
+
+bool vpssIndex(const std::string& name, int& index) {
+    if (name == "enc" || name == "encoder") {
+        index = kVpssChnEncoder;
+    } else if (name == "vo" || name == "display") {
+        index = kVpssChnDisplay;
+    } else if (name == "yuv") {
+        index = kVpssChnYuv;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 设置单个键
+ * @return 0 成功，1 未知键，2 非法值
+ */
+int applyKey(const std::string& key, const std::string& value, PipelineConfig& config,
+             std::string& profileName) {
+    ViConfig& vi = config.vi;
+    EncodeParams& venc = config.venc;
+    VoConfig& vo = config.vo;
+    bool ok;
+
+    // ---- VI ----
+    if (key == "vi.dev") {
+        ok = parseInt(value, vi.devId);
+    } else if (key == "vi.pipe") {
+        ok = parseInt(value, vi.pipeId);
+    } else if (key == "vi.chn") {
+        ok = parseInt(value, vi.chnId);
+    } else if (key == "vi.entity") {
+        vi.entityName = value;
+        ok = true;
+    } else if (key == "vi.width") {
+        ok = parseUint(value, vi.width);
+    } else if (key == "vi.height") {
+        ok = parseUint(value, vi.height);
+    } else if (key == "vi.fps") {
+        ok = parseInt(value, vi.fps);
+    } else if (key == "vi.buf_count") {
+        ok = parseUint(value, vi.bufCount);
+    } else if (key == "vi.depth") {
+        ok = parseUint(value, vi.depth);
+
+    // ---- VPSS ----
+    } else if (key == "vpss.grp") {
+        ok = parseInt(value, config.vpssGrpId);
+    } else if (key.compare(0, 5, "vpss.") == 0) {
+        size_t dot = key.find('.', 5);
+        int index;
+        if (dot == std::string::npos || !vpssIndex(key.substr(5, dot - 5), index)) {
+            return 1;
+        }
+        VpssChnConfig& chn = config.vpss[index];
+        std::string field = key.substr(dot + 1);
+        if (field == "enable") {
+            ok = parseBool(value, chn.enabled);
+        } else if (field == "width") {
+            ok = parseUint(value, chn.width);
+        } else if (field == "height") {
+            ok = parseUint(value, chn.height);
+        } else if (field == "format") {
+            ok = parsePixelFormat(value, chn.pixelFormat);
+        } else if (field == "fps") {
+            ok = parseInt(value, chn.fps);
+        } else if (field == "depth") {
+            ok = parseUint(value, chn.depth);
+        } else if (field == "buf_count") {
+            ok = parseUint(value, chn.bufCount);
+        } else {
+            return 1;
+        }
+
+    // ---- VENC ----
+    } else if (key == "venc.chn") {
+        ok = parseInt(value, config.vencChnId);
+    } else if (key == "venc.codec") {
+        std::string v = toLower(value);
+        ok = (v == "h264" || v == "h265" || v == "hevc");
+        venc.useH265 = (v != "h264");
+    } else if (key == "venc.width") {
+        ok = parseUint(value, venc.width);
+    } else if (key == "venc.height") {
+        ok = parseUint(value, venc.height);
+    } else if (key == "venc.rc") {
+        std::string v = toLower(value);
+        ok = true;
+        if (v == "cbr") {
+            venc.rcMode = RateControlMode::CBR;
+        } else if (v == "vbr") {
+            venc.rcMode = RateControlMode::VBR;
+        } else if (v == "avbr") {
+            venc.rcMode = RateControlMode::AVBR;
+        } else {
+            ok = false;
+        }
+    } else if (key == "venc.bitrate") {
+        ok = parseUint(value, venc.bitrate);
+    } else if (key == "venc.max_bitrate") {
+        ok = parseUint(value, venc.maxBitrate);
+    } else if (key == "venc.min_bitrate") {
+        ok = parseUint(value, venc.minBitrate);
+    } else if (key == "venc.fps") {
+        ok = parseUint(value, venc.fps);
+    } else if (key == "venc.gop") {
+        ok = parseUint(value, venc.gop);
+    } else if (key == "venc.profile") {
+        profileName = toLower(value);  // 全部解析完、编码格式确定后再转换
+        ok = !profileName.empty();
+    } else if (key == "venc.stream_buf_cnt") {
+        ok = parseUint(value, venc.streamBufCnt);
+    } else if (key == "venc.min_qp") {
+        ok = parseUint(value, venc.minQp);
+    } else if (key == "venc.max_qp") {
+        ok = parseUint(value, venc.maxQp);
+    } else if (key == "venc.min_iqp") {
+        ok = parseUint(value, venc.minIQp);
+    } else if (key == "venc.max_iqp") {
+        ok = parseUint(value, venc.maxIQp);
+
+    // ---- VO ----
+    } else if (key == "vo.dev") {
+        ok = parseInt(value, vo.devId);
+    } else if (key == "vo.layer") {
+        ok = parseInt(value, vo.layerId);
+    } else if (key == "vo.chn") {
+        ok = parseInt(value, vo.chnId);
+    } else if (key == "vo.intf") {
+        vo.intf = toLower(value);
+        ok = !vo.intf.empty();
+    } else if (key == "vo.sync") {
+        vo.sync = value;
+        ok = !vo.sync.empty();
+    } else if (key == "vo.rect") {
+        ok = parseRect(value, vo.rectX, vo.rectY, vo.rectWidth, vo.rectHeight);
+    } else if (key == "vo.chn_rect") {
+        ok = parseRect(value, vo.chnRectX, vo.chnRectY, vo.chnRectWidth, vo.chnRectHeight);
+    } else {
+        return 1;
+    }
+
+    return ok ? 0 : 2;
+}
+
+}  // namespace
+
+bool parsePipelineConfig(std::istream& in, PipelineConfig& config, const std::string& source) {
+    std::string line;
+    std::string profileName;
+    int lineNo = 0;
+    bool ok = true;
+
+    while (std::getline(in, line)) {
+        lineNo++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "[PipelineConfig] " << source << ":" << lineNo
+                      << ": expected key = value" << std::endl;
+            ok = false;
+            continue;
+        }
+
+        std::string key = toLower(trim(line.substr(0, eq)));
+        std::string value = trim(line.substr(eq + 1));
+        int ret = applyKey(key, value, config, profileName);
+        if (ret == 1) {
+            std::cerr << "[PipelineConfig] " << source << ":" << lineNo
+                      << ": unknown key '" << key << "'" << std::endl;
+            ok = false;
+        } else if (ret == 2) {
+            std::cerr << "[PipelineConfig] " << source << ":" << lineNo
+                      << ": invalid value '" << value << "' for " << key << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!profileName.empty() &&
+        !resolveProfile(profileName, config.venc.useH265, config.venc.profile)) {
+        std::cerr << "[PipelineConfig] " << source << ": profile '" << profileName
+                  << "' is not valid for " << (config.venc.useH265 ? "H265" : "H264") << std::endl;
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool loadPipelineConfig(const std::string& path, PipelineConfig& config) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "[PipelineConfig] Cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return parsePipelineConfig(file, config, path);
+}
+
+bool validatePipelineConfig(const PipelineConfig& config) {
+    bool ok = true;
+
+    const ViConfig& vi = config.vi;
+    if (vi.width == 0 || vi.height == 0 || (vi.width & 1) || (vi.height & 1)) {
+        std::cerr << "[PipelineConfig] Invalid VI size " << vi.width << "x" << vi.height
+                  << " (must be non-zero and even)" << std::endl;
+        ok = false;
+    }
+    if (vi.bufCount == 0) {
+        std::cerr << "[PipelineConfig] vi.buf_count must be positive" << std::endl;
+        ok = false;
+    }
+
+    static const char* kChnNames[kVpssChnCount] = { "enc", "vo", "yuv" };
+    for (int i = 0; i < kVpssChnCount; i++) {
+        const VpssChnConfig& chn = config.vpss[i];
+        if ((chn.width == 0) != (chn.height == 0) || (chn.width & 1) || (chn.height & 1)) {
+            std::cerr << "[PipelineConfig] Invalid vpss." << kChnNames[i] << " size "
+                      << chn.width << "x" << chn.height
+                      << " (both zero to follow VI, or both even)" << std::endl;
+            ok = false;
+        } else if (chn.width > 0 && vi.width > 0 && vi.height > 0 &&
+                   (chn.width > kVpssMaxOutputSize || chn.height > kVpssMaxOutputSize ||
+                    chn.width * kVpssMaxScaleDown < vi.width ||
+                    chn.height * kVpssMaxScaleDown < vi.height ||
+                    chn.width > vi.width * kVpssMaxScaleUp ||
+                    chn.height > vi.height * kVpssMaxScaleUp)) {
+            std::cerr << "[PipelineConfig] vpss." << kChnNames[i] << " size "
+                      << chn.width << "x" << chn.height << " is out of scaler range for input "
+                      << vi.width << "x" << vi.height << " (1/" << kVpssMaxScaleDown << " ~ "
+                      << kVpssMaxScaleUp << "x, max " << kVpssMaxOutputSize << ")" << std::endl;
+            ok = false;
+        }
+
+        // 抽帧以 VI 输出帧率为源帧率，只能降不能升
+        if (chn.fps == 0 || chn.fps < -1) {
+            std::cerr << "[PipelineConfig] vpss." << kChnNames[i]
+                      << ".fps must be positive or -1" << std::endl;
+            ok = false;
+        } else if (chn.fps > 0 && vi.fps <= 0) {
+            std::cerr << "[PipelineConfig] vpss." << kChnNames[i]
+                      << ".fps requires vi.fps to be set" << std::endl;
+            ok = false;
+        } else if (chn.fps > vi.fps) {
+            std::cerr << "[PipelineConfig] vpss." << kChnNames[i] << ".fps " << chn.fps
+                      << " exceeds vi.fps " << vi.fps << std::endl;
+            ok = false;
+        }
+    }
+
+    const EncodeParams& venc = config.venc;
+    if (!validateEncodeParams(venc)) {
+        ok = false;
+    }
+    const VpssChnConfig& encChn = config.vpss[kVpssChnEncoder];
+    if (encChn.fps > 0 && venc.fps != static_cast<uint32_t>(encChn.fps)) {
+        // 码控按 venc.fps 分配每帧码率，与实际输入帧率不符会导致码率偏差
+        std::cerr << "[PipelineConfig] venc.fps " << venc.fps << " differs from vpss.enc.fps "
+                  << encChn.fps << std::endl;
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool validateEncodeParams(const EncodeParams& venc) {
+    bool ok = true;
+    if ((venc.width == 0) != (venc.height == 0) || (venc.width & 1) || (venc.height & 1)) {
+        std::cerr << "[PipelineConfig] Invalid venc size " << venc.width << "x" << venc.height
+                  << std::endl;
+        ok = false;
+    }
+    if (venc.bitrate < 1000 || venc.fps == 0 || venc.gop == 0) {
+        std::cerr << "[PipelineConfig] venc.bitrate (>= 1000), venc.fps and venc.gop must be positive"
+                  << std::endl;
+        ok = false;
+    }
+    if (venc.maxBitrate > 0 && venc.maxBitrate < venc.bitrate) {
+        std::cerr << "[PipelineConfig] venc.max_bitrate is lower than venc.bitrate" << std::endl;
+        ok = false;
+    }
+    if (venc.maxQp > kVencMaxQp || venc.maxIQp > kVencMaxQp ||
+        (venc.minQp > 0 && venc.maxQp > 0 && venc.minQp > venc.maxQp) ||
+        (venc.minIQp > 0 && venc.maxIQp > 0 && venc.minIQp > venc.maxIQp)) {
+        std::cerr << "[PipelineConfig] Invalid venc QP range " << venc.minQp << "-" << venc.maxQp
+                  << " (I " << venc.minIQp << "-" << venc.maxIQp << ", max " << kVencMaxQp << ")"
+                  << std::endl;
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,127 @@
+#include "RtpPacketizer.h"
+#include "AnnexB.h"
+#include <random>
+
+namespace {
+
+const int kH264NalAud = 9;
+const int kH265NalAud = 35;
+
+const uint8_t kH264FuA = 28;
+const uint8_t kH265Fu = 49;
+
+}  // namespace
+
+RtpPacketizer::RtpPacketizer(uint8_t payloadType, size_t mtu)
+    : m_payloadType(payloadType & 0x7F),
+      m_maxPayload(mtu > kRtpHeaderSize + 64 ? mtu - kRtpHeaderSize : 64) {
+    // SSRC、起始序列号与时间戳随机（RFC 3550 5.1）
+    std::random_device rd;
+    m_ssrc = rd();
+    m_sequence = static_cast<uint16_t>(rd());
+    m_timestampOffset = rd();
+}
+
+size_t RtpPacketizer::packetize(const EncodedFrame& frame) {
+    const bool h265 = frame.isH265;
+    const size_t fuHeaderSize = h265 ? 3 : 2;
+    const size_t nalHeaderSize = h265 ? 2 : 1;
+    const size_t fuPayload = m_maxPayload - fuHeaderSize;
+
+    // 第一遍：收集 NAL、计算包数，头部区一次分配到位（iovec 指向其中）
+    m_nals.clear();
+    size_t count = 0;
+    forEachNal(frame, [&](const uint8_t* nal, size_t size) {
+        int type = nalUnitType(nal, h265);
+        if (type == (h265 ? kH265NalAud : kH264NalAud) || size <= nalHeaderSize) {
+            return;
+        }
+        Nal entry;
+        entry.data = nal;
+        entry.size = size;
+        m_nals.push_back(entry);
+        if (size <= m_maxPayload) {
+            count += 1;
+        } else {
+            count += (size - nalHeaderSize + fuPayload - 1) / fuPayload;
+        }
+    });
+
+    if (m_headers.size() < count * kMaxHeaderSize) {
+        m_headers.resize(count * kMaxHeaderSize);
+    }
+    if (m_iov.size() < count * 2) {
+        m_iov.resize(count * 2);
+    }
+    m_packetCount = count;
+    if (count == 0) {
+        return 0;
+    }
+
+    const uint32_t timestamp = rtpTimestamp(frame.timestamp);
+    size_t index = 0;
+    for (size_t n = 0; n < m_nals.size(); n++) {
+        const uint8_t* nal = m_nals[n].data;
+        size_t size = m_nals[n].size;
+        bool lastNal = (n + 1 == m_nals.size());
+
+        if (size <= m_maxPayload) {
+            addPacket(index++, timestamp, lastNal, nullptr, 0, nal, size);
+            continue;
+        }
+
+        // 分片：去掉 NAL 头，由 FU 指示字节 + 分片头还原
+        uint8_t header[3];
+        int type = nalUnitType(nal, h265);
+        if (h265) {
+            header[0] = static_cast<uint8_t>((nal[0] & 0x81) | (kH265Fu << 1));
+            header[1] = nal[1];
+        } else {
+            header[0] = static_cast<uint8_t>((nal[0] & 0xE0) | kH264FuA);
+        }
+        uint8_t& fuHeader = header[fuHeaderSize - 1];
+
+        const uint8_t* p = nal + nalHeaderSize;
+        size_t remaining = size - nalHeaderSize;
+        bool first = true;
+        while (remaining > 0) {
+            size_t chunk = remaining < fuPayload ? remaining : fuPayload;
+            bool last = (chunk == remaining);
+            fuHeader = static_cast<uint8_t>((first ? 0x80 : 0) | (last ? 0x40 : 0) | type);
+            addPacket(index++, timestamp, last && lastNal, header, fuHeaderSize, p, chunk);
+            p += chunk;
+            remaining -= chunk;
+            first = false;
+        }
+    }
+    return count;
+}
+
+void RtpPacketizer::addPacket(size_t index, uint32_t timestamp, bool marker,
+                              const uint8_t* payloadHeader, size_t payloadHeaderSize,
+                              const uint8_t* data, size_t size) {
+    uint8_t* h = &m_headers[index * kMaxHeaderSize];
+    uint16_t seq = m_sequence++;
+
+    h[0] = 0x80;  // V=2, P=0, X=0, CC=0
+    h[1] = static_cast<uint8_t>((marker ? 0x80 : 0) | m_payloadType);
+    h[2] = static_cast<uint8_t>(seq >> 8);
+    h[3] = static_cast<uint8_t>(seq);
+    h[4] = static_cast<uint8_t>(timestamp >> 24);
+    h[5] = static_cast<uint8_t>(timestamp >> 16);
+    h[6] = static_cast<uint8_t>(timestamp >> 8);
+    h[7] = static_cast<uint8_t>(timestamp);
+    h[8] = static_cast<uint8_t>(m_ssrc >> 24);
+    h[9] = static_cast<uint8_t>(m_ssrc >> 16);
+    h[10] = static_cast<uint8_t>(m_ssrc >> 8);
+    h[11] = static_cast<uint8_t>(m_ssrc);
+    for (size_t i = 0; i < payloadHeaderSize; i++) {
+        h[kRtpHeaderSize + i] = payloadHeader[i];
+    }
+
+    iovec* iov = &m_iov[index * 2];
+    iov[0].iov_base = h;
+    iov[0].iov_len = kRtpHeaderSize + payloadHeaderSize;
+    iov[1].iov_base = const_cast<uint8_t*>(data);
+    iov[1].iov_len = size;
+}
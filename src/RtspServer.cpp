@@ -0,0 +1,815 @@
+#include "RtspServer.h"
+#include "AnnexB.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace {
+
+const uint8_t kPayloadType = 96;
+
+// 服务端 epoll 事件标识（连接 socket 直接以 fd 标识）
+const int kTagListen = -1;
+const int kTagRtcp = -2;
+
+const size_t kMaxRequestBytes = 64 * 1024;
+const unsigned kMaxBatch = 1024;          // 单次 sendmmsg 的包数上限（UIO_MAXIOV）
+
+const int kH264NalSps = 7;
+const int kH264NalPps = 8;
+const int kH265NalVps = 32;
+const int kH265NalSps = 33;
+const int kH265NalPps = 34;
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+bool addToPoll(int pollFd, int fd, int tag) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = tag;
+    return epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+std::string toLower(std::string s) {
+    for (size_t i = 0; i < s.size(); i++) {
+        s[i] = static_cast<char>(tolower(static_cast<unsigned char>(s[i])));
+    }
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::string base64(const std::vector<uint8_t>& data) {
+    static const char kTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t v = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < data.size()) v |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < data.size()) v |= data[i + 2];
+        out += kTable[(v >> 18) & 0x3F];
+        out += kTable[(v >> 12) & 0x3F];
+        out += (i + 1 < data.size()) ? kTable[(v >> 6) & 0x3F] : '=';
+        out += (i + 2 < data.size()) ? kTable[v & 0x3F] : '=';
+    }
+    return out;
+}
+
+}  // namespace
+
+RtspServer::RtspServer(const RtspServerConfig& config)
+    : ServiceBase("RtspServer"), m_config(config) {
+    setThreadAttr(ThreadAttr::background());
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_metricsCollector.reset([this](MetricsWriter& writer) { collectMetrics(writer); });
+}
+
+RtspServer::~RtspServer() {
+    stop();
+    join();
+    closeSockets();
+}
+
+int RtspServer::addStream(const std::string& name, bool isH265) {
+    if (isRunning()) {
+        std::cerr << "[" << m_name << "] addStream must be called before start()" << std::endl;
+        return -1;
+    }
+    if (name.empty() || name.find('/') != std::string::npos || findStream("/" + name) >= 0) {
+        std::cerr << "[" << m_name << "] Invalid or duplicate stream name: " << name << std::endl;
+        return -1;
+    }
+
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->name = name;
+    stream->isH265.store(isH265);
+    stream->packetizer.reset(new RtpPacketizer(kPayloadType, m_config.mtu));
+    stream->viewers = std::make_shared<const ViewerList>();
+    m_streams.push_back(std::move(stream));
+    return static_cast<int>(m_streams.size()) - 1;
+}
+
+bool RtspServer::open() {
+    if (m_listenFd >= 0) {
+        return true;
+    }
+
+    m_pollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_pollFd < 0) {
+        std::cerr << "[" << m_name << "] epoll_create1 failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // RTSP 监听
+    m_listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(m_config.port);
+    if (m_listenFd < 0 || bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(m_listenFd, 16) != 0) {
+        std::cerr << "[" << m_name << "] Failed to listen on port " << m_config.port << ": "
+                  << strerror(errno) << std::endl;
+        closeSockets();
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    m_port = ntohs(addr.sin_port);
+
+    // RTP/RTCP：偶数端口 + 相邻奇数端口
+    uint16_t base = m_config.rtpPort ? static_cast<uint16_t>(m_config.rtpPort & ~1u) : 5004;
+    for (int attempt = 0; attempt < 100 && m_rtpFd < 0; attempt++, base = static_cast<uint16_t>(base + 2)) {
+        int rtp = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        int rtcp = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        addr.sin_port = htons(base);
+        bool ok = rtp >= 0 && rtcp >= 0 &&
+                  bind(rtp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        addr.sin_port = htons(static_cast<uint16_t>(base + 1));
+        ok = ok && bind(rtcp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (!ok) {
+            if (rtp >= 0) close(rtp);
+            if (rtcp >= 0) close(rtcp);
+            continue;
+        }
+        m_rtpFd = rtp;
+        m_rtcpFd = rtcp;
+        m_rtpPort = base;
+    }
+    if (m_rtpFd < 0) {
+        std::cerr << "[" << m_name << "] No free RTP/RTCP port pair from " << m_config.rtpPort << std::endl;
+        closeSockets();
+        return false;
+    }
+    // 关键帧扇出时一次写入的数据量较大，加大发送缓冲
+    setsockopt(m_rtpFd, SOL_SOCKET, SO_SNDBUF, &m_config.sendBufferBytes, sizeof(m_config.sendBufferBytes));
+
+    if (!addToPoll(m_pollFd, m_listenFd, kTagListen) || !addToPoll(m_pollFd, m_rtcpFd, kTagRtcp)) {
+        std::cerr << "[" << m_name << "] Failed to add sockets to epoll: " << strerror(errno) << std::endl;
+        closeSockets();
+        return false;
+    }
+
+    std::cout << "[" << m_name << "] Listening on port " << m_port << ", RTP/RTCP " << m_rtpPort
+              << "-" << (m_rtpPort + 1) << std::endl;
+    return true;
+}
+
+void RtspServer::pushFrame(int stream, const EncodedFrame& frame) {
+    if (stream < 0 || stream >= static_cast<int>(m_streams.size()) || m_rtpFd < 0) {
+        return;
+    }
+    Stream& s = *m_streams[stream];
+    if (frame.isKeyFrame) {
+        updateParameterSets(s, frame);
+    }
+
+    std::shared_ptr<const ViewerList> viewers;
+    {
+        std::lock_guard<std::mutex> lock(s.viewersMutex);
+        viewers = s.viewers;
+    }
+    if (viewers->empty()) {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(s.sendMutex);
+
+    // 本帧的接收者：新观看者从关键帧开始
+    s.targets.clear();
+    for (size_t i = 0; i < viewers->size(); i++) {
+        Viewer* viewer = (*viewers)[i].get();
+        if (viewer->waitKeyFrame.load(std::memory_order_relaxed)) {
+            if (!frame.isKeyFrame) {
+                continue;
+            }
+            viewer->waitKeyFrame.store(false, std::memory_order_relaxed);
+        }
+        s.targets.push_back(viewer);
+    }
+    if (s.targets.empty()) {
+        return;
+    }
+
+    size_t packets = s.packetizer->packetize(frame);
+    if (packets == 0) {
+        return;
+    }
+
+    // 按包展开：同一个包连续发给所有观看者，各 mmsghdr 共用该包的 iovec
+    const size_t total = packets * s.targets.size();
+    if (s.messages.size() < total) {
+        s.messages.resize(total);
+    }
+    uint64_t frameBytes = 0;
+    size_t m = 0;
+    for (size_t p = 0; p < packets; p++) {
+        iovec* iov = s.packetizer->packetIov(p);
+        frameBytes += s.packetizer->packetSize(p);
+        for (size_t t = 0; t < s.targets.size(); t++) {
+            msghdr& hdr = s.messages[m++].msg_hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_name = &s.targets[t]->rtpAddr;
+            hdr.msg_namelen = sizeof(sockaddr_in);
+            hdr.msg_iov = iov;
+            hdr.msg_iovlen = 2;
+        }
+    }
+
+    size_t sent = 0;
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    while (sent < total) {
+        unsigned batch = static_cast<unsigned>(std::min<size_t>(total - sent, kMaxBatch));
+        int n = sendmmsg(m_rtpFd, &s.messages[sent], batch, 0);
+        calls++;
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // 失败的是第一个未发出的包，跳过后继续
+            errors++;
+            sent++;
+            continue;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    uint64_t fanoutUs = elapsedUs(start);
+
+    std::lock_guard<std::mutex> statsLock(m_statsMutex);
+    m_stats.frames++;
+    m_stats.packets += packets;
+    m_stats.datagrams += total - errors;
+    m_stats.bytes += frameBytes * s.targets.size();
+    m_stats.sendCalls += calls;
+    m_stats.sendErrors += errors;
+    if (fanoutUs > m_stats.maxFanoutUs) {
+        m_stats.maxFanoutUs = fanoutUs;
+    }
+}
+
+uint32_t RtspServer::viewerCount(int stream) const {
+    if (stream < 0 || stream >= static_cast<int>(m_streams.size())) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(m_streams[stream]->viewersMutex);
+    return static_cast<uint32_t>(m_streams[stream]->viewers->size());
+}
+
+RtspServer::Stats RtspServer::stats() const {
+    Stats result;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        result = m_stats;
+    }
+    result.viewers = 0;
+    for (size_t i = 0; i < m_streams.size(); i++) {
+        result.viewers += viewerCount(static_cast<int>(i));
+    }
+    return result;
+}
+
+void RtspServer::collectMetrics(MetricsWriter& writer) {
+    // 流列表在 start() 之后不再变化，启动前不输出
+    if (!isRunning()) {
+        return;
+    }
+    Stats current = stats();
+    MetricLabels labels = metricLabels();
+    writer.gauge("media_rtsp_connections", "Open RTSP control connections", labels, current.connections);
+    writer.gauge("media_rtsp_viewers", "Sessions currently playing", labels, current.viewers);
+    writer.counter("media_rtsp_frames_total", "Frames sent while viewers were attached", labels, current.frames);
+    writer.counter("media_rtsp_datagrams_total", "RTP datagrams sent to all viewers", labels,
+                   current.datagrams);
+    writer.counter("media_rtsp_bytes_total", "RTP bytes sent to all viewers", labels, current.bytes);
+    writer.counter("media_rtsp_send_errors_total", "RTP datagrams that failed to send", labels,
+                   current.sendErrors);
+}
+
+void RtspServer::updateParameterSets(Stream& stream, const EncodedFrame& frame) {
+    std::vector<uint8_t> vps;
+    std::vector<uint8_t> sps;
+    std::vector<uint8_t> pps;
+    forEachNal(frame, [&](const uint8_t* nal, size_t size) {
+        int type = nalUnitType(nal, frame.isH265);
+        if (frame.isH265) {
+            if (type == kH265NalVps) vps.assign(nal, nal + size);
+            else if (type == kH265NalSps) sps.assign(nal, nal + size);
+            else if (type == kH265NalPps) pps.assign(nal, nal + size);
+        } else {
+            if (type == kH264NalSps) sps.assign(nal, nal + size);
+            else if (type == kH264NalPps) pps.assign(nal, nal + size);
+        }
+    });
+    if (sps.empty() || pps.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stream.paramMutex);
+    stream.isH265.store(frame.isH265);
+    stream.vps.swap(vps);
+    stream.sps.swap(sps);
+    stream.pps.swap(pps);
+}
+
+void RtspServer::run() {
+    if (m_pollFd < 0 && !open()) {
+        std::cerr << "[" << m_name << "] Not started: sockets unavailable" << std::endl;
+        return;
+    }
+    setChannelFd(m_pollFd);
+    m_lastExpireCheck = std::chrono::steady_clock::now();
+
+    while (m_running.load()) {
+        int events = waitEvents(1000);
+        if (events & WAIT_TASK) {
+            processTasks();
+        }
+        if (events & WAIT_CHANNEL) {
+            handleSocketEvents();
+        }
+        expireSessions();
+    }
+
+    closeAll();
+}
+
+void RtspServer::handleSocketEvents() {
+    struct epoll_event events[32];
+    int n = epoll_wait(m_pollFd, events, 32, 0);
+    for (int i = 0; i < n; i++) {
+        int tag = events[i].data.fd;
+        if (tag == kTagListen) {
+            acceptConnections();
+        } else if (tag == kTagRtcp) {
+            readRtcp();
+        } else {
+            readConnection(tag);
+        }
+    }
+}
+
+void RtspServer::acceptConnections() {
+    while (true) {
+        sockaddr_in peer;
+        socklen_t len = sizeof(peer);
+        int fd = accept4(m_listenFd, reinterpret_cast<sockaddr*>(&peer), &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "[" << m_name << "] accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
+        }
+        if (!addToPoll(m_pollFd, fd, fd)) {
+            close(fd);
+            continue;
+        }
+
+        Connection& conn = m_connections[fd];
+        conn.fd = fd;
+        conn.peer = peer;
+        conn.input.clear();
+
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.connections = static_cast<uint32_t>(m_connections.size());
+    }
+}
+
+void RtspServer::readConnection(int fd) {
+    std::map<int, Connection>::iterator it = m_connections.find(fd);
+    if (it == m_connections.end()) {
+        return;
+    }
+    Connection& conn = it->second;
+
+    char buf[4096];
+    while (true) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            conn.input.append(buf, static_cast<size_t>(n));
+            if (conn.input.size() > kMaxRequestBytes) {
+                std::cerr << "[" << m_name << "] Request too large, closing connection" << std::endl;
+                closeConnection(fd);
+                return;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        closeConnection(fd);  // 对端关闭或出错
+        return;
+    }
+
+    while (true) {
+        size_t end = conn.input.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            break;
+        }
+        Request req;
+        if (!parseRequest(conn.input.substr(0, end), req)) {
+            std::cerr << "[" << m_name << "] Malformed request, closing connection" << std::endl;
+            closeConnection(fd);
+            return;
+        }
+        // 请求体（SET_PARAMETER 等）不使用，跳过
+        size_t total = end + 4;
+        std::map<std::string, std::string>::const_iterator cl = req.headers.find("content-length");
+        if (cl != req.headers.end()) {
+            total += strtoul(cl->second.c_str(), nullptr, 10);
+        }
+        if (conn.input.size() < total) {
+            break;
+        }
+        conn.input.erase(0, total);
+        handleRequest(conn, req);
+    }
+}
+
+void RtspServer::closeConnection(int fd) {
+    std::vector<std::string> ids;
+    for (std::map<std::string, Session>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        if (it->second.connection == fd) {
+            ids.push_back(it->first);
+        }
+    }
+    for (size_t i = 0; i < ids.size(); i++) {
+        removeSession(ids[i]);
+    }
+
+    epoll_ctl(m_pollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_connections.erase(fd);
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.connections = static_cast<uint32_t>(m_connections.size());
+}
+
+void RtspServer::readRtcp() {
+    // 只用接收者报告判断客户端是否还在，内容不解析
+    uint8_t buf[1500];
+    while (true) {
+        sockaddr_in from;
+        socklen_t len = sizeof(from);
+        ssize_t n = recvfrom(m_rtcpFd, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &len);
+        if (n < 0) {
+            return;
+        }
+        for (std::map<std::string, Session>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+            const sockaddr_in& a = it->second.rtcpAddr;
+            if (a.sin_addr.s_addr == from.sin_addr.s_addr && a.sin_port == from.sin_port) {
+                it->second.lastActive = std::chrono::steady_clock::now();
+                break;
+            }
+        }
+    }
+}
+
+void RtspServer::expireSessions() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - m_lastExpireCheck < std::chrono::seconds(1)) {
+        return;
+    }
+    m_lastExpireCheck = now;
+
+    std::vector<std::string> expired;
+    for (std::map<std::string, Session>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        if (now - it->second.lastActive > std::chrono::seconds(m_config.sessionTimeoutSec)) {
+            expired.push_back(it->first);
+        }
+    }
+    for (size_t i = 0; i < expired.size(); i++) {
+        std::cout << "[" << m_name << "] Session " << expired[i] << " timed out" << std::endl;
+        removeSession(expired[i]);
+    }
+}
+
+void RtspServer::closeAll() {
+    while (!m_connections.empty()) {
+        closeConnection(m_connections.begin()->first);
+    }
+}
+
+void RtspServer::closeSockets() {
+    int* fds[] = { &m_listenFd, &m_rtpFd, &m_rtcpFd, &m_pollFd };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (*fds[i] >= 0) {
+            close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+}
+
+bool RtspServer::parseRequest(const std::string& text, Request& req) {
+    size_t lineEnd = text.find("\r\n");
+    std::string line = text.substr(0, lineEnd);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = (sp1 == std::string::npos) ? std::string::npos : line.find(' ', sp1 + 1);
+    if (sp2 == std::string::npos || line.compare(sp2 + 1, 5, "RTSP/") != 0) {
+        return false;
+    }
+    req.method = line.substr(0, sp1);
+    req.url = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    while (lineEnd != std::string::npos) {
+        size_t begin = lineEnd + 2;
+        lineEnd = text.find("\r\n", begin);
+        line = text.substr(begin, lineEnd == std::string::npos ? std::string::npos : lineEnd - begin);
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        req.headers[toLower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+
+    std::map<std::string, std::string>::const_iterator it = req.headers.find("cseq");
+    if (it == req.headers.end()) {
+        return false;
+    }
+    req.cseq = it->second;
+    return true;
+}
+
+void RtspServer::handleRequest(Connection& conn, const Request& req) {
+    Session* session = findSession(req);
+    if (session) {
+        session->lastActive = std::chrono::steady_clock::now();
+    }
+
+    if (req.method == "OPTIONS") {
+        sendResponse(conn, req, 200, "OK",
+                     "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, GET_PARAMETER, TEARDOWN\r\n");
+    } else if (req.method == "DESCRIBE") {
+        handleDescribe(conn, req);
+    } else if (req.method == "SETUP") {
+        handleSetup(conn, req);
+    } else if (req.method == "PLAY" || req.method == "PAUSE" || req.method == "TEARDOWN") {
+        if (!session) {
+            sendResponse(conn, req, 454, "Session Not Found");
+        } else if (req.method == "PLAY") {
+            handlePlay(conn, req, *session);
+        } else if (req.method == "PAUSE") {
+            if (session->viewer) {
+                removeViewer(*m_streams[session->stream], session->viewer);
+                session->viewer.reset();
+            }
+            sendResponse(conn, req, 200, "OK", "Session: " + session->id + "\r\n");
+        } else {
+            std::string id = session->id;
+            removeSession(id);
+            sendResponse(conn, req, 200, "OK", "Session: " + id + "\r\n");
+        }
+    } else if (req.method == "GET_PARAMETER") {
+        // 客户端保活
+        sendResponse(conn, req, 200, "OK", session ? "Session: " + session->id + "\r\n" : std::string());
+    } else {
+        sendResponse(conn, req, 501, "Not Implemented");
+    }
+}
+
+void RtspServer::handleDescribe(Connection& conn, const Request& req) {
+    int stream = findStream(req.url);
+    if (stream < 0) {
+        sendResponse(conn, req, 404, "Not Found");
+        return;
+    }
+
+    std::string base = req.url;
+    if (base.empty() || base[base.size() - 1] != '/') {
+        base += '/';
+    }
+    sendResponse(conn, req, 200, "OK", "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n",
+                 buildSdp(stream, conn));
+}
+
+void RtspServer::handleSetup(Connection& conn, const Request& req) {
+    int stream = findStream(req.url);
+    if (stream < 0) {
+        sendResponse(conn, req, 404, "Not Found");
+        return;
+    }
+    if (findSession(req)) {
+        sendResponse(conn, req, 459, "Aggregate Operation Not Allowed");
+        return;
+    }
+
+    // 只支持 UDP 单播
+    std::map<std::string, std::string>::const_iterator it = req.headers.find("transport");
+    std::string transport = (it != req.headers.end()) ? it->second : std::string();
+    int rtpPort = 0;
+    int rtcpPort = 0;
+    size_t pos = transport.find("client_port=");
+    if (transport.find("RTP/AVP") == std::string::npos || transport.find("TCP") != std::string::npos ||
+        transport.find("multicast") != std::string::npos || pos == std::string::npos ||
+        sscanf(transport.c_str() + pos + 12, "%d-%d", &rtpPort, &rtcpPort) < 1 ||
+        rtpPort <= 0 || rtpPort > 65535) {
+        sendResponse(conn, req, 461, "Unsupported Transport");
+        return;
+    }
+    if (rtcpPort <= 0 || rtcpPort > 65535) {
+        rtcpPort = rtpPort + 1;
+    }
+
+    uint32_t sessions = 0;
+    for (std::map<std::string, Session>::const_iterator s = m_sessions.begin(); s != m_sessions.end(); ++s) {
+        if (s->second.stream == stream) {
+            sessions++;
+        }
+    }
+    if (sessions >= m_config.maxViewers) {
+        sendResponse(conn, req, 453, "Not Enough Bandwidth");
+        return;
+    }
+
+    std::random_device rd;
+    char id[17];
+    snprintf(id, sizeof(id), "%08X%08X", rd(), rd());
+
+    Session& session = m_sessions[id];
+    session.id = id;
+    session.stream = stream;
+    session.connection = conn.fd;
+    session.rtpAddr = conn.peer;
+    session.rtpAddr.sin_port = htons(static_cast<uint16_t>(rtpPort));
+    session.rtcpAddr = conn.peer;
+    session.rtcpAddr.sin_port = htons(static_cast<uint16_t>(rtcpPort));
+    session.lastActive = std::chrono::steady_clock::now();
+
+    char headers[256];
+    snprintf(headers, sizeof(headers),
+             "Transport: RTP/AVP;unicast;client_port=%d-%d;server_port=%u-%u;ssrc=%08X\r\n"
+             "Session: %s;timeout=%u\r\n",
+             rtpPort, rtcpPort, m_rtpPort, m_rtpPort + 1, m_streams[stream]->packetizer->ssrc(), id,
+             m_config.sessionTimeoutSec);
+    sendResponse(conn, req, 200, "OK", headers);
+}
+
+void RtspServer::handlePlay(Connection& conn, const Request& req, Session& session) {
+    sendResponse(conn, req, 200, "OK", "Session: " + session.id + "\r\nRange: npt=0.000-\r\n");
+    if (session.viewer) {
+        return;
+    }
+
+    // 回复之后再加入观看者列表，客户端先收到 PLAY 回复再收到 RTP
+    Stream& stream = *m_streams[session.stream];
+    session.viewer = std::make_shared<Viewer>();
+    session.viewer->rtpAddr = session.rtpAddr;
+    addViewer(stream, session.viewer);
+
+    char addr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &session.rtpAddr.sin_addr, addr, sizeof(addr));
+    std::cout << "[" << m_name << "] Session " << session.id << " playing '" << stream.name << "' to "
+              << addr << ":" << ntohs(session.rtpAddr.sin_port) << " ("
+              << viewerCount(session.stream) << " viewers)" << std::endl;
+}
+
+void RtspServer::sendResponse(Connection& conn, const Request& req, int code, const char* reason,
+                              const std::string& headers, const std::string& body) {
+    std::string out = "RTSP/1.0 " + std::to_string(code) + " " + reason + "\r\nCSeq: " + req.cseq +
+                      "\r\nServer: RtspServer\r\n" + headers;
+    if (!body.empty()) {
+        out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    out += "\r\n";
+    out += body;
+
+    ssize_t n = send(conn.fd, out.data(), out.size(), MSG_NOSIGNAL);
+    if (n != static_cast<ssize_t>(out.size())) {
+        std::cerr << "[" << m_name << "] Failed to send " << req.method << " response" << std::endl;
+    }
+}
+
+int RtspServer::findStream(const std::string& url) const {
+    // rtsp://host:port/<name>[/trackID=0]
+    std::string path = url;
+    if (path.compare(0, 7, "rtsp://") == 0) {
+        size_t slash = path.find('/', 7);
+        path = (slash == std::string::npos) ? std::string() : path.substr(slash);
+    }
+    size_t begin = path.find_first_not_of('/');
+    if (begin == std::string::npos) {
+        return -1;
+    }
+    size_t end = path.find_first_of("/?", begin);
+    std::string name = path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+    for (size_t i = 0; i < m_streams.size(); i++) {
+        if (m_streams[i]->name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string RtspServer::buildSdp(int stream, const Connection& conn) {
+    Stream& s = *m_streams[stream];
+    std::vector<uint8_t> vps;
+    std::vector<uint8_t> sps;
+    std::vector<uint8_t> pps;
+    bool h265;
+    {
+        std::lock_guard<std::mutex> lock(s.paramMutex);
+        vps = s.vps;
+        sps = s.sps;
+        pps = s.pps;
+        h265 = s.isH265.load();
+    }
+
+    sockaddr_in local;
+    socklen_t len = sizeof(local);
+    char ip[INET_ADDRSTRLEN] = "0.0.0.0";
+    if (getsockname(conn.fd, reinterpret_cast<sockaddr*>(&local), &len) == 0) {
+        inet_ntop(AF_INET, &local.sin_addr, ip, sizeof(ip));
+    }
+
+    std::string sdp = "v=0\r\n"
+                      "o=- " + std::to_string(time(nullptr)) + " 1 IN IP4 " + ip + "\r\n"
+                      "s=" + s.name + "\r\n"
+                      "c=IN IP4 0.0.0.0\r\n"
+                      "t=0 0\r\n"
+                      "a=control:*\r\n"
+                      "m=video 0 RTP/AVP " + std::to_string(kPayloadType) + "\r\n";
+    std::string pt = std::to_string(kPayloadType);
+    if (h265) {
+        sdp += "a=rtpmap:" + pt + " H265/90000\r\n";
+        if (!sps.empty()) {
+            sdp += "a=fmtp:" + pt + " sprop-vps=" + base64(vps) + ";sprop-sps=" + base64(sps) +
+                   ";sprop-pps=" + base64(pps) + "\r\n";
+        }
+    } else {
+        sdp += "a=rtpmap:" + pt + " H264/90000\r\n";
+        sdp += "a=fmtp:" + pt + " packetization-mode=1";
+        if (sps.size() >= 4) {
+            char profile[16];
+            snprintf(profile, sizeof(profile), "%02X%02X%02X", sps[1], sps[2], sps[3]);
+            sdp += std::string(";profile-level-id=") + profile + ";sprop-parameter-sets=" + base64(sps) +
+                   "," + base64(pps);
+        }
+        sdp += "\r\n";
+    }
+    sdp += "a=control:trackID=0\r\n";
+    return sdp;
+}
+
+RtspServer::Session* RtspServer::findSession(const Request& req) {
+    std::map<std::string, std::string>::const_iterator it = req.headers.find("session");
+    if (it == req.headers.end()) {
+        return nullptr;
+    }
+    std::string id = trim(it->second.substr(0, it->second.find(';')));
+    std::map<std::string, Session>::iterator s = m_sessions.find(id);
+    return (s == m_sessions.end()) ? nullptr : &s->second;
+}
+
+void RtspServer::removeSession(const std::string& id) {
+    std::map<std::string, Session>::iterator it = m_sessions.find(id);
+    if (it == m_sessions.end()) {
+        return;
+    }
+    if (it->second.viewer) {
+        removeViewer(*m_streams[it->second.stream], it->second.viewer);
+        std::cout << "[" << m_name << "] Session " << id << " stopped ("
+                  << viewerCount(it->second.stream) << " viewers)" << std::endl;
+    }
+    m_sessions.erase(it);
+}
+
+void RtspServer::addViewer(Stream& stream, const std::shared_ptr<Viewer>& viewer) {
+    std::lock_guard<std::mutex> lock(stream.viewersMutex);
+    std::shared_ptr<ViewerList> list = std::make_shared<ViewerList>(*stream.viewers);
+    list->push_back(viewer);
+    stream.viewers = list;
+}
+
+void RtspServer::removeViewer(Stream& stream, const std::shared_ptr<Viewer>& viewer) {
+    std::lock_guard<std::mutex> lock(stream.viewersMutex);
+    std::shared_ptr<ViewerList> list = std::make_shared<ViewerList>(*stream.viewers);
+    list->erase(std::remove(list->begin(), list->end(), viewer), list->end());
+    stream.viewers = list;
+}
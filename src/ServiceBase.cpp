@@ -1,14 +1,121 @@
 #include "ServiceBase.h"
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// epoll 事件标识
+static const uint32_t kEventTagTask    = 0;
+static const uint32_t kEventTagChannel = 1;
 
 ServiceBase::ServiceBase(const std::string& name)
-    : m_name(name) {
+    : m_name(name), m_metricInstance(MetricsRegistry::instance().acquireInstance(name)) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_tasksMetric = registry.counter("media_service_tasks_total", "Tasks executed on the service thread",
+                                     metricLabels());
+    m_wakeTaskMetric = registry.counter("media_service_wakeups_total", "Service thread wakeups by reason",
+                                        metricLabels({{"reason", "task"}}));
+    m_wakeChannelMetric = registry.counter("media_service_wakeups_total", "Service thread wakeups by reason",
+                                           metricLabels({{"reason", "channel"}}));
+    m_wakeTimeoutMetric = registry.counter("media_service_wakeups_total", "Service thread wakeups by reason",
+                                           metricLabels({{"reason", "timeout"}}));
+    m_runningMetric = registry.gauge("media_service_running", "Whether the service thread is running",
+                                     metricLabels());
+
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_eventFd < 0 || m_epollFd < 0) {
+        std::cerr << "[" << m_name << "] Failed to create eventfd/epoll: "
+                  << strerror(errno) << std::endl;
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = kEventTagTask;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_eventFd, &ev) != 0) {
+        std::cerr << "[" << m_name << "] Failed to add eventfd to epoll: "
+                  << strerror(errno) << std::endl;
+    }
 }
 
 ServiceBase::~ServiceBase() {
     stop();
     join();
+
+    if (m_epollFd >= 0) {
+        close(m_epollFd);
+    }
+    if (m_eventFd >= 0) {
+        close(m_eventFd);
+    }
+    MetricsRegistry::instance().releaseInstance(m_name, m_metricInstance);
+}
+
+void ServiceBase::enableFrameMetrics() {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    MetricLabels labels = metricLabels();
+    m_frameMetrics.framesIn = registry.counter("media_frames_in_total", "Frames received from MPI", labels);
+    m_frameMetrics.framesOut = registry.counter("media_frames_out_total",
+                                                "Frames delivered to callbacks and subscribers", labels);
+    m_frameMetrics.framesDropped = registry.counter("media_frames_dropped_total",
+                                                    "Frames received but not delivered", labels);
+    m_frameMetrics.bytes = registry.counter("media_bytes_total", "Bytes delivered", labels);
+    m_frameMetrics.timeouts = registry.counter("media_mpi_timeouts_total",
+                                               "Frame fetches that returned no data", labels);
+}
+
+MetricLabels ServiceBase::metricLabels(const MetricLabels& extra) const {
+    MetricLabels labels;
+    labels.push_back(std::make_pair(std::string("service"), m_name));
+    labels.push_back(std::make_pair(std::string("instance"), std::to_string(m_metricInstance)));
+    labels.insert(labels.end(), extra.begin(), extra.end());
+    return labels;
+}
+
+void ServiceBase::countMpiError(const char* call, int code) {
+    char hex[16];
+    snprintf(hex, sizeof(hex), "0x%08x", static_cast<unsigned>(code));
+    MetricsRegistry::instance()
+        .counter("media_mpi_errors_total", "MPI call failures by error code",
+                 metricLabels({{"call", call}, {"code", hex}}))
+        ->inc();
+}
+
+std::shared_ptr<MetricHistogram> ServiceBase::callbackHistogram(const std::string& subscriber) {
+    return MetricsRegistry::instance().histogram("media_callback_duration_seconds",
+                                                 "Time spent in frame callbacks",
+                                                 metricLabels({{"subscriber", subscriber}}));
+}
+
+void ServiceBase::setThreadAttr(const ThreadAttr& attr) {
+    std::lock_guard<std::mutex> lock(m_threadAttrMutex);
+    m_threadAttr = attr;
+}
+
+ThreadAttr ServiceBase::threadAttr() const {
+    std::lock_guard<std::mutex> lock(m_threadAttrMutex);
+    return m_threadAttr;
+}
+
+std::string ServiceBase::defaultThreadName() const {
+    static const size_t kMaxLen = 15;
+    std::string suffix = m_metricInstance > 0 ? "/" + std::to_string(m_metricInstance) : std::string();
+    std::string base = m_name.substr(0, kMaxLen > suffix.size() ? kMaxLen - suffix.size() : 0);
+    return base + suffix;
+}
+
+void* ServiceBase::threadEntry(void* arg) {
+    std::unique_ptr<std::function<void()>> body(static_cast<std::function<void()>*>(arg));
+    (*body)();
+    return nullptr;
 }
 
 void ServiceBase::start() {
@@ -16,14 +123,67 @@ void ServiceBase::start() {
         std::cerr << "[" << m_name << "] Service is already running" << std::endl;
         return;
     }
+    if (m_threadJoinable) {
+        // 上次 stop() 之后没有 join，先回收旧线程
+        join();
+    }
+
+    ThreadAttr attr = threadAttr();
+    if (attr.name.empty()) {
+        attr.name = defaultThreadName();
+    }
 
     m_running.store(true);
-    m_thread = std::thread([this]() {
+    m_runningMetric->set(1);
+
+    // 线程退出时 promise 随 lambda 一起析构，m_exitFuture 进入终止状态
+    std::shared_ptr<TaskPromise> exitPromise = std::make_shared<TaskPromise>();
+    m_exitFuture = exitPromise->getFuture();
+
+    std::function<void()>* body = new std::function<void()>([this, exitPromise, attr]() {
         m_threadId = std::this_thread::get_id();
-        std::cout << "[" << m_name << "] Service thread started" << std::endl;
+        // 设置失败的属性已打印警告，日志中给出实际生效的属性
+        bool applied = applyThreadAttr(attr, m_name);
+        std::cout << "[" << m_name << "] Service thread started (" << describeThreadAttr(currentThreadAttr())
+                  << (applied ? "" : ", requested " + describeThreadAttr(attr)) << ")" << std::endl;
         run();
+        // run() 也可能因错误自行返回：清除运行标志，之后的 postAsync 不再入队
+        m_running.store(false);
+        // 退出前移除通道 fd，避免下次启动时残留已失效的句柄
+        setChannelFd(-1);
+        // 等待已通过运行标志检查、尚未完成入队的 postAsync，再丢弃剩余任务，
+        // 等待中的 postAsync/postSync 调用方收到取消状态
+        while (m_posting.load() != 0) {
+            std::this_thread::yield();
+        }
+        discardTasks();
+        m_runningMetric->set(0);
         std::cout << "[" << m_name << "] Service thread exited" << std::endl;
+        exitPromise->finish(TaskStatus::Done);
     });
+
+    pthread_attr_t pattr;
+    pthread_attr_init(&pattr);
+    if (attr.stackSize > 0) {
+        size_t stackSize = attr.stackSize < static_cast<size_t>(PTHREAD_STACK_MIN)
+                               ? static_cast<size_t>(PTHREAD_STACK_MIN) : attr.stackSize;
+        int ret = pthread_attr_setstacksize(&pattr, stackSize);
+        if (ret != 0) {
+            std::cerr << "[" << m_name << "] Invalid stack size " << attr.stackSize << ": "
+                      << strerror(ret) << ", using default" << std::endl;
+        }
+    }
+    int ret = pthread_create(&m_thread, &pattr, &ServiceBase::threadEntry, body);
+    pthread_attr_destroy(&pattr);
+
+    if (ret != 0) {
+        std::cerr << "[" << m_name << "] Failed to create service thread: " << strerror(ret) << std::endl;
+        delete body;  // exitPromise 随之析构，m_exitFuture 进入终止状态
+        m_running.store(false);
+        m_runningMetric->set(0);
+        return;
+    }
+    m_threadJoinable = true;
 }
 
 void ServiceBase::stop() {
@@ -32,35 +192,187 @@ void ServiceBase::stop() {
     }
 
     m_running.store(false);
-    m_taskCv.notify_all();  // 唤醒等待的线程
+    wakeup();  // 唤醒等待的线程
 }
 
 void ServiceBase::join() {
-    if (m_thread.joinable()) {
-        m_thread.join();
+    if (m_threadJoinable) {
+        pthread_join(m_thread, nullptr);
+        m_threadJoinable = false;
     }
 }
 
-void ServiceBase::processTasks() {
-    std::unique_lock<std::mutex> lock(m_taskMutex);
-    
-    // 等待任务或停止信号
-    m_taskCv.wait(lock, [this] {
-        return !m_taskQueue.empty() || !m_running.load();
-    });
+bool ServiceBase::join(int timeoutMs) {
+    if (!m_threadJoinable) {
+        return true;
+    }
+
+    if (!m_exitFuture.wait(timeoutMs)) {
+        std::cerr << "[" << m_name << "] Service thread did not exit within "
+                  << timeoutMs << "ms" << std::endl;
+        return false;
+    }
+
+    join();
+    return true;
+}
+
+void ServiceBase::enqueueTask(Task&& task) {
+    bool queued = false;
+    if (!m_overflowActive.load(std::memory_order_acquire)) {
+        queued = m_taskRing.tryPush(std::move(task));
+    }
+
+    if (!queued) {
+        // 环形队列满（或溢出队列尚未清空）：进入溢出队列，保持投递顺序
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflowQueue.push(std::move(task));
+        m_overflowActive.store(true, std::memory_order_release);
+    }
 
-    // 处理所有待处理的任务
-    while (!m_taskQueue.empty() && m_running.load()) {
-        auto task = std::move(m_taskQueue.front());
-        m_taskQueue.pop();
-        
-        lock.unlock();
-        try {
-            task();
-        } catch (const std::exception& e) {
-            std::cerr << "[" << m_name << "] Task exception: " << e.what() << std::endl;
+    wakeup();
+}
+
+void ServiceBase::wakeup() {
+    // 已有未消费的唤醒时无需重复写 eventfd
+    if (m_wakePending.exchange(true)) {
+        return;
+    }
+    signalEventFd();
+}
+
+void ServiceBase::signalEventFd() {
+    if (m_eventFd < 0) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t n = write(m_eventFd, &one, sizeof(one));
+    (void)n;  // 计数器溢出（EAGAIN）时 fd 已处于可读状态，无需处理
+}
+
+bool ServiceBase::setChannelFd(int fd) {
+    if (fd == m_channelFd) {
+        return fd >= 0;
+    }
+
+    if (m_epollFd < 0) {
+        return false;
+    }
+
+    if (m_channelFd >= 0) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, m_channelFd, nullptr);
+        m_channelFd = -1;
+    }
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = kEventTagChannel;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        std::cerr << "[" << m_name << "] Failed to add channel fd " << fd
+                  << " to epoll: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_channelFd = fd;
+    return true;
+}
+
+int ServiceBase::waitEvents(int timeoutMs) {
+    if (m_epollFd < 0) {
+        // epoll 不可用时退化为短暂休眠
+        int sleepMs = (timeoutMs < 0 || timeoutMs > 10) ? 10 : timeoutMs;
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+        return WAIT_TASK;
+    }
+
+    struct epoll_event events[2];
+    int n = epoll_wait(m_epollFd, events, 2, timeoutMs);
+    if (n < 0) {
+        if (errno != EINTR) {
+            std::cerr << "[" << m_name << "] epoll_wait failed: " << strerror(errno) << std::endl;
+        }
+        return WAIT_TIMEOUT;
+    }
+    if (n == 0) {
+        m_wakeTimeoutMetric->inc();
+    }
+
+    int result = WAIT_TIMEOUT;
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.u32 == kEventTagTask) {
+            // 先清空计数再处理任务，处理期间新投递的任务会再次置位
+            uint64_t value = 0;
+            ssize_t r = read(m_eventFd, &value, sizeof(value));
+            (void)r;
+            m_wakePending.store(false);
+            m_wakeTaskMetric->inc();
+            result |= WAIT_TASK;
+        } else if (events[i].data.u32 == kEventTagChannel) {
+            m_wakeChannelMetric->inc();
+            result |= WAIT_CHANNEL;
         }
-        lock.lock();
     }
+    return result;
+}
+
+void ServiceBase::runTask(Task& task) {
+    m_tasksMetric->inc();
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "[" << m_name << "] Task exception: " << e.what() << std::endl;
+    }
+    task.reset();
+}
+
+void ServiceBase::discardTasks() {
+    Task task;
+    while (m_taskRing.tryPop(task)) {
+        task.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(m_overflowMutex);
+    while (!m_overflowQueue.empty()) {
+        m_overflowQueue.pop();
+    }
+    m_overflowActive.store(false, std::memory_order_release);
 }
 
+void ServiceBase::processTasks() {
+    Task task;
+
+    // 单次最多处理一个环形队列容量的任务，避免持续投递时饿死帧处理
+    size_t budget = m_taskRing.capacity();
+    while (budget > 0 && m_running.load() && m_taskRing.tryPop(task)) {
+        runTask(task);
+        budget--;
+    }
+
+    // 溢出队列中的任务晚于环形队列中的任务，环形队列清空后才处理
+    if (budget > 0 && m_overflowActive.load(std::memory_order_acquire)) {
+        std::unique_lock<std::mutex> lock(m_overflowMutex);
+        while (!m_overflowQueue.empty() && m_running.load()) {
+            task = std::move(m_overflowQueue.front());
+            m_overflowQueue.pop();
+
+            lock.unlock();
+            runTask(task);
+            lock.lock();
+        }
+        if (m_overflowQueue.empty()) {
+            m_overflowActive.store(false, std::memory_order_release);
+        }
+    }
+
+    // 仍有剩余任务：重新置位 eventfd，保证下一次 waitEvents() 立即返回
+    if (m_running.load() && (!m_taskRing.emptyApprox() || m_overflowActive.load())) {
+        m_wakePending.store(true);
+        signalEventFd();
+    }
+}
@@ -0,0 +1,185 @@
+#include "StartupScheduler.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* statusName(TaskStatus status) {
+    switch (status) {
+    case TaskStatus::Done:      return "ok";
+    case TaskStatus::Failed:    return "FAILED";
+    case TaskStatus::Cancelled: return "skipped";
+    default:                    return "pending";
+    }
+}
+
+}  // namespace
+
+StartupScheduler::StartupScheduler() {
+    // 阶段大多阻塞在驱动调用上而不是占用 CPU，单核机器上也保留一定并行度
+    unsigned cores = std::thread::hardware_concurrency();
+    m_maxThreads = cores > kMinDefaultThreads ? static_cast<int>(cores) : kMinDefaultThreads;
+}
+
+void StartupScheduler::setMaxThreads(int maxThreads) {
+    m_maxThreads = maxThreads > 0 ? maxThreads : 1;
+}
+
+int StartupScheduler::addStage(const std::string& name, StageFunc func, std::initializer_list<int> deps) {
+    return addStage(name, std::move(func), std::vector<int>(deps));
+}
+
+int StartupScheduler::addStage(const std::string& name, StageFunc func, const std::vector<int>& deps) {
+    int id = static_cast<int>(m_stages.size());
+    m_stages.push_back(Stage());
+    Stage& stage = m_stages.back();
+    stage.func = std::move(func);
+    stage.timing.name = name;
+
+    for (size_t i = 0; i < deps.size(); i++) {
+        int dep = deps[i];
+        if (dep < 0 || dep >= id) {
+            // 只能依赖已添加的阶段，保证无环
+            std::cerr << "[StartupScheduler] Stage " << name << " has invalid dependency " << dep
+                      << std::endl;
+            continue;
+        }
+        stage.deps.push_back(dep);
+        m_stages[dep].dependents.push_back(id);
+    }
+    stage.pendingDeps = static_cast<int>(stage.deps.size());
+    return id;
+}
+
+bool StartupScheduler::run() {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<int> ready;
+    size_t finished = 0;
+    int64_t begin = nowUs();
+
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        m_stages[i].timing.status = TaskStatus::Pending;
+        m_stages[i].pendingDeps = static_cast<int>(m_stages[i].deps.size());
+        if (m_stages[i].pendingDeps == 0) {
+            ready.push_back(static_cast<int>(i));
+        }
+    }
+
+    // 阶段结束：更新依赖它的阶段，失败时连带取消（调用方持有 mutex）
+    std::function<void(int)> complete = [&](int id) {
+        finished++;
+        Stage& stage = m_stages[id];
+        for (size_t i = 0; i < stage.dependents.size(); i++) {
+            Stage& next = m_stages[stage.dependents[i]];
+            if (next.timing.status != TaskStatus::Pending) {
+                continue;
+            }
+            if (stage.timing.status != TaskStatus::Done) {
+                next.timing.status = TaskStatus::Cancelled;
+                next.timing.startUs = nowUs() - begin;
+                complete(stage.dependents[i]);
+            } else if (--next.pendingDeps == 0) {
+                ready.push_back(stage.dependents[i]);
+            }
+        }
+    };
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cond.wait(lock, [&] { return !ready.empty() || finished == m_stages.size(); });
+            if (ready.empty()) {
+                return;
+            }
+            int id = ready.front();
+            ready.pop_front();
+            Stage& stage = m_stages[id];
+            stage.timing.status = TaskStatus::Running;
+            stage.timing.startUs = nowUs() - begin;
+            lock.unlock();
+
+            bool ok = false;
+            try {
+                ok = stage.func ? stage.func() : true;
+            } catch (...) {
+                ok = false;
+            }
+            int64_t end = nowUs() - begin;
+
+            lock.lock();
+            stage.timing.durationUs = end - stage.timing.startUs;
+            stage.timing.status = ok ? TaskStatus::Done : TaskStatus::Failed;
+            if (!ok) {
+                std::cerr << "[StartupScheduler] Stage " << stage.timing.name << " failed" << std::endl;
+            }
+            complete(id);
+            cond.notify_all();
+        }
+    };
+
+    int threads = m_maxThreads;
+    if (threads > static_cast<int>(m_stages.size())) {
+        threads = static_cast<int>(m_stages.size());
+    }
+    if (threads <= 1) {
+        worker();  // 串行：在调用方线程上执行
+    } else {
+        // 调用方线程也参与执行
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; i++) {
+            pool.push_back(std::thread(worker));
+        }
+        worker();
+        for (size_t i = 0; i < pool.size(); i++) {
+            pool[i].join();
+        }
+    }
+
+    m_totalUs = nowUs() - begin;
+
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        if (m_stages[i].timing.status != TaskStatus::Done) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TaskStatus StartupScheduler::getStatus(int stage) const {
+    if (stage < 0 || stage >= static_cast<int>(m_stages.size())) {
+        return TaskStatus::Cancelled;
+    }
+    return m_stages[stage].timing.status;
+}
+
+std::vector<StartupStageTiming> StartupScheduler::getTimings() const {
+    std::vector<StartupStageTiming> timings;
+    timings.reserve(m_stages.size());
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        timings.push_back(m_stages[i].timing);
+    }
+    return timings;
+}
+
+void StartupScheduler::printTimings(std::ostream& out) const {
+    char line[160];
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        const StartupStageTiming& t = m_stages[i].timing;
+        snprintf(line, sizeof(line), "  %-28s %8.2f ms +%8.2f ms  %s\n", t.name.c_str(),
+                 t.startUs / 1000.0, t.durationUs / 1000.0, statusName(t.status));
+        out << line;
+    }
+    snprintf(line, sizeof(line), "  %-28s %8.2f ms\n", "total", m_totalUs / 1000.0);
+    out << line;
+}
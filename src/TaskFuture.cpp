@@ -0,0 +1,176 @@
+#include "TaskFuture.h"
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// 进程级完成槽池（池耗尽时退化为堆分配）
+static const uint32_t kSlotPoolSize = 256;
+static CompletionSlot g_slotPool[kSlotPoolSize];
+
+// 空闲链表头：高 32 位为版本号（防 ABA），低 32 位为池内下标 + 1（0 表示空）
+static std::atomic<uint64_t> g_freeHead(0);
+static std::atomic<bool> g_poolReady(false);
+static std::atomic<bool> g_poolInitializing(false);
+
+static int futexWait(std::atomic<uint32_t>* addr, uint32_t expected, const struct timespec* timeout) {
+    return static_cast<int>(syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr),
+                                    FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0));
+}
+
+static void futexWakeAll(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+
+static void pushFree(CompletionSlot* slot) {
+    uint64_t head = g_freeHead.load(std::memory_order_relaxed);
+    for (;;) {
+        slot->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | (slot->index + 1);
+        if (g_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+static CompletionSlot* popFree() {
+    uint64_t head = g_freeHead.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t top = static_cast<uint32_t>(head);
+        if (top == 0) {
+            return nullptr;
+        }
+        CompletionSlot* slot = &g_slotPool[top - 1];
+        uint32_t next = slot->next.load(std::memory_order_relaxed);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+        if (g_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire,
+                                             std::memory_order_acquire)) {
+            return slot;
+        }
+    }
+}
+
+static void initPool() {
+    if (g_poolReady.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (g_poolInitializing.exchange(true)) {
+        // 其它线程正在初始化，等待完成
+        while (!g_poolReady.load(std::memory_order_acquire)) {
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < kSlotPoolSize; i++) {
+        g_slotPool[i].index = i;
+        pushFree(&g_slotPool[i]);
+    }
+    g_poolReady.store(true, std::memory_order_release);
+}
+
+CompletionSlot* CompletionSlot::acquire() {
+    initPool();
+
+    CompletionSlot* slot = popFree();
+    if (!slot) {
+        slot = new CompletionSlot();
+        slot->index = kHeapIndex;
+    }
+    slot->state.store(static_cast<uint32_t>(TaskStatus::Pending), std::memory_order_relaxed);
+    slot->refs.store(1, std::memory_order_release);
+    return slot;
+}
+
+void CompletionSlot::release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (index == kHeapIndex) {
+        delete this;
+    } else {
+        pushFree(this);
+    }
+}
+
+bool CompletionSlot::transition(TaskStatus from, TaskStatus to) {
+    uint32_t cur = state.load(std::memory_order_acquire);
+    for (;;) {
+        if ((cur & kStatusMask) != static_cast<uint32_t>(from)) {
+            return false;
+        }
+        uint32_t desired = static_cast<uint32_t>(to);
+        bool terminal = (to != TaskStatus::Pending && to != TaskStatus::Running);
+        if (!terminal) {
+            desired |= (cur & kWaiterBit);  // 非终止状态保留等待位
+        }
+        if (state.compare_exchange_weak(cur, desired, std::memory_order_acq_rel,
+                                        std::memory_order_acquire)) {
+            if (terminal && (cur & kWaiterBit)) {
+                futexWakeAll(&state);
+            }
+            return true;
+        }
+    }
+}
+
+bool CompletionSlot::wait(int timeoutMs) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+
+    for (;;) {
+        uint32_t cur = state.load(std::memory_order_acquire);
+        TaskStatus s = static_cast<TaskStatus>(cur & kStatusMask);
+        if (s != TaskStatus::Pending && s != TaskStatus::Running) {
+            return true;
+        }
+
+        // 标记有等待者，完成方据此决定是否需要 futex 唤醒
+        if (!(cur & kWaiterBit)) {
+            if (!state.compare_exchange_weak(cur, cur | kWaiterBit, std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+                continue;
+            }
+            cur |= kWaiterBit;
+        }
+
+        struct timespec ts;
+        struct timespec* pts = nullptr;
+        if (timeoutMs >= 0) {
+            std::chrono::steady_clock::duration left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero()) {
+                return false;
+            }
+            long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+            ts.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+            ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+            pts = &ts;
+        }
+
+        if (futexWait(&state, cur, pts) != 0 && errno == ETIMEDOUT) {
+            TaskStatus after = status();
+            return after != TaskStatus::Pending && after != TaskStatus::Running;
+        }
+    }
+}
+
+bool TaskFuture::waitAll(const std::vector<TaskFuture>& futures, int timeoutMs) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+
+    for (size_t i = 0; i < futures.size(); i++) {
+        int left = -1;
+        if (timeoutMs >= 0) {
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            left = ms > 0 ? static_cast<int>(ms) : 0;
+        }
+        if (!futures[i].wait(left)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,223 @@
+#include "ThreadAttr.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// RK3588：CPU 0-3 为 Cortex-A55，CPU 4-7 为 Cortex-A76
+static const int kRk3588LittleFirst = 0;
+static const int kRk3588BigFirst = 4;
+static const int kRk3588ClusterSize = 4;
+
+// pthread_setname_np 的长度限制（不含结尾 0）
+static const size_t kThreadNameMax = 15;
+
+static std::vector<int> cpuRange(int first, int count) {
+    std::vector<int> cpus;
+    for (int i = 0; i < count; i++) {
+        cpus.push_back(first + i);
+    }
+    return cpus;
+}
+
+std::vector<int> rk3588BigCores() {
+    return cpuRange(kRk3588BigFirst, kRk3588ClusterSize);
+}
+
+std::vector<int> rk3588LittleCores() {
+    return cpuRange(kRk3588LittleFirst, kRk3588ClusterSize);
+}
+
+ThreadAttr ThreadAttr::captureDrain() {
+    ThreadAttr attr;
+    attr.cpus = rk3588BigCores();
+    attr.policy = SCHED_FIFO;
+    attr.priority = kCaptureDrainPriority;
+    return attr;
+}
+
+ThreadAttr ThreadAttr::frameCallback() {
+    ThreadAttr attr;
+    attr.cpus = rk3588BigCores();
+    return attr;
+}
+
+ThreadAttr ThreadAttr::background() {
+    ThreadAttr attr;
+    attr.cpus = rk3588LittleCores();
+    return attr;
+}
+
+static const char* policyName(int policy) {
+    switch (policy) {
+        case SCHED_OTHER: return "SCHED_OTHER";
+        case SCHED_FIFO:  return "SCHED_FIFO";
+        case SCHED_RR:    return "SCHED_RR";
+        default:          return "SCHED_?";
+    }
+}
+
+static std::string formatCpus(const std::vector<int>& cpus) {
+    std::string out;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        if (!out.empty()) {
+            out += ",";
+        }
+        out += std::to_string(cpus[i]);
+        if (j > i) {
+            out += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return out;
+}
+
+std::string describeThreadAttr(const ThreadAttr& attr) {
+    std::string out = "cpus " + (attr.cpus.empty() ? std::string("any") : formatCpus(attr.cpus));
+    out += std::string(", ") + policyName(attr.policy);
+    if (attr.policy == SCHED_FIFO || attr.policy == SCHED_RR) {
+        out += " " + std::to_string(attr.priority);
+    } else if (attr.nice != 0) {
+        out += " nice " + std::to_string(attr.nice);
+    }
+    if (attr.stackSize) {
+        out += ", stack " + std::to_string(attr.stackSize / 1024) + "KB";
+    }
+    return out;
+}
+
+static bool applyAffinity(const std::vector<int>& cpus, const std::string& logName) {
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int count = 0;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        int cpu = cpus[i];
+        if (cpu < 0 || cpu >= CPU_SETSIZE || (configured > 0 && cpu >= configured)) {
+            continue;
+        }
+        CPU_SET(cpu, &set);
+        count++;
+    }
+
+    if (count == 0) {
+        std::cerr << "[" << logName << "] None of cpus " << formatCpus(cpus)
+                  << " exist, CPU affinity unchanged" << std::endl;
+        return false;
+    }
+
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+        std::cerr << "[" << logName << "] Failed to set CPU affinity " << formatCpus(cpus)
+                  << ": " << strerror(ret) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool applyScheduling(const ThreadAttr& attr, const std::string& logName) {
+    bool realtime = attr.policy == SCHED_FIFO || attr.policy == SCHED_RR;
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = realtime ? attr.priority : 0;
+
+    int ret = pthread_setschedparam(pthread_self(), attr.policy, &param);
+    if (ret != 0) {
+        std::cerr << "[" << logName << "] Failed to set " << policyName(attr.policy)
+                  << (realtime ? " " + std::to_string(attr.priority) : std::string())
+                  << ": " << strerror(ret) << ", keeping default scheduling" << std::endl;
+        return false;
+    }
+
+    if (!realtime && attr.nice != 0) {
+        // nice 在 Linux 上按线程生效，需要用线程 ID 设置
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, attr.nice) != 0) {
+            std::cerr << "[" << logName << "] Failed to set nice " << attr.nice
+                      << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool applyThreadAttr(const ThreadAttr& attr, const std::string& logName) {
+    bool ok = true;
+
+    if (!attr.name.empty()) {
+        std::string name = attr.name.substr(0, kThreadNameMax);
+        int ret = pthread_setname_np(pthread_self(), name.c_str());
+        if (ret != 0) {
+            std::cerr << "[" << logName << "] Failed to set thread name: " << strerror(ret) << std::endl;
+            ok = false;
+        }
+    }
+
+    if (!attr.cpus.empty() && !applyAffinity(attr.cpus, logName)) {
+        ok = false;
+    }
+
+    // 默认调度且不改 nice 时不调用，避免覆盖从父线程继承的属性
+    if ((attr.policy != SCHED_OTHER || attr.nice != 0) && !applyScheduling(attr, logName)) {
+        ok = false;
+    }
+
+    return ok;
+}
+
+ThreadAttr currentThreadAttr() {
+    ThreadAttr attr;
+    pthread_t self = pthread_self();
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(self, sizeof(set), &set) == 0) {
+        long configured = sysconf(_SC_NPROCESSORS_CONF);
+        for (int cpu = 0; cpu < CPU_SETSIZE && (configured <= 0 || cpu < configured); cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                attr.cpus.push_back(cpu);
+            }
+        }
+        if (configured > 0 && static_cast<long>(attr.cpus.size()) == configured) {
+            attr.cpus.clear();  // 不限制
+        }
+    }
+
+    int policy = SCHED_OTHER;
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    if (pthread_getschedparam(self, &policy, &param) == 0) {
+        attr.policy = policy;
+        attr.priority = param.sched_priority;
+    }
+    if (attr.policy != SCHED_FIFO && attr.policy != SCHED_RR) {
+        errno = 0;
+        int nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+        if (errno == 0) {
+            attr.nice = nice;
+        }
+    }
+
+    char name[kThreadNameMax + 1] = {};
+    if (pthread_getname_np(self, name, sizeof(name)) == 0) {
+        attr.name = name;
+    }
+
+    pthread_attr_t pattr;
+    if (pthread_getattr_np(self, &pattr) == 0) {
+        size_t stackSize = 0;
+        if (pthread_attr_getstacksize(&pattr, &stackSize) == 0) {
+            attr.stackSize = stackSize;
+        }
+        pthread_attr_destroy(&pattr);
+    }
+    return attr;
+}
@@ -0,0 +1,588 @@
+#include "TsSegmenter.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t kTsPacketSize = 188;
+const uint16_t kPmtPid = 0x1000;
+const uint16_t kVideoPid = 0x0100;
+const uint16_t kProgramNumber = 1;
+const uint8_t kStreamTypeH264 = 0x1B;
+const uint8_t kStreamTypeH265 = 0x24;
+const uint8_t kVideoStreamId = 0xE0;
+
+// PTS 相对 PCR 的解码延迟（90kHz），给解码器留出缓冲时间
+const uint64_t kPtsDelay = 18000;
+const uint64_t kPtsMask = (1ULL << 33) - 1;
+
+// 分段写超过预分配长度时的扩展步长
+const uint64_t kPreallocateStep = 4 * 1024 * 1024;
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** MPEG-2 CRC32（PSI 表用） */
+uint32_t crc32Mpeg(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= static_cast<uint32_t>(data[i]) << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/** 写一个只有一个 section 的 PSI 包（section 不含 CRC，CRC 在这里追加） */
+void writePsiPacket(uint8_t* pkt, uint16_t pid, uint8_t& cc, const uint8_t* section, size_t size) {
+    pkt[0] = 0x47;
+    pkt[1] = static_cast<uint8_t>(0x40 | (pid >> 8));
+    pkt[2] = static_cast<uint8_t>(pid);
+    pkt[3] = static_cast<uint8_t>(0x10 | cc);
+    cc = (cc + 1) & 0x0F;
+    pkt[4] = 0;  // pointer_field
+    memcpy(pkt + 5, section, size);
+    uint32_t crc = crc32Mpeg(section, size);
+    uint8_t* p = pkt + 5 + size;
+    p[0] = static_cast<uint8_t>(crc >> 24);
+    p[1] = static_cast<uint8_t>(crc >> 16);
+    p[2] = static_cast<uint8_t>(crc >> 8);
+    p[3] = static_cast<uint8_t>(crc);
+    memset(p + 4, 0xFF, kTsPacketSize - (5 + size + 4));
+}
+
+void writeTimestamp(uint8_t* p, uint8_t prefix, uint64_t ts) {
+    p[0] = static_cast<uint8_t>((prefix << 4) | ((ts >> 29) & 0x0E) | 1);
+    p[1] = static_cast<uint8_t>(ts >> 22);
+    p[2] = static_cast<uint8_t>(((ts >> 14) & 0xFE) | 1);
+    p[3] = static_cast<uint8_t>(ts >> 7);
+    p[4] = static_cast<uint8_t>(((ts << 1) & 0xFE) | 1);
+}
+
+void writePcr(uint8_t* p, uint64_t base) {
+    p[0] = static_cast<uint8_t>(base >> 25);
+    p[1] = static_cast<uint8_t>(base >> 17);
+    p[2] = static_cast<uint8_t>(base >> 9);
+    p[3] = static_cast<uint8_t>(base >> 1);
+    p[4] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E);  // 扩展部分为 0
+    p[5] = 0;
+}
+
+/** 帧是否以 AUD 开头 */
+bool startsWithAud(const EncodedFrame& frame) {
+    if (frame.segmentCount == 0 || frame.segments[0].size < 5) {
+        return false;
+    }
+    const uint8_t* p = frame.segments[0].data;
+    size_t header = (p[2] == 1) ? 3 : 4;
+    if (frame.segments[0].size <= header) {
+        return false;
+    }
+    int type = frame.isH265 ? (p[header] >> 1) & 0x3F : p[header] & 0x1F;
+    return frame.isH265 ? type == 35 : type == 9;
+}
+
+}  // namespace
+
+TsSegmenter::TsSegmenter(const TsSegmenterConfig& config)
+    : m_config(config) {
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+TsSegmenter::~TsSegmenter() {
+    close();
+}
+
+bool TsSegmenter::open() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_opened) {
+        return true;
+    }
+    struct stat st;
+    if (m_config.dir.empty() || stat(m_config.dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        std::cerr << "[TsSegmenter] Output directory not found: " << m_config.dir << std::endl;
+        return false;
+    }
+
+    size_t packets = m_config.writeBufferBytes / kTsPacketSize;
+    m_buffer.resize((packets > 0 ? packets : 1) * kTsPacketSize);
+    m_bufferUsed = 0;
+    m_nextPrealloc = m_config.preallocateBytes;
+    m_nextDiscontinuity = true;
+
+    scanExistingSegments();
+    applyRetention();
+    m_opened = true;
+    return true;
+}
+
+bool TsSegmenter::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_opened) {
+        return true;
+    }
+    bool ok = closeSegment(0);
+    writePlaylist(true);
+    m_opened = false;
+    return ok;
+}
+
+TsSegmenter::Stats TsSegmenter::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string TsSegmenter::segmentPath(const std::string& name) const {
+    return m_config.dir + "/" + name;
+}
+
+void TsSegmenter::scanExistingSegments() {
+    DIR* dir = opendir(m_config.dir.c_str());
+    if (!dir) {
+        return;
+    }
+
+    // 上次运行留下的 <prefix><序号>.ts：计入保留预算，序号接着往后编
+    std::vector<Segment> found;
+    const std::string& prefix = m_config.prefix;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix.size() + 3 || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - 3, 3, ".ts") != 0) {
+            continue;
+        }
+        std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - 3);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        struct stat st;
+        if (stat(segmentPath(name).c_str(), &st) != 0) {
+            continue;
+        }
+        Segment segment;
+        segment.sequence = strtoull(digits.c_str(), nullptr, 10);
+        segment.name = name;
+        segment.bytes = static_cast<uint64_t>(st.st_size);
+        segment.duration = 0;
+        segment.discontinuity = false;
+        found.push_back(segment);
+    }
+    closedir(dir);
+
+    std::sort(found.begin(), found.end(), [](const Segment& a, const Segment& b) {
+        return a.sequence < b.sequence;
+    });
+    for (size_t i = 0; i < found.size(); i++) {
+        m_segments.push_back(found[i]);
+        m_retainedBytes += found[i].bytes;
+        m_nextSequence = found[i].sequence + 1;
+    }
+    if (!found.empty()) {
+        std::cout << "[TsSegmenter] Found " << found.size() << " existing segments ("
+                  << m_retainedBytes / 1024 / 1024 << " MB), continuing at " << m_nextSequence
+                  << std::endl;
+    }
+}
+
+bool TsSegmenter::writeFrame(const EncodedFrame& frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_opened) {
+        return false;
+    }
+    if (frame.size == 0 || frame.segmentCount == 0) {
+        return true;
+    }
+
+    bool codecChanged = m_fd >= 0 && frame.isH265 != m_isH265;
+    if (frame.isKeyFrame) {
+        // 留半帧余量：GOP 正好等于分段时长时，时间戳取整误差不会把分段推迟一个 GOP
+        uint64_t target = static_cast<uint64_t>(m_config.segmentMs) * 1000;
+        bool due = m_fd < 0 || m_writeFailed || codecChanged || frame.timestamp < m_segmentStart ||
+                   frame.timestamp - m_segmentStart + m_lastFrameInterval / 2 >= target;
+        if (due) {
+            if (m_fd >= 0) {
+                m_nextDiscontinuity = m_nextDiscontinuity || codecChanged;
+                closeSegment(frame.timestamp);
+                writePlaylist(false);
+            }
+            if (!openSegment(frame)) {
+                m_stats.droppedFrames++;
+                return false;
+            }
+        } else {
+            // 分段中间的关键帧前也放 PAT/PMT，从任意关键帧开始都能解码
+            writeTables();
+        }
+    }
+
+    if (m_fd < 0 || m_writeFailed || frame.isH265 != m_isH265) {
+        // 第一个关键帧之前、写入失败后、编码格式变化后的非关键帧：等下一个关键帧
+        m_stats.droppedFrames++;
+        return m_fd >= 0 && !m_writeFailed;
+    }
+
+    writePes(frame);
+    if (m_writeFailed) {
+        m_stats.droppedFrames++;
+        return false;
+    }
+
+    if (m_lastTimestamp != 0 && frame.timestamp > m_lastTimestamp) {
+        m_lastFrameInterval = frame.timestamp - m_lastTimestamp;
+    }
+    m_lastTimestamp = frame.timestamp;
+    m_stats.frames++;
+    return true;
+}
+
+bool TsSegmenter::openSegment(const EncodedFrame& frame) {
+    Segment segment;
+    segment.sequence = m_nextSequence++;
+    segment.name = m_config.prefix + std::to_string(segment.sequence) + ".ts";
+    segment.bytes = 0;
+    segment.duration = 0;
+    segment.discontinuity = m_nextDiscontinuity;
+
+    std::string path = segmentPath(segment.name);
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        std::cerr << "[TsSegmenter] Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    m_current = segment;
+    m_nextDiscontinuity = false;
+    m_isH265 = frame.isH265;
+    m_segmentStart = frame.timestamp;
+    m_lastTimestamp = 0;
+    m_offset = 0;
+    m_allocated = 0;
+    m_writeFailed = false;
+    m_bufferUsed = 0;
+
+    // 按上一分段的大小一次预分配整个分段
+    m_preallocate = m_config.preallocateBytes > 0;
+    preallocate(m_nextPrealloc);
+
+    writeTables();
+    return true;
+}
+
+bool TsSegmenter::closeSegment(uint64_t endTimestamp) {
+    if (m_fd < 0) {
+        return true;
+    }
+
+    int64_t begin = nowUs();
+    bool ok = flushBuffer();
+    if (m_allocated > m_offset) {
+        // 释放 KEEP_SIZE 预分配中没用到的部分
+        if (ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0) {
+            std::cerr << "[TsSegmenter] ftruncate failed: " << strerror(errno) << std::endl;
+        }
+    }
+    // 落盘后再进入播放列表；已落盘的页不会再读，丢弃页缓存
+    fdatasync(m_fd);
+    posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(m_fd);
+    m_fd = -1;
+
+    uint64_t elapsed = static_cast<uint64_t>(nowUs() - begin);
+    if (elapsed > m_stats.maxWriteUs) {
+        m_stats.maxWriteUs = elapsed;
+    }
+
+    if (m_offset == 0) {
+        unlink(segmentPath(m_current.name).c_str());
+        m_nextDiscontinuity = true;
+        return ok;
+    }
+
+    uint64_t end = endTimestamp;
+    if (end <= m_segmentStart) {
+        end = (m_lastTimestamp > m_segmentStart ? m_lastTimestamp : m_segmentStart) + m_lastFrameInterval;
+    }
+    m_current.bytes = m_offset;
+    m_current.duration = (end - m_segmentStart) / 1e6;
+    m_segments.push_back(m_current);
+    m_retainedBytes += m_offset;
+    m_stats.segments++;
+    if (m_writeFailed) {
+        // 写入失败的分段在失败处截断，后面的内容缺失
+        m_nextDiscontinuity = true;
+    }
+
+    // 下一分段预分配：本分段大小再留 25% 余量
+    m_nextPrealloc = m_offset + m_offset / 4;
+
+    applyRetention();
+    return ok;
+}
+
+void TsSegmenter::applyRetention() {
+    while (!m_segments.empty() &&
+           ((m_config.maxSegments > 0 && m_segments.size() > m_config.maxSegments) ||
+            (m_config.maxBytes > 0 && m_retainedBytes > m_config.maxBytes))) {
+        const Segment& oldest = m_segments.front();
+        if (unlink(segmentPath(oldest.name).c_str()) != 0 && errno != ENOENT) {
+            std::cerr << "[TsSegmenter] Failed to delete " << oldest.name << ": " << strerror(errno)
+                      << std::endl;
+        }
+        m_retainedBytes -= oldest.bytes;
+        m_segments.pop_front();
+        m_stats.deletedSegments++;
+    }
+}
+
+void TsSegmenter::writePlaylist(bool endList) {
+    if (m_config.playlist.empty()) {
+        return;
+    }
+
+    // 播放列表窗口：最近 playlistSize 个本次录像的分段
+    size_t first = m_segments.size();
+    while (first > 0 && m_segments[first - 1].duration > 0 &&
+           (m_config.playlistSize == 0 || m_segments.size() - first < m_config.playlistSize)) {
+        first--;
+    }
+
+    double maxDuration = 1.0;
+    for (size_t i = first; i < m_segments.size(); i++) {
+        maxDuration = std::max(maxDuration, m_segments[i].duration);
+    }
+
+    std::string text = "#EXTM3U\n#EXT-X-VERSION:3\n";
+    // HLS 要求 EXTINF 四舍五入后不超过 TARGETDURATION
+    text += "#EXT-X-TARGETDURATION:" + std::to_string(std::lround(maxDuration)) + "\n";
+    uint64_t mediaSequence = first < m_segments.size() ? m_segments[first].sequence : m_nextSequence;
+    text += "#EXT-X-MEDIA-SEQUENCE:" + std::to_string(mediaSequence) + "\n";
+    char line[64];
+    for (size_t i = first; i < m_segments.size(); i++) {
+        if (m_segments[i].discontinuity && i != first) {
+            text += "#EXT-X-DISCONTINUITY\n";
+        }
+        snprintf(line, sizeof(line), "#EXTINF:%.3f,\n", m_segments[i].duration);
+        text += line;
+        text += m_segments[i].name + "\n";
+    }
+    if (endList) {
+        text += "#EXT-X-ENDLIST\n";
+    }
+
+    // 写临时文件后 rename，读取方看到的总是完整的列表
+    std::string path = segmentPath(m_config.playlist);
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[TsSegmenter] Failed to open " << tmpPath << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    ssize_t n = write(fd, text.data(), text.size());
+    ::close(fd);
+    if (n != static_cast<ssize_t>(text.size()) || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "[TsSegmenter] Failed to write playlist " << path << std::endl;
+        unlink(tmpPath.c_str());
+    }
+}
+
+void TsSegmenter::writeTables() {
+    uint8_t pat[] = {
+        0x00,                                         // table_id
+        0xB0, 13,                                     // section_length
+        0x00, 0x01,                                   // transport_stream_id
+        0xC1, 0x00, 0x00,                             // version 0, current, section 0/0
+        static_cast<uint8_t>(kProgramNumber >> 8), static_cast<uint8_t>(kProgramNumber),
+        static_cast<uint8_t>(0xE0 | (kPmtPid >> 8)), static_cast<uint8_t>(kPmtPid),
+    };
+    writePsiPacket(nextPacket(), 0x0000, m_ccPat, pat, sizeof(pat));
+
+    uint8_t pmt[] = {
+        0x02,                                         // table_id
+        0xB0, 18,                                     // section_length
+        static_cast<uint8_t>(kProgramNumber >> 8), static_cast<uint8_t>(kProgramNumber),
+        0xC1, 0x00, 0x00,
+        static_cast<uint8_t>(0xE0 | (kVideoPid >> 8)), static_cast<uint8_t>(kVideoPid),  // PCR_PID
+        0xF0, 0x00,                                   // program_info_length
+        m_isH265 ? kStreamTypeH265 : kStreamTypeH264,
+        static_cast<uint8_t>(0xE0 | (kVideoPid >> 8)), static_cast<uint8_t>(kVideoPid),
+        0xF0, 0x00,                                   // ES_info_length
+    };
+    writePsiPacket(nextPacket(), kPmtPid, m_ccPmt, pmt, sizeof(pmt));
+}
+
+void TsSegmenter::writePes(const EncodedFrame& frame) {
+    static const uint8_t kH264Aud[] = { 0x00, 0x00, 0x00, 0x01, 0x09, 0xF0 };
+    static const uint8_t kH265Aud[] = { 0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x50 };
+
+    uint64_t clock = frame.timestamp * 9 / 100;  // 微秒 -> 90kHz
+    uint64_t pcr = clock & kPtsMask;
+    uint64_t pts = (clock + kPtsDelay) & kPtsMask;
+
+    // PES 头（视频 PES 长度填 0）+ AUD（HLS 要求每个访问单元以 AUD 开头）
+    uint8_t head[32];
+    size_t headSize = 0;
+    head[headSize++] = 0x00;
+    head[headSize++] = 0x00;
+    head[headSize++] = 0x01;
+    head[headSize++] = kVideoStreamId;
+    head[headSize++] = 0x00;
+    head[headSize++] = 0x00;
+    head[headSize++] = 0x80;  // marker
+    head[headSize++] = 0x80;  // PTS
+    head[headSize++] = 5;
+    writeTimestamp(head + headSize, 0x2, pts);
+    headSize += 5;
+    if (!startsWithAud(frame)) {
+        const uint8_t* aud = frame.isH265 ? kH265Aud : kH264Aud;
+        size_t audSize = frame.isH265 ? sizeof(kH265Aud) : sizeof(kH264Aud);
+        memcpy(head + headSize, aud, audSize);
+        headSize += audSize;
+    }
+
+    struct Chunk {
+        const uint8_t* data;
+        size_t size;
+    };
+    Chunk chunks[1 + EncodedFrame::kMaxSegments];
+    int chunkCount = 0;
+    chunks[chunkCount].data = head;
+    chunks[chunkCount++].size = headSize;
+    size_t remaining = headSize;
+    for (int i = 0; i < frame.segmentCount; i++) {
+        chunks[chunkCount].data = frame.segments[i].data;
+        chunks[chunkCount++].size = frame.segments[i].size;
+        remaining += frame.segments[i].size;
+    }
+
+    int chunk = 0;
+    size_t chunkOffset = 0;
+    bool first = true;
+    while (remaining > 0) {
+        uint8_t* pkt = nextPacket();
+
+        // 首包的 adaptation field 带 PCR（关键帧再加随机访问标志），末包用 adaptation field 填充
+        size_t adaptation = first ? 8 : 0;
+        size_t payload = kTsPacketSize - 4 - adaptation;
+        if (remaining < payload) {
+            payload = remaining;
+            adaptation = kTsPacketSize - 4 - payload;
+        }
+
+        pkt[0] = 0x47;
+        pkt[1] = static_cast<uint8_t>((first ? 0x40 : 0x00) | (kVideoPid >> 8));
+        pkt[2] = static_cast<uint8_t>(kVideoPid);
+        pkt[3] = static_cast<uint8_t>((adaptation > 0 ? 0x30 : 0x10) | m_ccVideo);
+        m_ccVideo = (m_ccVideo + 1) & 0x0F;
+
+        uint8_t* p = pkt + 4;
+        if (adaptation > 0) {
+            p[0] = static_cast<uint8_t>(adaptation - 1);
+            if (adaptation > 1) {
+                size_t used = 2;
+                p[1] = 0x00;
+                if (first) {
+                    p[1] = static_cast<uint8_t>(0x10 | (frame.isKeyFrame ? 0x40 : 0x00));
+                    writePcr(p + 2, pcr);
+                    used = 8;
+                }
+                memset(p + used, 0xFF, adaptation - used);
+            }
+            p += adaptation;
+        }
+
+        size_t left = payload;
+        while (left > 0) {
+            size_t take = std::min(left, chunks[chunk].size - chunkOffset);
+            memcpy(p, chunks[chunk].data + chunkOffset, take);
+            p += take;
+            left -= take;
+            chunkOffset += take;
+            if (chunkOffset == chunks[chunk].size) {
+                chunk++;
+                chunkOffset = 0;
+            }
+        }
+        remaining -= payload;
+        first = false;
+    }
+}
+
+uint8_t* TsSegmenter::nextPacket() {
+    if (m_bufferUsed + kTsPacketSize > m_buffer.size()) {
+        flushBuffer();
+    }
+    uint8_t* pkt = &m_buffer[m_bufferUsed];
+    m_bufferUsed += kTsPacketSize;
+    return pkt;
+}
+
+void TsSegmenter::preallocate(uint64_t end) {
+    if (!m_preallocate || m_fd < 0 || end <= m_allocated) {
+        return;
+    }
+    uint64_t target = std::max(end, m_allocated + kPreallocateStep);
+    if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_allocated),
+                  static_cast<off_t>(target - m_allocated)) == 0) {
+        m_allocated = target;
+    } else if (errno == EOPNOTSUPP || errno == ENOSYS) {
+        m_preallocate = false;
+    }
+}
+
+bool TsSegmenter::flushBuffer() {
+    if (m_bufferUsed == 0) {
+        return !m_writeFailed;
+    }
+    if (m_writeFailed || m_fd < 0) {
+        m_bufferUsed = 0;
+        return false;
+    }
+
+    int64_t begin = nowUs();
+    preallocate(m_offset + m_bufferUsed);
+    size_t written = 0;
+    while (written < m_bufferUsed) {
+        ssize_t n = pwrite(m_fd, &m_buffer[written], m_bufferUsed - written,
+                           static_cast<off_t>(m_offset + written));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[TsSegmenter] Write to " << m_current.name << " failed: " << strerror(errno)
+                      << std::endl;
+            m_stats.writeErrors++;
+            m_writeFailed = true;
+            m_bufferUsed = 0;
+            // 截掉写了一半的缓冲，分段保持在完整的 TS 包边界
+            if (ftruncate(m_fd, static_cast<off_t>(m_offset)) != 0) {
+                std::cerr << "[TsSegmenter] ftruncate failed: " << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+
+    m_offset += m_bufferUsed;
+    m_stats.bytes += m_bufferUsed;
+    m_bufferUsed = 0;
+
+    uint64_t elapsed = static_cast<uint64_t>(nowUs() - begin);
+    if (elapsed > m_stats.maxWriteUs) {
+        m_stats.maxWriteUs = elapsed;
+    }
+    return true;
+}
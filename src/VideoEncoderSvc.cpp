@@ -1,7 +1,12 @@
 #include "VideoEncoderSvc.h"
+#include "EncodedFrameRing.h"
+#include "LatencyTracer.h"
+#include "PipelineConfig.h"
+#include <chrono>
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
+#include <vector>
 
 // MPP 头文件
 #include "rk_mpi_venc.h"
@@ -9,24 +14,243 @@
 #include "rk_comm_venc.h"
 #include "rk_common.h"
 
+namespace {
+
+/**
+ * @brief VENC 码流持有者：析构时调用 RK_MPI_VENC_ReleaseStream 归还码流缓冲区
+ */
+struct VencStreamHolder {
+    VENC_CHN chn;
+    VENC_STREAM_S stream;
+    std::vector<VENC_PACK_S> packs;
+    std::shared_ptr<std::atomic<int>> outstanding;
+
+    VencStreamHolder(VENC_CHN c, const VENC_STREAM_S& s,
+                     const std::shared_ptr<std::atomic<int>>& counter)
+        : chn(c), stream(s), packs(s.pstPack, s.pstPack + s.u32PackCount), outstanding(counter) {
+        stream.pstPack = packs.data();
+        outstanding->fetch_add(1);
+    }
+
+    ~VencStreamHolder() {
+        RK_S32 s32Ret = RK_MPI_VENC_ReleaseStream(chn, &stream);
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << "[VideoEncoderSvc] RK_MPI_VENC_ReleaseStream failed: " << s32Ret
+                      << " (chn=" << chn << ")" << std::endl;
+        }
+        outstanding->fetch_sub(1);
+    }
+};
+
+/**
+ * @brief 扫描 Annex-B 起始码，找到第一个 VCL NAL 并判断是否为随机接入点
+ *
+ * 只扫描到第一个 VCL NAL 为止（前面只有 SPS/PPS/SEI 等小参数集）。
+ */
+bool isRandomAccessPack(const uint8_t* p, size_t len, bool h265) {
+    for (size_t i = 0; i + 3 < len; i++) {
+        if (p[i] != 0 || p[i + 1] != 0 || p[i + 2] != 1) {
+            continue;
+        }
+        uint8_t header = p[i + 3];
+        if (h265) {
+            int type = (header >> 1) & 0x3f;
+            if (type < 32) {
+                return type >= 16 && type <= 21;  // BLA/IDR/CRA
+            }
+        } else {
+            int type = header & 0x1f;
+            if (type >= 1 && type <= 5) {
+                return type == 5;  // IDR
+            }
+        }
+        i += 2;
+    }
+    return false;
+}
+
+/**
+ * @brief 根据 VENC 报告的 NALU 类型判断是否为关键帧
+ *
+ * 只认 IDR：*_NALU_ISLICE 也用于帧内刷新/GOP 内的周期 I 帧，不是随机访问点
+ * （H265 的 CRA/BLA 由 isRandomAccessPack() 按 NAL 头识别）。
+ */
+bool isKeyPackType(const VENC_PACK_S& pack, bool h265) {
+    if (h265) {
+        return pack.DataType.enH265EType == H265E_NALU_IDRSLICE;
+    }
+    return pack.DataType.enH264EType == H264E_NALU_IDRSLICE;
+}
+
+/**
+ * @brief 填写 CBR 码控属性（H264/H265 结构成员相同）
+ */
+template<typename CbrAttr>
+void fillCbrAttr(CbrAttr& rc, RK_U32 gop, RK_U32 srcFps, RK_U32 fps, RK_U32 kbps) {
+    rc.u32Gop = gop;
+    rc.u32BitRate = kbps;
+    rc.u32StatTime = 1;
+    rc.u32SrcFrameRateNum = srcFps;
+    rc.u32SrcFrameRateDen = 1;
+    rc.fr32DstFrameRateNum = fps;
+    rc.fr32DstFrameRateDen = 1;
+}
+
+/**
+ * @brief 填写 VBR/AVBR 码控属性
+ */
+template<typename VbrAttr>
+void fillVbrAttr(VbrAttr& rc, RK_U32 gop, RK_U32 srcFps, RK_U32 fps, RK_U32 kbps, RK_U32 maxKbps,
+                 RK_U32 minKbps) {
+    rc.u32Gop = gop;
+    rc.u32BitRate = kbps;
+    rc.u32MaxBitRate = maxKbps;
+    rc.u32MinBitRate = minKbps;
+    rc.u32StatTime = 1;
+    rc.u32SrcFrameRateNum = srcFps;
+    rc.u32SrcFrameRateDen = 1;
+    rc.fr32DstFrameRateNum = fps;
+    rc.fr32DstFrameRateDen = 1;
+}
+
+}  // namespace
+
+// GetStream 超时（无通道 fd 时使用）
+static const int kStreamTimeoutMs = 100;
+// 空闲等待上限（有通道 fd 时使用，到期后重新检查状态）
+static const int kIdleWaitMs = 1000;
+// 重建通道前等待借出码流归还的上限
+static const int kStreamDrainTimeoutMs = 500;
+
+EncodedFrame copyEncodedFrame(const EncodedFrame& frame, PacketBufferPool& pool) {
+    EncodedFrame copy = frame;
+    copy.data = pool.acquire(frame.size);
+    copy.zeroCopy = false;
+    if (!copy.data) {
+        copy.size = 0;
+        copy.segmentCount = 0;
+        return copy;
+    }
+
+    uint8_t* dst = copy.data.get();
+    for (int i = 0; i < frame.segmentCount; i++) {
+        memcpy(dst, frame.segments[i].data, frame.segments[i].size);
+        copy.segments[i].data = dst;
+        dst += frame.segments[i].size;
+    }
+    copy.contiguous = true;
+    return copy;
+}
+
 VideoEncoderSvc::VideoEncoderSvc()
-    : ServiceBase("VideoEncoderSvc") {
+    : ServiceBase("VideoEncoderSvc"),
+      m_packs(new VENC_PACK_S[EncodedFrame::kMaxSegments]),
+      m_packetPool(PacketBufferPool::shared()) {
+    setThreadAttr(ThreadAttr::captureDrain());
+    enableFrameMetrics();
+    m_callbackMetric = callbackHistogram("callback");
+    setSequenceFps(m_params.fps);
+    m_metricsCollector.reset([this](MetricsWriter& writer) { collectMetrics(writer); });
 }
 
 VideoEncoderSvc::~VideoEncoderSvc() {
     stop();
     join();
-    cleanupEncoder();
+    m_dispatcher.removeAll();
 }
 
 void VideoEncoderSvc::setEncodeParams(const EncodeParams& params) {
+    reconfigure(params);
+}
+
+TaskFuture VideoEncoderSvc::reconfigure(const EncodeParams& params) {
+    TaskPromise promise;
+    TaskFuture future = promise.getFuture();
+    if (!validateEncodeParams(params)) {
+        promise.finish(TaskStatus::Failed);
+        return future;
+    }
+
+    if (!m_running.load()) {
+        // 未运行：只保存，创建通道时生效
+        std::lock_guard<std::mutex> lock(m_paramsMutex);
+        m_params = params;
+        setSequenceFps(params.fps);
+        promise.finish(TaskStatus::Done);
+        return future;
+    }
+
+    // 运行中：在服务线程上应用，与取流互斥，不需要额外加锁
+    return postAsync([this, params]() { return applyParams(params); });
+}
+
+void VideoEncoderSvc::setChannelRebuilder(ChannelRebuilder rebuilder) {
+    std::lock_guard<std::mutex> lock(m_rebuilderMutex);
+    m_rebuilder = std::move(rebuilder);
+}
+
+EncodeParams VideoEncoderSvc::getEncodeParams() {
     std::lock_guard<std::mutex> lock(m_paramsMutex);
-    m_params = params;
-    
-    // 如果编码器已初始化，需要重新初始化
-    if (m_encoderInitialized) {
-        cleanupEncoder();
-        initEncoder();
+    return m_params;
+}
+
+void VideoEncoderSvc::fillChnAttr(VENC_CHN_ATTR_S& attr, uint32_t width, uint32_t height) {
+    EncodeParams params = getEncodeParams();
+    if (params.width > 0 && params.height > 0) {
+        width = params.width;
+        height = params.height;
+    }
+    RK_U32 fps = params.fps > 0 ? params.fps : 30;
+    // 源帧率为 VENC 实际输入帧率，目标帧率更低时由 VENC 丢帧
+    RK_U32 srcFps = m_inputFps.load();
+    if (srcFps < fps) {
+        srcFps = fps;
+    }
+    RK_U32 kbps = params.bitrate / 1000;
+    RK_U32 maxKbps = params.maxBitrate > 0 ? params.maxBitrate / 1000 : kbps * 3 / 2;
+    RK_U32 minKbps = params.minBitrate / 1000;
+
+    memset(&attr, 0, sizeof(VENC_CHN_ATTR_S));
+    attr.stVencAttr.enType = params.useH265 ? RK_VIDEO_ID_HEVC : RK_VIDEO_ID_AVC;
+    attr.stVencAttr.enPixelFormat = RK_FMT_YUV420SP;
+    attr.stVencAttr.u32PicWidth = width;
+    attr.stVencAttr.u32PicHeight = height;
+    attr.stVencAttr.u32VirWidth = width;
+    attr.stVencAttr.u32VirHeight = height;
+    attr.stVencAttr.u32StreamBufCnt = params.streamBufCnt;
+    if (params.profile > 0) {
+        attr.stVencAttr.u32Profile = params.profile;
+    } else {
+        attr.stVencAttr.u32Profile = params.useH265 ? H265E_PROFILE_MAIN : H264E_PROFILE_HIGH;
+    }
+
+    RK_U32 gop = params.gop > 0 ? params.gop : fps;
+    switch (params.rcMode) {
+    case RateControlMode::VBR:
+        attr.stRcAttr.enRcMode = params.useH265 ? VENC_RC_MODE_H265VBR : VENC_RC_MODE_H264VBR;
+        if (params.useH265) {
+            fillVbrAttr(attr.stRcAttr.stH265Vbr, gop, srcFps, fps, kbps, maxKbps, minKbps);
+        } else {
+            fillVbrAttr(attr.stRcAttr.stH264Vbr, gop, srcFps, fps, kbps, maxKbps, minKbps);
+        }
+        break;
+    case RateControlMode::AVBR:
+        attr.stRcAttr.enRcMode = params.useH265 ? VENC_RC_MODE_H265AVBR : VENC_RC_MODE_H264AVBR;
+        if (params.useH265) {
+            fillVbrAttr(attr.stRcAttr.stH265Avbr, gop, srcFps, fps, kbps, maxKbps, minKbps);
+        } else {
+            fillVbrAttr(attr.stRcAttr.stH264Avbr, gop, srcFps, fps, kbps, maxKbps, minKbps);
+        }
+        break;
+    case RateControlMode::CBR:
+    default:
+        attr.stRcAttr.enRcMode = params.useH265 ? VENC_RC_MODE_H265CBR : VENC_RC_MODE_H264CBR;
+        if (params.useH265) {
+            fillCbrAttr(attr.stRcAttr.stH265Cbr, gop, srcFps, fps, kbps);
+        } else {
+            fillCbrAttr(attr.stRcAttr.stH264Cbr, gop, srcFps, fps, kbps);
+        }
+        break;
     }
 }
 
@@ -35,6 +259,88 @@ void VideoEncoderSvc::setEncodeCallback(EncodeCallback callback) {
     m_callback = callback;
 }
 
+int VideoEncoderSvc::addSubscriber(const std::string& name, EncodeCallback callback,
+                                   size_t capacity, OverflowPolicy policy) {
+    // 统计回调耗时；开启追踪时同时记录回调返回时间
+    std::shared_ptr<MetricHistogram> metric = callbackHistogram(name);
+    EncodeCallback traced = [this, name, callback, metric](const EncodedFrame& frame) {
+        uint64_t start = LatencyTracer::nowUs();
+        callback(frame);
+        uint64_t end = LatencyTracer::nowUs();
+        metric->observe(end - start);
+        std::shared_ptr<LatencyTracer> tracer = getLatencyTracer();
+        if (tracer) {
+            tracer->recordCallback(LatencyTracer::kPathVenc, name, frame.timestamp, start, end);
+        }
+    };
+    return m_dispatcher.addSubscriber(name, std::move(traced), capacity, policy);
+}
+
+bool VideoEncoderSvc::removeSubscriber(int id) {
+    return m_dispatcher.removeSubscriber(id);
+}
+
+bool VideoEncoderSvc::getSubscriberStats(int id, SubscriberStats& stats) const {
+    return m_dispatcher.getStats(id, stats);
+}
+
+std::shared_ptr<EncodedFrameRing> VideoEncoderSvc::enableFrameRing(size_t byteBudget) {
+    std::shared_ptr<EncodedFrameRing> ring = std::make_shared<EncodedFrameRing>(byteBudget, m_packetPool);
+    {
+        std::lock_guard<std::mutex> lock(m_frameRingMutex);
+        m_frameRing = ring;
+    }
+    std::cout << "[" << m_name << "] Frame ring enabled, budget=" << byteBudget << " bytes" << std::endl;
+    return ring;
+}
+
+void VideoEncoderSvc::disableFrameRing() {
+    std::lock_guard<std::mutex> lock(m_frameRingMutex);
+    m_frameRing.reset();
+}
+
+std::shared_ptr<EncodedFrameRing> VideoEncoderSvc::getFrameRing() {
+    std::lock_guard<std::mutex> lock(m_frameRingMutex);
+    return m_frameRing;
+}
+
+void VideoEncoderSvc::collectMetrics(MetricsWriter& writer) {
+    m_dispatcher.forEachStats([&](const std::string& name, const SubscriberStats& stats) {
+        MetricLabels labels = metricLabels({{"subscriber", name}});
+        writer.counter("media_subscriber_delivered_total", "Frames handed to subscriber callbacks", labels,
+                       stats.delivered);
+        writer.counter("media_subscriber_dropped_total", "Frames dropped because the subscriber queue was full",
+                       labels, stats.dropped);
+        writer.gauge("media_subscriber_queue_depth", "Frames waiting in the subscriber queue", labels,
+                     static_cast<double>(stats.queued));
+    });
+    MetricLabels labels = metricLabels();
+    writer.gauge("media_venc_outstanding_streams", "Zero-copy VENC streams still held by consumers", labels,
+                 m_outstandingStreams->load());
+    writer.counter("media_venc_zero_copy_fallbacks_total", "Streams copied because the zero-copy budget was used up",
+                   labels, m_zeroCopyFallbacks.load());
+    FrameSequenceTracker::Stats sequence = m_sequence.stats();
+    writer.counter("media_upstream_dropped_frames_total",
+                   "Frames dropped before they were fetched, inferred from PTS and sequence gaps", labels,
+                   sequence.dropped);
+    writer.counter("media_duplicate_frames_total", "Frames whose PTS or sequence did not advance", labels,
+                   sequence.duplicated);
+    writer.counter("media_late_frames_total", "Frames fetched later than the configured lateness bound",
+                   labels, sequence.late);
+    writer.gauge("media_frame_drop_rate", "Upstream drop rate over the last window", labels,
+                 sequence.windowDropRate);
+}
+
+void VideoEncoderSvc::setLatencyTracer(const std::shared_ptr<LatencyTracer>& tracer) {
+    std::lock_guard<std::mutex> lock(m_tracerMutex);
+    m_tracer = tracer;
+}
+
+std::shared_ptr<LatencyTracer> VideoEncoderSvc::getLatencyTracer() {
+    std::lock_guard<std::mutex> lock(m_tracerMutex);
+    return m_tracer;
+}
+
 void VideoEncoderSvc::setMPPParams(int vencChnId) {
     m_vencChnId = vencChnId;
     m_useBindingMode = (vencChnId >= 0);
@@ -42,96 +348,359 @@ void VideoEncoderSvc::setMPPParams(int vencChnId) {
               << ", bindingMode=" << m_useBindingMode << std::endl;
 }
 
+void VideoEncoderSvc::setPacketPool(const std::shared_ptr<PacketBufferPool>& pool) {
+    if (m_running.load()) {
+        std::cerr << "[" << m_name << "] Cannot change packet pool while running" << std::endl;
+        return;
+    }
+    m_packetPool = pool ? pool : PacketBufferPool::shared();
+}
+
+void VideoEncoderSvc::setZeroCopy(bool enable, int maxOutstanding) {
+    m_maxOutstandingStreams.store(maxOutstanding > 0 ? maxOutstanding : 1);
+    m_zeroCopy.store(enable);
+    std::cout << "[" << m_name << "] Zero-copy " << (enable ? "enabled" : "disabled")
+              << ", maxOutstanding=" << m_maxOutstandingStreams.load() << std::endl;
+}
+
 void VideoEncoderSvc::run() {
     if (m_useBindingMode) {
         // 绑定模式：从 VENC 循环获取编码流
+        queryChannelInfo();
+        applyRcParam();
+        openChannelFd();
+        m_sequence.resetSequence();  // 停止期间的间隔不算丢帧
+
         while (m_running.load()) {
             processTasks();
-            
-            if (!getEncodedStream()) {
-                usleep(10 * 1000);  // 10ms
+
+            if (m_useFd) {
+                // 空闲等待不超过连续性检查窗口，上游停止出帧时也能按时告警
+                int waitMs = m_sequence.stallCheckMs(LatencyTracer::nowUs(), kIdleWaitMs);
+                if (waitEvents(waitMs) & WAIT_CHANNEL) {
+                    getEncodedStream(0);
+                } else {
+                    m_sequence.checkStall(LatencyTracer::nowUs());
+                }
+            } else if (!getEncodedStream(kStreamTimeoutMs)) {
+                // GetStream 立即返回失败时避免空转，同时保证任务能及时处理
+                waitEvents(10);
             }
         }
+
+        closeChannelFd();
     } else {
         // 非绑定模式：需要手动编码（当前未实现）
         std::cerr << "[" << m_name << "] Non-binding mode not implemented" << std::endl;
     }
 }
 
-bool VideoEncoderSvc::getEncodedStream() {
+void VideoEncoderSvc::openChannelFd() {
+    // 优先等待 VENC 通道 fd，码流就绪、任务投递或停止请求都会立即唤醒线程
+    int vencFd = RK_MPI_VENC_GetFd(m_vencChnId);
+    m_useFd = (vencFd >= 0) && setChannelFd(vencFd);
+    if (!m_useFd) {
+        std::cerr << "[" << m_name << "] VENC fd unavailable (chn=" << m_vencChnId
+                  << "), fallback to timed GetStream" << std::endl;
+    }
+}
+
+void VideoEncoderSvc::closeChannelFd() {
+    if (!m_useFd) {
+        return;
+    }
+    setChannelFd(-1);
+    RK_MPI_VENC_CloseFd(m_vencChnId);
+    m_useFd = false;
+}
+
+bool VideoEncoderSvc::applyParams(const EncodeParams& params) {
+    EncodeParams old = getEncodeParams();
+
+    // 编码格式、尺寸和缓冲配置不能动态修改，只能重建通道
+    bool rebuild = params.useH265 != old.useH265 || params.width != old.width ||
+                   params.height != old.height || params.profile != old.profile ||
+                   params.streamBufCnt != old.streamBufCnt;
+
+    {
+        std::lock_guard<std::mutex> lock(m_paramsMutex);
+        m_params = params;
+    }
+
+    bool ok = rebuild ? rebuildChannel() : updateRcAttr();
+    if (ok) {
+        ok = applyRcParam();
+    }
+    if (!ok) {
+        std::cerr << "[" << m_name << "] Reconfigure failed, restoring previous parameters"
+                  << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(m_paramsMutex);
+            m_params = old;
+        }
+        if (rebuild) {
+            rebuildChannel();
+        } else {
+            updateRcAttr();
+        }
+        applyRcParam();
+        return false;
+    }
+
+    setSequenceFps(params.fps);
+    std::cout << "[" << m_name << "] Reconfigured" << (rebuild ? " (channel rebuilt)" : "")
+              << ": " << m_picWidth << "x" << m_picHeight << " " << (m_isH265 ? "H265" : "H264")
+              << ", bitrate " << params.bitrate << ", fps " << params.fps << ", gop " << params.gop
+              << std::endl;
+    return true;
+}
+
+void VideoEncoderSvc::setSequenceFps(uint32_t fps) {
+    FrameSequenceConfig config = m_sequence.config();
+    if (config.fps != fps) {
+        config.fps = fps;
+        m_sequence.setConfig(config);
+    }
+}
+
+bool VideoEncoderSvc::updateRcAttr() {
+    VENC_CHN_ATTR_S stAttr;
+    memset(&stAttr, 0, sizeof(VENC_CHN_ATTR_S));
+    RK_S32 s32Ret = RK_MPI_VENC_GetChnAttr(m_vencChnId, &stAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << "[" << m_name << "] RK_MPI_VENC_GetChnAttr failed: " << s32Ret << std::endl;
+        return false;
+    }
+
+    // 只替换码控属性，其余保持通道当前值
+    VENC_CHN_ATTR_S stNew;
+    fillChnAttr(stNew, stAttr.stVencAttr.u32PicWidth, stAttr.stVencAttr.u32PicHeight);
+    stAttr.stRcAttr = stNew.stRcAttr;
+
+    s32Ret = RK_MPI_VENC_SetChnAttr(m_vencChnId, &stAttr);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << "[" << m_name << "] RK_MPI_VENC_SetChnAttr failed: " << s32Ret << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool VideoEncoderSvc::rebuildChannel() {
+    ChannelRebuilder rebuilder;
+    {
+        std::lock_guard<std::mutex> lock(m_rebuilderMutex);
+        rebuilder = m_rebuilder;
+    }
+    if (!rebuilder) {
+        std::cerr << "[" << m_name << "] Codec/size change needs a channel rebuilder" << std::endl;
+        return false;
+    }
+
+    // 借出的码流必须在通道销毁前归还
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(kStreamDrainTimeoutMs);
+    while (m_outstandingStreams->load() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (m_outstandingStreams->load() > 0) {
+        std::cerr << "[" << m_name << "] " << m_outstandingStreams->load()
+                  << " zero-copy streams still held, cannot rebuild channel" << std::endl;
+        return false;
+    }
+
+    closeChannelFd();
+    m_sequence.resetSequence();  // 新通道的序号从 0 开始
+    bool ok = rebuilder();
+    queryChannelInfo();
+    openChannelFd();
+    return ok;
+}
+
+bool VideoEncoderSvc::applyRcParam() {
+    EncodeParams params = getEncodeParams();
+    if (params.minQp == 0 && params.maxQp == 0 && params.minIQp == 0 && params.maxIQp == 0) {
+        return true;
+    }
+
+    VENC_RC_PARAM_S stRcParam;
+    memset(&stRcParam, 0, sizeof(VENC_RC_PARAM_S));
+    RK_S32 s32Ret = RK_MPI_VENC_GetRcParam(m_vencChnId, &stRcParam);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << "[" << m_name << "] RK_MPI_VENC_GetRcParam failed: " << s32Ret << std::endl;
+        return false;
+    }
+
+    // H264/H265 的 QP 参数结构相同
+    VENC_PARAM_H264_S& qp = m_isH265 ? stRcParam.stParamH265 : stRcParam.stParamH264;
+    if (params.minQp > 0) {
+        qp.u32MinQp = params.minQp;
+    }
+    if (params.maxQp > 0) {
+        qp.u32MaxQp = params.maxQp;
+    }
+    if (params.minIQp > 0) {
+        qp.u32MinIQp = params.minIQp;
+    }
+    if (params.maxIQp > 0) {
+        qp.u32MaxIQp = params.maxIQp;
+    }
+
+    s32Ret = RK_MPI_VENC_SetRcParam(m_vencChnId, &stRcParam);
+    if (s32Ret != RK_SUCCESS) {
+        std::cerr << "[" << m_name << "] RK_MPI_VENC_SetRcParam failed: " << s32Ret << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void VideoEncoderSvc::queryChannelInfo() {
+    VENC_CHN_ATTR_S stAttr;
+    memset(&stAttr, 0, sizeof(VENC_CHN_ATTR_S));
+    if (RK_MPI_VENC_GetChnAttr(m_vencChnId, &stAttr) == RK_SUCCESS) {
+        m_isH265 = (stAttr.stVencAttr.enType == RK_VIDEO_ID_HEVC);
+        m_picWidth = stAttr.stVencAttr.u32PicWidth;
+        m_picHeight = stAttr.stVencAttr.u32PicHeight;
+    } else {
+        // 取不到通道属性时使用编码参数
+        std::lock_guard<std::mutex> lock(m_paramsMutex);
+        m_isH265 = m_params.useH265;
+        m_picWidth = m_params.width;
+        m_picHeight = m_params.height;
+    }
+}
+
+bool VideoEncoderSvc::getEncodedStream(int timeoutMs) {
+    // pack 数组始终按容量提供：QueryStatus 在码流尚未就绪时（带超时的 GetStream）报告 0 个 pack，
+    // 按它分配会让 SPS/PPS/IDR 等多 pack 的帧被截断或合并
     VENC_STREAM_S stStream;
     memset(&stStream, 0, sizeof(VENC_STREAM_S));
+    memset(m_packs.get(), 0, sizeof(VENC_PACK_S) * EncodedFrame::kMaxSegments);
+    stStream.pstPack = m_packs.get();  // 包数组由调用方提供
+    stStream.u32PackCount = EncodedFrame::kMaxSegments;
     
     // 从 VENC 获取编码流
-    RK_S32 s32Ret = RK_MPI_VENC_GetStream(m_vencChnId, &stStream, 100);  // 100ms 超时
+    RK_S32 s32Ret = RK_MPI_VENC_GetStream(m_vencChnId, &stStream, timeoutMs);
     if (s32Ret != RK_SUCCESS) {
         if (s32Ret != RK_ERR_VENC_BUF_EMPTY) {
             // 不是空缓冲区错误，记录日志，方便排查
             std::cerr << "[VideoEncoderSvc] RK_MPI_VENC_GetStream failed: " << s32Ret
                       << " (chn=" << m_vencChnId << ")" << std::endl;
+            countMpiError("RK_MPI_VENC_GetStream", s32Ret);
+        } else {
+            m_frameMetrics.timeouts->inc();
+            m_sequence.noteTimeout(LatencyTracer::nowUs());
         }
         return false;
     }
+    m_frameMetrics.framesIn->inc();
+    if (stStream.u32PackCount == static_cast<RK_U32>(EncodedFrame::kMaxSegments) &&
+        !stStream.pstPack[stStream.u32PackCount - 1].bFrameEnd) {
+        // pack 数组用满且最后一个不是帧尾：本帧超过 kMaxSegments 个 pack，剩余部分没有取到
+        uint64_t overflows = m_packOverflows.fetch_add(1) + 1;
+        if ((overflows & (overflows - 1)) == 0) {
+            std::cerr << "[" << m_name << "] Frame exceeds " << EncodedFrame::kMaxSegments
+                      << " packs, truncated (" << overflows << " times)" << std::endl;
+        }
+    }
+    std::shared_ptr<LatencyTracer> tracer = getLatencyTracer();
+    uint64_t outputUs = LatencyTracer::nowUs();
+    m_sequence.observe(stStream.pstPack[0].u64PTS, outputUs, stStream.u32Seq, true);
     
-    // 封装编码后的数据
+    // 封装编码后的数据：每个 pack 一个片段
     EncodedFrame encodedFrame;
-    encodedFrame.size = stStream.pstPack->u32Len;
-    encodedFrame.timestamp = stStream.pstPack->u64PTS;
-    encodedFrame.isKeyFrame = (stStream.pstPack->DataType.enH264EType == H264E_NALU_ISLICE);
+    encodedFrame.size = 0;
+    encodedFrame.timestamp = stStream.pstPack[0].u64PTS;
+    encodedFrame.isKeyFrame = false;
+    encodedFrame.width = m_picWidth;
+    encodedFrame.height = m_picHeight;
+    encodedFrame.isH265 = m_isH265;
     
-    // 获取数据指针
-    RK_VOID* pData = RK_MPI_MB_Handle2VirAddr(stStream.pstPack->pMbBlk);
-    if (pData) {
-        // 分配内存并拷贝数据（因为 ReleaseStream 后数据会失效）
-        encodedFrame.data = std::shared_ptr<uint8_t>(new uint8_t[encodedFrame.size], 
-                                                      [](uint8_t* p) { delete[] p; });
-        memcpy(encodedFrame.data.get(), pData, encodedFrame.size);
+    for (RK_U32 i = 0; i < stStream.u32PackCount; i++) {
+        const VENC_PACK_S& pack = stStream.pstPack[i];
+        const uint8_t* pData = static_cast<const uint8_t*>(RK_MPI_MB_Handle2VirAddr(pack.pMbBlk));
+        if (!pData || pack.u32Len == 0) {
+            continue;
+        }
+
+        EncodedSegment& seg = encodedFrame.segments[encodedFrame.segmentCount++];
+        seg.data = pData;
+        seg.size = pack.u32Len;
+        encodedFrame.size += pack.u32Len;
+
+        if (!encodedFrame.isKeyFrame) {
+            encodedFrame.isKeyFrame = isKeyPackType(pack, m_isH265) ||
+                                      isRandomAccessPack(pData, pack.u32Len, m_isH265);
+        }
+    }
+
+    for (int i = 1; i < encodedFrame.segmentCount; i++) {
+        if (encodedFrame.segments[i - 1].data + encodedFrame.segments[i - 1].size !=
+            encodedFrame.segments[i].data) {
+            encodedFrame.contiguous = false;
+            break;
+        }
     }
     
+    std::shared_ptr<VencStreamHolder> holder;
+    if (encodedFrame.segmentCount > 0 && m_zeroCopy.load()) {
+        if (m_outstandingStreams->load() < m_maxOutstandingStreams.load()) {
+            // 零拷贝：data 与持有者共享引用计数，最后一个引用释放时才 ReleaseStream
+            holder = std::make_shared<VencStreamHolder>(m_vencChnId, stStream,
+                                                        m_outstandingStreams);
+            encodedFrame.data = std::shared_ptr<uint8_t>(
+                holder, const_cast<uint8_t*>(encodedFrame.segments[0].data));
+            encodedFrame.zeroCopy = true;
+        } else {
+            m_zeroCopyFallbacks.fetch_add(1);
+        }
+    }
+
+    if (encodedFrame.segmentCount > 0 && !encodedFrame.zeroCopy) {
+        // 从缓冲池申请并拼接所有片段（因为 ReleaseStream 后数据会失效）
+        encodedFrame = copyEncodedFrame(encodedFrame, *m_packetPool);
+    }
+    
+    if (encodedFrame.size > 0) {
+        m_frameMetrics.framesOut->inc();
+        m_frameMetrics.bytes->inc(encodedFrame.size);
+    } else {
+        m_frameMetrics.framesDropped->inc();
+    }
+    if (tracer && encodedFrame.size > 0) {
+        tracer->recordStage(LatencyTracer::kStageVencOutput, encodedFrame.timestamp, outputUs);
+        tracer->recordStage(LatencyTracer::kStageVencDelivery, encodedFrame.timestamp,
+                            LatencyTracer::nowUs());
+    }
+
     // 调用回调
     {
         std::lock_guard<std::mutex> lock(m_callbackMutex);
         if (m_callback && encodedFrame.size > 0) {
+            uint64_t start = LatencyTracer::nowUs();
             m_callback(encodedFrame);
+            uint64_t end = LatencyTracer::nowUs();
+            m_callbackMetric->observe(end - start);
+            if (tracer) {
+                tracer->recordCallback(LatencyTracer::kPathVenc, "callback", encodedFrame.timestamp,
+                                       start, end);
+            }
         }
     }
-    
-    // 释放流（重要：必须释放）
-    RK_MPI_VENC_ReleaseStream(m_vencChnId, &stStream);
-    
-    return true;
-}
 
+    // 分发给异步订阅者（只入队，不等待消费）
+    if (encodedFrame.size > 0) {
+        m_dispatcher.publish(encodedFrame);
 
-bool VideoEncoderSvc::initEncoder() {
-    // TODO: 初始化编码器
-    // 例如：
-    // - x264_encoder_open()
-    // - 或硬件编码器初始化
-    // - 设置编码参数
+        std::shared_ptr<EncodedFrameRing> ring = getFrameRing();
+        if (ring) {
+            ring->push(encodedFrame);
+        }
+    }
     
-    std::lock_guard<std::mutex> lock(m_paramsMutex);
-    std::cout << "[" << m_name << "] Initializing encoder: "
-              << m_params.width << "x" << m_params.height
-              << ", bitrate: " << m_params.bitrate
-              << ", fps: " << m_params.fps
-              << ", format: " << (m_params.useH265 ? "H265" : "H264") << std::endl;
-
-    m_encoderInitialized = true;
-    return true;
-}
-
-void VideoEncoderSvc::cleanupEncoder() {
-    if (!m_encoderInitialized) {
-        return;
+    // 释放流（重要：必须释放）；零拷贝模式下由持有者在最后一个引用释放时归还
+    if (!holder) {
+        RK_MPI_VENC_ReleaseStream(m_vencChnId, &stStream);
     }
-
-    // TODO: 清理编码器资源
-    // 例如：
-    // - x264_encoder_close()
-    // - 或硬件编码器清理
     
-    std::cout << "[" << m_name << "] Cleaning up encoder" << std::endl;
-    m_encoderInitialized = false;
+    return true;
 }
-
@@ -9,6 +9,7 @@
 
 VideoOutputSvc::VideoOutputSvc()
     : ServiceBase("VideoOutputSvc") {
+    setThreadAttr(ThreadAttr::background());
 }
 
 VideoOutputSvc::~VideoOutputSvc() {
@@ -62,7 +63,7 @@ void VideoOutputSvc::run() {
         
         while (m_running.load()) {
             processTasks();
-            usleep(100 * 1000);  // 100ms，主要是处理任务队列
+            waitEvents(-1);  // 仅在有任务或停止请求时唤醒
         }
     } else {
         // 非绑定模式：需要手动发送帧（当前未实现）
@@ -1,4 +1,5 @@
 #include "YUVOutputSvc.h"
+#include "LatencyTracer.h"
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
@@ -9,13 +10,168 @@
 #include "rk_comm_vpss.h"
 #include "rk_common.h"
 
+namespace {
+
+/**
+ * @brief VPSS 输出帧持有者：析构时调用 RK_MPI_VPSS_ReleaseChnFrame 归还缓冲区
+ */
+struct VpssFrameHolder {
+    VPSS_GRP grp;
+    VPSS_CHN chn;
+    VIDEO_FRAME_INFO_S info;
+    std::shared_ptr<std::atomic<int>> heldFrames;
+
+    VpssFrameHolder(VPSS_GRP g, VPSS_CHN c, const VIDEO_FRAME_INFO_S& frame,
+                    const std::shared_ptr<std::atomic<int>>& held)
+        : grp(g), chn(c), info(frame), heldFrames(held) {
+        heldFrames->fetch_add(1);
+    }
+
+    ~VpssFrameHolder() {
+        RK_S32 s32Ret = RK_MPI_VPSS_ReleaseChnFrame(grp, chn, &info);
+        if (s32Ret != RK_SUCCESS) {
+            std::cerr << "[YUVOutputSvc] RK_MPI_VPSS_ReleaseChnFrame failed: " << s32Ret
+                      << " (grp=" << grp << ", chn=" << chn << ")" << std::endl;
+        }
+        heldFrames->fetch_sub(1);
+    }
+};
+
+/**
+ * @brief 根据像素格式和虚宽/虚高填充平面布局
+ *
+ * 10bit 格式按紧凑排列计算字节跨度（每像素 10 bit）。未识别的格式 numPlanes 保持 0。
+ */
+void fillPlaneLayout(VideoFrame& frame, const VIDEO_FRAME_S& vf) {
+    uint32_t virW = vf.u32VirWidth ? vf.u32VirWidth : vf.u32Width;
+    uint32_t virH = vf.u32VirHeight ? vf.u32VirHeight : vf.u32Height;
+    frame.virWidth = static_cast<int>(virW);
+    frame.virHeight = static_cast<int>(virH);
+    frame.numPlanes = 0;
+
+    uint32_t stride = virW;
+    size_t lumaSize = static_cast<size_t>(virW) * virH;
+
+    switch (vf.enPixelFormat) {
+    case RK_FMT_YUV420SP:
+    case RK_FMT_YUV420SP_VU:
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize, stride, virH / 2);
+        break;
+    case RK_FMT_YUV420SP_10BIT:
+        stride = virW * 10 / 8;
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, static_cast<size_t>(stride) * virH, stride, virH / 2);
+        break;
+    case RK_FMT_YUV422SP:
+    case RK_FMT_YUV422SP_VU:
+    case RK_FMT_YUV444SP:
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize,
+                       vf.enPixelFormat == RK_FMT_YUV444SP ? stride * 2 : stride, virH);
+        break;
+    case RK_FMT_YUV422SP_10BIT:
+        stride = virW * 10 / 8;
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, static_cast<size_t>(stride) * virH, stride, virH);
+        break;
+    case RK_FMT_YUV440SP:
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize, stride * 2, virH / 2);
+        break;
+    case RK_FMT_YUV411SP:
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize, stride / 2, virH);
+        break;
+    case RK_FMT_YUV400SP:
+        frame.setPlane(0, 0, stride, virH);
+        break;
+    case RK_FMT_YUV420P:
+    case RK_FMT_YUV420P_VU: {
+        size_t chromaSize = static_cast<size_t>(stride / 2) * (virH / 2);
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize, stride / 2, virH / 2);
+        frame.setPlane(2, lumaSize + chromaSize, stride / 2, virH / 2);
+        break;
+    }
+    case RK_FMT_YUV422P: {
+        size_t chromaSize = static_cast<size_t>(stride / 2) * virH;
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize, stride / 2, virH);
+        frame.setPlane(2, lumaSize + chromaSize, stride / 2, virH);
+        break;
+    }
+    case RK_FMT_YUV444P:
+        frame.setPlane(0, 0, stride, virH);
+        frame.setPlane(1, lumaSize, stride, virH);
+        frame.setPlane(2, lumaSize * 2, stride, virH);
+        break;
+    case RK_FMT_YUV422_YUYV:
+    case RK_FMT_YUV422_UYVY:
+    case RK_FMT_RGB565:
+    case RK_FMT_BGR565:
+        frame.setPlane(0, 0, virW * 2, virH);
+        break;
+    case RK_FMT_RGB888:
+    case RK_FMT_BGR888:
+        frame.setPlane(0, 0, virW * 3, virH);
+        break;
+    case RK_FMT_ARGB8888:
+    case RK_FMT_ABGR8888:
+    case RK_FMT_BGRA8888:
+    case RK_FMT_RGBA8888:
+        frame.setPlane(0, 0, virW * 4, virH);
+        break;
+    default:
+        break;
+    }
+}
+
+}  // namespace
+
+// GetChnFrame 超时（无通道 fd 时使用）
+static const int kFrameTimeoutMs = 100;
+// 空闲等待上限（有通道 fd 时使用，到期后重新检查状态）
+static const int kIdleWaitMs = 1000;
+
 YUVOutputSvc::YUVOutputSvc()
     : ServiceBase("YUVOutputSvc") {
+    // setYUVCallback() 的回调在服务线程中执行，不使用实时调度（见 ThreadAttr::frameCallback()）
+    setThreadAttr(ThreadAttr::frameCallback());
+    enableFrameMetrics();
+    m_callbackMetric = callbackHistogram("callback");
+    m_metricsCollector.reset([this](MetricsWriter& writer) { collectMetrics(writer); });
 }
 
 YUVOutputSvc::~YUVOutputSvc() {
     stop();
     join();
+    m_dispatcher.removeAll();
+}
+
+int YUVOutputSvc::addSubscriber(const std::string& name, YUVCallback callback,
+                                size_t capacity, OverflowPolicy policy) {
+    // 统计回调耗时；开启追踪时同时记录回调返回时间
+    std::shared_ptr<MetricHistogram> metric = callbackHistogram(name);
+    YUVCallback traced = [this, name, callback, metric](const VideoFrameRef& frame) {
+        uint64_t start = LatencyTracer::nowUs();
+        callback(frame);
+        uint64_t end = LatencyTracer::nowUs();
+        metric->observe(end - start);
+        std::shared_ptr<LatencyTracer> tracer = getLatencyTracer();
+        if (tracer) {
+            tracer->recordCallback(LatencyTracer::kPathYuv, name, frame.timestamp, start, end);
+        }
+    };
+    return m_dispatcher.addSubscriber(name, std::move(traced), capacity, policy);
+}
+
+bool YUVOutputSvc::removeSubscriber(int id) {
+    return m_dispatcher.removeSubscriber(id);
+}
+
+bool YUVOutputSvc::getSubscriberStats(int id, SubscriberStats& stats) const {
+    return m_dispatcher.getStats(id, stats);
 }
 
 void YUVOutputSvc::setMPPParams(int vpssGrpId, int vpssChnId) {
@@ -32,37 +188,113 @@ void YUVOutputSvc::setYUVCallback(YUVCallback callback) {
     m_callback = callback;
 }
 
+void YUVOutputSvc::collectMetrics(MetricsWriter& writer) {
+    m_dispatcher.forEachStats([&](const std::string& name, const SubscriberStats& stats) {
+        MetricLabels labels = metricLabels({{"subscriber", name}});
+        writer.counter("media_subscriber_delivered_total", "Frames handed to subscriber callbacks", labels,
+                       stats.delivered);
+        writer.counter("media_subscriber_dropped_total", "Frames dropped because the subscriber queue was full",
+                       labels, stats.dropped);
+        writer.gauge("media_subscriber_queue_depth", "Frames waiting in the subscriber queue", labels,
+                     static_cast<double>(stats.queued));
+    });
+    MetricLabels labels = metricLabels();
+    writer.gauge("media_yuv_held_frames", "VPSS frames currently held by the application", labels,
+                 m_heldFrames->load());
+    FrameSequenceTracker::Stats sequence = m_sequence.stats();
+    writer.counter("media_upstream_dropped_frames_total",
+                   "Frames dropped before they were fetched, inferred from PTS and sequence gaps", labels,
+                   sequence.dropped);
+    writer.counter("media_duplicate_frames_total", "Frames whose PTS or sequence did not advance", labels,
+                   sequence.duplicated);
+    writer.counter("media_late_frames_total", "Frames fetched later than the configured lateness bound",
+                   labels, sequence.late);
+    writer.gauge("media_frame_drop_rate", "Upstream drop rate over the last window", labels,
+                 sequence.windowDropRate);
+}
+
+void YUVOutputSvc::setLatencyTracer(const std::shared_ptr<LatencyTracer>& tracer) {
+    std::lock_guard<std::mutex> lock(m_tracerMutex);
+    m_tracer = tracer;
+}
+
+std::shared_ptr<LatencyTracer> YUVOutputSvc::getLatencyTracer() {
+    std::lock_guard<std::mutex> lock(m_tracerMutex);
+    return m_tracer;
+}
+
 void YUVOutputSvc::run() {
     if (m_useBindingMode) {
         // 绑定模式：从 VPSS 循环获取 YUV 帧
+        // 优先等待 VPSS 通道 fd，有帧、任务投递或停止请求都会立即唤醒线程
+        int vpssFd = RK_MPI_VPSS_GetChnFd(m_vpssGrpId, m_vpssChnId);
+        bool useFd = (vpssFd >= 0) && setChannelFd(vpssFd);
+        m_sequence.resetSequence();  // 停止期间的间隔不算丢帧
+        if (!useFd) {
+            std::cerr << "[" << m_name << "] VPSS fd unavailable (grp=" << m_vpssGrpId
+                      << ", chn=" << m_vpssChnId << "), fallback to timed GetChnFrame" << std::endl;
+        }
+
         while (m_running.load()) {
             processTasks();
-            
-            if (!getYUVFrame()) {
-                usleep(10 * 1000);  // 10ms
+
+            if (useFd) {
+                // 空闲等待不超过连续性检查窗口，上游停止出帧时也能按时告警
+                int waitMs = m_sequence.stallCheckMs(LatencyTracer::nowUs(), kIdleWaitMs);
+                if (waitEvents(waitMs) & WAIT_CHANNEL) {
+                    getYUVFrame(0);
+                } else {
+                    m_sequence.checkStall(LatencyTracer::nowUs());
+                }
+            } else if (!getYUVFrame(kFrameTimeoutMs)) {
+                // GetChnFrame 立即返回失败时避免空转，同时保证任务能及时处理
+                waitEvents(10);
             }
         }
+
+        if (useFd) {
+            setChannelFd(-1);
+        }
     } else {
         // 非绑定模式：需要手动输入帧（当前未实现）
         std::cerr << "[" << m_name << "] Non-binding mode not implemented" << std::endl;
     }
 }
 
-bool YUVOutputSvc::getYUVFrame() {
+bool YUVOutputSvc::getYUVFrame(int timeoutMs) {
     VIDEO_FRAME_INFO_S stFrame;
     memset(&stFrame, 0, sizeof(VIDEO_FRAME_INFO_S));
     
     // 从 VPSS 获取帧
-    RK_S32 s32Ret = RK_MPI_VPSS_GetChnFrame(m_vpssGrpId, m_vpssChnId, &stFrame, 100);  // 100ms 超时
+    RK_S32 s32Ret = RK_MPI_VPSS_GetChnFrame(m_vpssGrpId, m_vpssChnId, &stFrame, timeoutMs);
     if (s32Ret != RK_SUCCESS) {
         if (s32Ret != RK_ERR_VPSS_BUF_EMPTY) {
             // 不是空缓冲区错误，记录日志，方便排查
             std::cerr << "[YUVOutputSvc] RK_MPI_VPSS_GetChnFrame failed: " << s32Ret
                       << " (grp=" << m_vpssGrpId << ", chn=" << m_vpssChnId << ")" << std::endl;
+            countMpiError("RK_MPI_VPSS_GetChnFrame", s32Ret);
+        } else {
+            m_frameMetrics.timeouts->inc();
+            m_sequence.noteTimeout(LatencyTracer::nowUs());
         }
         return false;
     }
+    m_frameMetrics.framesIn->inc();
+    uint64_t outputUs = LatencyTracer::nowUs();
+    m_sequence.observe(stFrame.stVFrame.u64PTS, outputUs);
+    std::shared_ptr<LatencyTracer> tracer = getLatencyTracer();
+    if (tracer) {
+        tracer->recordStage(LatencyTracer::kStageVpssOutput, stFrame.stVFrame.u64PTS, outputUs);
+    }
     
+    // 应用层保留的帧已达上限：直接归还，避免 VPSS 缓冲区耗尽
+    if (m_heldFrames->load() >= m_maxHeldFrames.load()) {
+        RK_MPI_VPSS_ReleaseChnFrame(m_vpssGrpId, m_vpssChnId, &stFrame);
+        m_heldLimitDrops.fetch_add(1);
+        m_frameMetrics.framesDropped->inc();
+        return true;
+    }
+
     // 转换为 VideoFrame
     VideoFrame frame;
     frame.width = stFrame.stVFrame.u32Width;
@@ -70,32 +302,52 @@ bool YUVOutputSvc::getYUVFrame() {
     frame.pixelFormat = stFrame.stVFrame.enPixelFormat;
     frame.timestamp = stFrame.stVFrame.u64PTS;
     
-    // 获取数据指针（注意：ReleaseChnFrame 后数据会失效，需要拷贝或立即处理）
+    // 获取数据指针（帧句柄持有 MB_BLK，最后一个引用释放时才 ReleaseChnFrame）
     MB_BLK mbBlk = stFrame.stVFrame.pMbBlk;
     if (mbBlk) {
         frame.data = static_cast<uint8_t*>(RK_MPI_MB_Handle2VirAddr(mbBlk));
         frame.size = RK_MPI_MB_GetSize(mbBlk);
     }
+    fillPlaneLayout(frame, stFrame.stVFrame);
+
+    VideoFrameRef frameRef(frame, mbBlk,
+                           std::make_shared<VpssFrameHolder>(m_vpssGrpId, m_vpssChnId, stFrame,
+                                                             m_heldFrames));
     
-    // 处理帧（调用回调）
-    processFrame(frame);
-    
-    // 释放帧（重要：必须释放）
-    RK_MPI_VPSS_ReleaseChnFrame(m_vpssGrpId, m_vpssChnId, &stFrame);
+    m_frameMetrics.framesOut->inc();
+    m_frameMetrics.bytes->inc(frame.size);
+    if (tracer) {
+        tracer->recordStage(LatencyTracer::kStageYuvDelivery, frame.timestamp, LatencyTracer::nowUs());
+    }
+
+    // 处理帧（调用回调）；回调未保留句柄时，frameRef 析构即归还帧
+    processFrame(frameRef);
     
     return true;
 }
 
-void YUVOutputSvc::processFrame(const VideoFrame& frame) {
+void YUVOutputSvc::processFrame(const VideoFrameRef& frame) {
     // 调用回调，将 YUV 数据传递给应用层（算法处理）
-    std::lock_guard<std::mutex> lock(m_callbackMutex);
-    
-    if (m_callback) {
-        try {
-            m_callback(frame);
-        } catch (const std::exception& e) {
-            std::cerr << "[" << m_name << "] Callback exception: " << e.what() << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        
+        if (m_callback) {
+            uint64_t start = LatencyTracer::nowUs();
+            try {
+                m_callback(frame);
+                uint64_t end = LatencyTracer::nowUs();
+                m_callbackMetric->observe(end - start);
+                std::shared_ptr<LatencyTracer> tracer = getLatencyTracer();
+                if (tracer) {
+                    tracer->recordCallback(LatencyTracer::kPathYuv, "callback", frame.timestamp, start, end);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "[" << m_name << "] Callback exception: " << e.what() << std::endl;
+            }
         }
     }
+
+    // 分发给异步订阅者（队列中的句柄保留帧，直到订阅者处理完）
+    m_dispatcher.publish(frame);
 }
 
@@ -2,15 +2,23 @@
 #include "VideoEncoderSvc.h"
 #include "YUVOutputSvc.h"
 #include "VideoFrame.h"
+#include "PipelineConfig.h"
+#include "EncodedFrameRing.h"
+#include "Mp4Muxer.h"
+#include "TsSegmenter.h"
+#include "RtspServer.h"
+#include "DiskWriterSvc.h"
+#include "LatencyTracer.h"
+#include "MetricsServer.h"
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <csignal>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <mutex>
 #include <cstring>
-
-// MPP 系统头文件
-#include "rk_mpi_sys.h"
+#include <cstdlib>
 
 // 测试参数（写死）
 static const int WIDTH = 3840;
@@ -20,19 +28,31 @@ static const int VI_DEV_ID = 0;
 static const int VI_PIPE_ID = 0;
 // 对齐 test_mpi_vi 的默认通道配置：channelId 默认为 1
 static const int VI_CHN_ID = 1;
-static const std::string VENC_OUTPUT_FILE = "/data/venc_0.bin";
-static const std::string YUV_OUTPUT_FILE = "/data/yuv_0.raw";
+// 输出目录默认 /data，可用环境变量 MEDIA_TEST_OUTPUT_DIR 覆盖（主机上用软件 MPI 运行时）
+static std::string VENC_OUTPUT_FILE = "/data/venc_0.bin";
+static std::string YUV_OUTPUT_FILE = "/data/yuv_0.raw";
+// 可拖动播放的 fMP4 录像（与裸码流同时写）
+static std::string MP4_OUTPUT_FILE = "/data/venc_0.mp4";
+// 端到端时延追踪（Chrome/Perfetto trace，退出时写出）
+static std::string TRACE_OUTPUT_FILE = "/data/latency_trace.json";
 static const size_t MAX_FILE_SIZE = 50 * 1024 * 1024;  // 50MB
+// 事件录像：收到 SIGUSR1 时把事件前 N 秒（MEDIA_TEST_PREROLL_SEC，默认 5）写到 event_<n>.bin
+static std::string OUTPUT_DIR = "/data";
+static int PREROLL_SEC = 5;
+// RTSP 直播端口（MEDIA_TEST_RTSP_PORT 覆盖）
+static int RTSP_PORT = 8554;
+// 指标采集端点：<输出目录>/metrics.sock，MEDIA_TEST_METRICS_PORT 另开本机 HTTP 端口
+static std::string METRICS_SOCKET = "/data/metrics.sock";
+static int METRICS_PORT = 0;
 
 static volatile bool g_running = true;
-static std::ofstream g_venc_file;
-static std::ofstream g_yuv_file;
-static std::mutex g_venc_file_mutex;
-static std::mutex g_yuv_file_mutex;
-static size_t g_venc_file_size = 0;
-static size_t g_yuv_file_size = 0;
-static int g_frame_count = 0;
-static int g_yuv_count = 0;
+static volatile sig_atomic_t g_event = 0;
+// 裸码流/YUV 转储：回调只把数据拷进写盘服务的缓冲，由写盘线程批量写出
+static std::unique_ptr<DiskWriterSvc> g_writer;
+static int g_venc_file = -1;
+static int g_yuv_file = -1;
+static std::atomic<int> g_frame_count{0};
+static std::atomic<int> g_yuv_count{0};
 
 void signalHandler(int sig) {
     (void)sig;
@@ -40,34 +60,48 @@ void signalHandler(int sig) {
     std::cout << "\n[Test] Received signal, stopping..." << std::endl;
 }
 
+void eventSignalHandler(int sig) {
+    (void)sig;
+    g_event = 1;
+}
+
+// 把预录缓冲中事件前 PREROLL_SEC 秒（从之前最近的 IDR 开始）写到文件
+void saveEventClip(const std::shared_ptr<EncodedFrameRing>& ring, int index) {
+    std::vector<EncodedFrame> frames;
+    ring->extractLast(static_cast<uint64_t>(PREROLL_SEC) * 1000000, frames);
+    if (frames.empty()) {
+        std::cerr << "[Test] Event " << index << ": pre-roll buffer has no key frame yet" << std::endl;
+        return;
+    }
+
+    std::string path = OUTPUT_DIR + "/event_" + std::to_string(index) + ".bin";
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    size_t bytes = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        for (int j = 0; j < frames[i].segmentCount; j++) {
+            file.write(reinterpret_cast<const char*>(frames[i].segments[j].data),
+                       frames[i].segments[j].size);
+        }
+        bytes += frames[i].size;
+    }
+    std::cout << "[Test] Event " << index << ": " << frames.size() << " frames ("
+              << (frames.back().timestamp - frames.front().timestamp) / 1000 << " ms, "
+              << bytes / 1024 << " KB) -> " << path << std::endl;
+}
+
 // 编码数据回调
 void onEncodedFrame(const EncodedFrame& frame) {
     std::cout << "[Test] onEncodedFrame called, size=" << frame.size
               << ", isKeyFrame=" << (frame.isKeyFrame ? "Yes" : "No") << std::endl;
 
-    if (frame.size > 0) {
-        std::lock_guard<std::mutex> lock(g_venc_file_mutex);
-        
-        // 检查文件大小，超过50M则清空重新开始
-        if (g_venc_file_size + frame.size > MAX_FILE_SIZE) {
-            g_venc_file.close();
-            g_venc_file.open(VENC_OUTPUT_FILE, std::ios::binary | std::ios::trunc);
-            g_venc_file_size = 0;
-            std::cout << "[Test] VENC file reset (reached 50MB limit)" << std::endl;
-        }
-        
-        if (g_venc_file.is_open()) {
-            g_venc_file.write(reinterpret_cast<const char*>(frame.data.get()), frame.size);
-            g_venc_file.flush();
-            g_venc_file_size += frame.size;
-            g_frame_count++;
-            
-            if (g_frame_count % 30 == 0) {
-                std::cout << "[Test] Encoded frames: " << g_frame_count 
-                          << ", KeyFrame: " << (frame.isKeyFrame ? "Yes" : "No")
-                          << ", Size: " << frame.size << " bytes"
-                          << ", File: " << (g_venc_file_size / 1024 / 1024) << "MB" << std::endl;
-            }
+    // 文件超过 50MB 时由写盘服务截断从头写
+    if (frame.size > 0 && g_writer->write(g_venc_file, frame)) {
+        int count = ++g_frame_count;
+        if (count % 30 == 0) {
+            std::cout << "[Test] Encoded frames: " << count
+                      << ", KeyFrame: " << (frame.isKeyFrame ? "Yes" : "No")
+                      << ", Size: " << frame.size << " bytes"
+                      << ", File: " << (g_writer->fileSize(g_venc_file) / 1024 / 1024) << "MB" << std::endl;
         }
     }
 }
@@ -79,46 +113,76 @@ void onYUVFrame(const VideoFrame& frame) {
               << ", w=" << frame.width
               << ", h=" << frame.height << std::endl;
 
-    if (frame.data != nullptr && frame.size > 0) {
-        std::lock_guard<std::mutex> lock(g_yuv_file_mutex);
-        
-        // 检查文件大小，超过50M则清空重新开始
-        if (g_yuv_file_size + frame.size > MAX_FILE_SIZE) {
-            g_yuv_file.close();
-            g_yuv_file.open(YUV_OUTPUT_FILE, std::ios::binary | std::ios::trunc);
-            g_yuv_file_size = 0;
-            std::cout << "[Test] YUV file reset (reached 50MB limit)" << std::endl;
-        }
-        
-        if (g_yuv_file.is_open()) {
-            // 注意：frame.data 可能是指向MMAP的指针，需要立即写入
-            // 因为 ReleaseChnFrame 后数据可能失效
-            g_yuv_file.write(reinterpret_cast<const char*>(frame.data), frame.size);
-            g_yuv_file.flush();
-            g_yuv_file_size += frame.size;
-            g_yuv_count++;
-            
-            if (g_yuv_count % 30 == 0) {
-                std::cout << "[Test] YUV frames: " << g_yuv_count 
-                          << ", Size: " << frame.width << "x" << frame.height
-                          << ", File: " << (g_yuv_file_size / 1024 / 1024) << "MB" << std::endl;
-            }
+    // 数据拷进写盘缓冲后回调返回，帧随即归还 VPSS
+    if (frame.data != nullptr && frame.size > 0 && g_writer->write(g_yuv_file, frame)) {
+        int count = ++g_yuv_count;
+        if (count % 30 == 0) {
+            std::cout << "[Test] YUV frames: " << count
+                      << ", Size: " << frame.width << "x" << frame.height
+                      << ", File: " << (g_writer->fileSize(g_yuv_file) / 1024 / 1024) << "MB" << std::endl;
         }
     }
 }
 
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    // 默认拓扑（4K H264 10Mbps），可用配置文件覆盖：test_media_manager [pipeline.conf]
+    PipelineConfig config;
+    config.vi.devId = VI_DEV_ID;
+    config.vi.pipeId = VI_PIPE_ID;
+    config.vi.chnId = VI_CHN_ID;
+    config.vi.entityName = DEVICE;
+    config.vi.width = WIDTH;
+    config.vi.height = HEIGHT;
+    config.venc.bitrate = 10000000;  // 10Mbps
+    config.venc.fps = 30;
+    config.venc.gop = 30;
+    config.venc.useH265 = false;     // H264
+    if (argc > 1 && !loadPipelineConfig(argv[1], config)) {
+        std::cerr << "[Test] Failed to load pipeline config: " << argv[1] << std::endl;
+        return -1;
+    }
+
+    const char* outputDir = getenv("MEDIA_TEST_OUTPUT_DIR");
+    if (outputDir && *outputDir) {
+        OUTPUT_DIR = outputDir;
+        VENC_OUTPUT_FILE = std::string(outputDir) + "/venc_0.bin";
+        YUV_OUTPUT_FILE = std::string(outputDir) + "/yuv_0.raw";
+        MP4_OUTPUT_FILE = std::string(outputDir) + "/venc_0.mp4";
+        TRACE_OUTPUT_FILE = std::string(outputDir) + "/latency_trace.json";
+        METRICS_SOCKET = std::string(outputDir) + "/metrics.sock";
+    }
+    const char* preroll = getenv("MEDIA_TEST_PREROLL_SEC");
+    if (preroll && atoi(preroll) > 0) {
+        PREROLL_SEC = atoi(preroll);
+    }
+    const char* rtspPort = getenv("MEDIA_TEST_RTSP_PORT");
+    if (rtspPort && atoi(rtspPort) > 0) {
+        RTSP_PORT = atoi(rtspPort);
+    }
+    const char* metricsPort = getenv("MEDIA_TEST_METRICS_PORT");
+    if (metricsPort && atoi(metricsPort) > 0) {
+        METRICS_PORT = atoi(metricsPort);
+    }
 
     std::cout << "========================================" << std::endl;
     std::cout << "  MediaManager Test Program" << std::endl;
     std::cout << "========================================" << std::endl;
-    std::cout << "Resolution: " << WIDTH << "x" << HEIGHT << std::endl;
-    std::cout << "Device: " << DEVICE << std::endl;
-    std::cout << "VI Dev/Pipe/Chn: " << VI_DEV_ID << "/" << VI_PIPE_ID << "/" << VI_CHN_ID << std::endl;
+    std::cout << "Resolution: " << config.vi.width << "x" << config.vi.height << std::endl;
+    std::cout << "Device: " << config.vi.entityName << std::endl;
+    std::cout << "VI Dev/Pipe/Chn: " << config.vi.devId << "/" << config.vi.pipeId << "/"
+              << config.vi.chnId << std::endl;
     std::cout << "VENC Output: " << VENC_OUTPUT_FILE << " (max 50MB)" << std::endl;
+    std::cout << "MP4 Output: " << MP4_OUTPUT_FILE << std::endl;
+    std::cout << "HLS Output: " << OUTPUT_DIR << "/hls/index.m3u8 (2s segments, keep 10)" << std::endl;
+    std::cout << "RTSP: rtsp://<ip>:" << RTSP_PORT << "/live" << std::endl;
     std::cout << "YUV Output: " << YUV_OUTPUT_FILE << " (max 50MB)" << std::endl;
+    std::cout << "Latency Trace: " << TRACE_OUTPUT_FILE << std::endl;
+    std::cout << "Metrics: curl --unix-socket " << METRICS_SOCKET << " http://localhost/metrics";
+    if (METRICS_PORT > 0) {
+        std::cout << " | http://127.0.0.1:" << METRICS_PORT << "/metrics";
+    }
+    std::cout << std::endl;
+    std::cout << "Event Pre-roll: " << PREROLL_SEC << "s (kill -USR1 " << getpid() << ")" << std::endl;
     std::cout << "VO Output: (temporarily disabled)" << std::endl;
     std::cout << "Press Ctrl+C to stop" << std::endl;
     std::cout << "========================================" << std::endl;
@@ -127,71 +191,108 @@ int main(int argc, char* argv[]) {
     // 注册信号处理
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    signal(SIGUSR1, eventSignalHandler);
 
-    // 初始化 MPP 系统（非常关键，所有 RK_MPI_* 调用前必须调用）
-    if (RK_MPI_SYS_Init() != RK_SUCCESS) {
-        std::cerr << "[Test] RK_MPI_SYS_Init failed" << std::endl;
-        return -1;
-    }
-    std::cout << "[Test] RK_MPI_SYS_Init ok" << std::endl;
-
-    // 创建 MediaManager
+    // 创建 MediaManager（第一路流水线创建时初始化 MPP 系统，deinit 时退出）
     MediaManager manager;
 
     // 初始化 MediaManager
     std::cout << "[Test] Initializing MediaManager..." << std::endl;
-    if (!manager.init(VI_DEV_ID, VI_PIPE_ID, VI_CHN_ID, DEVICE)) {
+    if (!manager.init(config)) {
         std::cerr << "[Test] Failed to initialize MediaManager" << std::endl;
         return -1;
     }
     std::cout << "[Test] MediaManager initialized successfully" << std::endl;
 
+    // 时延追踪：VI 采集 → VPSS/VENC 输出 → 各订阅者回调返回
+    std::shared_ptr<LatencyTracer> tracer = manager.getPipeline(0)->enableLatencyTracing();
+
+    // 丢帧告警：VENC/VPSS 因取帧不及时丢帧时打印
+    manager.getPipeline(0)->setFrameDropCallback([](const FrameDropAlert& alert) {
+        std::cout << "[Test] " << alert.stage << (alert.active ? " dropping frames: " : " recovered: ")
+                  << alert.windowDropped << " lost / " << alert.windowFrames << " received ("
+                  << alert.dropRate * 100 << "%)" << std::endl;
+    });
+
     // 设置编码回调
     auto encoderSvc = manager.getEncoderService();
+    Mp4MuxerConfig mp4Config;
+    mp4Config.path = MP4_OUTPUT_FILE;
+    std::shared_ptr<Mp4Muxer> mp4Muxer = std::make_shared<Mp4Muxer>(mp4Config);
+    // TS 分段录像：2 秒一段，滚动保留最近 10 段
+    TsSegmenterConfig tsConfig;
+    tsConfig.dir = OUTPUT_DIR + "/hls";
+    tsConfig.segmentMs = 2000;
+    tsConfig.playlistSize = 5;
+    tsConfig.maxSegments = 10;
+    mkdir(tsConfig.dir.c_str(), 0755);
+    std::shared_ptr<TsSegmenter> tsSegmenter = std::make_shared<TsSegmenter>(tsConfig);
+    // RTSP 直播：订阅者线程中打包并扇出给所有观看者
+    RtspServerConfig rtspConfig;
+    rtspConfig.port = static_cast<uint16_t>(RTSP_PORT);
+    std::shared_ptr<RtspServer> rtspServer = std::make_shared<RtspServer>(rtspConfig);
+    int rtspStream = rtspServer->addStream("live", config.venc.useH265);
     std::cout << "[Test] Got encoderSvc ptr: " << (encoderSvc ? "non-null" : "null") << std::endl;
     if (encoderSvc) {
         std::cout << "[Test] Before setEncodeCallback" << std::endl;
-        encoderSvc->setEncodeCallback(onEncodedFrame);
-        
-        // 设置编码参数
-        std::cout << "[Test] Before setEncodeParams" << std::endl;
-        EncodeParams params;
-        params.width = WIDTH;
-        params.height = HEIGHT;
-        params.bitrate = 10000000;  // 10Mbps
-        params.fps = 30;
-        params.gop = 30;
-        params.useH265 = false;  // H264
-        encoderSvc->setEncodeParams(params);
-        
+        // 文件写入较慢，使用异步订阅者，避免阻塞 VENC 取流
+        encoderSvc->addSubscriber("venc-file", onEncodedFrame, 64, OverflowPolicy::DropNewest);
+        if (mp4Muxer->open()) {
+            encoderSvc->addSubscriber("venc-mp4", [mp4Muxer](const EncodedFrame& frame) {
+                mp4Muxer->writeFrame(frame);
+            }, 64, OverflowPolicy::DropNewest);
+        }
+        if (tsSegmenter->open()) {
+            encoderSvc->addSubscriber("venc-ts", [tsSegmenter](const EncodedFrame& frame) {
+                tsSegmenter->writeFrame(frame);
+            }, 64, OverflowPolicy::DropNewest);
+        }
+        if (rtspServer->open()) {
+            rtspServer->start();
+            encoderSvc->addSubscriber("venc-rtsp", [rtspServer, rtspStream](const EncodedFrame& frame) {
+                rtspServer->pushFrame(rtspStream, frame);
+            }, 30, OverflowPolicy::DropOldest);
+        }
+
+        // 预录缓冲：预录时长加一个 GOP，按码率上限估算，留 50% 余量
+        const EncodeParams& venc = config.venc;
+        uint64_t peakBitrate = venc.maxBitrate > venc.bitrate ? venc.maxBitrate : venc.bitrate;
+        double gopSec = static_cast<double>(venc.gop) / venc.fps;
+        size_t budget = static_cast<size_t>(peakBitrate / 8 * (PREROLL_SEC + gopSec) * 1.5);
+        encoderSvc->enableFrameRing(budget);
+
         std::cout << "[Test] Encoder service configured" << std::endl;
     }
 
     // 设置YUV回调
     auto yuvSvc = manager.getYUVService();
     if (yuvSvc) {
-        yuvSvc->setYUVCallback(onYUVFrame);
+        yuvSvc->addSubscriber("yuv-file", onYUVFrame, 2, OverflowPolicy::DropOldest);
         std::cout << "[Test] YUV service configured" << std::endl;
     }
 
-    // 打开VENC输出文件
-    g_venc_file.open(VENC_OUTPUT_FILE, std::ios::binary | std::ios::trunc);
-    if (!g_venc_file.is_open()) {
-        std::cerr << "[Test] Failed to open VENC output file: " << VENC_OUTPUT_FILE << std::endl;
+    // 打开VENC/YUV输出文件（缓冲按 4K NV12 约 10 帧估算）
+    DiskWriterConfig writerConfig;
+    writerConfig.bufferBytes = 128 * 1024 * 1024;
+    g_writer.reset(new DiskWriterSvc(writerConfig));
+    g_venc_file = g_writer->openFile(VENC_OUTPUT_FILE, MAX_FILE_SIZE);
+    g_yuv_file = g_writer->openFile(YUV_OUTPUT_FILE, MAX_FILE_SIZE);
+    if (g_venc_file < 0 || g_yuv_file < 0) {
+        std::cerr << "[Test] Failed to open output files in " << OUTPUT_DIR << std::endl;
         manager.deinit();
         return -1;
     }
-    std::cout << "[Test] VENC output file opened: " << VENC_OUTPUT_FILE << std::endl;
+    g_writer->start();
+    std::cout << "[Test] Output files opened: " << VENC_OUTPUT_FILE << ", " << YUV_OUTPUT_FILE << std::endl;
 
-    // 打开YUV输出文件
-    g_yuv_file.open(YUV_OUTPUT_FILE, std::ios::binary | std::ios::trunc);
-    if (!g_yuv_file.is_open()) {
-        std::cerr << "[Test] Failed to open YUV output file: " << YUV_OUTPUT_FILE << std::endl;
-        g_venc_file.close();
-        manager.deinit();
-        return -1;
+    // 指标采集端点（各服务的计数器在创建时已注册）
+    MetricsServerConfig metricsConfig;
+    metricsConfig.unixPath = METRICS_SOCKET;
+    metricsConfig.tcpPort = static_cast<uint16_t>(METRICS_PORT);
+    MetricsServer metricsServer(metricsConfig);
+    if (metricsServer.open()) {
+        metricsServer.start();
     }
-    std::cout << "[Test] YUV output file opened: " << YUV_OUTPUT_FILE << std::endl;
 
     // 启动所有服务
     std::cout << "[Test] Starting services (VO disabled)..." << std::endl;
@@ -205,13 +306,19 @@ int main(int argc, char* argv[]) {
     std::cout << "[Test] Running... (Press Ctrl+C to stop)" << std::endl;
     std::cout << "----------------------------------------" << std::endl;
     
+    int eventCount = 0;
     while (g_running) {
-        sleep(1);  // 每秒检查一次
+        sleep(1);  // 每秒检查一次（信号会提前唤醒）
+
+        if (g_event && encoderSvc && encoderSvc->getFrameRing()) {
+            g_event = 0;
+            saveEventClip(encoderSvc->getFrameRing(), eventCount++);
+        }
         
         // 每秒输出一次统计信息
         std::cout << "[Test] Running... "
-                  << "VENC: " << g_frame_count << " frames (" << (g_venc_file_size / 1024 / 1024) << "MB), "
-                  << "YUV: " << g_yuv_count << " frames (" << (g_yuv_file_size / 1024 / 1024) << "MB), "
+                  << "VENC: " << g_frame_count << " frames (" << (g_writer->fileSize(g_venc_file) / 1024 / 1024) << "MB), "
+                  << "YUV: " << g_yuv_count << " frames (" << (g_writer->fileSize(g_yuv_file) / 1024 / 1024) << "MB), "
                   << "VO: Disabled in this run" << std::endl;
     }
 
@@ -223,28 +330,35 @@ int main(int argc, char* argv[]) {
     //manager.stopOutputService(); // 本轮测试未启动 VO
     manager.stopYUVService();
 
-    // 关闭文件
-    {
-        std::lock_guard<std::mutex> lock(g_venc_file_mutex);
-        if (g_venc_file.is_open()) {
-            g_venc_file.close();
-            std::cout << "[Test] VENC output file closed" << std::endl;
-        }
-    }
-    
-    {
-        std::lock_guard<std::mutex> lock(g_yuv_file_mutex);
-        if (g_yuv_file.is_open()) {
-            g_yuv_file.close();
-            std::cout << "[Test] YUV output file closed" << std::endl;
-        }
-    }
+    // 写出最后一个分片
+    mp4Muxer->close();
+    Mp4Muxer::Stats mp4Stats = mp4Muxer->stats();
+    tsSegmenter->close();
+    TsSegmenter::Stats tsStats = tsSegmenter->stats();
+    FrameSequenceTracker::Stats vencSequence = encoderSvc ? encoderSvc->getSequenceTracker().stats()
+                                                          : FrameSequenceTracker::Stats();
+    FrameSequenceTracker::Stats yuvSequence = yuvSvc ? yuvSvc->getSequenceTracker().stats()
+                                                     : FrameSequenceTracker::Stats();
+    RtspServer::Stats rtspStats = rtspServer->stats();
+    rtspServer->stop();
+    rtspServer->join();
+    MetricsServer::Stats metricsStats = metricsServer.stats();
+    metricsServer.stop();
+    metricsServer.join();
 
-    // 反初始化
-    manager.deinit();
+    // 关闭文件（写出剩余数据）
+    uint64_t vencFileSize = g_writer->fileSize(g_venc_file);
+    uint64_t yuvFileSize = g_writer->fileSize(g_yuv_file);
+    g_writer->closeFile(g_venc_file);
+    g_writer->closeFile(g_yuv_file);
+    DiskWriterSvc::Stats writerStats = g_writer->stats();
+    std::cout << "[Test] Output files closed" << std::endl;
 
-    // 退出 MPP 系统
-    RK_MPI_SYS_Exit();
+    bool traceSaved = tracer && tracer->exportChromeTrace(TRACE_OUTPUT_FILE);
+
+    // 反初始化（同时退出 MPP 系统）
+    manager.deinit();
+    g_writer.reset();  // 订阅者已全部移除
 
     // 打印统计信息
     std::cout << std::endl;
@@ -253,10 +367,63 @@ int main(int argc, char* argv[]) {
     std::cout << "========================================" << std::endl;
     std::cout << "VENC (Encoding):" << std::endl;
     std::cout << "  - Frames: " << g_frame_count << std::endl;
-    std::cout << "  - File: " << VENC_OUTPUT_FILE << " (" << (g_venc_file_size / 1024 / 1024) << "MB)" << std::endl;
+    std::cout << "  - File: " << VENC_OUTPUT_FILE << " (" << (vencFileSize / 1024 / 1024) << "MB)" << std::endl;
+    std::cout << "MP4:" << std::endl;
+    std::cout << "  - Frames: " << mp4Stats.frames << " in " << mp4Stats.fragments << " fragments, "
+              << mp4Stats.files << " file(s), max fragment write " << mp4Stats.maxFragmentUs / 1000.0
+              << " ms" << std::endl;
+    std::cout << "  - File: " << MP4_OUTPUT_FILE << " (" << (mp4Stats.bytes / 1024 / 1024) << "MB)" << std::endl;
+    std::cout << "HLS:" << std::endl;
+    std::cout << "  - Frames: " << tsStats.frames << " in " << tsStats.segments << " segments ("
+              << tsStats.deletedSegments << " deleted), max write " << tsStats.maxWriteUs / 1000.0
+              << " ms" << std::endl;
+    std::cout << "  - Playlist: " << tsConfig.dir << "/" << tsConfig.playlist << std::endl;
+    std::cout << "RTSP:" << std::endl;
+    std::cout << "  - Frames: " << rtspStats.frames << ", " << rtspStats.packets << " RTP packets, "
+              << rtspStats.datagrams << " datagrams sent, max fan-out " << rtspStats.maxFanoutUs / 1000.0
+              << " ms" << std::endl;
     std::cout << "YUV (Algorithm Feed):" << std::endl;
     std::cout << "  - Frames: " << g_yuv_count << std::endl;
-    std::cout << "  - File: " << YUV_OUTPUT_FILE << " (" << (g_yuv_file_size / 1024 / 1024) << "MB)" << std::endl;
+    std::cout << "  - File: " << YUV_OUTPUT_FILE << " (" << (yuvFileSize / 1024 / 1024) << "MB)" << std::endl;
+    std::cout << "Disk writer:" << std::endl;
+    std::cout << "  - " << writerStats.bytesWritten / 1024 / 1024 << "MB in " << writerStats.writeCalls
+              << " writes, " << writerStats.droppedWrites << " dropped, peak buffer "
+              << writerStats.peakBufferedBytes / 1024 / 1024 << "MB" << std::endl;
+    std::cout << "  - Write latency p50/p95/p99/max: " << writerStats.latencyP50Us / 1000.0 << "/"
+              << writerStats.latencyP95Us / 1000.0 << "/" << writerStats.latencyP99Us / 1000.0 << "/"
+              << writerStats.latencyMaxUs / 1000.0 << " ms" << std::endl;
+    std::cout << "Frame continuity (lost / duplicated / late, max gap):" << std::endl;
+    std::cout << "  - VENC: " << vencSequence.dropped << " / " << vencSequence.duplicated << " / "
+              << vencSequence.late << ", " << vencSequence.maxGapUs / 1000.0 << " ms" << std::endl;
+    std::cout << "  - YUV: " << yuvSequence.dropped << " / " << yuvSequence.duplicated << " / "
+              << yuvSequence.late << ", " << yuvSequence.maxGapUs / 1000.0 << " ms" << std::endl;
+    std::cout << "Metrics:" << std::endl;
+    std::cout << "  - Scrapes: " << metricsStats.scrapes << ", last render "
+              << metricsStats.lastRenderUs / 1000.0 << " ms (" << metricsStats.lastResponseBytes
+              << " bytes)" << std::endl;
+    if (tracer) {
+        std::cout << "Latency (since VI capture, ms):" << std::endl;
+        std::vector<LatencyTracer::Summary> latency = tracer->summaries();
+        char line[160];
+        snprintf(line, sizeof(line), "  %-22s %7s %8s %8s %8s %8s %12s", "stage", "count", "p50", "p90",
+                 "p99", "max", "callback p99");
+        std::cout << line << std::endl;
+        for (size_t i = 0; i < latency.size(); i++) {
+            const LatencyTracer::Summary& l = latency[i];
+            snprintf(line, sizeof(line), "  %-22s %7llu %8.2f %8.2f %8.2f %8.2f", l.name.c_str(),
+                     static_cast<unsigned long long>(l.count), l.p50Us / 1000.0, l.p90Us / 1000.0,
+                     l.p99Us / 1000.0, l.maxUs / 1000.0);
+            std::cout << line;
+            if (i >= LatencyTracer::kStageCount) {
+                snprintf(line, sizeof(line), " %12.2f", l.callbackP99Us / 1000.0);
+                std::cout << line;
+            }
+            std::cout << std::endl;
+        }
+        if (traceSaved) {
+            std::cout << "  - Trace: " << TRACE_OUTPUT_FILE << " (open in ui.perfetto.dev)" << std::endl;
+        }
+    }
     std::cout << "VO (Display):" << std::endl;
     std::cout << "  - Status: Check screen output" << std::endl;
     std::cout << "========================================" << std::endl;
@@ -0,0 +1,97 @@
+/*
+ * ServiceBase 停止竞态测试
+ *
+ * 多个线程不断 postSync(-1) 的同时停止服务：每个调用都必须返回（任务被执行或被取消），
+ * 不能有任务滞留在队列中导致调用方永久阻塞。超过期限仍有调用未返回时判定失败。
+ *
+ *   ./build_native/test_service_base [rounds]
+ */
+#include "ServiceBase.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const int kPosters = 4;
+const int kDefaultRounds = 2000;
+const int kRoundTimeoutMs = 5000;
+
+class EchoSvc : public ServiceBase {
+public:
+    EchoSvc() : ServiceBase("EchoSvc") {}
+    ~EchoSvc() {
+        stop();
+        join();
+    }
+
+protected:
+    void run() override {
+        while (m_running.load()) {
+            processTasks();
+            waitEvents(-1);
+        }
+    }
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : kDefaultRounds;
+
+    // 服务线程的启动/退出日志每轮都会打印，测试只保留结果
+    std::cout.setstate(std::ios::failbit);
+
+    EchoSvc svc;
+    uint64_t done = 0;
+    uint64_t cancelled = 0;
+    for (int round = 0; round < rounds; round++) {
+        svc.start();
+
+        std::atomic<int> finished{0};
+        std::atomic<uint64_t> doneCount{0};
+        std::atomic<uint64_t> cancelledCount{0};
+        std::vector<std::thread> posters;
+        for (int i = 0; i < kPosters; i++) {
+            posters.push_back(std::thread([&svc, &finished, &doneCount, &cancelledCount]() {
+                // 投递直到服务停止：停止后 postSync 返回 false
+                while (svc.postSync([]() { return true; }, -1)) {
+                    doneCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                cancelledCount.fetch_add(1, std::memory_order_relaxed);
+                finished.fetch_add(1);
+            }));
+        }
+
+        // 停止时刻在各轮之间错开，覆盖投递的不同阶段
+        std::this_thread::sleep_for(std::chrono::microseconds(round % 200));
+        svc.stop();
+
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(kRoundTimeoutMs);
+        while (finished.load() < kPosters && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (finished.load() < kPosters) {
+            std::cerr << "[Test] FAIL: round " << round << ": " << (kPosters - finished.load())
+                      << " postSync call(s) still blocked " << kRoundTimeoutMs << "ms after stop()"
+                      << std::endl;
+            _exit(1);  // 阻塞的线程无法 join
+        }
+
+        for (size_t i = 0; i < posters.size(); i++) {
+            posters[i].join();
+        }
+        svc.join();
+        done += doneCount.load();
+        cancelled += cancelledCount.load();
+    }
+
+    std::cerr << "[Test] PASS: " << rounds << " rounds, " << done << " tasks done, " << cancelled
+              << " cancelled at stop" << std::endl;
+    return 0;
+}